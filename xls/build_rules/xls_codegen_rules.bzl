@@ -200,6 +200,7 @@ def xls_ir_verilog_impl(ctx, src):
         "delay_model",
         "io_constraints",
         "receives_first_sends_last",
+        "recompute_cheap_values",
         "top",
         "generator",
         "input_valid_signal",
@@ -232,6 +233,7 @@ def xls_ir_verilog_impl(ctx, src):
         "ram_configurations",
         "gate_recvs",
         "array_index_bounds_checking",
+        "infer_register_enables",
     )
 
     is_args_valid(codegen_args, CODEGEN_FLAGS)
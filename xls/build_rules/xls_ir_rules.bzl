@@ -195,6 +195,9 @@ def _optimize_ir(ctx, src):
         "opt_level",
         "convert_array_index_to_select",
         "inline_procs",
+        "resource_sharing",
+        "time_budget",
+        "max_fixed_point_iterations",
     )
 
     is_args_valid(opt_ir_args, IR_OPT_FLAGS)
@@ -260,6 +263,7 @@ def get_ir_equivalence_test_cmd(
     )
     IR_EQUIVALENCE_FLAGS = (
         "timeout",
+        "solver_portfolio",
     )
 
     ir_equivalence_args = dict(ctx.attr.ir_equivalence_args)
@@ -318,6 +322,7 @@ def get_eval_ir_test_cmd(ctx, src, append_cmd_line_args = True):
         "use_llvm_jit",
         "test_llvm_jit",
         "llvm_opt_level",
+        "jobs",
         "test_only_inject_jit_result",
     )
 
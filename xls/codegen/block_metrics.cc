@@ -14,11 +14,17 @@
 
 #include "xls/codegen/block_metrics.h"
 
+#include "absl/container/btree_map.h"
 #include "absl/strings/str_format.h"
 #include "xls/codegen/xls_metrics.pb.h"
+#include "xls/common/casts.h"
+#include "xls/common/math_util.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/ir/block.h"
+#include "xls/ir/channel.h"
 #include "xls/ir/node_iterator.h"
+#include "xls/ir/node_util.h"
+#include "xls/ir/proc.h"
 
 namespace xls::verilog {
 namespace {
@@ -34,6 +40,21 @@ int64_t GenerateFlopCount(Block* block) {
   return count;
 }
 
+// Returns the number of register bits in the block which have a load enable.
+absl::StatusOr<int64_t> GenerateGatedFlopCount(Block* block) {
+  int64_t count = 0;
+
+  for (Register* reg : block->GetRegisters()) {
+    XLS_ASSIGN_OR_RETURN(RegisterWrite * reg_write,
+                         block->GetRegisterWrite(reg));
+    if (reg_write->load_enable().has_value()) {
+      count += reg->type()->GetFlatBitCount();
+    }
+  }
+
+  return count;
+}
+
 // Returns true if there is a combinational feedthrough path from an input port
 // to an output port.
 bool HasFeedthroughPass(Block* block) {
@@ -328,13 +349,190 @@ absl::Status GenerateBom(Block* block, BlockMetricsProto* proto) {
   return absl::OkStatus();
 }
 
+// The stages of the operations on a single channel.
+struct ChannelStages {
+  std::optional<int64_t> min_send;
+  std::optional<int64_t> max_send;
+  std::optional<int64_t> min_receive;
+  std::optional<int64_t> max_receive;
+};
+
+// A lower bound on the initiation interval along with the reason for it. A
+// missing bound indicates a potential deadlock.
+struct IntervalBound {
+  std::optional<int64_t> initiation_interval;
+  std::string reason;
+};
+
+// Computes the bound on the initiation interval imposed by a channel on which
+// the proc both sends and receives. The send of activation `n` produces the
+// token consumed by the receive of activation `n + k` where `k` is the number
+// of initial values of the channel. All times below are at the ports of the
+// block and relative to the start of activation 0, with `II` the initiation
+// interval:
+//
+//   receive of activation n:  n * II + r
+//   send of activation n:     n * II + s + input_latency + output_latency
+//
+// The token must traverse the FIFO (one cycle if the FIFO has storage) before
+// it is received, which yields `k * II >= s + io_latency + fifo_latency - r`.
+// If the FIFO depth `d` is known, the FIFO must also have room for the tokens
+// sent before earlier activations receive theirs, which yields
+// `(d - k) * II >= r - s - io_latency`.
+IntervalBound LoopbackChannelBound(const StreamingChannel* channel,
+                                   const ChannelStages& stages,
+                                   int64_t io_latency) {
+  IntervalBound bound{1, ""};
+  int64_t k = channel->initial_values().size();
+  std::optional<int64_t> depth = channel->GetFifoDepth();
+  int64_t fifo_latency = depth.has_value() && depth.value() == 0 ? 0 : 1;
+
+  int64_t recurrence =
+      stages.max_send.value() + io_latency + fifo_latency -
+      stages.min_receive.value();
+  if (recurrence > 0) {
+    if (k == 0) {
+      return IntervalBound{
+          std::nullopt,
+          absl::StrFormat("channel %s: receive in stage %d depends on send "
+                          "in stage %d of the same activation",
+                          channel->name(), stages.min_receive.value(),
+                          stages.max_send.value())};
+    }
+    int64_t ii = CeilOfRatio(recurrence, k);
+    if (ii > bound.initiation_interval.value()) {
+      bound = IntervalBound{
+          ii, absl::StrFormat("channel %s: recurrence of %d cycles over %d "
+                              "initial values",
+                              channel->name(), recurrence, k)};
+    }
+  }
+
+  int64_t slack = stages.max_receive.value() - stages.min_send.value() -
+                  io_latency;
+  if (depth.has_value() && slack > 0) {
+    int64_t free_entries = depth.value() - k;
+    if (free_entries <= 0) {
+      return IntervalBound{
+          std::nullopt,
+          absl::StrFormat("channel %s: FIFO of depth %d cannot hold tokens "
+                          "sent %d cycles before they are received",
+                          channel->name(), depth.value(), slack)};
+    }
+    int64_t ii = CeilOfRatio(slack, free_entries);
+    if (ii > bound.initiation_interval.value()) {
+      bound = IntervalBound{
+          ii, absl::StrFormat("channel %s: FIFO of depth %d holds tokens for "
+                              "%d cycles",
+                              channel->name(), depth.value(), slack)};
+    }
+  }
+  return bound;
+}
+
 }  // namespace
 
+absl::Status GenerateThroughputMetrics(const PipelineSchedule& schedule,
+                                       int64_t input_latency,
+                                       int64_t output_latency,
+                                       BlockMetricsProto* proto) {
+  FunctionBase* f = schedule.function_base();
+  proto->set_pipeline_latency(schedule.length() - 1 + input_latency +
+                              output_latency);
+  proto->set_recompute_flop_savings(schedule.recompute_flop_savings());
+
+  IntervalBound bound{1, ""};
+  auto update_bound = [&](const IntervalBound& other) {
+    if (!bound.initiation_interval.has_value()) {
+      return;
+    }
+    if (!other.initiation_interval.has_value() ||
+        other.initiation_interval.value() > bound.initiation_interval.value()) {
+      bound = other;
+    }
+  };
+
+  if (f->IsProc()) {
+    Proc* proc = f->AsProcOrDie();
+
+    // A state element must be updated before the activation which reads it
+    // can start.
+    for (int64_t i = 0; i < proc->GetStateElementCount(); ++i) {
+      Param* param = proc->GetStateParam(i);
+      int64_t distance = schedule.cycle(proc->GetNextStateElement(i)) -
+                         schedule.cycle(param) + 1;
+      update_bound(IntervalBound{
+          distance, absl::StrFormat("state element %s: recurrence of %d cycles",
+                                    param->GetName(), distance)});
+    }
+
+    absl::btree_map<std::string, std::pair<Channel*, ChannelStages>> channels;
+    for (Node* node : proc->nodes()) {
+      if (!node->Is<Send>() && !node->Is<Receive>()) {
+        continue;
+      }
+      XLS_ASSIGN_OR_RETURN(Channel * channel, GetChannelUsedByNode(node));
+      auto& [ch, stages] = channels[channel->name()];
+      ch = channel;
+      int64_t stage = schedule.cycle(node);
+      auto update = [stage](std::optional<int64_t>& min_stage,
+                            std::optional<int64_t>& max_stage) {
+        min_stage = std::min(min_stage.value_or(stage), stage);
+        max_stage = std::max(max_stage.value_or(stage), stage);
+      };
+      if (node->Is<Send>()) {
+        update(stages.min_send, stages.max_send);
+      } else {
+        update(stages.min_receive, stages.max_receive);
+      }
+    }
+
+    for (const auto& [name, channel_and_stages] : channels) {
+      const auto& [channel, stages] = channel_and_stages;
+      bool is_send = stages.max_send.has_value();
+      bool is_receive = stages.max_receive.has_value();
+      if (is_receive) {
+        ChannelLatencyProto* latency = proto->add_channel_latencies();
+        latency->set_channel_name(name);
+        latency->set_receive(true);
+        latency->set_stage(stages.max_receive.value());
+        latency->set_latency(stages.max_receive.value());
+      }
+      if (is_send) {
+        ChannelLatencyProto* latency = proto->add_channel_latencies();
+        latency->set_channel_name(name);
+        latency->set_receive(false);
+        latency->set_stage(stages.max_send.value());
+        latency->set_latency(stages.max_send.value() + input_latency +
+                             output_latency);
+      }
+      if (is_send && is_receive && channel->kind() == ChannelKind::kStreaming) {
+        update_bound(LoopbackChannelBound(
+            down_cast<StreamingChannel*>(channel), stages,
+            input_latency + output_latency));
+      }
+    }
+  }
+
+  proto->set_throughput_limiter(bound.reason);
+  if (bound.initiation_interval.has_value()) {
+    proto->set_initiation_interval(bound.initiation_interval.value());
+    proto->set_worst_case_throughput(
+        1.0 / static_cast<double>(bound.initiation_interval.value()));
+  } else {
+    proto->set_worst_case_throughput(0.0);
+  }
+  return absl::OkStatus();
+}
+
 absl::StatusOr<BlockMetricsProto> GenerateBlockMetrics(
     Block* block, std::optional<const DelayEstimator*> delay_estimator) {
   BlockMetricsProto proto;
   proto.set_flop_count(GenerateFlopCount(block));
   proto.set_feedthrough_path_exists(HasFeedthroughPass(block));
+  XLS_ASSIGN_OR_RETURN(int64_t gated_flop_count,
+                       GenerateGatedFlopCount(block));
+  proto.set_gated_flop_count(gated_flop_count);
 
   if (delay_estimator.has_value()) {
     proto.set_delay_model(delay_estimator.value()->name());
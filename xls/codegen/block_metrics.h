@@ -19,6 +19,7 @@
 #include "xls/codegen/xls_metrics.pb.h"
 #include "xls/delay_model/delay_estimator.h"
 #include "xls/ir/block.h"
+#include "xls/scheduling/pipeline_schedule.h"
 
 namespace xls::verilog {
 
@@ -30,6 +31,19 @@ absl::StatusOr<BlockMetricsProto> GenerateBlockMetrics(
     Block* block,
     std::optional<const DelayEstimator*> delay_estimator = std::nullopt);
 
+// Computes static latency and throughput metrics from the schedule of the
+// function or proc from which a block was generated and sets the corresponding
+// fields of `proto`. `input_latency` and `output_latency` are the number of
+// cycles added by I/O flops (see CodegenOptions::GetInputLatency). The
+// computed metrics assume that the environment of the block (other than
+// channels which the block both sends on and receives from) never stalls.
+// The number of pipeline register bits saved by recomputation during
+// scheduling is recorded as well.
+absl::Status GenerateThroughputMetrics(const PipelineSchedule& schedule,
+                                       int64_t input_latency,
+                                       int64_t output_latency,
+                                       BlockMetricsProto* proto);
+
 }  // namespace xls::verilog
 
 #endif  // XLS_CODEGEN_BLOCK_METRICS_GENERATOR_H_
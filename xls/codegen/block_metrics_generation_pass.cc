@@ -32,6 +32,30 @@ absl::StatusOr<bool> BlockMetricsGenerationPass::RunInternal(
 
   XLS_ASSIGN_OR_RETURN(BlockMetricsProto block_metrics,
                        GenerateBlockMetrics(unit->block));
+  if (options.schedule.has_value()) {
+    XLS_RETURN_IF_ERROR(GenerateThroughputMetrics(
+        options.schedule.value(), options.codegen_options.GetInputLatency(),
+        options.codegen_options.GetOutputLatency(), &block_metrics));
+  }
+
+  // Report the load enables inferred earlier in the pipeline. Registers may
+  // have been removed by passes which ran after the inference.
+  double toggle_reduction = 0.0;
+  for (const InferredRegisterEnable& enable :
+       unit->inferred_register_enables) {
+    if (!unit->block->GetRegister(enable.register_name).ok()) {
+      continue;
+    }
+    InferredRegisterEnableProto* proto =
+        block_metrics.add_inferred_register_enables();
+    proto->set_register_name(enable.register_name);
+    proto->set_bit_count(enable.bit_count);
+    proto->set_hold(enable.hold);
+    proto->set_unobserved(enable.unobserved);
+    proto->set_estimated_idle_fraction(enable.estimated_idle_fraction);
+    toggle_reduction += enable.bit_count * enable.estimated_idle_fraction;
+  }
+  block_metrics.set_estimated_toggle_reduction(toggle_reduction);
   XLS_RETURN_IF_ERROR(unit->signature->ReplaceBlockMetrics(block_metrics));
 
   return true;
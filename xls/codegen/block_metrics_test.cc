@@ -14,6 +14,7 @@
 
 #include "xls/codegen/block_metrics.h"
 
+#include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "xls/codegen/block_conversion.h"
 #include "xls/codegen/codegen_options.h"
@@ -23,7 +24,9 @@
 #include "xls/ir/block.h"
 #include "xls/ir/function_builder.h"
 #include "xls/ir/ir_parser.h"
+#include "xls/ir/node_iterator.h"
 #include "xls/ir/package.h"
+#include "xls/ir/proc.h"
 #include "xls/ir/type.h"
 #include "xls/scheduling/pipeline_schedule.h"
 
@@ -81,6 +84,31 @@ TEST(BlockMetricsGeneratorTest, PipelineRegisters) {
   EXPECT_EQ(proto.flop_count(), 64);
 }
 
+TEST(BlockMetricsGeneratorTest, GatedFlopCount) {
+  Package package("test");
+
+  Type* u32 = package.GetBitsType(32);
+  BlockBuilder bb("test_block", &package);
+
+  XLS_ASSERT_OK(bb.block()->AddClockPort("clk"));
+  BValue en = bb.InputPort("en", package.GetBitsType(1));
+  BValue a = bb.InputPort("a", u32);
+  BValue b = bb.InputPort("b", package.GetBitsType(8));
+
+  BValue a_reg = bb.InsertRegister("a_reg", a, /*load_enable=*/en);
+  BValue b_reg = bb.InsertRegister("b_reg", b);
+  bb.OutputPort("x", a_reg);
+  bb.OutputPort("y", b_reg);
+
+  XLS_ASSERT_OK_AND_ASSIGN(Block * block, bb.Build());
+
+  XLS_ASSERT_OK_AND_ASSIGN(BlockMetricsProto proto,
+                           GenerateBlockMetrics(block));
+
+  EXPECT_EQ(proto.flop_count(), 40);
+  EXPECT_EQ(proto.gated_flop_count(), 32);
+}
+
 TEST(BlockMetricsGeneratorTest, PipelineRegistersCount) {
   Package package("test");
 
@@ -112,6 +140,100 @@ TEST(BlockMetricsGeneratorTest, PipelineRegistersCount) {
   EXPECT_EQ(proto.flop_count(), schedule.CountFinalInteriorPipelineRegisters());
 }
 
+TEST(BlockMetricsGeneratorTest, ThroughputOfPipelinedFunction) {
+  Package package("test");
+
+  FunctionBuilder fb("test_func", &package);
+  BValue x = fb.Param("x", package.GetBitsType(32));
+  BValue y = fb.Param("y", package.GetBitsType(32));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Function * f, fb.BuildWithReturnValue(fb.Negate(fb.Not(fb.Add(x, y)))));
+
+  XLS_ASSERT_OK_AND_ASSIGN(const DelayEstimator* delay_estimator,
+                           GetDelayEstimator("unit"));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      PipelineSchedule schedule,
+      PipelineSchedule::Run(f, *delay_estimator,
+                            SchedulingOptions().pipeline_stages(3)));
+
+  BlockMetricsProto proto;
+  XLS_ASSERT_OK(GenerateThroughputMetrics(schedule, /*input_latency=*/1,
+                                          /*output_latency=*/1, &proto));
+  EXPECT_EQ(proto.pipeline_latency(), 4);
+  EXPECT_EQ(proto.initiation_interval(), 1);
+  EXPECT_DOUBLE_EQ(proto.worst_case_throughput(), 1.0);
+  EXPECT_EQ(proto.channel_latencies_size(), 0);
+}
+
+// Builds a proc which receives on `channel`, sends the incremented value back
+// on `channel` and accumulates the received values in a state element. The
+// send is scheduled in stage 2 and the next state value in stage 1.
+absl::StatusOr<PipelineSchedule> LoopbackProcSchedule(Package* package,
+                                                      Channel* channel) {
+  TokenlessProcBuilder pb("loopback", "tkn", package);
+  BValue st = pb.StateElement("st", Value(UBits(0, 32)));
+  BValue data = pb.Receive(channel);
+  BValue send = pb.Send(channel, pb.Add(data, pb.Literal(UBits(1, 32))));
+  BValue next = pb.Add(st, data);
+  XLS_ASSIGN_OR_RETURN(Proc * proc, pb.Build({next}));
+
+  ScheduleCycleMap cycle_map;
+  for (Node* node : TopoSort(proc)) {
+    int64_t cycle = node == send.node() ? 2 : (node == next.node() ? 1 : 0);
+    for (Node* operand : node->operands()) {
+      cycle = std::max(cycle, cycle_map.at(operand));
+    }
+    cycle_map[node] = cycle;
+  }
+  return PipelineSchedule(proc, cycle_map);
+}
+
+TEST(BlockMetricsGeneratorTest, ThroughputOfLoopbackChannel) {
+  Package package("test");
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * channel,
+      package.CreateStreamingChannel(
+          "loop", ChannelOps::kSendReceive, package.GetBitsType(32),
+          /*initial_values=*/{Value(UBits(0, 32))}, /*fifo_depth=*/1));
+  XLS_ASSERT_OK_AND_ASSIGN(PipelineSchedule schedule,
+                           LoopbackProcSchedule(&package, channel));
+
+  BlockMetricsProto proto;
+  XLS_ASSERT_OK(GenerateThroughputMetrics(schedule, /*input_latency=*/0,
+                                          /*output_latency=*/0, &proto));
+  EXPECT_EQ(proto.pipeline_latency(), 2);
+  // The token sent in stage 2 passes through the FIFO and must be received in
+  // stage 0 of the next activation.
+  EXPECT_EQ(proto.initiation_interval(), 3);
+  EXPECT_DOUBLE_EQ(proto.worst_case_throughput(), 1.0 / 3.0);
+  EXPECT_THAT(proto.throughput_limiter(), testing::HasSubstr("channel loop"));
+
+  ASSERT_EQ(proto.channel_latencies_size(), 2);
+  EXPECT_EQ(proto.channel_latencies(0).channel_name(), "loop");
+  EXPECT_TRUE(proto.channel_latencies(0).receive());
+  EXPECT_EQ(proto.channel_latencies(0).latency(), 0);
+  EXPECT_FALSE(proto.channel_latencies(1).receive());
+  EXPECT_EQ(proto.channel_latencies(1).stage(), 2);
+  EXPECT_EQ(proto.channel_latencies(1).latency(), 2);
+}
+
+TEST(BlockMetricsGeneratorTest, ThroughputOfDeadlockedLoopbackChannel) {
+  Package package("test");
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * channel,
+      package.CreateStreamingChannel("loop", ChannelOps::kSendReceive,
+                                     package.GetBitsType(32)));
+  XLS_ASSERT_OK_AND_ASSIGN(PipelineSchedule schedule,
+                           LoopbackProcSchedule(&package, channel));
+
+  BlockMetricsProto proto;
+  XLS_ASSERT_OK(GenerateThroughputMetrics(schedule, /*input_latency=*/0,
+                                          /*output_latency=*/0, &proto));
+  EXPECT_FALSE(proto.has_initiation_interval());
+  EXPECT_EQ(proto.worst_case_throughput(), 0.0);
+  EXPECT_THAT(proto.throughput_limiter(), testing::HasSubstr("channel loop"));
+}
+
 TEST(BlockMetricsGeneratorTest, DelayModel) {
   Package package("test");
   BlockBuilder bb("pass_thru", &package);
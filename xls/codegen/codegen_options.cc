@@ -50,7 +50,8 @@ CodegenOptions::CodegenOptions(const CodegenOptions& options)
       streaming_channel_ready_suffix_(options.streaming_channel_ready_suffix_),
       streaming_channel_valid_suffix_(options.streaming_channel_valid_suffix_),
       array_index_bounds_checking_(options.array_index_bounds_checking_),
-      gate_recvs_(options.gate_recvs_) {
+      gate_recvs_(options.gate_recvs_),
+      infer_register_enables_(options.infer_register_enables_) {
   for (auto& [op, op_override] : options.op_overrides_) {
     op_overrides_.insert_or_assign(op, op_override->Clone());
   }
@@ -81,6 +82,7 @@ CodegenOptions& CodegenOptions::operator=(const CodegenOptions& options) {
   streaming_channel_valid_suffix_ = options.streaming_channel_valid_suffix_;
   array_index_bounds_checking_ = options.array_index_bounds_checking_;
   gate_recvs_ = options.gate_recvs_;
+  infer_register_enables_ = options.infer_register_enables_;
   for (auto& [op, op_override] : options.op_overrides_) {
     op_overrides_.insert_or_assign(op, op_override->Clone());
   }
@@ -247,6 +249,11 @@ CodegenOptions& CodegenOptions::gate_recvs(bool value) {
   return *this;
 }
 
+CodegenOptions& CodegenOptions::infer_register_enables(bool value) {
+  infer_register_enables_ = value;
+  return *this;
+}
+
 CodegenOptions& CodegenOptions::ram_configurations(
     absl::Span<const std::unique_ptr<RamConfiguration>> ram_configurations) {
   ram_configurations_.clear();
@@ -220,6 +220,13 @@ class CodegenOptions {
   CodegenOptions& gate_recvs(bool value);
   bool gate_recvs() const { return gate_recvs_; }
 
+  // Infer load enables for registers whose next value is provably equal to
+  // their current value, or whose value is provably unobserved, under some
+  // predicate. The inferred enables reduce switching in the datapath and
+  // enable downstream tools to insert clock gates.
+  CodegenOptions& infer_register_enables(bool value);
+  bool infer_register_enables() const { return infer_register_enables_; }
+
   // List of channels to rewrite for RAMs.
   CodegenOptions& ram_configurations(
       absl::Span<const std::unique_ptr<RamConfiguration>> ram_configurations);
@@ -250,6 +257,7 @@ class CodegenOptions {
   std::string streaming_channel_valid_suffix_ = "_vld";
   bool array_index_bounds_checking_ = true;
   bool gate_recvs_ = true;
+  bool infer_register_enables_ = false;
   std::vector<std::unique_ptr<RamConfiguration>> ram_configurations_;
 };
 
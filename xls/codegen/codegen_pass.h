@@ -15,6 +15,9 @@
 #ifndef XLS_CODEGEN_CODEGEN_PASS_H_
 #define XLS_CODEGEN_CODEGEN_PASS_H_
 
+#include <string>
+#include <vector>
+
 #include "absl/types/optional.h"
 #include "xls/codegen/codegen_options.h"
 #include "xls/codegen/module_signature.h"
@@ -38,6 +41,22 @@ struct CodegenPassOptions : public PassOptions {
   std::optional<PipelineSchedule> schedule;
 };
 
+// Describes a load enable inferred for a register during codegen. Recorded so
+// that the inferred enables can be reported in the block metrics.
+struct InferredRegisterEnable {
+  std::string register_name;
+  int64_t bit_count;
+
+  // Whether the register holds its value under the inferred predicate.
+  bool hold;
+
+  // Whether the register's value is unobserved under the inferred predicate.
+  bool unobserved;
+
+  // Estimated fraction of cycles in which the inferred enable is deasserted.
+  double estimated_idle_fraction;
+};
+
 // Data structure operated on by codegen passes. Contains the IR and associated
 // metadata which may be used and mutated by passes.
 struct CodegenPassUnit {
@@ -57,6 +76,9 @@ struct CodegenPassUnit {
   // out-of-sync with the IR.
   std::optional<ModuleSignature> signature;
 
+  // Load enables inferred by RegisterEnableInferencePass.
+  std::vector<InferredRegisterEnable> inferred_register_enables;
+
   // These methods are required by CompoundPassBase.
   std::string DumpIr() const;
   const std::string& name() const { return block->name(); }
@@ -23,6 +23,7 @@
 #include "xls/codegen/mulp_combining_pass.h"
 #include "xls/codegen/port_legalization_pass.h"
 #include "xls/codegen/ram_rewrite_pass.h"
+#include "xls/codegen/register_enable_inference_pass.h"
 #include "xls/codegen/register_legalization_pass.h"
 #include "xls/codegen/signature_generation_pass.h"
 #include "xls/passes/dce_pass.h"
@@ -66,6 +67,10 @@ std::unique_ptr<CodegenCompoundPass> CreateCodegenPassPipeline() {
   // pipeline.
   top->Add<CodegenWrapperPass>(std::make_unique<IdentityRemovalPass>());
 
+  // Optionally infer load enables for registers which hold their value or
+  // whose value is unobserved under some predicate.
+  top->Add<RegisterEnableInferencePass>();
+
   // Final dead-code elimination pass to remove cruft left from earlier passes.
   top->Add<CodegenWrapperPass>(std::make_unique<DeadCodeEliminationPass>());
 
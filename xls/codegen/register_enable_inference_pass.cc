@@ -0,0 +1,433 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/codegen/register_enable_inference_pass.h"
+
+#include <algorithm>
+#include <functional>
+#include <optional>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/data_structures/binary_decision_diagram.h"
+#include "xls/ir/block.h"
+#include "xls/ir/node_util.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/value.h"
+#include "xls/passes/bdd_function.h"
+
+namespace xls::verilog {
+namespace {
+
+// Selectors wider than this are not considered. The number of arms of the
+// select (and the cost of expressing arm conditions in the BDD) grows
+// exponentially with the selector width.
+constexpr int64_t kMaxSelectorWidth = 8;
+
+// Returns the probability that the given BDD expression is true assuming each
+// BDD variable is independently true with probability one half.
+double TrueProbability(const BinaryDecisionDiagram& bdd, BddNodeIndex expr) {
+  // The nodes are evaluated in a post-order traversal from `expr`. Node indices
+  // can not be used to order the evaluation as they are not topologically
+  // ordered once the BDD has been sifted.
+  absl::flat_hash_map<BddNodeIndex, double> probability = {{bdd.zero(), 0.0},
+                                                           {bdd.one(), 1.0}};
+  std::vector<BddNodeIndex> stack = {expr};
+  while (!stack.empty()) {
+    BddNodeIndex node = stack.back();
+    if (probability.contains(node)) {
+      stack.pop_back();
+      continue;
+    }
+    const BddNode& bdd_node = bdd.GetNode(node);
+    auto high = probability.find(bdd_node.high);
+    auto low = probability.find(bdd_node.low);
+    if (high != probability.end() && low != probability.end()) {
+      double node_probability = 0.5 * (high->second + low->second);
+      probability[node] = node_probability;
+      stack.pop_back();
+      continue;
+    }
+    if (high == probability.end()) {
+      stack.push_back(bdd_node.high);
+    }
+    if (low == probability.end()) {
+      stack.push_back(bdd_node.low);
+    }
+  }
+  return probability.at(expr);
+}
+
+// A reference to a particular arm of a select. The arm is chosen when
+// `selector` (the selector of `select`, or the value which will be loaded into
+// the register driving the selector) has the arm's index.
+struct SelectArm {
+  Select* select;
+  Node* selector;
+  int64_t arm;
+};
+
+// A single-bit condition which is the OR of the conditions under which each of
+// the given select arms is chosen. The condition is expressed as an expression
+// in the BDD. The corresponding IR is only created if the condition is used.
+struct Condition {
+  std::vector<SelectArm> arms;
+  BddNodeIndex bdd;
+};
+
+// Helper for building conditions under which selects choose particular arms.
+class ArmConditionBuilder {
+ public:
+  ArmConditionBuilder(Block* block, BddFunction* bdd_function)
+      : block_(block), bdd_function_(bdd_function) {}
+
+  BinaryDecisionDiagram& bdd() { return bdd_function_->bdd(); }
+
+  // Returns the BDD expression which is true when `selector` has the value
+  // `index`.
+  BddNodeIndex BddSelectorEquals(Node* selector, int64_t index) {
+    BddNodeIndex result = bdd().one();
+    for (int64_t i = 0; i < selector->BitCountOrDie(); ++i) {
+      BddNodeIndex bit = bdd_function_->GetBddNode(selector, i);
+      result = bdd().And(result, ((index >> i) & 1) ? bit : bdd().Not(bit));
+    }
+    return result;
+  }
+
+  // Returns the BDD expression which is true when `selector` (the selector of
+  // `select`) chooses the given arm. `arm` equal to the number of cases
+  // indicates the default value.
+  BddNodeIndex BddArmSelected(Select* select, Node* selector, int64_t arm) {
+    int64_t case_count = select->cases().size();
+    if (arm < case_count) {
+      return BddSelectorEquals(selector, arm);
+    }
+    BddNodeIndex any_case = bdd().zero();
+    for (int64_t i = 0; i < case_count; ++i) {
+      any_case = bdd().Or(any_case, BddSelectorEquals(selector, i));
+    }
+    return bdd().Not(any_case);
+  }
+
+  // Creates an IR node which is true when the given arm is chosen.
+  absl::StatusOr<Node*> IrArmSelected(const SelectArm& select_arm) {
+    Node* selector = select_arm.selector;
+    int64_t arm = select_arm.arm;
+    int64_t width = selector->BitCountOrDie();
+    int64_t case_count = select_arm.select->cases().size();
+    if (width == 1 && arm < case_count) {
+      if (arm == 1) {
+        return selector;
+      }
+      return block_->MakeNode<UnOp>(selector->loc(), selector, Op::kNot);
+    }
+    if (arm < case_count) {
+      XLS_ASSIGN_OR_RETURN(Node * index,
+                           block_->MakeNode<xls::Literal>(
+                               selector->loc(), Value(UBits(arm, width))));
+      return block_->MakeNode<CompareOp>(selector->loc(), selector, index,
+                                         Op::kEq);
+    }
+    XLS_ASSIGN_OR_RETURN(Node * limit,
+                         block_->MakeNode<xls::Literal>(
+                             selector->loc(), Value(UBits(case_count, width))));
+    return block_->MakeNode<CompareOp>(selector->loc(), selector, limit,
+                                       Op::kUGe);
+  }
+
+ private:
+  Block* block_;
+  BddFunction* bdd_function_;
+};
+
+// Returns the indices of the arms of `select` which satisfy `pred`. Arm `i` is
+// case `i` and arm `cases().size()` is the default value.
+std::vector<int64_t> ArmsMatching(Select* select,
+                                  const std::function<bool(Node*)>& pred) {
+  std::vector<int64_t> arms;
+  for (int64_t i = 0; i < select->cases().size(); ++i) {
+    if (pred(select->get_case(i))) {
+      arms.push_back(i);
+    }
+  }
+  if (select->default_value().has_value() &&
+      pred(select->default_value().value())) {
+    arms.push_back(select->cases().size());
+  }
+  return arms;
+}
+
+int64_t ArmCount(Select* select) {
+  return select->cases().size() + (select->default_value().has_value() ? 1 : 0);
+}
+
+// Returns true if the two nodes are known to be equal. Non-bits typed nodes are
+// only considered equal if they are the same node.
+bool KnownEqual(Node* a, Node* b, const BddFunction& bdd_function) {
+  if (a == b) {
+    return true;
+  }
+  if (!a->GetType()->IsBits() || a->GetType() != b->GetType()) {
+    return false;
+  }
+  for (int64_t i = 0; i < a->BitCountOrDie(); ++i) {
+    if (bdd_function.GetBddNode(a, i) != bdd_function.GetBddNode(b, i)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// The inferred load condition for a single register.
+struct InferredCondition {
+  Register* reg;
+  RegisterWrite* reg_write;
+  std::optional<Condition> not_hold;
+  std::optional<Condition> observed;
+};
+
+// Returns the condition under which the register does *not* hold its value,
+// if a useful condition can be inferred.
+absl::StatusOr<std::optional<Condition>> InferNotHoldCondition(
+    RegisterRead* reg_read, RegisterWrite* reg_write,
+    ArmConditionBuilder& builder, BddFunction& bdd_function) {
+  if (!reg_write->data()->Is<Select>()) {
+    return std::nullopt;
+  }
+  Select* select = reg_write->data()->As<Select>();
+  if (select->selector()->BitCountOrDie() > kMaxSelectorWidth) {
+    return std::nullopt;
+  }
+  std::vector<int64_t> hold_arms = ArmsMatching(select, [&](Node* n) {
+    return KnownEqual(n, reg_read, bdd_function);
+  });
+  if (hold_arms.empty() || hold_arms.size() == ArmCount(select)) {
+    return std::nullopt;
+  }
+
+  BddNodeIndex hold = builder.bdd().zero();
+  for (int64_t arm : hold_arms) {
+    hold = builder.bdd().Or(
+        hold, builder.BddArmSelected(select, select->selector(), arm));
+  }
+  if (hold == builder.bdd().zero()) {
+    // The register never holds its value.
+    return std::nullopt;
+  }
+
+  Condition result;
+  result.bdd = builder.bdd().Not(hold);
+  for (int64_t arm = 0; arm < ArmCount(select); ++arm) {
+    if (std::find(hold_arms.begin(), hold_arms.end(), arm) ==
+        hold_arms.end()) {
+      result.arms.push_back(SelectArm{select, select->selector(), arm});
+    }
+  }
+  return result;
+}
+
+// Returns the condition under which the value loaded into the register will be
+// observed, if a useful condition can be inferred.
+absl::StatusOr<std::optional<Condition>> InferObservedCondition(
+    Block* block, RegisterRead* reg_read, RegisterWrite* reg_write,
+    ArmConditionBuilder& builder) {
+  if (reg_read->users().empty()) {
+    return std::nullopt;
+  }
+  Register* reg = reg_read->GetRegister();
+  struct Use {
+    Select* select;
+    RegisterWrite* selector_write;
+    std::vector<int64_t> arms;
+  };
+  std::vector<Use> uses;
+  for (Node* user : reg_read->users()) {
+    if (!user->Is<Select>() || user->As<Select>()->selector() == reg_read ||
+        !user->As<Select>()->selector()->Is<RegisterRead>()) {
+      return std::nullopt;
+    }
+    Select* select = user->As<Select>();
+    if (select->selector()->BitCountOrDie() > kMaxSelectorWidth) {
+      return std::nullopt;
+    }
+    Register* selector_reg =
+        select->selector()->As<RegisterRead>()->GetRegister();
+    XLS_ASSIGN_OR_RETURN(RegisterWrite * selector_write,
+                         block->GetRegisterWrite(selector_reg));
+    // The selector register must be loaded in exactly the same cycles as this
+    // register and must be reset together with it (if at all).
+    if (selector_write->load_enable() != reg_write->load_enable() ||
+        selector_write->reset() != reg_write->reset()) {
+      return std::nullopt;
+    }
+    if (reg->reset().has_value() &&
+        (selector_reg->reset()->active_low != reg->reset()->active_low)) {
+      return std::nullopt;
+    }
+    uses.push_back(Use{select, selector_write,
+                       ArmsMatching(select, [&](Node* n) {
+                         return n == reg_read;
+                       })});
+  }
+
+  BddNodeIndex observed = builder.bdd().zero();
+  for (const Use& use : uses) {
+    for (int64_t arm : use.arms) {
+      observed = builder.bdd().Or(
+          observed, builder.BddArmSelected(use.select,
+                                           use.selector_write->data(), arm));
+    }
+  }
+  if (observed == builder.bdd().one()) {
+    return std::nullopt;
+  }
+
+  Condition result;
+  result.bdd = observed;
+  for (const Use& use : uses) {
+    for (int64_t arm : use.arms) {
+      result.arms.push_back(
+          SelectArm{use.select, use.selector_write->data(), arm});
+    }
+  }
+  return result;
+}
+
+// Creates a single-bit node which is the IR expression of the given condition.
+absl::StatusOr<Node*> MakeConditionNode(Block* block,
+                                        const Condition& condition,
+                                        ArmConditionBuilder& builder) {
+  std::vector<Node*> terms;
+  for (const SelectArm& arm : condition.arms) {
+    XLS_ASSIGN_OR_RETURN(Node * term, builder.IrArmSelected(arm));
+    terms.push_back(term);
+  }
+  XLS_RET_CHECK(!terms.empty());
+  if (terms.size() == 1) {
+    return terms.front();
+  }
+  return block->MakeNode<NaryOp>(SourceInfo(), terms, Op::kOr);
+}
+
+}  // namespace
+
+absl::StatusOr<bool> RegisterEnableInferencePass::RunInternal(
+    CodegenPassUnit* unit, const CodegenPassOptions& options,
+    PassResults* results) const {
+  if (!options.codegen_options.infer_register_enables()) {
+    return false;
+  }
+  Block* block = unit->block;
+  if (block->GetRegisters().empty()) {
+    return false;
+  }
+
+  XLS_ASSIGN_OR_RETURN(
+      std::unique_ptr<BddFunction> bdd_function,
+      BddFunction::Run(block, BddFunction::kDefaultPathLimit));
+  ArmConditionBuilder builder(block, bdd_function.get());
+
+  // Infer all conditions before modifying any register writes. The
+  // "unobserved" inference compares the load enables of pairs of registers and
+  // must see the original enables.
+  std::vector<InferredCondition> inferred;
+  for (Register* reg : block->GetRegisters()) {
+    if (reg->type()->GetFlatBitCount() == 0) {
+      continue;
+    }
+    XLS_ASSIGN_OR_RETURN(RegisterRead * reg_read, block->GetRegisterRead(reg));
+    XLS_ASSIGN_OR_RETURN(RegisterWrite * reg_write,
+                         block->GetRegisterWrite(reg));
+    InferredCondition condition{reg, reg_write, std::nullopt, std::nullopt};
+    XLS_ASSIGN_OR_RETURN(condition.not_hold,
+                         InferNotHoldCondition(reg_read, reg_write, builder,
+                                               *bdd_function));
+    XLS_ASSIGN_OR_RETURN(
+        condition.observed,
+        InferObservedCondition(block, reg_read, reg_write, builder));
+    // Drop conditions already implied by the existing load enable (e.g., if
+    // this pass has been run before).
+    if (reg_write->load_enable().has_value()) {
+      BddNodeIndex existing =
+          bdd_function->GetBddNode(reg_write->load_enable().value(), 0);
+      for (std::optional<Condition>* c :
+           {&condition.not_hold, &condition.observed}) {
+        if (c->has_value() &&
+            builder.bdd().And(existing, builder.bdd().Not((*c)->bdd)) ==
+                builder.bdd().zero()) {
+          c->reset();
+        }
+      }
+    }
+    if (condition.not_hold.has_value() || condition.observed.has_value()) {
+      inferred.push_back(std::move(condition));
+    }
+  }
+
+  for (InferredCondition& condition : inferred) {
+    std::vector<Node*> enable_terms;
+    if (condition.reg_write->load_enable().has_value()) {
+      enable_terms.push_back(condition.reg_write->load_enable().value());
+    }
+    BddNodeIndex load = builder.bdd().one();
+    for (const std::optional<Condition>& c :
+         {condition.not_hold, condition.observed}) {
+      if (c.has_value()) {
+        XLS_ASSIGN_OR_RETURN(Node * term,
+                             MakeConditionNode(block, *c, builder));
+        enable_terms.push_back(term);
+        load = builder.bdd().And(load, c->bdd);
+      }
+    }
+    Node* load_enable = enable_terms.front();
+    if (enable_terms.size() > 1) {
+      XLS_ASSIGN_OR_RETURN(
+          load_enable,
+          block->MakeNodeWithName<NaryOp>(
+              SourceInfo(), enable_terms, Op::kAnd,
+              absl::StrCat(condition.reg->name(), "_inferred_load_en")));
+    }
+    XLS_RETURN_IF_ERROR(block
+                            ->MakeNode<RegisterWrite>(
+                                /*loc=*/condition.reg_write->loc(),
+                                /*data=*/condition.reg_write->data(),
+                                /*load_enable=*/load_enable,
+                                /*reset=*/condition.reg_write->reset(),
+                                /*reg=*/condition.reg)
+                            .status());
+    XLS_RETURN_IF_ERROR(block->RemoveNode(condition.reg_write));
+
+    double idle_fraction = 1.0 - TrueProbability(builder.bdd(), load);
+    XLS_VLOG(2) << absl::StreamFormat(
+        "Inferred load enable for register %s (hold=%d, unobserved=%d), "
+        "estimated idle fraction %f",
+        condition.reg->name(), condition.not_hold.has_value(),
+        condition.observed.has_value(), idle_fraction);
+    InferredRegisterEnable inferred_enable;
+    inferred_enable.register_name = condition.reg->name();
+    inferred_enable.bit_count = condition.reg->type()->GetFlatBitCount();
+    inferred_enable.hold = condition.not_hold.has_value();
+    inferred_enable.unobserved = condition.observed.has_value();
+    inferred_enable.estimated_idle_fraction = idle_fraction;
+    unit->inferred_register_enables.push_back(inferred_enable);
+  }
+
+  return !inferred.empty();
+}
+
+}  // namespace xls::verilog
@@ -0,0 +1,64 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_CODEGEN_REGISTER_ENABLE_INFERENCE_PASS_H_
+#define XLS_CODEGEN_REGISTER_ENABLE_INFERENCE_PASS_H_
+
+#include "absl/status/statusor.h"
+#include "xls/codegen/codegen_pass.h"
+
+namespace xls::verilog {
+
+// Infers load enables for registers which need not be loaded in every cycle.
+// Two kinds of conditions are inferred:
+//
+// (1) Hold: the data input of the register is a select one or more of whose
+//     arms is (provably, using BDDs) equal to the current value of the
+//     register. For example:
+//
+//       state_write: register_write(sel(p, cases=[x, state_read]), ...)
+//
+//     The register need not be loaded when `p` is true. This pattern is common
+//     for state elements updated under a condition.
+//
+// (2) Unobserved: the value of the register is only used as a case of selects
+//     whose selector is itself a register loaded in the same cycles as this
+//     register. For example:
+//
+//       a_reg: register_write(a, load_enable=en)
+//       s_reg: register_write(s, load_enable=en)
+//       ... sel(s_reg_read, cases=[b, a_reg_read])
+//
+//     The register `a_reg` need only be loaded when `s` (the value to be
+//     loaded into the selector register) selects `a_reg`.
+//
+// The inferred predicate is AND-ed with any existing load enable. The pass is
+// enabled by CodegenOptions::infer_register_enables. Inferred enables are
+// recorded in the CodegenPassUnit along with an estimate (computed from the
+// BDD) of the fraction of cycles in which the register is no longer loaded.
+class RegisterEnableInferencePass : public CodegenPass {
+ public:
+  RegisterEnableInferencePass()
+      : CodegenPass("register_enable_inference",
+                    "Infer register load enables") {}
+  ~RegisterEnableInferencePass() override {}
+
+  absl::StatusOr<bool> RunInternal(CodegenPassUnit* unit,
+                                   const CodegenPassOptions& options,
+                                   PassResults* results) const override;
+};
+
+}  // namespace xls::verilog
+
+#endif  // XLS_CODEGEN_REGISTER_ENABLE_INFERENCE_PASS_H_
@@ -0,0 +1,227 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/codegen/register_enable_inference_pass.h"
+
+#include <random>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "xls/codegen/codegen_pass.h"
+#include "xls/common/status/matchers.h"
+#include "xls/interpreter/block_interpreter.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_matcher.h"
+#include "xls/ir/ir_test_base.h"
+
+namespace m = ::xls::op_matchers;
+
+namespace xls::verilog {
+namespace {
+
+using status_testing::IsOkAndHolds;
+
+class RegisterEnableInferencePassTest : public IrTestBase {
+ protected:
+  absl::StatusOr<bool> Run(Block* block, CodegenPassUnit* unit = nullptr) {
+    PassResults results;
+    CodegenPassOptions options;
+    options.codegen_options.infer_register_enables(true);
+    CodegenPassUnit local_unit(block->package(), block);
+    return RegisterEnableInferencePass().Run(
+        unit == nullptr ? &local_unit : unit, options, &results);
+  }
+
+  // Runs the pass on a clone of `block` and verifies that the original and
+  // transformed blocks produce the same outputs for random inputs.
+  void ExpectEquivalentAfterPass(Block* block) {
+    XLS_ASSERT_OK_AND_ASSIGN(Block * transformed,
+                             block->Clone(absl::StrCat(block->name(), "_t")));
+    XLS_ASSERT_OK_AND_ASSIGN(bool changed, Run(transformed));
+    EXPECT_TRUE(changed);
+
+    std::minstd_rand engine;
+    std::vector<absl::flat_hash_map<std::string, uint64_t>> inputs;
+    for (int64_t cycle = 0; cycle < 256; ++cycle) {
+      absl::flat_hash_map<std::string, uint64_t> cycle_inputs;
+      for (InputPort* port : block->GetInputPorts()) {
+        cycle_inputs[port->GetName()] =
+            engine() & Mask(port->GetType()->GetFlatBitCount());
+      }
+      inputs.push_back(cycle_inputs);
+    }
+    XLS_ASSERT_OK_AND_ASSIGN(auto expected,
+                             InterpretSequentialBlock(block, inputs));
+    XLS_ASSERT_OK_AND_ASSIGN(auto actual,
+                             InterpretSequentialBlock(transformed, inputs));
+    EXPECT_EQ(expected, actual);
+  }
+
+  static uint64_t Mask(int64_t width) {
+    return width >= 64 ? ~uint64_t{0} : (uint64_t{1} << width) - 1;
+  }
+};
+
+TEST_F(RegisterEnableInferencePassTest, DisabledByDefault) {
+  auto p = CreatePackage();
+  BlockBuilder bb(TestName(), p.get());
+  XLS_ASSERT_OK(bb.block()->AddClockPort("clk"));
+  BValue c = bb.InputPort("c", p->GetBitsType(1));
+  BValue x = bb.InputPort("x", p->GetBitsType(32));
+  XLS_ASSERT_OK_AND_ASSIGN(Register * reg,
+                           bb.block()->AddRegister("state", x.GetType()));
+  BValue state = bb.RegisterRead(reg);
+  bb.RegisterWrite(reg, bb.Select(c, {state, x}));
+  bb.OutputPort("out", state);
+  XLS_ASSERT_OK_AND_ASSIGN(Block * block, bb.Build());
+
+  PassResults results;
+  CodegenPassUnit unit(block->package(), block);
+  EXPECT_THAT(
+      RegisterEnableInferencePass().Run(&unit, CodegenPassOptions(), &results),
+      IsOkAndHolds(false));
+}
+
+TEST_F(RegisterEnableInferencePassTest, HoldStateRegister) {
+  auto p = CreatePackage();
+  BlockBuilder bb(TestName(), p.get());
+  XLS_ASSERT_OK(bb.block()->AddClockPort("clk"));
+  BValue c = bb.InputPort("c", p->GetBitsType(1));
+  BValue x = bb.InputPort("x", p->GetBitsType(32));
+  XLS_ASSERT_OK_AND_ASSIGN(Register * reg,
+                           bb.block()->AddRegister("state", x.GetType()));
+  BValue state = bb.RegisterRead(reg);
+  bb.RegisterWrite(reg, bb.Select(c, {state, x}));
+  bb.OutputPort("out", state);
+  XLS_ASSERT_OK_AND_ASSIGN(Block * block, bb.Build());
+
+  ExpectEquivalentAfterPass(block);
+
+  CodegenPassUnit unit(block->package(), block);
+  EXPECT_THAT(Run(block, &unit), IsOkAndHolds(true));
+  XLS_ASSERT_OK_AND_ASSIGN(RegisterWrite * reg_write,
+                           block->GetRegisterWrite(reg));
+  ASSERT_TRUE(reg_write->load_enable().has_value());
+  EXPECT_THAT(reg_write->load_enable().value(), m::InputPort("c"));
+
+  ASSERT_EQ(unit.inferred_register_enables.size(), 1);
+  EXPECT_EQ(unit.inferred_register_enables[0].register_name, "state");
+  EXPECT_EQ(unit.inferred_register_enables[0].bit_count, 32);
+  EXPECT_TRUE(unit.inferred_register_enables[0].hold);
+  EXPECT_FALSE(unit.inferred_register_enables[0].unobserved);
+  EXPECT_DOUBLE_EQ(unit.inferred_register_enables[0].estimated_idle_fraction,
+                   0.5);
+
+  // Pass should be idempotent.
+  EXPECT_THAT(Run(block), IsOkAndHolds(false));
+}
+
+TEST_F(RegisterEnableInferencePassTest, HoldWithExistingLoadEnable) {
+  auto p = CreatePackage();
+  BlockBuilder bb(TestName(), p.get());
+  XLS_ASSERT_OK(bb.block()->AddClockPort("clk"));
+  BValue en = bb.InputPort("en", p->GetBitsType(1));
+  BValue s = bb.InputPort("s", p->GetBitsType(2));
+  BValue x = bb.InputPort("x", p->GetBitsType(16));
+  BValue y = bb.InputPort("y", p->GetBitsType(16));
+  XLS_ASSERT_OK_AND_ASSIGN(Register * reg,
+                           bb.block()->AddRegister("state", x.GetType()));
+  BValue state = bb.RegisterRead(reg);
+  // The hold arm is a bitwise-equivalent rearrangement of the register value
+  // which is detected using BDDs.
+  BValue same_state = bb.Concat({bb.BitSlice(state, 8, 8),
+                                 bb.BitSlice(state, 0, 8)});
+  bb.RegisterWrite(reg, bb.Select(s, {x, same_state, y}, /*default=*/state),
+                   /*load_enable=*/en);
+  bb.OutputPort("out", state);
+  XLS_ASSERT_OK_AND_ASSIGN(Block * block, bb.Build());
+
+  ExpectEquivalentAfterPass(block);
+
+  CodegenPassUnit unit(block->package(), block);
+  EXPECT_THAT(Run(block, &unit), IsOkAndHolds(true));
+  XLS_ASSERT_OK_AND_ASSIGN(RegisterWrite * reg_write,
+                           block->GetRegisterWrite(reg));
+  ASSERT_TRUE(reg_write->load_enable().has_value());
+  EXPECT_THAT(reg_write->load_enable().value(),
+              m::And(m::InputPort("en"), m::Or(m::Eq(), m::Eq())));
+  ASSERT_EQ(unit.inferred_register_enables.size(), 1);
+  EXPECT_DOUBLE_EQ(unit.inferred_register_enables[0].estimated_idle_fraction,
+                   0.5);
+}
+
+TEST_F(RegisterEnableInferencePassTest, UnobservedPipelineRegister) {
+  auto p = CreatePackage();
+  BlockBuilder bb(TestName(), p.get());
+  XLS_ASSERT_OK(bb.block()->AddClockPort("clk"));
+  BValue en = bb.InputPort("en", p->GetBitsType(1));
+  BValue s = bb.InputPort("s", p->GetBitsType(1));
+  BValue a = bb.InputPort("a", p->GetBitsType(32));
+  BValue b = bb.InputPort("b", p->GetBitsType(32));
+  BValue s_reg = bb.InsertRegister("s_reg", s, /*load_enable=*/en);
+  BValue a_reg = bb.InsertRegister("a_reg", a, /*load_enable=*/en);
+  BValue b_reg = bb.InsertRegister("b_reg", b, /*load_enable=*/en);
+  bb.OutputPort("out", bb.Select(s_reg, {a_reg, b_reg}));
+  XLS_ASSERT_OK_AND_ASSIGN(Block * block, bb.Build());
+
+  ExpectEquivalentAfterPass(block);
+
+  CodegenPassUnit unit(block->package(), block);
+  EXPECT_THAT(Run(block, &unit), IsOkAndHolds(true));
+  XLS_ASSERT_OK_AND_ASSIGN(RegisterWrite * a_write,
+                           block->GetRegisterWrite(
+                               block->GetRegister("a_reg").value()));
+  XLS_ASSERT_OK_AND_ASSIGN(RegisterWrite * b_write,
+                           block->GetRegisterWrite(
+                               block->GetRegister("b_reg").value()));
+  XLS_ASSERT_OK_AND_ASSIGN(RegisterWrite * s_write,
+                           block->GetRegisterWrite(
+                               block->GetRegister("s_reg").value()));
+  EXPECT_THAT(a_write->load_enable().value(),
+              m::And(m::InputPort("en"), m::Not(m::InputPort("s"))));
+  EXPECT_THAT(b_write->load_enable().value(),
+              m::And(m::InputPort("en"), m::InputPort("s")));
+  EXPECT_THAT(s_write->load_enable().value(), m::InputPort("en"));
+
+  EXPECT_EQ(unit.inferred_register_enables.size(), 2);
+  for (const InferredRegisterEnable& enable : unit.inferred_register_enables) {
+    EXPECT_TRUE(enable.unobserved);
+    EXPECT_FALSE(enable.hold);
+    EXPECT_DOUBLE_EQ(enable.estimated_idle_fraction, 0.5);
+  }
+}
+
+TEST_F(RegisterEnableInferencePassTest, ObservedElsewhereIsNotGated) {
+  auto p = CreatePackage();
+  BlockBuilder bb(TestName(), p.get());
+  XLS_ASSERT_OK(bb.block()->AddClockPort("clk"));
+  BValue en = bb.InputPort("en", p->GetBitsType(1));
+  BValue other_en = bb.InputPort("other_en", p->GetBitsType(1));
+  BValue s = bb.InputPort("s", p->GetBitsType(1));
+  BValue a = bb.InputPort("a", p->GetBitsType(32));
+  BValue b = bb.InputPort("b", p->GetBitsType(32));
+  // The selector register is loaded under a different enable.
+  BValue s_reg = bb.InsertRegister("s_reg", s, /*load_enable=*/other_en);
+  BValue a_reg = bb.InsertRegister("a_reg", a, /*load_enable=*/en);
+  BValue b_reg = bb.InsertRegister("b_reg", b, /*load_enable=*/en);
+  bb.OutputPort("out", bb.Select(s_reg, {a_reg, b_reg}));
+  // The value of b_reg is also directly observable.
+  bb.OutputPort("b_out", b_reg);
+  XLS_ASSERT_OK_AND_ASSIGN(Block * block, bb.Build());
+
+  EXPECT_THAT(Run(block), IsOkAndHolds(false));
+}
+
+}  // namespace
+}  // namespace xls::verilog
@@ -14,7 +14,9 @@
 
 #include "xls/data_structures/binary_decision_diagram.h"
 
+#include <algorithm>
 #include <limits>
+#include <vector>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -26,8 +28,33 @@
 #include "xls/common/logging/vlog_is_on.h"
 
 namespace xls {
+namespace {
 
-BinaryDecisionDiagram::BinaryDecisionDiagram() {
+// Minimum size of the BDD before ShouldSift returns true. Sifting small BDDs
+// is not worth the time.
+constexpr int64_t kMinSiftThreshold = 4096;
+
+// Sifting stops moving a variable in one direction once the BDD grows beyond
+// this factor of the best size found.
+constexpr double kMaxSiftGrowth = 1.2;
+
+// Maximum number of variables sifted in each call to Sift. The variables with
+// the most nodes are sifted first.
+constexpr int64_t kMaxSiftedVariables = 64;
+
+// Maximum number of level swaps in each call to Sift.
+constexpr int64_t kMaxSiftSwaps = 200000;
+
+// Saturating sum of path counts.
+int32_t AddPathCounts(int32_t a, int32_t b) {
+  return std::min(static_cast<int64_t>(a) + b,
+                  static_cast<int64_t>(std::numeric_limits<int32_t>::max()));
+}
+
+}  // namespace
+
+BinaryDecisionDiagram::BinaryDecisionDiagram()
+    : sift_threshold_(kMinSiftThreshold) {
   // Leaf node 0.
   nodes_.push_back(BddNode(BddVariable(-1), BddNodeIndex(-1), BddNodeIndex(-1),
                            /*p=*/1));
@@ -49,11 +76,17 @@ BddNodeIndex BinaryDecisionDiagram::GetOrCreateNode(BddVariable var,
   }
   // Compute the number of paths that the new node will have to the terminal
   // nodes 0 and 1. Use int64s to avoid overflowing and saturate at INT32_MAX.
-  int32_t paths = std::min(
-      static_cast<int64_t>(GetNode(low).path_count) + GetNode(high).path_count,
-      static_cast<int64_t>(std::numeric_limits<int32_t>::max()));
-  nodes_.emplace_back(var, high, low, paths);
-  BddNodeIndex node_index = BddNodeIndex(nodes_.size() - 1);
+  int32_t paths =
+      AddPathCounts(GetNode(low).path_count, GetNode(high).path_count);
+  BddNodeIndex node_index;
+  if (!free_nodes_.empty() && !sifting_) {
+    node_index = free_nodes_.back();
+    free_nodes_.pop_back();
+    nodes_[node_index.value()] = BddNode(var, high, low, paths);
+  } else {
+    nodes_.emplace_back(var, high, low, paths);
+    node_index = BddNodeIndex(nodes_.size() - 1);
+  }
   node_map_[key] = node_index;
   return node_index;
 }
@@ -65,7 +98,7 @@ BddNodeIndex BinaryDecisionDiagram::Restrict(BddNodeIndex expr, BddVariable var,
   }
 
   const BddNode& node = GetNode(expr);
-  XLS_CHECK_LE(var, node.variable);
+  XLS_CHECK_LE(GetVariableLevel(var), GetVariableLevel(node.variable));
   if (node.variable == var) {
     return value ? node.high : node.low;
   }
@@ -97,15 +130,17 @@ BddNodeIndex BinaryDecisionDiagram::IfThenElse(BddNodeIndex cond,
   // decompose the expression by peeling away the first variable and performing
   // a Shannon decomposition.
 
-  // First, find the lowest-index variable amongst all expressions. In all paths
-  // through the BDD the variable indices are strictly increasing.
+  // First, find the lowest-level variable amongst all expressions. In all
+  // paths through the BDD the variable levels are strictly increasing.
   BddVariable min_var = GetNode(cond).variable;
   // Only non-leaf nodes (not zero or one) have associated variables.
-  if (if_true != zero() && if_true != one()) {
-    min_var = std::min(min_var, GetNode(if_true).variable);
+  if (if_true != zero() && if_true != one() &&
+      GetNodeLevel(if_true) < GetVariableLevel(min_var)) {
+    min_var = GetNode(if_true).variable;
   }
-  if (if_false != zero() && if_false != one()) {
-    min_var = std::min(min_var, GetNode(if_false).variable);
+  if (if_false != zero() && if_false != one() &&
+      GetNodeLevel(if_false) < GetVariableLevel(min_var)) {
+    min_var = GetNode(if_false).variable;
   }
 
   // Perform a Shannon expansion about the variable where Shannon expansion is
@@ -132,6 +167,9 @@ BddNodeIndex BinaryDecisionDiagram::IfThenElse(BddNodeIndex cond,
 BddNodeIndex BinaryDecisionDiagram::NewVariable() {
   BddVariable var = next_var_;
   ++next_var_;
+  // New variables are placed at the bottom of the order.
+  variable_levels_.push_back(level_variables_.size());
+  level_variables_.push_back(var);
   return GetOrCreateNode(var, one(), zero());
 }
 
@@ -147,6 +185,227 @@ BddNodeIndex BinaryDecisionDiagram::And(BddNodeIndex a, BddNodeIndex b) {
   return IfThenElse(a, b, zero());
 }
 
+BddNodeIndex BinaryDecisionDiagram::GetOrCreateSiftNode(BddVariable var,
+                                                        BddNodeIndex high,
+                                                        BddNodeIndex low) {
+  if (high == low) {
+    ++ref_counts_[high.value()];
+    return high;
+  }
+  auto it = node_map_.find(std::make_tuple(var, high, low));
+  if (it != node_map_.end()) {
+    ++ref_counts_[it->second.value()];
+    return it->second;
+  }
+  BddNodeIndex node = GetOrCreateNode(var, high, low);
+  XLS_CHECK_EQ(node.value(), ref_counts_.size());
+  ref_counts_.push_back(1);
+  ++ref_counts_[high.value()];
+  ++ref_counts_[low.value()];
+  level_nodes_[GetVariableLevel(var)].push_back(node);
+  return node;
+}
+
+void BinaryDecisionDiagram::Dereference(BddNodeIndex expr) {
+  if (expr == zero() || expr == one() || --ref_counts_[expr.value()] > 0) {
+    return;
+  }
+  BddNode node = GetNode(expr);
+  node_map_.erase(std::make_tuple(node.variable, node.high, node.low));
+  nodes_[expr.value()] = BddNode(BddVariable(-1), BddNodeIndex(-1),
+                                 BddNodeIndex(-1), /*p=*/0);
+  free_nodes_.push_back(expr);
+  Dereference(node.high);
+  Dereference(node.low);
+}
+
+void BinaryDecisionDiagram::SwapLevels(int64_t level) {
+  BddVariable x = level_variables_[level];
+  BddVariable y = level_variables_[level + 1];
+  std::vector<BddNodeIndex> x_nodes = std::move(level_nodes_[level]);
+  std::vector<BddNodeIndex> y_nodes = std::move(level_nodes_[level + 1]);
+  level_nodes_[level].clear();
+  level_nodes_[level + 1].clear();
+  level_variables_[level] = y;
+  level_variables_[level + 1] = x;
+  variable_levels_[y.value()] = level;
+  variable_levels_[x.value()] = level + 1;
+
+  auto has_variable = [&](BddNodeIndex expr, BddVariable var) {
+    return expr != zero() && expr != one() && GetNode(expr).variable == var;
+  };
+  // Nodes of `x` which do not depend on `y` simply move down a level. The
+  // others are rewritten in place as nodes of `y` with children of `x` so the
+  // node index keeps its expression:
+  //
+  //   x ? (y ? f11 : f10) : (y ? f01 : f00)
+  //     = y ? (x ? f11 : f01) : (x ? f10 : f00)
+  //
+  for (BddNodeIndex f : x_nodes) {
+    // Skip nodes which were garbage collected.
+    if (!has_variable(f, x)) {
+      continue;
+    }
+    BddNode node = GetNode(f);
+    bool high_has_y = has_variable(node.high, y);
+    bool low_has_y = has_variable(node.low, y);
+    if (!high_has_y && !low_has_y) {
+      level_nodes_[level + 1].push_back(f);
+      continue;
+    }
+    BddNodeIndex f11 = high_has_y ? GetNode(node.high).high : node.high;
+    BddNodeIndex f10 = high_has_y ? GetNode(node.high).low : node.high;
+    BddNodeIndex f01 = low_has_y ? GetNode(node.low).high : node.low;
+    BddNodeIndex f00 = low_has_y ? GetNode(node.low).low : node.low;
+    BddNodeIndex new_high = GetOrCreateSiftNode(x, f11, f01);
+    BddNodeIndex new_low = GetOrCreateSiftNode(x, f10, f00);
+    node_map_.erase(std::make_tuple(x, node.high, node.low));
+    nodes_[f.value()] = BddNode(y, new_high, new_low, node.path_count);
+    node_map_[std::make_tuple(y, new_high, new_low)] = f;
+    level_nodes_[level].push_back(f);
+    Dereference(node.high);
+    Dereference(node.low);
+  }
+  for (BddNodeIndex g : y_nodes) {
+    if (has_variable(g, y)) {
+      level_nodes_[level].push_back(g);
+    }
+  }
+  ++swap_count_;
+}
+
+void BinaryDecisionDiagram::SiftVariable(BddVariable variable) {
+  int64_t level = GetVariableLevel(variable);
+  int64_t best_level = level;
+  int64_t best_size = size();
+  auto record_size = [&]() {
+    if (size() < best_size) {
+      best_size = size();
+      best_level = level;
+    }
+    return size() <= kMaxSiftGrowth * best_size &&
+           swap_count_ < kMaxSiftSwaps;
+  };
+  // Move the variable to the bottom, then to the top, stopping early if the
+  // BDD grows too much. Then move it to the best level seen.
+  while (level + 1 < level_variables_.size()) {
+    SwapLevels(level);
+    ++level;
+    if (!record_size()) {
+      break;
+    }
+  }
+  while (level > 0) {
+    SwapLevels(level - 1);
+    --level;
+    if (!record_size()) {
+      break;
+    }
+  }
+  while (level < best_level) {
+    SwapLevels(level);
+    ++level;
+  }
+  while (level > best_level) {
+    SwapLevels(level - 1);
+    --level;
+  }
+}
+
+void BinaryDecisionDiagram::Sift(absl::Span<const BddNodeIndex> roots) {
+  int64_t size_before = size();
+
+  // Count the references to each node from the roots and other live nodes.
+  // The variable base nodes are always live.
+  ref_counts_.assign(nodes_.size(), 0);
+  std::vector<bool> live(nodes_.size(), false);
+  live[zero().value()] = true;
+  live[one().value()] = true;
+  std::vector<BddNodeIndex> worklist(roots.begin(), roots.end());
+  for (BddVariable var(0); var < next_var_; ++var) {
+    worklist.push_back(GetVariableBaseNode(var));
+  }
+  for (BddNodeIndex root : worklist) {
+    ++ref_counts_[root.value()];
+  }
+  while (!worklist.empty()) {
+    BddNodeIndex expr = worklist.back();
+    worklist.pop_back();
+    if (live[expr.value()]) {
+      continue;
+    }
+    live[expr.value()] = true;
+    for (BddNodeIndex child : {GetNode(expr).high, GetNode(expr).low}) {
+      ++ref_counts_[child.value()];
+      worklist.push_back(child);
+    }
+  }
+
+  // Garbage collect the dead nodes. The memoized if-then-else results may
+  // refer to them.
+  ite_map_.clear();
+  level_nodes_.assign(level_variables_.size(), {});
+  for (int64_t i = 2; i < nodes_.size(); ++i) {
+    const BddNode& node = nodes_[i];
+    if (node.variable == BddVariable(-1)) {
+      // Already free.
+      continue;
+    }
+    if (live[i]) {
+      level_nodes_[GetVariableLevel(node.variable)].push_back(BddNodeIndex(i));
+      continue;
+    }
+    node_map_.erase(std::make_tuple(node.variable, node.high, node.low));
+    nodes_[i] = BddNode(BddVariable(-1), BddNodeIndex(-1), BddNodeIndex(-1),
+                        /*p=*/0);
+    free_nodes_.push_back(BddNodeIndex(i));
+  }
+  int64_t size_after_gc = size();
+
+  // Sift the variables with the most nodes first.
+  sifting_ = true;
+  swap_count_ = 0;
+  std::vector<BddVariable> variables(level_variables_.begin(),
+                                     level_variables_.end());
+  std::vector<int64_t> variable_sizes(variables.size());
+  for (int64_t level = 0; level < level_variables_.size(); ++level) {
+    variable_sizes[level_variables_[level].value()] =
+        level_nodes_[level].size();
+  }
+  std::stable_sort(variables.begin(), variables.end(),
+                   [&](BddVariable a, BddVariable b) {
+                     return variable_sizes[a.value()] >
+                            variable_sizes[b.value()];
+                   });
+  for (int64_t i = 0; i < variables.size() && i < kMaxSiftedVariables &&
+                      swap_count_ < kMaxSiftSwaps;
+       ++i) {
+    SiftVariable(variables[i]);
+  }
+  sifting_ = false;
+
+  // Recompute the path counts bottom-up in the new order.
+  for (int64_t level = level_nodes_.size() - 1; level >= 0; --level) {
+    for (BddNodeIndex expr : level_nodes_[level]) {
+      BddNode& node = nodes_[expr.value()];
+      if (node.variable != level_variables_[level]) {
+        // Garbage collected.
+        continue;
+      }
+      node.path_count = AddPathCounts(GetNode(node.high).path_count,
+                                      GetNode(node.low).path_count);
+    }
+  }
+  ref_counts_.clear();
+  level_nodes_.clear();
+
+  sift_threshold_ = std::max(kMinSiftThreshold, 2 * size());
+  XLS_VLOG(1) << absl::StreamFormat(
+      "Sifted BDD with %d variables: %d nodes, %d after garbage collection, %d "
+      "after sifting (%d swaps)",
+      variable_count(), size_before, size_after_gc, size(), swap_count_);
+}
+
 absl::StatusOr<bool> BinaryDecisionDiagram::Evaluate(
     BddNodeIndex expr,
     const absl::flat_hash_map<BddNodeIndex, bool>& variable_values) const {
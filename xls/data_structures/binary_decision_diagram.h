@@ -16,9 +16,11 @@
 #define XLS_DATA_STRUCTURES_BINARY_DECISION_DIAGRAM_H_
 
 #include <cstdint>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/statusor.h"
+#include "absl/types/span.h"
 #include "xls/common/strong_int.h"
 
 namespace xls {
@@ -31,9 +33,18 @@ namespace xls {
 //   K.S. Brace, R.L. Rudell, and R.E. Bryant,
 //   "Efficient Implementation of a BDD package"
 //   https://ieeexplore.ieee.org/document/114826
+//
+// Variables are ordered by level. Initially the level of a variable is its
+// creation order. The order can be changed by dynamic reordering with Sift:
+//   R. Rudell, "Dynamic variable ordering for ordered binary decision
+//   diagrams"
+//   https://ieeexplore.ieee.org/document/580029
 
 // For efficiency variables and nodes are referred to by indices into vector
-// data members in the BDD.
+// data members in the BDD. Node indices are not topologically ordered: sifting
+// rewrites nodes in place to refer to newly created children and the indices of
+// garbage-collected nodes are reused, so a child may have a larger index than
+// its parent. Traverse from the roots to visit children before parents.
 DEFINE_STRONG_INT_TYPE(BddVariable, int32_t);
 DEFINE_STRONG_INT_TYPE(BddNodeIndex, int32_t);
 
@@ -90,11 +101,35 @@ class BinaryDecisionDiagram {
   }
 
   // Returns the number of nodes in the graph.
-  int64_t size() const { return nodes_.size(); }
+  int64_t size() const { return nodes_.size() - free_nodes_.size(); }
+
+  // Returns one past the largest node index in the graph. Node indices below
+  // this value which have been garbage collected by Sift have a path count of
+  // zero.
+  int64_t index_limit() const { return nodes_.size(); }
 
   // Returns the number of variables in the graph.
   int64_t variable_count() const { return next_var_.value(); }
 
+  // Returns the level of the given variable in the variable order. In all
+  // paths through the BDD the levels are strictly increasing.
+  int64_t GetVariableLevel(BddVariable variable) const {
+    return variable_levels_.at(variable.value());
+  }
+
+  // Returns true if the BDD has grown enough since the last call to Sift that
+  // it should be reordered.
+  bool ShouldSift() const { return size() >= sift_threshold_; }
+
+  // Reorders the variables to reduce the number of nodes in the BDD using
+  // Rudell's sifting algorithm: each variable in turn is moved through the
+  // order by swapping adjacent levels and is left at the level which minimizes
+  // the BDD size. Every node reachable from `roots` continues to represent the
+  // same expression and keeps its index; all other nodes (other than the
+  // variable base nodes) are garbage collected and their indices may be
+  // reused. Path counts are recomputed for the new order.
+  void Sift(absl::Span<const BddNodeIndex> roots);
+
   // Returns the number of paths in the given expression.
   int64_t path_count(BddNodeIndex expr) const {
     return GetNode(expr).path_count;
@@ -136,10 +171,49 @@ class BinaryDecisionDiagram {
     return node_map_.at({variable, one(), zero()});
   }
 
+  // Returns the level of the variable of the given non-leaf node.
+  int64_t GetNodeLevel(BddNodeIndex expr) const {
+    return GetVariableLevel(GetNode(expr).variable);
+  }
+
+  // Helpers for Sift. Swaps the variables at levels `level` and `level + 1`.
+  void SwapLevels(int64_t level);
+
+  // Moves `variable` through the order and leaves it at the best level found.
+  void SiftVariable(BddVariable variable);
+
+  // Like GetOrCreateNode but adds a reference to the returned node and records
+  // new nodes in `level_nodes_`. Only used during sifting.
+  BddNodeIndex GetOrCreateSiftNode(BddVariable var, BddNodeIndex high,
+                                   BddNodeIndex low);
+
+  // Removes a reference to the given node during sifting. Nodes without
+  // references are garbage collected.
+  void Dereference(BddNodeIndex expr);
+
   // The numeric id to use for the next created variable. Increments with each
   // call to NewVariable which
   BddVariable next_var_ = BddVariable(0);
 
+  // The level of each variable, indexed by variable, and the variable at each
+  // level.
+  std::vector<int64_t> variable_levels_;
+  std::vector<BddVariable> level_variables_;
+
+  // Indices of garbage collected nodes which can be reused for new nodes.
+  std::vector<BddNodeIndex> free_nodes_;
+
+  // Size of the BDD at which ShouldSift returns true.
+  int64_t sift_threshold_;
+
+  // State used during sifting: the number of references to each node from
+  // other live nodes and the roots, the nodes at each level, and the number of
+  // level swaps performed.
+  bool sifting_ = false;
+  std::vector<int32_t> ref_counts_;
+  std::vector<std::vector<BddNodeIndex>> level_nodes_;
+  int64_t swap_count_ = 0;
+
   // The vector of all the nodes in the BDD.
   std::vector<BddNode> nodes_;
 
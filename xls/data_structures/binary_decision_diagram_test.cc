@@ -306,5 +306,72 @@ TEST(BinaryDecisionDiagramTest, ThreeVariableExhaustive) {
   }
 }
 
+TEST(BinaryDecisionDiagramTest, SiftPairwiseAnd) {
+  // The BDD of (a0 & b0) | (a1 & b1) | ... is exponential in size if all of
+  // the `a` variables are ordered before the `b` variables and linear if they
+  // are interleaved.
+  const int64_t kPairs = 8;
+  BinaryDecisionDiagram bdd;
+  std::vector<BddNodeIndex> a;
+  std::vector<BddNodeIndex> b;
+  for (int64_t i = 0; i < kPairs; ++i) {
+    a.push_back(bdd.NewVariable());
+  }
+  for (int64_t i = 0; i < kPairs; ++i) {
+    b.push_back(bdd.NewVariable());
+  }
+  BddNodeIndex expr = bdd.zero();
+  for (int64_t i = 0; i < kPairs; ++i) {
+    expr = bdd.Or(expr, bdd.And(a[i], b[i]));
+  }
+  int64_t size_before = bdd.size();
+  EXPECT_GT(size_before, 1 << kPairs);
+
+  bdd.Sift({expr});
+  // Variable base nodes, one node for each `a` and `b` variable in the
+  // expression, and the leaves.
+  EXPECT_LE(bdd.size(), 4 * kPairs + 2);
+  EXPECT_EQ(bdd.path_count(expr), (1 << kPairs) * 2 - 1);
+
+  // The node index of the expression still represents the same expression
+  // and new expressions may be built after reordering.
+  BddNodeIndex not_expr = bdd.Not(expr);
+  for (int64_t value = 0; value < (1 << (2 * kPairs)); value += 37) {
+    absl::flat_hash_map<BddNodeIndex, bool> values;
+    bool expected = false;
+    for (int64_t i = 0; i < kPairs; ++i) {
+      bool a_value = (value >> i) & 1;
+      bool b_value = (value >> (i + kPairs)) & 1;
+      values[a[i]] = a_value;
+      values[b[i]] = b_value;
+      expected = expected || (a_value && b_value);
+    }
+    EXPECT_THAT(bdd.Evaluate(expr, values), IsOkAndHolds(expected));
+    EXPECT_THAT(bdd.Evaluate(not_expr, values), IsOkAndHolds(!expected));
+  }
+}
+
+TEST(BinaryDecisionDiagramTest, SiftGarbageCollects) {
+  BinaryDecisionDiagram bdd;
+  BddNodeIndex x0 = bdd.NewVariable();
+  BddNodeIndex x1 = bdd.NewVariable();
+  BddNodeIndex x2 = bdd.NewVariable();
+  BddNodeIndex kept = bdd.And(x0, x1);
+  bdd.Or(bdd.And(x0, x2), bdd.Not(x1));
+  int64_t size_before = bdd.size();
+
+  bdd.Sift({kept});
+  EXPECT_LT(bdd.size(), size_before);
+  EXPECT_THAT(bdd.Evaluate(kept, {{x0, true}, {x1, true}, {x2, false}}),
+              IsOkAndHolds(true));
+  EXPECT_THAT(bdd.Evaluate(kept, {{x0, true}, {x1, false}, {x2, true}}),
+              IsOkAndHolds(false));
+
+  // Garbage collected node indices are reused.
+  int64_t index_limit = bdd.index_limit();
+  bdd.Or(bdd.And(x0, x2), bdd.Not(x1));
+  EXPECT_EQ(bdd.index_limit(), index_limit);
+}
+
 }  // namespace
 }  // namespace xls
@@ -14,10 +14,10 @@
 
 #include "xls/data_structures/min_cut.h"
 
-#include <deque>
-#include <set>
+#include <algorithm>
+#include <limits>
+#include <vector>
 
-#include "absl/container/flat_hash_set.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
@@ -87,74 +87,85 @@ std::string Graph::ToString() const {
 
 namespace {
 
-// Struct representing an edge in the residual graph.
-struct ResidualEdge {
-  NodeId from;
-  NodeId to;
-  int64_t capacity;
-
-  // The id of the other edge of the forward/backward pair of edges created in
-  // the residual graph for each edge in the original graph.
-  EdgeId dual_edge;
-};
-
 // Data structure representing the residual graph. The residual graph is a data
 // structure used in the min-cut algorithm which mirrors the input graph. The
 // nodes in the two graphs are identical, but each edge in the input graph
-// corresponds to two edges in the residual graph: one edge aligned with the
-// original edge and one edge in the backwards direction. Each residual edge has
+// corresponds to two arcs in the residual graph: one arc aligned with the
+// original edge and one arc in the backwards direction. Each residual arc has
 // a capacity which is a function of the original edge weight and the current
 // flow along the edge.
+//
+// The arcs are stored in compressed sparse row (CSR) form: the arcs extending
+// from node `n` are the indices [first_arc(n), first_arc(n + 1)) of flat
+// arrays. This keeps the inner loops of the max-flow computation over
+// contiguous memory.
 class ResidualGraph {
  public:
-  ResidualGraph(const Graph& graph) {
-    // There are exactly twice as many edges in the residual graph because each
-    // edge in the original graph maps to a forward and backward edge in the
-    // residual graph. The forward edge in the original graph has the same
-    // EdgeId as its corresponding edge in the original graph.
-    edges_.resize(graph.edge_count() * 2);
-    successors_.resize(graph.node_count());
+  explicit ResidualGraph(const Graph& graph) {
+    int64_t node_count = graph.node_count();
+    int64_t arc_count = 2 * graph.edge_count();
+    first_arc_.assign(node_count + 1, 0);
     for (EdgeId edge_id = EdgeId{0}; edge_id <= graph.max_edge_id();
          edge_id += EdgeId{1}) {
       const Edge& edge = graph.edge(edge_id);
-      EdgeId backward_edge_id{int64_t{edge_id} + graph.edge_count()};
-
-      // Add the forward edge to the residual graph. It has an inital capacity
-      // equal to the weight of the edge in the original graph.
-      edges_[int64_t{edge_id}] =
-          ResidualEdge{edge.from, edge.to, edge.weight, backward_edge_id};
-      successors_[int64_t{edge.from}].push_back(edge_id);
+      ++first_arc_[int64_t{edge.from} + 1];
+      ++first_arc_[int64_t{edge.to} + 1];
+    }
+    for (int64_t i = 0; i < node_count; ++i) {
+      first_arc_[i + 1] += first_arc_[i];
+    }
 
-      // Add the backward edge to the residual graph. It has an inital capacity
+    to_.resize(arc_count);
+    capacity_.resize(arc_count);
+    dual_.resize(arc_count);
+    forward_arc_.resize(graph.edge_count());
+    std::vector<int64_t> next_arc(first_arc_.begin(), first_arc_.end() - 1);
+    for (EdgeId edge_id = EdgeId{0}; edge_id <= graph.max_edge_id();
+         edge_id += EdgeId{1}) {
+      const Edge& edge = graph.edge(edge_id);
+      int64_t forward = next_arc[int64_t{edge.from}]++;
+      int64_t backward = next_arc[int64_t{edge.to}]++;
+      // The forward arc has an initial capacity equal to the weight of the
+      // edge in the original graph. The backward arc has an initial capacity
       // of zero.
-      edges_[int64_t{backward_edge_id}] =
-          ResidualEdge{edge.to, edge.from, 0, edge_id};
-      successors_[int64_t{edge.to}].push_back(backward_edge_id);
+      to_[forward] = int64_t{edge.to};
+      capacity_[forward] = edge.weight;
+      dual_[forward] = backward;
+      to_[backward] = int64_t{edge.from};
+      capacity_[backward] = 0;
+      dual_[backward] = forward;
+      forward_arc_[int64_t{edge_id}] = forward;
     }
   }
 
-  // Returns the edges extended from the given node.
-  absl::Span<const EdgeId> successors(NodeId node) const {
-    return successors_[int64_t{node}];
-  }
+  int64_t node_count() const { return first_arc_.size() - 1; }
+
+  // The arcs extending from `node` are [first_arc(node), first_arc(node + 1)).
+  int64_t first_arc(int64_t node) const { return first_arc_[node]; }
+
+  int64_t to(int64_t arc) const { return to_[arc]; }
+  int64_t capacity(int64_t arc) const { return capacity_[arc]; }
 
-  // Push flow along the given edge. The capacity of this edge is reduced and
-  // the capacity of the dual edge is increased.
-  void PushFlow(int64_t amount, ResidualEdge* residual_edge) {
-    XLS_CHECK_GE(residual_edge->capacity, amount);
-    residual_edge->capacity -= amount;
-    edge(residual_edge->dual_edge).capacity += amount;
+  // Returns the arc in the residual graph aligned with the given edge of the
+  // original graph.
+  int64_t forward_arc(EdgeId edge_id) const {
+    return forward_arc_[int64_t{edge_id}];
   }
 
-  const ResidualEdge& edge(EdgeId id) const { return edges_[int64_t{id}]; }
-  ResidualEdge& edge(EdgeId id) { return edges_[int64_t{id}]; }
+  // Push flow along the given arc. The capacity of this arc is reduced and the
+  // capacity of the dual arc is increased.
+  void PushFlow(int64_t amount, int64_t arc) {
+    XLS_DCHECK_GE(capacity_[arc], amount);
+    capacity_[arc] -= amount;
+    capacity_[dual_[arc]] += amount;
+  }
 
  private:
-  // The set of all edges in the graph. The vector is indexed by EdgeId.
-  std::vector<ResidualEdge> edges_;
-
-  // Edges extending from each node. Outer vector is indexed by NodeId.
-  std::vector<std::vector<EdgeId>> successors_;
+  std::vector<int64_t> first_arc_;
+  std::vector<int64_t> to_;
+  std::vector<int64_t> capacity_;
+  std::vector<int64_t> dual_;
+  std::vector<int64_t> forward_arc_;
 };
 
 // Returns a string representation of the graph which includes residual capacity
@@ -170,145 +181,181 @@ std::string GraphWithFlowToString(const Graph& graph,
               const Edge& e = graph.edge(e_id);
               absl::StrAppendFormat(
                   out, "%s[%d/%d]", graph.name(e.to),
-                  e.weight - residual_graph.edge(e_id).capacity, e.weight);
+                  e.weight -
+                      residual_graph.capacity(residual_graph.forward_arc(e_id)),
+                  e.weight);
             }));
   }
   return out;
 }
 
-// Finds an augmenting path from source to sink in the graph (path of edges with
-// non-zero residual capacity) and increases the flow along each edge in the
-// path. The amount of flow increase is equal to the minimum residual capacity
-// of any edge in the path. The augmenting path is found via Dinic's algorithm
-// which finds a shortest augmenting path via BFS search. Returns the amount of
-// augmented flow. If no augmenting path is found then zero is returned.
-int64_t AugmentFlow(const Graph& graph, NodeId source, NodeId sink,
-                    ResidualGraph* residual_graph) {
-  XLS_VLOG_LINES(4, GraphWithFlowToString(graph, *residual_graph));
-
-  // Perform a BFS search from flow to find the shortest augmenting path (by
-  // edge count) from source to sink. For each edge traversed in the BFS search,
-  // 'path_back' holds the previous edge in the path from the source along with
-  // the residual capacity of that path..
-  absl::flat_hash_map<NodeId, std::pair<ResidualEdge*, int64_t>> path_back;
-  std::vector<NodeId> frontier = {source};
-  while (!frontier.empty()) {
-    std::vector<NodeId> next_frontier;
-    // Try to add extend the BFS-constructed paths from the source with the
-    // given edge.
-    auto maybe_extend_frontier = [&](ResidualEdge* e) {
-      if (path_back.contains(e->to)) {
-        return;
-      }
-      int64_t path_capacity = path_back.contains(e->from)
-                                  ? path_back.at(e->from).second
-                                  : std::numeric_limits<int64_t>::max();
-      // The residual capacity of a path is the minimum residual capacity of any
-      // edge in the path.
-      path_capacity = std::min(path_capacity, e->capacity);
-      path_back[e->to] = {e, path_capacity};
-      next_frontier.push_back(e->to);
-      XLS_VLOG(5) << "  Added " << graph.name(e->to) << " to the frontier";
-    };
-
-    for (NodeId node : frontier) {
-      XLS_VLOG(5) << "Visiting " << graph.name(node);
-      for (EdgeId edge_id : residual_graph->successors(node)) {
-        ResidualEdge& edge = residual_graph->edge(edge_id);
-        XLS_VLOG(5) << absl::StreamFormat(
-            "  Traversing %s->%s", graph.name(edge.from), graph.name(edge.to));
-        XLS_CHECK_GE(edge.capacity, 0);
-        if (edge.capacity > 0) {
-          maybe_extend_frontier(&edge);
-          if (edge.to == sink) {
-            // Found augmenting path. As this is the first path we've found in a
-            // BFS search it is necessarily a shortest path. Walk back along
-            // path and augment the flow.
-            int64_t augmented_flow_amount = path_back.at(sink).second;
-            XLS_CHECK_GT(augmented_flow_amount, 0);
-            NodeId n = sink;
-            while (n != source) {
-              ResidualEdge* e = path_back.at(n).first;
-              residual_graph->PushFlow(augmented_flow_amount, e);
-              XLS_CHECK_GE(e->capacity, 0);
-              n = e->from;
-            }
-            if (XLS_VLOG_IS_ON(4)) {
-              XLS_VLOG(4) << "Augmented flow: " << augmented_flow_amount;
-              std::vector<const ResidualEdge*> augmented_path;
-              NodeId n = sink;
-              while (n != source) {
-                const ResidualEdge* e = path_back.at(n).first;
-                augmented_path.push_back(e);
-                n = e->from;
-              }
-              std::reverse(augmented_path.begin(), augmented_path.end());
-              XLS_VLOG(4) << "Augmented path: "
-                          << absl::StrJoin(
-                                 augmented_path, ", ",
-                                 [&](std::string* out, const ResidualEdge* e) {
-                                   absl::StrAppendFormat(
-                                       out, "%s->%s [new capacity %d]",
-                                       graph.name(e->from), graph.name(e->to),
-                                       e->capacity);
-                                 });
-            }
-            return augmented_flow_amount;
+// Computes the maximum flow from source to sink using Dinic's algorithm. Each
+// phase computes the BFS level (distance from the source) of every node over
+// arcs with residual capacity and then saturates a blocking flow in the level
+// graph. A blocking flow is found by repeatedly advancing along arcs to the
+// next level, retreating from (and pruning) dead-end nodes, and augmenting when
+// the sink is reached. Each node keeps a pointer to its current arc so that
+// every arc is scanned at most once per phase. The search is iterative so deep
+// graphs do not exhaust the stack.
+class Dinic {
+ public:
+  Dinic(ResidualGraph* residual_graph, int64_t source, int64_t sink)
+      : residual_graph_(residual_graph),
+        source_(source),
+        sink_(sink),
+        level_(residual_graph->node_count()),
+        current_arc_(residual_graph->node_count()) {}
+
+  // Returns the value of the maximum flow.
+  int64_t Run() {
+    int64_t flow = 0;
+    int64_t phase = 0;
+    while (ComputeLevels()) {
+      int64_t phase_flow = BlockingFlow();
+      XLS_VLOG(4) << absl::StreamFormat("Phase %d: augmented flow by %d",
+                                        phase++, phase_flow);
+      flow += phase_flow;
+    }
+    return flow;
+  }
+
+ private:
+  // Computes the level of each node by BFS from the source. Returns whether
+  // the sink is reachable.
+  bool ComputeLevels() {
+    std::fill(level_.begin(), level_.end(), -1);
+    level_[source_] = 0;
+    queue_.clear();
+    queue_.push_back(source_);
+    for (int64_t i = 0; i < queue_.size(); ++i) {
+      int64_t node = queue_[i];
+      for (int64_t arc = residual_graph_->first_arc(node);
+           arc < residual_graph_->first_arc(node + 1); ++arc) {
+        int64_t to = residual_graph_->to(arc);
+        if (level_[to] < 0 && residual_graph_->capacity(arc) > 0) {
+          level_[to] = level_[node] + 1;
+          if (to == sink_) {
+            return true;
           }
+          queue_.push_back(to);
         }
       }
     }
+    return false;
+  }
+
+  // Saturates a blocking flow in the current level graph. Returns the amount
+  // of flow added.
+  int64_t BlockingFlow() {
+    for (int64_t node = 0; node < current_arc_.size(); ++node) {
+      current_arc_[node] = residual_graph_->first_arc(node);
+    }
+    int64_t flow = 0;
+    // The current path from the source as a stack of arcs, and the node at the
+    // tail of each arc.
+    std::vector<int64_t> path_arcs;
+    std::vector<int64_t> path_nodes;
+    int64_t node = source_;
+    while (true) {
+      if (node == sink_) {
+        int64_t amount = std::numeric_limits<int64_t>::max();
+        for (int64_t arc : path_arcs) {
+          amount = std::min(amount, residual_graph_->capacity(arc));
+        }
+        XLS_CHECK_GT(amount, 0);
+        // Augment and retreat to the tail of the first saturated arc.
+        int64_t first_saturated = -1;
+        for (int64_t i = 0; i < path_arcs.size(); ++i) {
+          residual_graph_->PushFlow(amount, path_arcs[i]);
+          if (first_saturated < 0 &&
+              residual_graph_->capacity(path_arcs[i]) == 0) {
+            first_saturated = i;
+          }
+        }
+        flow += amount;
+        node = path_nodes[first_saturated];
+        path_arcs.resize(first_saturated);
+        path_nodes.resize(first_saturated);
+        continue;
+      }
 
-    frontier = std::move(next_frontier);
-    next_frontier.clear();
+      // Advance along the first admissible arc.
+      int64_t end_arc = residual_graph_->first_arc(node + 1);
+      int64_t& arc = current_arc_[node];
+      while (arc < end_arc &&
+             (residual_graph_->capacity(arc) == 0 ||
+              level_[residual_graph_->to(arc)] != level_[node] + 1)) {
+        ++arc;
+      }
+      if (arc < end_arc) {
+        path_arcs.push_back(arc);
+        path_nodes.push_back(node);
+        node = residual_graph_->to(arc);
+        continue;
+      }
+
+      // Dead end. Remove the node from the level graph and retreat.
+      level_[node] = -1;
+      if (node == source_) {
+        return flow;
+      }
+      node = path_nodes.back();
+      path_arcs.pop_back();
+      path_nodes.pop_back();
+      ++current_arc_[node];
+    }
   }
 
-  XLS_VLOG(4) << "No augmenting path found";
-  return 0;
-}
+  ResidualGraph* residual_graph_;
+  int64_t source_;
+  int64_t sink_;
+  std::vector<int64_t> level_;
+  std::vector<int64_t> current_arc_;
+  std::vector<int64_t> queue_;
+};
 
 }  // namespace
 
 GraphCut MinCutBetweenNodes(const Graph& graph, NodeId source, NodeId sink) {
-  // This loop is the core of the Ford-Fulkerson method. Starting with zero flow
-  // on all edges, flow is increased along a path from source to sink with
-  // residual capacity (called an augmenting path). When no further augmenting
-  // paths exist, flow has been maximized. 'flow' is the flow of each edge in
-  // the graph indexed by EdgeId.
+  // Compute a maximum flow from source to sink. By the max-flow min-cut
+  // theorem, the saturated edges of a maximum flow form a minimum cut.
   ResidualGraph residual_graph(graph);
-  while (AugmentFlow(graph, source, sink, &residual_graph) > 0) {
-  }
+  int64_t max_flow =
+      Dinic(&residual_graph, int64_t{source}, int64_t{sink}).Run();
+  XLS_VLOG(4) << "Maximum flow: " << max_flow;
+  XLS_VLOG_LINES(4, GraphWithFlowToString(graph, residual_graph));
 
   // Once a maximum flow is found, walk the residual graph from the source. All
   // reachable nodes form one partition.
-  absl::flat_hash_set<NodeId> reachable_from_source;
-  std::deque<NodeId> frontier = {source};
-  reachable_from_source.insert(source);
+  std::vector<bool> reachable_from_source(graph.node_count(), false);
+  std::vector<int64_t> frontier = {int64_t{source}};
+  reachable_from_source[int64_t{source}] = true;
   while (!frontier.empty()) {
-    NodeId node = frontier.front();
-    frontier.pop_front();
-    for (EdgeId successor_edge_id : residual_graph.successors(node)) {
-      const ResidualEdge& edge = residual_graph.edge(successor_edge_id);
-      if (edge.capacity > 0 && !reachable_from_source.contains(edge.to)) {
-        reachable_from_source.insert(edge.to);
-        frontier.push_back(edge.to);
+    int64_t node = frontier.back();
+    frontier.pop_back();
+    for (int64_t arc = residual_graph.first_arc(node);
+         arc < residual_graph.first_arc(node + 1); ++arc) {
+      int64_t to = residual_graph.to(arc);
+      if (residual_graph.capacity(arc) > 0 && !reachable_from_source[to]) {
+        reachable_from_source[to] = true;
+        frontier.push_back(to);
       }
     }
   }
-  XLS_CHECK(!reachable_from_source.contains(sink));
+  XLS_CHECK(!reachable_from_source[int64_t{sink}]);
 
   GraphCut min_cut;
   min_cut.weight = 0;
   for (NodeId node_id = NodeId(0); node_id <= graph.max_node_id(); ++node_id) {
-    if (reachable_from_source.contains(node_id)) {
+    if (reachable_from_source[int64_t{node_id}]) {
       min_cut.source_partition.push_back(node_id);
     } else {
       min_cut.sink_partition.push_back(node_id);
     }
     for (EdgeId edge_id : graph.successors(node_id)) {
       const Edge& edge = graph.edge(edge_id);
-      if (reachable_from_source.contains(edge.from) &&
-          !reachable_from_source.contains(edge.to)) {
+      if (reachable_from_source[int64_t{edge.from}] &&
+          !reachable_from_source[int64_t{edge.to}]) {
         min_cut.weight += edge.weight;
       }
     }
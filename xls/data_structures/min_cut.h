@@ -97,8 +97,10 @@ struct GraphCut {
 // Computes a minimum cut of the given graph where source and sink are in
 // different partitions. The cut is returned as a partitioning of the nodes of
 // the graph into two sets of nodes on either side of the cut. The min cut is
-// found via the Ford-Fulkerson method using Dinic's algorithm. This results in
-// a worst case run time of O(V^2 * E).
+// derived from a maximum flow computed with Dinic's blocking-flow algorithm
+// over a compressed sparse row layout of the residual graph. This results in a
+// worst case run time of O(V^2 * E), though in practice far fewer phases are
+// required than augmenting paths.
 GraphCut MinCutBetweenNodes(const Graph& graph, NodeId source, NodeId sink);
 
 }  // namespace min_cut
@@ -355,6 +355,42 @@ TEST(MinCutTest, ResidualGraphTraversalTest) {
   EXPECT_EQ(min_cut.weight, 2);
 }
 
+TEST(MinCutTest, LongChain) {
+  // A long chain of nodes with a single light edge in the middle. Exercises
+  // deep augmenting paths.
+  constexpr int64_t kLength = 100000;
+  Graph graph;
+  std::vector<NodeId> nodes;
+  for (int64_t i = 0; i < kLength; ++i) {
+    nodes.push_back(graph.AddNode());
+  }
+  for (int64_t i = 0; i + 1 < kLength; ++i) {
+    graph.AddEdge(nodes[i], nodes[i + 1], i == kLength / 2 ? 3 : 100);
+  }
+  GraphCut min_cut = MinCutBetweenNodes(graph, nodes.front(), nodes.back());
+  EXPECT_EQ(min_cut.weight, 3);
+  EXPECT_EQ(min_cut.source_partition.size(), kLength / 2 + 1);
+  EXPECT_EQ(min_cut.sink_partition.size(), kLength / 2 - 1);
+}
+
+TEST(MinCutTest, ParallelPaths) {
+  // Many parallel paths of length two from source to sink. The first edge of
+  // each path has weight i and the second has weight 100 - i so the min cut
+  // takes the lighter edge of each path.
+  Graph graph;
+  NodeId source = graph.AddNode("source");
+  NodeId sink = graph.AddNode("sink");
+  int64_t expected_weight = 0;
+  for (int64_t i = 0; i <= 100; ++i) {
+    NodeId middle = graph.AddNode();
+    graph.AddEdge(source, middle, i);
+    graph.AddEdge(middle, sink, 100 - i);
+    expected_weight += std::min(i, 100 - i);
+  }
+  GraphCut min_cut = MinCutBetweenNodes(graph, source, sink);
+  EXPECT_EQ(min_cut.weight, expected_weight);
+}
+
 }  // namespace
 }  // namespace min_cut
 }  // namespace xls
@@ -1953,18 +1953,59 @@ WildcardPattern::~WildcardPattern() {}
 
 // -- class QuickCheck
 
+std::string QuickCheckStrategyToString(QuickCheckStrategy strategy) {
+  switch (strategy) {
+    case QuickCheckStrategy::kSample:
+      return "sample";
+    case QuickCheckStrategy::kExhaustive:
+      return "exhaustive";
+    case QuickCheckStrategy::kProve:
+      return "prove";
+    case QuickCheckStrategy::kAuto:
+      return "auto";
+  }
+  return absl::StrFormat("<invalid QuickCheckStrategy(%d)>",
+                         static_cast<int64_t>(strategy));
+}
+
+absl::StatusOr<QuickCheckStrategy> QuickCheckStrategyFromString(
+    std::string_view s) {
+  for (QuickCheckStrategy strategy :
+       {QuickCheckStrategy::kSample, QuickCheckStrategy::kExhaustive,
+        QuickCheckStrategy::kProve, QuickCheckStrategy::kAuto}) {
+    if (s == QuickCheckStrategyToString(strategy)) {
+      return strategy;
+    }
+  }
+  return absl::InvalidArgumentError(
+      absl::StrFormat("Unknown quickcheck strategy: '%s'", s));
+}
+
 QuickCheck::QuickCheck(Module* owner, Span span, Function* f,
-                       std::optional<int64_t> test_count)
-    : AstNode(owner), span_(span), f_(f), test_count_(std::move(test_count)) {}
+                       std::optional<int64_t> test_count,
+                       QuickCheckStrategy strategy)
+    : AstNode(owner),
+      span_(span),
+      f_(f),
+      test_count_(std::move(test_count)),
+      strategy_(strategy) {}
 
 QuickCheck::~QuickCheck() {}
 
 std::string QuickCheck::ToString() const {
-  std::string test_count_str;
+  std::vector<std::string> config;
   if (test_count_.has_value()) {
-    test_count_str = absl::StrFormat("(test_count=%d)", *test_count_);
+    config.push_back(absl::StrFormat("test_count=%d", *test_count_));
+  }
+  if (strategy_ != QuickCheckStrategy::kSample) {
+    config.push_back(
+        absl::StrCat("strategy=", QuickCheckStrategyToString(strategy_)));
+  }
+  std::string config_str;
+  if (!config.empty()) {
+    config_str = absl::StrCat("(", absl::StrJoin(config, ", "), ")");
   }
-  return absl::StrFormat("#[quickcheck%s]\n%s", test_count_str, f_->ToString());
+  return absl::StrFormat("#[quickcheck%s]\n%s", config_str, f_->ToString());
 }
 
 // -- class TupleIndex
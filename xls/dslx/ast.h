@@ -2477,13 +2477,31 @@ class TestProc : public AstNode {
   Proc* proc_;
 };
 
+// How the inputs on which a quickcheck predicate is evaluated are chosen.
+enum class QuickCheckStrategy {
+  // Evaluates the predicate on `test_count` randomly sampled inputs.
+  kSample,
+  // Evaluates the predicate on every possible input.
+  kExhaustive,
+  // Proves the predicate (or finds a counterexample) with an SMT solver.
+  kProve,
+  // kExhaustive for small input spaces, kProve otherwise, falling back to
+  // kSample if the solver cannot decide the predicate.
+  kAuto,
+};
+
+std::string QuickCheckStrategyToString(QuickCheckStrategy strategy);
+absl::StatusOr<QuickCheckStrategy> QuickCheckStrategyFromString(
+    std::string_view s);
+
 // Represents a function to be quick-check'd.
 class QuickCheck : public AstNode {
  public:
   static constexpr int64_t kDefaultTestCount = 1000;
 
   QuickCheck(Module* owner, Span span, Function* f,
-             std::optional<int64_t> test_count = absl::nullopt);
+             std::optional<int64_t> test_count = absl::nullopt,
+             QuickCheckStrategy strategy = QuickCheckStrategy::kSample);
 
   ~QuickCheck() override;
 
@@ -2506,12 +2524,14 @@ class QuickCheck : public AstNode {
   int64_t test_count() const {
     return test_count_ ? *test_count_ : kDefaultTestCount;
   }
+  QuickCheckStrategy strategy() const { return strategy_; }
   std::optional<Span> GetSpan() const override { return f_->span(); }
 
  private:
   Span span_;
   Function* f_;
   std::optional<int64_t> test_count_;
+  QuickCheckStrategy strategy_;
 };
 
 // Represents an index into a tuple, e.g., "(u32:7, u32:8).1".
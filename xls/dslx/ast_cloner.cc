@@ -523,7 +523,7 @@ class AstCloner : public AstNodeVisitor {
     XLS_RETURN_IF_ERROR(VisitChildren(n));
     old_to_new_[n] = module_->Make<QuickCheck>(
         n->GetSpan().value(), down_cast<Function*>(old_to_new_.at(n->f())),
-        n->test_count());
+        n->test_count(), n->strategy());
     return absl::OkStatus();
   }
 
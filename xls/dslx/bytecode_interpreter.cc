@@ -468,6 +468,28 @@ absl::Status BytecodeInterpreter::EvalCall(const Bytecode& bytecode) {
     args[num_args - i - 1] = arg;
   }
 
+  if (options_.fn_call_hook() != nullptr &&
+      user_fn_data.function->tag() == Function::Tag::kNormal) {
+    XLS_ASSIGN_OR_RETURN(
+        std::optional<InterpValue> result,
+        options_.fn_call_hook()(
+            user_fn_data.function, bf->type_info(), args,
+            data.bindings.has_value() ? &data.bindings.value() : nullptr));
+    if (result.has_value()) {
+      // The callee's frame is skipped, so run the post-fn eval hook here to
+      // keep checking calls evaluated by the hook (e.g., in --compare mode).
+      if (options_.post_fn_eval_hook() != nullptr && !result->IsUnit()) {
+        ParametricEnv holder;
+        XLS_RETURN_IF_ERROR(options_.post_fn_eval_hook()(
+            user_fn_data.function, args,
+            data.bindings.has_value() ? &data.bindings.value() : &holder,
+            *result));
+      }
+      stack_.push_back(*std::move(result));
+      return absl::OkStatus();
+    }
+  }
+
   std::vector<InterpValue> args_copy = args;
   frames_.push_back(Frame(bf, std::move(args), bf->type_info(), data.bindings,
                           std::move(args_copy)));
@@ -79,6 +79,11 @@ using PostFnEvalHook = std::function<absl::Status(
     const Function* f, absl::Span<const InterpValue> args, const ParametricEnv*,
     const InterpValue& got)>;
 using TraceHook = std::function<void(std::string_view)>;
+// Hook which may evaluate a call to a DSLX function in place of the
+// interpreter. Returns std::nullopt if the call should be interpreted.
+using FnCallHook = std::function<absl::StatusOr<std::optional<InterpValue>>(
+    const Function* f, const TypeInfo* type_info,
+    absl::Span<const InterpValue> args, const ParametricEnv* bindings)>;
 
 // Trace hook which logs trace messages to INFO.
 inline void InfoLoggingTraceHook(std::string_view entry) {
@@ -96,6 +101,17 @@ class BytecodeInterpreterOptions {
   }
   const PostFnEvalHook& post_fn_eval_hook() const { return post_fn_eval_hook_; }
 
+  // Callback to invoke before a call to a (non-builtin) DSLX function is
+  // interpreted. If the callback returns a value, it is used as the result of
+  // the call and the callee's bytecode is not executed; the post-fn eval hook
+  // is still invoked on the value. This is used to dispatch frequently called
+  // functions to the JIT (see HotFunctionJit).
+  BytecodeInterpreterOptions& fn_call_hook(FnCallHook hook) {
+    fn_call_hook_ = std::move(hook);
+    return *this;
+  }
+  const FnCallHook& fn_call_hook() const { return fn_call_hook_; }
+
   // Callback to invoke when a trace operation executes. The callback argument
   // is the trace string.
   BytecodeInterpreterOptions& trace_hook(TraceHook hook) {
@@ -122,6 +138,7 @@ class BytecodeInterpreterOptions {
 
  private:
   PostFnEvalHook post_fn_eval_hook_ = nullptr;
+  FnCallHook fn_call_hook_ = nullptr;
   TraceHook trace_hook_ = nullptr;
   bool trace_channels_ = false;
   std::optional<int64_t> max_ticks_;
@@ -0,0 +1,169 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/dslx/hot_function_jit.h"
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/dslx/interp_value_helpers.h"
+#include "xls/dslx/mangle.h"
+#include "xls/ir/events.h"
+#include "xls/ir/value.h"
+
+namespace xls::dslx {
+
+HotFunctionJit::HotFunctionJit(ImportData* import_data, int64_t threshold,
+                               const ConvertOptions& convert_options)
+    : import_data_(import_data),
+      threshold_(threshold),
+      convert_options_(convert_options) {
+  // Failures must be visible to the JIT as assertions so the call can be
+  // re-executed by the interpreter.
+  convert_options_.emit_fail_as_assert = true;
+}
+
+FnCallHook HotFunctionJit::MakeFnCallHook() {
+  return [this](const Function* f, const TypeInfo* type_info,
+                absl::Span<const InterpValue> args,
+                const ParametricEnv* bindings) {
+    return Call(f, type_info, args, bindings);
+  };
+}
+
+absl::StatusOr<Package*> HotFunctionJit::GetOrConvertPackage(Module* module) {
+  auto it = packages_.find(module);
+  if (it == packages_.end()) {
+    // Failed conversions are recorded as null so they are not retried.
+    absl::StatusOr<std::unique_ptr<Package>> package =
+        ConvertModuleToPackage(module, import_data_, convert_options_,
+                               /*traverse_tests=*/true);
+    if (!package.ok()) {
+      packages_[module] = nullptr;
+      return package.status();
+    }
+    it = packages_.emplace(module, std::move(package).value()).first;
+  }
+  if (it->second == nullptr) {
+    return absl::FailedPreconditionError(absl::StrFormat(
+        "Module %s could not be converted to IR.", module->name()));
+  }
+  return it->second.get();
+}
+
+absl::Status HotFunctionJit::Compile(const Function* f,
+                                     const TypeInfo* type_info,
+                                     const ParametricEnv& bindings,
+                                     Entry* entry) {
+  XLS_ASSIGN_OR_RETURN(Package * package, GetOrConvertPackage(f->owner()));
+  XLS_ASSIGN_OR_RETURN(TypeInfo * root_type_info,
+                       import_data_->GetRootTypeInfoForNode(f));
+  std::optional<bool> requires_implicit_token =
+      root_type_info->GetRequiresImplicitToken(f);
+  XLS_RET_CHECK(requires_implicit_token.has_value());
+
+  std::optional<ConcreteType*> fn_type = type_info->GetItem(f);
+  XLS_RET_CHECK(fn_type.has_value());
+  auto* function_type = dynamic_cast<const FunctionType*>(fn_type.value());
+  XLS_RET_CHECK(function_type != nullptr);
+
+  XLS_ASSIGN_OR_RETURN(
+      std::string ir_name,
+      MangleDslxName(f->owner()->name(), f->identifier(),
+                     *requires_implicit_token
+                         ? CallingConvention::kImplicitToken
+                         : CallingConvention::kTypical,
+                     f->GetFreeParametricKeySet(), &bindings));
+  XLS_ASSIGN_OR_RETURN(xls::Function * ir_function,
+                       package->GetFunction(ir_name));
+  XLS_ASSIGN_OR_RETURN(entry->jit, FunctionJit::Create(ir_function));
+  entry->requires_implicit_token = *requires_implicit_token;
+  entry->return_type = &function_type->return_type();
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::optional<InterpValue>> HotFunctionJit::Call(
+    const Function* f, const TypeInfo* type_info,
+    absl::Span<const InterpValue> args, const ParametricEnv* bindings) {
+  ParametricEnv env = bindings == nullptr ? ParametricEnv() : *bindings;
+  Entry& entry = entries_[std::make_pair(f, env)];
+  switch (entry.state) {
+    case State::kInterpreted:
+      return std::nullopt;
+    case State::kCounting: {
+      if (++entry.call_count <= threshold_) {
+        return std::nullopt;
+      }
+      absl::Status status = Compile(f, type_info, env, &entry);
+      if (!status.ok()) {
+        XLS_VLOG(1) << "Not JIT compiling " << f->identifier() << " "
+                    << env.ToString() << ": " << status;
+        entry.state = State::kInterpreted;
+        return std::nullopt;
+      }
+      XLS_VLOG(1) << "JIT compiled " << f->identifier() << " "
+                  << env.ToString() << " after " << entry.call_count
+                  << " calls";
+      entry.state = State::kCompiled;
+      ++compiled_count_;
+      break;
+    }
+    case State::kCompiled:
+      break;
+  }
+
+  absl::StatusOr<std::vector<Value>> ir_args =
+      InterpValue::ConvertValuesToIr(args);
+  if (!ir_args.ok()) {
+    // E.g. arguments of types which have no IR equivalent.
+    XLS_VLOG(1) << "Not JIT evaluating " << f->identifier() << ": "
+                << ir_args.status();
+    entry.state = State::kInterpreted;
+    return std::nullopt;
+  }
+  if (entry.requires_implicit_token) {
+    ir_args->insert(ir_args->begin(), Value::Bool(true));
+    ir_args->insert(ir_args->begin(), Value::Token());
+  }
+
+  XLS_ASSIGN_OR_RETURN(InterpreterResult<Value> result,
+                       entry.jit->Run(*ir_args));
+  if (!result.events.trace_msgs.empty() ||
+      !result.events.assert_msgs.empty()) {
+    ++fallback_count_;
+    return std::nullopt;
+  }
+
+  Value value = std::move(result.value);
+  if (entry.requires_implicit_token) {
+    XLS_RET_CHECK(value.IsTuple() && value.size() == 2);
+    Value real_value = value.element(1);
+    value = std::move(real_value);
+  }
+  ++jit_call_count_;
+  XLS_ASSIGN_OR_RETURN(InterpValue interp_value,
+                       ValueToInterpValue(value, entry.return_type));
+  return interp_value;
+}
+
+}  // namespace xls::dslx
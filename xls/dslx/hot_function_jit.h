@@ -0,0 +1,124 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_DSLX_HOT_FUNCTION_JIT_H_
+#define XLS_DSLX_HOT_FUNCTION_JIT_H_
+
+#include <stdint.h>
+
+#include <memory>
+#include <optional>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "xls/dslx/ast.h"
+#include "xls/dslx/bytecode_interpreter.h"
+#include "xls/dslx/concrete_type.h"
+#include "xls/dslx/import_data.h"
+#include "xls/dslx/interp_value.h"
+#include "xls/dslx/ir_converter.h"
+#include "xls/dslx/parametric_env.h"
+#include "xls/ir/package.h"
+#include "xls/jit/function_jit.h"
+
+namespace xls::dslx {
+
+// Evaluates frequently called DSLX functions with the JIT instead of the
+// bytecode interpreter ("mixed-mode" execution).
+//
+// Calls are counted per (function, parametric bindings). Once a function has
+// been called more than `threshold` times its module is converted to IR and
+// the function is JIT compiled; subsequent calls are evaluated by the JIT with
+// arguments and results converted at the boundary.
+//
+// A call whose JIT evaluation produces trace messages or assertion failures is
+// re-executed by the interpreter, so trace output and fail!() errors (including
+// their source positions) are exactly those of the interpreter. Functions which
+// cannot be compiled (e.g. parametric instantiations which are only reachable
+// from test constructs the IR converter does not visit) are interpreted.
+//
+// Usage:
+//
+//   HotFunctionJit hot_jit(&import_data, /*threshold=*/1000);
+//   BytecodeInterpreterOptions options;
+//   options.fn_call_hook(hot_jit.MakeFnCallHook());
+//
+// Note: this object is not thread-safe.
+class HotFunctionJit {
+ public:
+  HotFunctionJit(ImportData* import_data, int64_t threshold,
+                 const ConvertOptions& convert_options = ConvertOptions());
+
+  // Returns a hook which dispatches calls through this object, for use as the
+  // interpreter's fn_call_hook. The hook must not outlive this object.
+  FnCallHook MakeFnCallHook();
+
+  // Evaluates the call of `f` with the JIT if it is hot; returns std::nullopt
+  // if the call should be interpreted.
+  absl::StatusOr<std::optional<InterpValue>> Call(
+      const Function* f, const TypeInfo* type_info,
+      absl::Span<const InterpValue> args, const ParametricEnv* bindings);
+
+  // Number of calls evaluated by the JIT.
+  int64_t jit_call_count() const { return jit_call_count_; }
+
+  // Number of JIT evaluations discarded and re-executed by the interpreter due
+  // to trace messages or assertion failures.
+  int64_t fallback_count() const { return fallback_count_; }
+
+  // Number of (function, parametric bindings) pairs which were compiled.
+  int64_t compiled_count() const { return compiled_count_; }
+
+ private:
+  enum class State {
+    // The function is interpreted until its call count passes the threshold.
+    kCounting,
+    kCompiled,
+    // Compilation failed; the function is always interpreted.
+    kInterpreted,
+  };
+
+  struct Entry {
+    State state = State::kCounting;
+    int64_t call_count = 0;
+    std::unique_ptr<FunctionJit> jit;
+    bool requires_implicit_token = false;
+    const ConcreteType* return_type = nullptr;
+  };
+
+  absl::Status Compile(const Function* f, const TypeInfo* type_info,
+                       const ParametricEnv& bindings, Entry* entry);
+
+  // Returns the IR conversion of `module`, converting it on first use.
+  absl::StatusOr<Package*> GetOrConvertPackage(Module* module);
+
+  ImportData* import_data_;
+  int64_t threshold_;
+  ConvertOptions convert_options_;
+
+  absl::flat_hash_map<const Module*, std::unique_ptr<Package>> packages_;
+  absl::flat_hash_map<std::pair<const Function*, ParametricEnv>, Entry>
+      entries_;
+
+  int64_t jit_call_count_ = 0;
+  int64_t fallback_count_ = 0;
+  int64_t compiled_count_ = 0;
+};
+
+}  // namespace xls::dslx
+
+#endif  // XLS_DSLX_HOT_FUNCTION_JIT_H_
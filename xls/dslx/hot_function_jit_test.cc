@@ -0,0 +1,202 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/dslx/hot_function_jit.h"
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "xls/common/status/matchers.h"
+#include "xls/dslx/bytecode_emitter.h"
+#include "xls/dslx/bytecode_interpreter.h"
+#include "xls/dslx/create_import_data.h"
+#include "xls/dslx/import_data.h"
+#include "xls/dslx/interp_value.h"
+#include "xls/dslx/parse_and_typecheck.h"
+
+namespace xls::dslx {
+namespace {
+
+using status_testing::IsOkAndHolds;
+using status_testing::StatusIs;
+using testing::ElementsAre;
+using testing::HasSubstr;
+
+class HotFunctionJitTest : public ::testing::Test {
+ protected:
+  HotFunctionJitTest() : import_data_(CreateImportDataForTest()) {}
+
+  absl::Status Parse(std::string_view program) {
+    XLS_ASSIGN_OR_RETURN(
+        TypecheckedModule tm,
+        ParseAndTypecheck(program, "test.x", "test", &import_data_));
+    XLS_ASSIGN_OR_RETURN(Function * f,
+                         tm.module->GetMemberOrError<Function>("main"));
+    XLS_ASSIGN_OR_RETURN(main_, BytecodeEmitter::Emit(&import_data_,
+                                                      tm.type_info, f,
+                                                      ParametricEnv()));
+    return absl::OkStatus();
+  }
+
+  // Interprets `main`, dispatching hot calls through `hot_jit` if non-null.
+  absl::StatusOr<InterpValue> Run(HotFunctionJit* hot_jit,
+                                  std::vector<std::string>* traces = nullptr) {
+    BytecodeInterpreterOptions options;
+    if (hot_jit != nullptr) {
+      options.fn_call_hook(hot_jit->MakeFnCallHook());
+    }
+    if (traces != nullptr) {
+      options.trace_hook(
+          [traces](std::string_view s) { traces->push_back(std::string(s)); });
+    }
+    return BytecodeInterpreter::Interpret(&import_data_, main_.get(), {},
+                                          options);
+  }
+
+  ImportData import_data_;
+  std::unique_ptr<BytecodeFunction> main_;
+};
+
+TEST_F(HotFunctionJitTest, HotFunctionIsJitted) {
+  XLS_ASSERT_OK(Parse(R"(
+fn add_one(x: u32) -> u32 { x + u32:1 }
+
+fn main() -> u32 {
+  for (_, acc): (u32, u32) in range(u32:0, u32:10) {
+    add_one(acc)
+  }(u32:0)
+}
+)"));
+  HotFunctionJit hot_jit(&import_data_, /*threshold=*/3);
+  EXPECT_THAT(Run(&hot_jit), IsOkAndHolds(InterpValue::MakeU32(10)));
+  EXPECT_EQ(hot_jit.compiled_count(), 1);
+  EXPECT_EQ(hot_jit.jit_call_count(), 7);
+}
+
+TEST_F(HotFunctionJitTest, PostFnEvalHookSeesJittedCalls) {
+  XLS_ASSERT_OK(Parse(R"(
+fn add_one(x: u32) -> u32 { x + u32:1 }
+
+fn main() -> u32 {
+  for (_, acc): (u32, u32) in range(u32:0, u32:10) {
+    add_one(acc)
+  }(u32:0)
+}
+)"));
+  HotFunctionJit hot_jit(&import_data_, /*threshold=*/3);
+  std::vector<InterpValue> add_one_results;
+  BytecodeInterpreterOptions options;
+  options.fn_call_hook(hot_jit.MakeFnCallHook())
+      .post_fn_eval_hook([&](const Function* f,
+                             absl::Span<const InterpValue> args,
+                             const ParametricEnv*, const InterpValue& got) {
+        if (f->identifier() == "add_one") {
+          add_one_results.push_back(got);
+        }
+        return absl::OkStatus();
+      });
+  EXPECT_THAT(
+      BytecodeInterpreter::Interpret(&import_data_, main_.get(), {}, options),
+      IsOkAndHolds(InterpValue::MakeU32(10)));
+  EXPECT_EQ(hot_jit.jit_call_count(), 7);
+  // Calls evaluated by the JIT are checked as well as interpreted ones.
+  ASSERT_EQ(add_one_results.size(), 10);
+  EXPECT_EQ(add_one_results.back(), InterpValue::MakeU32(10));
+}
+
+TEST_F(HotFunctionJitTest, ParametricStructAndEnumValues) {
+  XLS_ASSERT_OK(Parse(R"(
+enum Op : u2 { ADD = 0, SUB = 1 }
+
+struct Acc<N: u32> { op: Op, value: sN[N] }
+
+fn step<N: u32>(acc: Acc<N>) -> Acc<N> {
+  match acc.op {
+    Op::ADD => Acc<N> { op: Op::SUB, value: acc.value + sN[N]:3 },
+    _ => Acc<N> { op: Op::ADD, value: acc.value - sN[N]:1 },
+  }
+}
+
+fn main() -> (Acc<8>, Acc<16>) {
+  let a = for (_, acc): (u32, Acc<8>) in range(u32:0, u32:5) {
+    step(acc)
+  }(Acc<8> { op: Op::ADD, value: s8:0 });
+  let b = for (_, acc): (u32, Acc<16>) in range(u32:0, u32:4) {
+    step(acc)
+  }(Acc<16> { op: Op::SUB, value: s16:-10 });
+  (a, b)
+}
+)"));
+  XLS_ASSERT_OK_AND_ASSIGN(InterpValue expected, Run(/*hot_jit=*/nullptr));
+  HotFunctionJit hot_jit(&import_data_, /*threshold=*/0);
+  XLS_ASSERT_OK_AND_ASSIGN(InterpValue result, Run(&hot_jit));
+  // Each instantiation of `step` is compiled separately and the enum and
+  // signed values are reconstructed from the JIT results.
+  EXPECT_EQ(hot_jit.compiled_count(), 2);
+  EXPECT_EQ(hot_jit.jit_call_count(), 9);
+  EXPECT_EQ(result, expected) << result.ToString();
+  EXPECT_TRUE(result.GetValuesOrDie()[0].GetValuesOrDie()[0].IsEnum());
+  EXPECT_TRUE(result.GetValuesOrDie()[1].GetValuesOrDie()[1].IsSigned());
+}
+
+TEST_F(HotFunctionJitTest, TracesAreEmittedByInterpreter) {
+  XLS_ASSERT_OK(Parse(R"(
+fn traced(x: u32) -> u32 {
+  let _ = trace_fmt!("x is {}", x);
+  x
+}
+
+fn main() -> u32 {
+  for (i, acc): (u32, u32) in range(u32:0, u32:3) {
+    acc + traced(i)
+  }(u32:0)
+}
+)"));
+  HotFunctionJit hot_jit(&import_data_, /*threshold=*/0);
+  std::vector<std::string> traces;
+  EXPECT_THAT(Run(&hot_jit, &traces), IsOkAndHolds(InterpValue::MakeU32(3)));
+  EXPECT_THAT(traces, ElementsAre("x is 0", "x is 1", "x is 2"));
+  EXPECT_EQ(hot_jit.fallback_count(), 3);
+  EXPECT_EQ(hot_jit.jit_call_count(), 0);
+}
+
+TEST_F(HotFunctionJitTest, FailureIsReportedByInterpreter) {
+  XLS_ASSERT_OK(Parse(R"(
+fn fail_on_four(x: u32) -> u32 {
+  if x == u32:4 { fail!("x_is_four", x) } else { x }
+}
+
+fn main() -> u32 {
+  for (i, acc): (u32, u32) in range(u32:0, u32:8) {
+    acc + fail_on_four(i)
+  }(u32:0)
+}
+)"));
+  HotFunctionJit hot_jit(&import_data_, /*threshold=*/0);
+  EXPECT_THAT(Run(&hot_jit),
+              StatusIs(absl::StatusCode::kInternal,
+                       HasSubstr("The program being interpreted failed!")));
+  EXPECT_EQ(hot_jit.jit_call_count(), 4);
+  EXPECT_EQ(hot_jit.fallback_count(), 1);
+}
+
+}  // namespace
+}  // namespace xls::dslx
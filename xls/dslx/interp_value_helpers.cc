@@ -294,9 +294,14 @@ absl::StatusOr<InterpValue> ValueToInterpValue(const Value& v,
   switch (v.kind()) {
     case ValueKind::kBits: {
       InterpValueTag tag = InterpValueTag::kUBits;
+      if (auto* enum_type = dynamic_cast<const EnumType*>(type);
+          enum_type != nullptr) {
+        return InterpValue::MakeEnum(v.bits(), enum_type->signedness(),
+                                     &enum_type->nominal_type());
+      }
       if (type != nullptr) {
-        XLS_RET_CHECK(type != nullptr);
         auto* bits_type = dynamic_cast<const BitsType*>(type);
+        XLS_RET_CHECK(bits_type != nullptr) << type->ToString();
         tag = bits_type->is_signed() ? InterpValueTag::kSBits
                                      : InterpValueTag::kUBits;
       }
@@ -313,6 +318,12 @@ absl::StatusOr<InterpValue> ValueToInterpValue(const Value& v,
           XLS_CHECK(array_type != nullptr);
           return &array_type->element_type();
         }
+        // Structs are represented as tuples in both the IR and the
+        // interpreter.
+        if (auto* struct_type = dynamic_cast<const StructType*>(type);
+            struct_type != nullptr) {
+          return &struct_type->GetMemberType(i);
+        }
         auto* tuple_type = dynamic_cast<const TupleType*>(type);
         XLS_CHECK(tuple_type != nullptr);
         return &tuple_type->GetMemberType(i);
@@ -57,6 +57,10 @@ ABSL_FLAG(bool, trace_channels, false,
 ABSL_FLAG(int64_t, max_ticks, 100000,
           "If non-zero, the maximum number of ticks to execute on any proc. If "
           "exceeded an error is returned.");
+ABSL_FLAG(int64_t, auto_jit_threshold, -1,
+          "If non-negative, DSLX functions called more than this many times "
+          "are JIT compiled and subsequent calls are evaluated by the JIT "
+          "(mixed-mode execution). -1 disables the JIT dispatch.");
 // LINT.ThenChange(//xls/build_rules/xls_dslx_rules.bzl)
 
 namespace xls::dslx {
@@ -79,6 +83,7 @@ absl::Status RealMain(std::string_view entry_module_path,
                       CompareFlag compare_flag, bool execute,
                       bool warnings_as_errors, std::optional<int64_t> seed,
                       bool trace_channels, std::optional<int64_t> max_ticks,
+                      std::optional<int64_t> auto_jit_threshold,
                       bool* printed_error) {
   XLS_ASSIGN_OR_RETURN(std::string program, GetFileContents(entry_module_path));
   XLS_ASSIGN_OR_RETURN(std::string module_name, PathToName(entry_module_path));
@@ -102,7 +107,8 @@ absl::Status RealMain(std::string_view entry_module_path,
       .seed = seed,
       .warnings_as_errors = warnings_as_errors,
       .trace_channels = trace_channels,
-      .max_ticks = max_ticks};
+      .max_ticks = max_ticks,
+      .auto_jit_threshold = auto_jit_threshold};
   XLS_ASSIGN_OR_RETURN(
       TestResult test_result,
       ParseAndTest(program, module_name, entry_module_path, options));
@@ -150,6 +156,11 @@ int main(int argc, char* argv[]) {
                     << "; must be one of none|jit|interpreter";
   }
 
+  std::optional<int64_t> auto_jit_threshold =
+      absl::GetFlag(FLAGS_auto_jit_threshold) < 0
+          ? std::nullopt
+          : std::optional<int64_t>(absl::GetFlag(FLAGS_auto_jit_threshold));
+
   // Optional seed value.
   std::optional<int64_t> seed;
   if (int64_t seed_flag_value = absl::GetFlag(FLAGS_seed);
@@ -173,7 +184,8 @@ int main(int argc, char* argv[]) {
   absl::Status status =
       xls::dslx::RealMain(args[0], dslx_paths, test_filter, preference.value(),
                           compare_flag, execute, warnings_as_errors, seed,
-                          trace_channels, max_ticks, &printed_error);
+                          trace_channels, max_ticks, auto_jit_threshold,
+                          &printed_error);
   if (printed_error) {
     return EXIT_FAILURE;
   }
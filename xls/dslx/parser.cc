@@ -1248,34 +1248,65 @@ absl::StatusOr<QuickCheck*> Parser::ParseQuickCheck(
     absl::flat_hash_map<std::string, Function*>* name_to_fn, Bindings* bindings,
     const Span& directive_span) {
   std::optional<int64_t> test_count;
+  QuickCheckStrategy strategy = QuickCheckStrategy::kSample;
   XLS_ASSIGN_OR_RETURN(bool peek_is_paren, PeekTokenIs(TokenKind::kOParen));
   if (peek_is_paren) {  // Config is specified.
     DropTokenOrDie();
-    XLS_ASSIGN_OR_RETURN(std::string config_name, PopIdentifierOrError());
-    XLS_RETURN_IF_ERROR(DropTokenOrError(TokenKind::kEquals));
-    if (config_name == "test_count") {
-      XLS_ASSIGN_OR_RETURN(Token count_token,
-                           PopTokenOrError(TokenKind::kNumber));
-      XLS_ASSIGN_OR_RETURN(test_count, count_token.GetValueAsInt64());
-      if (test_count <= 0) {
+    while (true) {
+      XLS_ASSIGN_OR_RETURN(std::string config_name, PopIdentifierOrError());
+      XLS_RETURN_IF_ERROR(DropTokenOrError(TokenKind::kEquals));
+      if (config_name == "test_count") {
+        XLS_ASSIGN_OR_RETURN(Token count_token,
+                             PopTokenOrError(TokenKind::kNumber));
+        XLS_ASSIGN_OR_RETURN(test_count, count_token.GetValueAsInt64());
+        if (test_count <= 0) {
+          return ParseErrorStatus(
+              count_token.span(),
+              absl::StrFormat("Number of tests should be > 0, got %d",
+                              *test_count));
+        }
+      } else if (config_name == "strategy") {
+        XLS_ASSIGN_OR_RETURN(Token strategy_token,
+                             PopTokenOrError(TokenKind::kIdentifier));
+        absl::StatusOr<QuickCheckStrategy> strategy_or =
+            QuickCheckStrategyFromString(*strategy_token.GetValue());
+        if (!strategy_or.ok()) {
+          return ParseErrorStatus(
+              strategy_token.span(),
+              absl::StrFormat("Unknown quickcheck strategy: '%s'; expected "
+                              "one of sample, exhaustive, prove or auto",
+                              *strategy_token.GetValue()));
+        }
+        strategy = strategy_or.value();
+      } else {
         return ParseErrorStatus(
-            count_token.span(),
-            absl::StrFormat("Number of tests should be > 0, got %d",
-                            *test_count));
+            directive_span,
+            absl::StrFormat("Unknown configuration key in directive: '%s'",
+                            config_name));
+      }
+      XLS_ASSIGN_OR_RETURN(bool dropped_comma, TryDropToken(TokenKind::kComma));
+      if (!dropped_comma) {
+        break;
       }
-      XLS_RETURN_IF_ERROR(DropTokenOrError(TokenKind::kCParen));
-    } else {
-      return ParseErrorStatus(
-          directive_span,
-          absl::StrFormat("Unknown configuration key in directive: '%s'",
-                          config_name));
     }
+    XLS_RETURN_IF_ERROR(DropTokenOrError(TokenKind::kCParen));
+  }
+
+  // Only the sampling strategies draw random inputs, so a test count is
+  // meaningless for the others.
+  if (test_count.has_value() && strategy != QuickCheckStrategy::kSample &&
+      strategy != QuickCheckStrategy::kAuto) {
+    return ParseErrorStatus(
+        directive_span,
+        absl::StrFormat("test_count cannot be specified for the '%s' "
+                        "quickcheck strategy",
+                        QuickCheckStrategyToString(strategy)));
   }
 
   XLS_RETURN_IF_ERROR(DropTokenOrError(TokenKind::kCBrack));
   XLS_ASSIGN_OR_RETURN(
       Function * fn, ParseFunction(/*is_public=*/false, bindings, name_to_fn));
-  return module_->Make<QuickCheck>(fn->span(), fn, test_count);
+  return module_->Make<QuickCheck>(fn->span(), fn, test_count, strategy);
 }
 
 absl::StatusOr<XlsTuple*> Parser::ParseTupleRemainder(const Pos& start_pos,
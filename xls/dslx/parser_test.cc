@@ -884,6 +884,42 @@ fn foo(x: u5) -> bool {
 })");
 }
 
+TEST_F(ParserTest, QuickCheckDirectiveWithStrategy) {
+  RoundTrip(R"(#[quickcheck(strategy=exhaustive)]
+fn foo(x: u5) -> bool {
+  true
+})");
+}
+
+TEST_F(ParserTest, QuickCheckDirectiveWithTestCountAndStrategy) {
+  RoundTrip(R"(#[quickcheck(test_count=1024, strategy=auto)]
+fn foo(x: u5) -> bool {
+  true
+})");
+}
+
+TEST_F(ParserTest, QuickCheckDirectiveWithUnknownStrategy) {
+  constexpr std::string_view kProgram = R"(#[quickcheck(strategy=guess)]
+fn foo(x: u5) -> bool { true })";
+  Scanner s{"test.x", std::string{kProgram}};
+  Parser parser{"test", &s};
+  EXPECT_THAT(parser.ParseModule(),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Unknown quickcheck strategy: 'guess'")));
+}
+
+TEST_F(ParserTest, QuickCheckDirectiveTestCountWithProveStrategy) {
+  constexpr std::string_view kProgram =
+      R"(#[quickcheck(test_count=10, strategy=prove)]
+fn foo(x: u5) -> bool { true })";
+  Scanner s{"test.x", std::string{kProgram}};
+  Parser parser{"test", &s};
+  EXPECT_THAT(parser.ParseModule(),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("test_count cannot be specified for the "
+                                 "'prove' quickcheck strategy")));
+}
+
 TEST_F(ParserTest, ModuleWithTypeAliasArrayTuple) {
   RoundTrip(R"(type MyType = u32;
 type MyTupleType = (MyType[2],);)");
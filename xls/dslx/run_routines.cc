@@ -18,6 +18,9 @@
 #include <time.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <filesystem>  // NOLINT
 #include <functional>
 #include <iostream>
@@ -25,10 +28,12 @@
 #include <random>
 #include <string>
 #include <string_view>
+#include <thread>  // NOLINT(build/c++11)
 #include <utility>
 #include <variant>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/meta/type_traits.h"
 #include "absl/status/status.h"
@@ -36,6 +41,8 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "absl/types/optional.h"
 #include "absl/types/span.h"
 #include "xls/dslx/bindings.h"
@@ -46,6 +53,7 @@
 #include "xls/dslx/create_import_data.h"
 #include "xls/dslx/error_printer.h"
 #include "xls/dslx/errors.h"
+#include "xls/dslx/hot_function_jit.h"
 #include "xls/dslx/interp_value_helpers.h"
 #include "xls/dslx/ir_converter.h"
 #include "xls/dslx/mangle.h"
@@ -53,6 +61,16 @@
 #include "xls/dslx/typecheck.h"
 #include "xls/interpreter/function_interpreter.h"
 #include "xls/interpreter/random_value.h"
+#include "xls/ir/events.h"
+#include "xls/ir/ir_parser.h"
+#include "xls/ir/type.h"
+#include "xls/passes/dce_pass.h"
+#include "xls/passes/inlining_pass.h"
+#include "xls/passes/map_inlining_pass.h"
+#include "xls/passes/pass_base.h"
+#include "xls/passes/passes.h"
+#include "xls/passes/unroll_pass.h"
+#include "xls/solvers/z3_ir_translator.h"
 
 namespace xls::dslx {
 namespace {
@@ -61,6 +79,9 @@ namespace {
 constexpr int kUnitSpaces = 7;
 constexpr int kQuickcheckSpaces = 15;
 
+// How long the SMT solver may spend on a quickcheck using the prove strategy.
+constexpr absl::Duration kQuickCheckProofTimeout = absl::Minutes(5);
+
 absl::Status RunTestFunction(ImportData* import_data, TypeInfo* type_info,
                              Module* module, TestFunction* tf,
                              const BytecodeInterpreterOptions& options) {
@@ -270,9 +291,196 @@ absl::StatusOr<QuickCheckResults> DoQuickCheck(xls::Function* xls_function,
   return results;
 }
 
+// Returns the total number of bits in the parameters of the given function.
+static int64_t GetInputBitCount(xls::Function* f) {
+  int64_t bit_count = 0;
+  for (xls::Param* param : f->params()) {
+    bit_count += param->GetType()->GetFlatBitCount();
+  }
+  return bit_count;
+}
+
+// Builds a value of the given type from the low bits of "*bits", which are
+// consumed (shifted out). The type must have fewer than 64 bits.
+static Value ValueFromLowBits(xls::Type* type, uint64_t* bits) {
+  switch (type->kind()) {
+    case TypeKind::kBits: {
+      int64_t bit_count = type->AsBitsOrDie()->bit_count();
+      uint64_t mask = (uint64_t{1} << bit_count) - 1;
+      Value value(UBits(*bits & mask, bit_count));
+      *bits >>= bit_count;
+      return value;
+    }
+    case TypeKind::kTuple: {
+      std::vector<Value> elements;
+      for (xls::Type* element_type : type->AsTupleOrDie()->element_types()) {
+        elements.push_back(ValueFromLowBits(element_type, bits));
+      }
+      return Value::TupleOwned(std::move(elements));
+    }
+    case TypeKind::kArray: {
+      xls::ArrayType* array_type = type->AsArrayOrDie();
+      std::vector<Value> elements;
+      for (int64_t i = 0; i < array_type->size(); ++i) {
+        elements.push_back(ValueFromLowBits(array_type->element_type(), bits));
+      }
+      return Value::ArrayOwned(std::move(elements));
+    }
+    case TypeKind::kToken:
+      return Value::Token();
+  }
+  XLS_LOG(FATAL) << "Invalid type kind: " << type->ToString();
+}
+
+// Returns the arguments at the given index into the input space of "f": the
+// first parameter takes the least significant bits of the index.
+static std::vector<Value> ArgsFromIndex(xls::Function* f, uint64_t index) {
+  std::vector<Value> args;
+  for (xls::Param* param : f->params()) {
+    args.push_back(ValueFromLowBits(param->GetType(), &index));
+  }
+  return args;
+}
+
+// Evaluates the predicate on the inputs in [begin, end), stopping at the first
+// falsifying input or once an input at a smaller index has been found
+// falsifying by another thread. Lowers "*first_falsifying" to the index of the
+// falsifying input, if any.
+static absl::Status EvaluateQuickCheckRange(
+    const FunctionJit* jit, uint64_t begin, uint64_t end,
+    std::atomic<uint64_t>* first_falsifying) {
+  xls::Function* f = jit->function();
+  std::unique_ptr<FunctionJitBuffers> buffers = jit->CreateBuffers();
+  auto note_falsifying = [&](uint64_t index) {
+    uint64_t current = first_falsifying->load();
+    while (index < current &&
+           !first_falsifying->compare_exchange_weak(current, index)) {
+    }
+  };
+
+  if (!absl::c_all_of(f->params(),
+                      [](xls::Param* p) { return p->GetType()->IsBits(); })) {
+    for (uint64_t index = begin; index < end && index < *first_falsifying;
+         ++index) {
+      XLS_ASSIGN_OR_RETURN(Value result,
+                           DropInterpreterEvents(jit->Run(
+                               ArgsFromIndex(f, index), buffers.get())));
+      if (result.IsAllZeros()) {
+        note_falsifying(index);
+        break;
+      }
+    }
+    return absl::OkStatus();
+  }
+
+  // All parameters are bits, so the arguments are written directly into the
+  // JIT's native (little-endian) layout rather than marshaled through Values.
+  std::vector<std::vector<uint8_t>> arg_buffers;
+  std::vector<uint8_t*> arg_pointers;
+  std::vector<int64_t> arg_widths;
+  for (int64_t i = 0; i < f->params().size(); ++i) {
+    arg_buffers.push_back(std::vector<uint8_t>(jit->GetArgTypeSize(i), 0));
+    arg_pointers.push_back(arg_buffers.back().data());
+    arg_widths.push_back(f->param(i)->GetType()->GetFlatBitCount());
+  }
+  std::vector<uint8_t> result_buffer(jit->GetReturnTypeSize());
+  for (uint64_t index = begin; index < end && index < *first_falsifying;
+       ++index) {
+    uint64_t remaining = index;
+    for (int64_t i = 0; i < arg_buffers.size(); ++i) {
+      uint64_t arg = remaining & ((uint64_t{1} << arg_widths[i]) - 1);
+      remaining >>= arg_widths[i];
+      std::memcpy(arg_pointers[i], &arg,
+                  std::min(arg_buffers[i].size(), sizeof(arg)));
+    }
+    InterpreterEvents events;
+    XLS_RETURN_IF_ERROR(jit->RunWithViews(arg_pointers,
+                                          absl::MakeSpan(result_buffer),
+                                          &events, buffers.get()));
+    // Assertion failures in the predicate are errors, as in the non-bits path.
+    XLS_RETURN_IF_ERROR(InterpreterEventsToStatus(events));
+    if ((result_buffer[0] & 1) == 0) {
+      note_falsifying(index);
+      break;
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::optional<std::vector<Value>>> DoExhaustiveQuickCheck(
+    xls::Function* xls_function, std::string ir_name,
+    RunComparator* run_comparator, int64_t num_threads) {
+  int64_t bit_count = GetInputBitCount(xls_function);
+  if (bit_count > kMaxExhaustiveQuickCheckBits) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Input space of %s has %d bits; exhaustive quickcheck supports at "
+        "most %d",
+        xls_function->name(), bit_count, kMaxExhaustiveQuickCheckBits));
+  }
+  XLS_RET_CHECK(xls_function->return_value()->GetType()->IsBits() &&
+                xls_function->return_value()->BitCountOrDie() == 1);
+  XLS_ASSIGN_OR_RETURN(FunctionJit * jit,
+                       run_comparator->GetOrCompileJitFunction(
+                           std::move(ir_name), xls_function));
+
+  const uint64_t space_size = uint64_t{1} << bit_count;
+  num_threads = std::clamp<int64_t>(num_threads, 1, space_size);
+  std::atomic<uint64_t> first_falsifying(space_size);
+  std::vector<absl::Status> statuses(num_threads);
+  std::vector<std::thread> threads;
+  for (int64_t i = 0; i < num_threads; ++i) {
+    uint64_t begin = space_size * i / num_threads;
+    uint64_t end = space_size * (i + 1) / num_threads;
+    threads.emplace_back([&, i, begin, end] {
+      statuses[i] =
+          EvaluateQuickCheckRange(jit, begin, end, &first_falsifying);
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  for (const absl::Status& status : statuses) {
+    XLS_RETURN_IF_ERROR(status);
+  }
+
+  if (first_falsifying == space_size) {
+    return std::nullopt;
+  }
+  return std::optional<std::vector<Value>>(
+      ArgsFromIndex(xls_function, first_falsifying));
+}
+
+absl::StatusOr<std::optional<std::vector<Value>>> DoProveQuickCheck(
+    xls::Function* xls_function, absl::Duration timeout) {
+  // The translator does not handle invokes (or maps and counted fors), so
+  // inline everything into a copy of the package rather than mutating the one
+  // that is being tested.
+  XLS_ASSIGN_OR_RETURN(
+      std::unique_ptr<Package> package,
+      xls::Parser::ParsePackage(xls_function->package()->DumpIr()));
+  XLS_ASSIGN_OR_RETURN(xls::Function * f,
+                       package->GetFunction(xls_function->name()));
+  CompoundPass inlining_passes("inlining_passes", "All inlining passes.");
+  inlining_passes.Add<MapInliningPass>();
+  inlining_passes.Add<UnrollPass>();
+  inlining_passes.Add<InliningPass>();
+  inlining_passes.Add<DeadCodeEliminationPass>();
+  PassResults pass_results;
+  bool changed = true;
+  while (changed) {
+    XLS_ASSIGN_OR_RETURN(changed, inlining_passes.Run(package.get(),
+                                                      PassOptions(),
+                                                      &pass_results));
+  }
+
+  return solvers::z3::FindCounterexample(
+      f, f->return_value(), solvers::z3::Predicate::NotEqualToZero(), timeout);
+}
+
 static absl::Status RunQuickCheck(RunComparator* run_comparator,
                                   Package* ir_package, QuickCheck* quickcheck,
-                                  TypeInfo* type_info, int64_t seed) {
+                                  TypeInfo* type_info, int64_t seed,
+                                  QuickCheckStrategy* strategy_used) {
   Function* fn = quickcheck->f();
   XLS_ASSIGN_OR_RETURN(std::string ir_name,
                        MangleDslxName(fn->owner()->name(), fn->identifier(),
@@ -281,18 +489,64 @@ static absl::Status RunQuickCheck(RunComparator* run_comparator,
   XLS_ASSIGN_OR_RETURN(xls::Function * ir_function,
                        ir_package->GetFunction(ir_name));
 
-  XLS_ASSIGN_OR_RETURN(
-      QuickCheckResults qc_results,
-      DoQuickCheck(ir_function, std::move(ir_name), run_comparator, seed,
-                   quickcheck->test_count()));
-  const auto& [arg_sets, results] = qc_results;
-  XLS_ASSIGN_OR_RETURN(Bits last_result, results.back().GetBitsWithStatus());
-  if (!last_result.IsZero()) {
+  QuickCheckStrategy strategy = quickcheck->strategy();
+  int64_t input_bit_count = GetInputBitCount(ir_function);
+  if (strategy == QuickCheckStrategy::kAuto) {
+    strategy = input_bit_count <= kMaxExhaustiveQuickCheckBits
+                   ? QuickCheckStrategy::kExhaustive
+                   : QuickCheckStrategy::kProve;
+  }
+
+  std::optional<std::vector<Value>> falsifying_argset;
+  std::string how_found;
+  if (strategy == QuickCheckStrategy::kExhaustive) {
+    if (input_bit_count > kMaxExhaustiveQuickCheckBits) {
+      return FailureErrorStatus(
+          fn->span(),
+          absl::StrFormat("Cannot exhaustively check an input space of %d "
+                          "bits; at most %d bits are supported",
+                          input_bit_count, kMaxExhaustiveQuickCheckBits));
+    }
+    XLS_ASSIGN_OR_RETURN(
+        falsifying_argset,
+        DoExhaustiveQuickCheck(ir_function, ir_name, run_comparator,
+                               std::thread::hardware_concurrency()));
+    how_found = "by exhaustive search";
+  } else if (strategy == QuickCheckStrategy::kProve) {
+    absl::StatusOr<std::optional<std::vector<Value>>> proof =
+        DoProveQuickCheck(ir_function, kQuickCheckProofTimeout);
+    if (proof.ok()) {
+      falsifying_argset = std::move(proof).value();
+      how_found = "by SMT solver";
+    } else if (quickcheck->strategy() == QuickCheckStrategy::kAuto) {
+      // The solver timed out or could not translate the predicate; sampling
+      // still gives some assurance.
+      XLS_VLOG(1) << "Could not prove quickcheck " << quickcheck->identifier()
+                  << ", falling back to sampling: " << proof.status();
+      strategy = QuickCheckStrategy::kSample;
+    } else {
+      return proof.status();
+    }
+  }
+  if (strategy == QuickCheckStrategy::kSample) {
+    XLS_ASSIGN_OR_RETURN(
+        QuickCheckResults qc_results,
+        DoQuickCheck(ir_function, std::move(ir_name), run_comparator, seed,
+                     quickcheck->test_count()));
+    const auto& [arg_sets, results] = qc_results;
+    XLS_ASSIGN_OR_RETURN(Bits last_result, results.back().GetBitsWithStatus());
+    if (last_result.IsZero()) {
+      falsifying_argset = arg_sets.back();
+      how_found = absl::StrFormat("after %d tests", results.size());
+    }
+  }
+  *strategy_used = strategy;
+
+  if (!falsifying_argset.has_value()) {
     // Did not find a falsifying example.
     return absl::OkStatus();
   }
 
-  const std::vector<Value>& last_argset = arg_sets.back();
   XLS_ASSIGN_OR_RETURN(FunctionType * fn_type,
                        type_info->GetItemAs<FunctionType>(fn));
   const std::vector<std::unique_ptr<ConcreteType>>& params = fn_type->params();
@@ -300,7 +554,7 @@ static absl::Status RunQuickCheck(RunComparator* run_comparator,
   std::vector<InterpValue> dslx_argset;
   for (int64_t i = 0; i < params.size(); ++i) {
     const ConcreteType& arg_type = *params[i];
-    const Value& value = last_argset[i];
+    const Value& value = falsifying_argset->at(i);
     XLS_ASSIGN_OR_RETURN(InterpValue interp_value,
                          ValueToInterpValue(value, &arg_type));
     dslx_argset.push_back(interp_value);
@@ -310,9 +564,8 @@ static absl::Status RunQuickCheck(RunComparator* run_comparator,
         absl::StrAppend(out, v.ToString());
       });
   return FailureErrorStatus(
-      fn->span(),
-      absl::StrFormat("Found falsifying example after %d tests: [%s]",
-                      results.size(), dslx_argset_str));
+      fn->span(), absl::StrFormat("Found falsifying example %s: [%s]",
+                                  how_found, dslx_argset_str));
 }
 
 using HandleError = const std::function<void(
@@ -336,14 +589,25 @@ static absl::Status RunQuickChecksIfJitEnabled(
             << std::endl;
   for (QuickCheck* quickcheck : entry_module->GetQuickChecks()) {
     const std::string& test_name = quickcheck->identifier();
-    std::cerr << "[ RUN QUICKCHECK        ] " << test_name
-              << " count: " << quickcheck->test_count() << std::endl;
-    absl::Status status =
-        RunQuickCheck(run_comparator, ir_package, quickcheck, type_info, *seed);
+    std::cerr << "[ RUN QUICKCHECK        ] " << test_name;
+    if (quickcheck->strategy() == QuickCheckStrategy::kSample) {
+      std::cerr << " count: " << quickcheck->test_count() << std::endl;
+    } else {
+      std::cerr << " strategy: "
+                << QuickCheckStrategyToString(quickcheck->strategy())
+                << std::endl;
+    }
+    QuickCheckStrategy strategy_used = quickcheck->strategy();
+    absl::Time start = absl::Now();
+    absl::Status status = RunQuickCheck(run_comparator, ir_package, quickcheck,
+                                        type_info, *seed, &strategy_used);
+    absl::Duration elapsed = absl::Now() - start;
     if (!status.ok()) {
       handle_error(status, test_name, /*is_quickcheck=*/true);
     } else {
-      std::cerr << "[                    OK ] " << test_name << std::endl;
+      std::cerr << "[                    OK ] " << test_name << " ("
+                << QuickCheckStrategyToString(strategy_used) << ", "
+                << absl::FormatDuration(elapsed) << ")" << std::endl;
     }
   }
   std::cerr << absl::StreamFormat(
@@ -448,6 +712,14 @@ absl::StatusOr<TestResult> ParseAndTest(std::string_view program,
     };
   }
 
+  // In mixed-mode execution, frequently called functions are dispatched to the
+  // JIT. The call counts and compiled functions are shared by all tests.
+  std::optional<HotFunctionJit> hot_function_jit;
+  if (options.auto_jit_threshold.has_value()) {
+    hot_function_jit.emplace(&import_data, *options.auto_jit_threshold,
+                             options.convert_options);
+  }
+
   // Run unit tests.
   for (const std::string& test_name : entry_module->GetTestNames()) {
     if (!TestMatchesFilter(test_name, options.test_filter)) {
@@ -464,6 +736,9 @@ absl::StatusOr<TestResult> ParseAndTest(std::string_view program,
         .trace_hook(InfoLoggingTraceHook)
         .trace_channels(options.trace_channels)
         .max_ticks(options.max_ticks);
+    if (hot_function_jit.has_value()) {
+      interpreter_options.fn_call_hook(hot_function_jit->MakeFnCallHook());
+    }
     if (std::holds_alternative<TestFunction*>(*member)) {
       XLS_ASSIGN_OR_RETURN(TestFunction * tf, entry_module->GetTest(test_name));
       status = RunTestFunction(&import_data, tm_or.value().type_info,
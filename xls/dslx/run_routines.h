@@ -22,6 +22,7 @@
 
 #include <filesystem>  // NOLINT
 #include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -29,6 +30,7 @@
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/time/time.h"
 #include "absl/types/optional.h"
 #include "absl/types/span.h"
 #include "xls/common/test_macros.h"
@@ -95,6 +97,9 @@ class RunComparator {
 //   seed: Seed for QuickCheck random input stimulus.
 //   convert_options: Options used in IR conversion, see `ConvertOptions` for
 //    details.
+//   auto_jit_threshold: If set, functions called more than this many times
+//    (per set of parametric bindings) are JIT compiled and subsequently
+//    evaluated by the JIT, see `HotFunctionJit`.
 struct ParseAndTestOptions {
   std::string stdlib_path = xls::kDefaultDslxStdlibPath;
   absl::Span<const std::filesystem::path> dslx_paths = {};
@@ -107,6 +112,7 @@ struct ParseAndTestOptions {
   bool warnings_as_errors = true;
   bool trace_channels = false;
   std::optional<int64_t> max_ticks;
+  std::optional<int64_t> auto_jit_threshold;
 };
 
 enum class TestResult {
@@ -148,6 +154,32 @@ absl::StatusOr<QuickCheckResults> DoQuickCheck(xls::Function* xls_function,
                                                RunComparator* run_comparator,
                                                int64_t seed, int64_t num_tests);
 
+// The largest number of input bits for which the exhaustive quickcheck
+// strategy is used -- beyond this the input space has more than 2^32 points.
+inline constexpr int64_t kMaxExhaustiveQuickCheckBits = 32;
+
+// JIT-compiles the given xls_function and invokes it on every point of its
+// input space (which may have at most kMaxExhaustiveQuickCheckBits bits). The
+// space is split into num_threads contiguous ranges that are evaluated
+// concurrently.
+//
+// Returns the falsifying arguments with the smallest index in the input space
+// (so the result does not depend on thread scheduling), or std::nullopt if the
+// predicate holds for every input.
+absl::StatusOr<std::optional<std::vector<Value>>> DoExhaustiveQuickCheck(
+    xls::Function* xls_function, std::string ir_name,
+    RunComparator* run_comparator, int64_t num_threads);
+
+// Attempts to prove that the given xls_function holds for all inputs using
+// the Z3 IR translator. Invoked functions are inlined into a copy of the
+// package first, as the translator does not handle invokes.
+//
+// Returns a falsifying set of arguments, std::nullopt if the predicate was
+// proven, or a DeadlineExceeded error if the solver could not decide it within
+// the timeout.
+absl::StatusOr<std::optional<std::vector<Value>>> DoProveQuickCheck(
+    xls::Function* xls_function, absl::Duration timeout);
+
 }  // namespace xls::dslx
 
 #endif  // XLS_DSLX_RUN_ROUTINES_H_
@@ -17,6 +17,7 @@
 #include <stdint.h>
 
 #include <filesystem>  // NOLINT
+#include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
@@ -27,6 +28,7 @@
 #include "absl/container/flat_hash_map.h"
 #include "absl/meta/type_traits.h"
 #include "absl/status/statusor.h"
+#include "absl/time/time.h"
 #include "xls/common/file/temp_file.h"
 #include "xls/common/status/matchers.h"
 #include "xls/ir/ir_parser.h"
@@ -116,6 +118,52 @@ fn trivial(x: u5) -> bool { false }
   EXPECT_THAT(result, status_testing::IsOkAndHolds(TestResult::kSomeFailed));
 }
 
+TEST(RunRoutinesTest, ExhaustiveQuickCheck) {
+  constexpr const char* kProgram = R"(
+#[quickcheck(strategy=exhaustive)]
+fn add_commutes(x: u8, y: u8) -> bool { x + y == y + x }
+)";
+  RunComparator jit_comparator(CompareMode::kJit);
+  ParseAndTestOptions options;
+  options.run_comparator = &jit_comparator;
+  absl::StatusOr<TestResult> result =
+      ParseAndTest(kProgram, "test", "test.x", options);
+  EXPECT_THAT(result, status_testing::IsOkAndHolds(TestResult::kAllPassed));
+}
+
+TEST(RunRoutinesTest, ProveQuickCheck) {
+  constexpr const char* kProgram = R"(
+fn add(x: u64, y: u64) -> u64 { x + y }
+
+#[quickcheck(strategy=prove)]
+fn add_commutes(x: u64, y: u64) -> bool { add(x, y) == add(y, x) }
+)";
+  RunComparator jit_comparator(CompareMode::kJit);
+  ParseAndTestOptions options;
+  options.run_comparator = &jit_comparator;
+  absl::StatusOr<TestResult> result =
+      ParseAndTest(kProgram, "test", "test.x", options);
+  EXPECT_THAT(result, status_testing::IsOkAndHolds(TestResult::kAllPassed));
+}
+
+// A single falsifying value in a 64-bit space is all but impossible to sample,
+// but the auto strategy proves the predicate and finds it.
+TEST(RunRoutinesTest, FailingAutoQuickCheck) {
+  constexpr const char* kProgram = R"(
+#[quickcheck(strategy=auto)]
+fn not_magic(x: u64) -> bool { x != u64:0xdeadbeeff00dcafe }
+)";
+  XLS_ASSERT_OK_AND_ASSIGN(auto temp_file,
+                           TempFile::CreateWithContent(kProgram, "_test.x"));
+  RunComparator jit_comparator(CompareMode::kJit);
+  ParseAndTestOptions options;
+  options.run_comparator = &jit_comparator;
+  options.seed = int64_t{42};
+  absl::StatusOr<TestResult> result =
+      ParseAndTest(kProgram, "test", std::string(temp_file.path()), options);
+  EXPECT_THAT(result, status_testing::IsOkAndHolds(TestResult::kSomeFailed));
+}
+
 TEST(RunRoutinesTest, FailingProc) {
   constexpr std::string_view kProgram = R"(
 #[test_proc()]
@@ -262,6 +310,143 @@ TEST(QuickcheckTest, Seeding) {
   EXPECT_EQ(results1, results2);
 }
 
+// Exhaustive evaluation reports the falsifying input with the smallest index,
+// regardless of how the input space is split across threads.
+TEST(QuickcheckTest, ExhaustiveFindsFirstCounterexample) {
+  Package package("exhaustive");
+  std::string ir_text = R"(
+  fn lt_200(x: bits[8], y: bits[4]) -> bits[1] {
+    literal.3: bits[8] = literal(value=200)
+    ret ult.4: bits[1] = ult(x, literal.3)
+  }
+  )";
+  XLS_ASSERT_OK_AND_ASSIGN(xls::Function * function,
+                           Parser::ParseFunction(ir_text, &package));
+  RunComparator jit_comparator(CompareMode::kJit);
+  for (int64_t num_threads : {1, 3, 16}) {
+    EXPECT_THAT(DoExhaustiveQuickCheck(function, kFakeIrName, &jit_comparator,
+                                       num_threads),
+                status_testing::IsOkAndHolds(testing::Optional(
+                    testing::ElementsAre(Value(UBits(200, 8)),
+                                         Value(UBits(0, 4))))));
+  }
+}
+
+TEST(QuickcheckTest, ExhaustiveTuple) {
+  Package package("exhaustive_tuple");
+  std::string ir_text = R"(
+  fn same_members(x: (bits[4], bits[4])) -> bits[1] {
+    first_member: bits[4] = tuple_index(x, index=0)
+    second_member: bits[4] = tuple_index(x, index=1)
+    ret eq_value: bits[1] = eq(first_member, second_member)
+  }
+  )";
+  XLS_ASSERT_OK_AND_ASSIGN(xls::Function * function,
+                           Parser::ParseFunction(ir_text, &package));
+  RunComparator jit_comparator(CompareMode::kJit);
+  EXPECT_THAT(
+      DoExhaustiveQuickCheck(function, kFakeIrName, &jit_comparator,
+                             /*num_threads=*/4),
+      status_testing::IsOkAndHolds(testing::Optional(testing::ElementsAre(
+          Value::Tuple({Value(UBits(1, 4)), Value(UBits(0, 4))})))));
+}
+
+TEST(QuickcheckTest, ExhaustiveHolds) {
+  Package package("exhaustive_holds");
+  std::string ir_text = R"(
+  fn le_max(x: bits[10], y: bits[10]) -> bits[1] {
+    literal.3: bits[10] = literal(value=1023)
+    ret ule.4: bits[1] = ule(x, literal.3)
+  }
+  )";
+  XLS_ASSERT_OK_AND_ASSIGN(xls::Function * function,
+                           Parser::ParseFunction(ir_text, &package));
+  RunComparator jit_comparator(CompareMode::kJit);
+  EXPECT_THAT(DoExhaustiveQuickCheck(function, kFakeIrName, &jit_comparator,
+                                     /*num_threads=*/4),
+              status_testing::IsOkAndHolds(std::nullopt));
+}
+
+// An assertion failing in the predicate is reported as an error rather than
+// being dropped by the native-layout evaluation of bits parameters.
+TEST(QuickcheckTest, ExhaustiveAssertionFailure) {
+  Package package("exhaustive_assert");
+  std::string ir_text = R"(
+  fn lt_8(x: bits[4]) -> bits[1] {
+    after_all.2: token = after_all()
+    literal.3: bits[4] = literal(value=8)
+    ult.4: bits[1] = ult(x, literal.3)
+    assert.5: token = assert(after_all.2, ult.4, message="x is too large")
+    ret literal.6: bits[1] = literal(value=1)
+  }
+  )";
+  XLS_ASSERT_OK_AND_ASSIGN(xls::Function * function,
+                           Parser::ParseFunction(ir_text, &package));
+  RunComparator jit_comparator(CompareMode::kJit);
+  EXPECT_THAT(DoExhaustiveQuickCheck(function, kFakeIrName, &jit_comparator,
+                                     /*num_threads=*/2),
+              status_testing::StatusIs(absl::StatusCode::kAborted,
+                                       testing::HasSubstr("x is too large")));
+}
+
+TEST(QuickcheckTest, ExhaustiveRejectsLargeInputSpace) {
+  Package package("exhaustive_too_large");
+  std::string ir_text = R"(
+  fn f(x: bits[33]) -> bits[1] {
+    ret literal.2: bits[1] = literal(value=1)
+  }
+  )";
+  XLS_ASSERT_OK_AND_ASSIGN(xls::Function * function,
+                           Parser::ParseFunction(ir_text, &package));
+  RunComparator jit_comparator(CompareMode::kJit);
+  EXPECT_THAT(DoExhaustiveQuickCheck(function, kFakeIrName, &jit_comparator,
+                                     /*num_threads=*/1),
+              status_testing::StatusIs(absl::StatusCode::kInvalidArgument,
+                                       testing::HasSubstr("has 33 bits")));
+}
+
+// The prover inlines invoked functions before translating the predicate.
+TEST(QuickcheckTest, ProveHoldsThroughInvoke) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> package,
+                           Parser::ParsePackage(R"(
+package prove_holds
+
+fn add(a: bits[64], b: bits[64]) -> bits[64] {
+  ret add.3: bits[64] = add(a, b)
+}
+
+fn commutes(x: bits[64], y: bits[64]) -> bits[1] {
+  invoke.6: bits[64] = invoke(x, y, to_apply=add)
+  invoke.7: bits[64] = invoke(y, x, to_apply=add)
+  ret eq.8: bits[1] = eq(invoke.6, invoke.7)
+}
+)"));
+  XLS_ASSERT_OK_AND_ASSIGN(xls::Function * function,
+                           package->GetFunction("commutes"));
+  EXPECT_THAT(DoProveQuickCheck(function, absl::InfiniteDuration()),
+              status_testing::IsOkAndHolds(std::nullopt));
+  // The package under test is left untouched.
+  EXPECT_EQ(package->functions().size(), 2);
+}
+
+TEST(QuickcheckTest, ProveFindsCounterexample) {
+  Package package("prove_fails");
+  std::string ir_text = R"(
+  fn not_magic(x: bits[64], y: bits[8]) -> bits[1] {
+    literal.3: bits[64] = literal(value=0xdeadbeeff00dcafe)
+    ret ne.4: bits[1] = ne(x, literal.3)
+  }
+  )";
+  XLS_ASSERT_OK_AND_ASSIGN(xls::Function * function,
+                           Parser::ParseFunction(ir_text, &package));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::optional<std::vector<Value>> counterexample,
+      DoProveQuickCheck(function, absl::InfiniteDuration()));
+  ASSERT_TRUE(counterexample.has_value());
+  ASSERT_EQ(counterexample->size(), 2);
+  EXPECT_EQ(counterexample->at(0), Value(UBits(0xdeadbeeff00dcafe, 64)));
+}
+
 TEST(BytecodeInterpreterTest, DeadlockedProc) {
   // Test proc never sends to the subproc, so network is deadlocked.
   constexpr std::string_view kProgram = R"(
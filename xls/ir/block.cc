@@ -437,6 +437,13 @@ static absl::Status AddToMapOfNodeVectors(
 
 Node* Block::AddNodeInternal(std::unique_ptr<Node> node) {
   Node* ptr = FunctionBase::AddNodeInternal(std::move(node));
+  // The port, register and instantiation bookkeeping below is not recorded
+  // for rollback.
+  if (ptr->Is<InputPort>() || ptr->Is<OutputPort>() ||
+      ptr->Is<RegisterRead>() || ptr->Is<RegisterWrite>() ||
+      ptr->Is<InstantiationInput>() || ptr->Is<InstantiationOutput>()) {
+    RecordUnrevertibleChange();
+  }
   if (RegisterRead* reg_read = dynamic_cast<RegisterRead*>(ptr)) {
     XLS_CHECK_OK(AddToMapOfNodeVectors(reg_read->GetRegister(), reg_read,
                                        &register_reads_));
@@ -458,6 +465,11 @@ absl::Status Block::RemoveNode(Node* n) {
   // Simliar to parameters in xls::Functions, input and output ports are also
   // also stored separately as vectors for easy access and to indicate ordering.
   // Fix up these vectors prior to removing the node.
+  if (n->Is<InputPort>() || n->Is<OutputPort>() || n->Is<RegisterRead>() ||
+      n->Is<RegisterWrite>() || n->Is<InstantiationInput>() ||
+      n->Is<InstantiationOutput>()) {
+    RecordUnrevertibleChange();
+  }
   if (n->Is<InputPort>() || n->Is<OutputPort>()) {
     Port port;
     if (n->Is<InputPort>()) {
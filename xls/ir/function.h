@@ -53,6 +53,7 @@ class Function : public FunctionBase {
     XLS_RET_CHECK_EQ(n->function_base(), this) << absl::StreamFormat(
         "Return value node %s is not in this function %s (is in function %s)",
         n->GetName(), name(), n->function_base()->name());
+    RecordUndo([this, old = return_value_]() { return_value_ = old; });
     return_value_ = n;
     return absl::OkStatus();
   }
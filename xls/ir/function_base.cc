@@ -14,6 +14,9 @@
 
 #include "xls/ir/function_base.h"
 
+#include <algorithm>
+#include <iterator>
+
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
@@ -58,6 +61,10 @@ absl::Status FunctionBase::MoveParamToIndex(Param* param, int64_t index) {
         "Given param is not a member of this function base: " +
         param->ToString());
   }
+  RecordUndo([this, param, old_index = it - params_.begin()]() {
+    params_.erase(std::find(params_.begin(), params_.end(), param));
+    params_.insert(params_.begin() + old_index, param);
+  });
   params_.erase(it);
   params_.insert(params_.begin() + index, param);
   return absl::OkStatus();
@@ -82,6 +89,24 @@ absl::StatusOr<Node*> FunctionBase::GetNode(
 absl::Status FunctionBase::RemoveNode(Node* node) {
   XLS_RET_CHECK(node->users().empty()) << node->GetName();
   XLS_RET_CHECK(!HasImplicitUse(node)) << node->GetName();
+  auto node_it = node_iterators_.find(node);
+  XLS_RET_CHECK(node_it != node_iterators_.end());
+  if (!HasCheckpoint()) {
+    DetachNode(node);
+    return absl::OkStatus();
+  }
+  auto next_it = std::next(node_it->second);
+  Node* next = next_it == nodes_.end() ? nullptr : next_it->get();
+  int64_t param_index = -1;
+  if (node->Is<Param>()) {
+    param_index = std::find(params_.begin(), params_.end(), node) -
+                  params_.begin();
+  }
+  undo_log_.push_back(NodeRemoved{DetachNode(node), next, param_index});
+  return absl::OkStatus();
+}
+
+std::unique_ptr<Node> FunctionBase::DetachNode(Node* node) {
   std::vector<Node*> unique_operands;
   for (Node* operand : node->operands()) {
     if (!absl::c_linear_search(unique_operands, operand)) {
@@ -96,12 +121,105 @@ absl::Status FunctionBase::RemoveNode(Node* node) {
                   params_.end());
   }
   auto node_it = node_iterators_.find(node);
-  XLS_RET_CHECK(node_it != node_iterators_.end());
+  std::unique_ptr<Node> detached = std::move(*node_it->second);
   nodes_.erase(node_it->second);
   node_iterators_.erase(node_it);
+  return detached;
+}
+
+void FunctionBase::Checkpoint() { checkpoints_.push_back(undo_log_.size()); }
+
+void FunctionBase::Commit() {
+  XLS_CHECK(HasCheckpoint()) << "No checkpoint to commit in " << name();
+  checkpoints_.pop_back();
+  if (checkpoints_.empty()) {
+    undo_log_.clear();
+  }
+}
+
+absl::Status FunctionBase::Rollback() {
+  XLS_RET_CHECK(HasCheckpoint()) << "No checkpoint to roll back in " << name();
+  int64_t checkpoint = checkpoints_.back();
+  checkpoints_.pop_back();
+  bool revertible =
+      std::none_of(undo_log_.begin() + checkpoint, undo_log_.end(),
+                   [](const UndoEntry& entry) {
+                     return std::holds_alternative<UnrevertibleChange>(entry);
+                   });
+  if (!revertible) {
+    // Leave the entries in place so rolling back an enclosing checkpoint fails
+    // as well.
+    if (checkpoints_.empty()) {
+      undo_log_.clear();
+    }
+    return absl::FailedPreconditionError(absl::StrFormat(
+        "Cannot roll back changes to %s; a change which does not support "
+        "rollback was made since the checkpoint",
+        name()));
+  }
+  while (undo_log_.size() > checkpoint) {
+    UndoEntry entry = std::move(undo_log_.back());
+    undo_log_.pop_back();
+    Undo(std::move(entry));
+  }
   return absl::OkStatus();
 }
 
+void FunctionBase::RecordOperandsChange(Node* node) {
+  // Nodes which are not yet part of the graph are constructed rather than
+  // changed.
+  if (HasCheckpoint() && node_iterators_.contains(node)) {
+    undo_log_.push_back(OperandsChanged{
+        node, std::vector<Node*>(node->operands().begin(),
+                                 node->operands().end())});
+  }
+}
+
+void FunctionBase::RecordRename(Node* node) {
+  if (HasCheckpoint() && node_iterators_.contains(node)) {
+    undo_log_.push_back(NodeRenamed{node, node->name_});
+  }
+}
+
+void FunctionBase::Undo(UndoEntry entry) {
+  if (NodeAdded* added = std::get_if<NodeAdded>(&entry)) {
+    XLS_CHECK(added->node->users().empty()) << added->node->GetName();
+    DetachNode(added->node);
+  } else if (NodeRemoved* removed = std::get_if<NodeRemoved>(&entry)) {
+    Node* node = removed->node.get();
+    NodeList::iterator position = removed->next == nullptr
+                                      ? nodes_.end()
+                                      : node_iterators_.at(removed->next);
+    node_iterators_[node] = nodes_.insert(position, std::move(removed->node));
+    if (removed->param_index >= 0) {
+      params_.insert(params_.begin() + removed->param_index,
+                     node->As<Param>());
+    }
+    for (Node* operand : node->operands()) {
+      operand->AddUser(node);
+    }
+  } else if (OperandsChanged* changed = std::get_if<OperandsChanged>(&entry)) {
+    Node* node = changed->node;
+    for (Node* operand : node->operands()) {
+      if (operand != nullptr) {
+        operand->users_.erase(node);
+      }
+    }
+    node->operands_ = std::move(changed->operands);
+    for (Node* operand : node->operands()) {
+      if (operand != nullptr) {
+        operand->AddUser(node);
+      }
+    }
+  } else if (NodeRenamed* renamed = std::get_if<NodeRenamed>(&entry)) {
+    renamed->node->name_ = std::move(renamed->name);
+  } else if (auto* undo = std::get_if<std::function<void()>>(&entry)) {
+    (*undo)();
+  } else {
+    XLS_LOG(FATAL) << "Unrevertible change in " << name();
+  }
+}
+
 absl::Status FunctionBase::Accept(DfsVisitor* visitor) {
   for (Node* node : nodes()) {
     if (node->users().empty()) {
@@ -165,6 +283,9 @@ Node* FunctionBase::AddNodeInternal(std::unique_ptr<Node> node) {
   }
   Node* ptr = node.get();
   node_iterators_[ptr] = nodes_.insert(nodes_.end(), std::move(node));
+  if (HasCheckpoint()) {
+    undo_log_.push_back(NodeAdded{ptr});
+  }
   return ptr;
 }
 
@@ -15,8 +15,10 @@
 #ifndef XLS_IR_FUNCTION_BASE_H_
 #define XLS_IR_FUNCTION_BASE_H_
 
+#include <functional>
 #include <memory>
 #include <string>
+#include <variant>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
@@ -124,6 +126,25 @@ class FunctionBase {
   // function type signature.
   virtual absl::Status RemoveNode(Node* n);
 
+  // Transactional editing of the graph. Checkpoint() starts recording the
+  // changes made to this function base: node additions and removals, operand
+  // replacements, renames, parameter reordering, and changes to the return
+  // value, proc state and next token. Rollback() reverts every change made
+  // since the most recent checkpoint and Commit() keeps them; both discard the
+  // checkpoint. Checkpoints nest. Nodes removed while a checkpoint is active
+  // are detached from the graph but kept alive until the outermost checkpoint
+  // is discarded, so rolling back restores the original Node objects.
+  //
+  // Changes to attributes of individual nodes (e.g., the start of a bit slice
+  // or a source location) are not recorded. Adding or removing block ports,
+  // register accesses and instantiation connections is not supported; after
+  // such a change Rollback() returns a FailedPrecondition error and leaves the
+  // graph as is.
+  void Checkpoint();
+  absl::Status Rollback();
+  void Commit();
+  bool HasCheckpoint() const { return !checkpoints_.empty(); }
+
   // Visit all nodes (including nodes not reachable from the root) in the
   // function using the given visitor.
   absl::Status Accept(DfsVisitor* visitor);
@@ -157,6 +178,22 @@ class FunctionBase {
   // added node.
   virtual Node* AddNodeInternal(std::unique_ptr<Node> node);
 
+  // Records an action which reverts a change made by a subclass, if a
+  // checkpoint is active. The action must not itself record changes.
+  void RecordUndo(std::function<void()> undo) {
+    if (HasCheckpoint()) {
+      undo_log_.push_back(std::move(undo));
+    }
+  }
+
+  // Records that a change was made which cannot be reverted, if a checkpoint
+  // is active. Rolling back past this point fails.
+  void RecordUnrevertibleChange() {
+    if (HasCheckpoint()) {
+      undo_log_.push_back(UnrevertibleChange{});
+    }
+  }
+
   // Returns a vector containing the reserved words in the IR.
   static std::vector<std::string> GetIrReservedWords();
 
@@ -173,6 +210,49 @@ class FunctionBase {
 
   NameUniquer node_name_uniquer_ =
       NameUniquer(/*separator=*/"__", GetIrReservedWords());
+
+ private:
+  // Node records changes to its operands and name.
+  friend class Node;
+
+  // Entries of the undo log.
+  struct NodeAdded {
+    Node* node;
+  };
+  struct NodeRemoved {
+    std::unique_ptr<Node> node;
+    // The node following the removed node in the node list, or nullptr if it
+    // was the last node.
+    Node* next;
+    // Index of the node in the parameter list, or -1 if it is not a param.
+    int64_t param_index;
+  };
+  struct OperandsChanged {
+    Node* node;
+    std::vector<Node*> operands;
+  };
+  struct NodeRenamed {
+    Node* node;
+    std::string name;
+  };
+  struct UnrevertibleChange {};
+  using UndoEntry = std::variant<NodeAdded, NodeRemoved, OperandsChanged,
+                                 NodeRenamed, UnrevertibleChange,
+                                 std::function<void()>>;
+
+  // Called by Node before its operands or name change.
+  void RecordOperandsChange(Node* node);
+  void RecordRename(Node* node);
+
+  // Unlinks the node from its operands and removes it from the node and
+  // parameter lists. Returns ownership of the node.
+  std::unique_ptr<Node> DetachNode(Node* node);
+
+  void Undo(UndoEntry entry);
+
+  // Sizes of the undo log at each active checkpoint, innermost last.
+  std::vector<int64_t> checkpoints_;
+  std::vector<UndoEntry> undo_log_;
 };
 
 std::ostream& operator<<(std::ostream& os, const FunctionBase& function);
@@ -425,5 +425,75 @@ fn graph(p: bits[42], q: bits[42]) -> bits[42] {
   }
 }
 
+TEST_F(FunctionTest, RollbackRestoresFunction) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
+fn f(x: bits[32], y: bits[32]) -> bits[32] {
+  a: bits[32] = add(x, y)
+  b: bits[32] = sub(a, y)
+  ret c: bits[32] = umul(b, x)
+}
+)",
+                                                       p.get()));
+  std::string original = f->DumpIr();
+  Node* a = FindNode("a", f);
+  Node* b = FindNode("b", f);
+  Node* c = FindNode("c", f);
+
+  f->Checkpoint();
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Node * neg, f->MakeNode<UnOp>(SourceInfo(), f->param(0), Op::kNeg));
+  XLS_ASSERT_OK(b->ReplaceUsesWith(neg));
+  XLS_ASSERT_OK(f->RemoveNode(b));
+  XLS_ASSERT_OK(f->RemoveNode(a));
+  c->SwapOperands(0, 1);
+  XLS_ASSERT_OK(f->set_return_value(neg));
+  XLS_ASSERT_OK(f->RemoveNode(c));
+  XLS_ASSERT_OK(f->MoveParamToIndex(f->param(1), 0));
+  EXPECT_EQ(f->node_count(), 3);
+  EXPECT_EQ(neg->GetName(), "b");
+
+  XLS_ASSERT_OK(f->Rollback());
+  EXPECT_FALSE(f->HasCheckpoint());
+  EXPECT_EQ(f->DumpIr(), original);
+  EXPECT_EQ(f->return_value(), c);
+  EXPECT_THAT(a->users(), ElementsAre(b));
+  EXPECT_THAT(c->operands(), ElementsAre(b, f->param(0)));
+  XLS_EXPECT_OK(VerifyFunction(f));
+}
+
+TEST_F(FunctionTest, NestedCheckpoints) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
+fn f(x: bits[32], y: bits[32]) -> bits[32] {
+  ret a: bits[32] = add(x, y)
+}
+)",
+                                                       p.get()));
+  std::string original = f->DumpIr();
+  Node* a = FindNode("a", f);
+
+  f->Checkpoint();
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Node * neg, f->MakeNode<UnOp>(SourceInfo(), f->param(0), Op::kNeg));
+  f->Checkpoint();
+  XLS_ASSERT_OK(f->set_return_value(neg));
+  f->Commit();
+  EXPECT_EQ(f->return_value(), neg);
+
+  // Rolling back the inner checkpoint only reverts the removal.
+  f->Checkpoint();
+  XLS_ASSERT_OK(f->RemoveNode(a));
+  XLS_ASSERT_OK(f->Rollback());
+  EXPECT_EQ(f->node_count(), 4);
+  EXPECT_EQ(f->return_value(), neg);
+
+  // The committed change is still reverted by the outer checkpoint.
+  XLS_ASSERT_OK(f->Rollback());
+  EXPECT_EQ(f->return_value(), a);
+  EXPECT_EQ(f->DumpIr(), original);
+  EXPECT_THAT(f->Rollback(), StatusIs(absl::StatusCode::kInternal));
+}
+
 }  // namespace
 }  // namespace xls
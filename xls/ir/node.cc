@@ -394,11 +394,13 @@ std::string Node::GetName() const {
 }
 
 void Node::SetName(std::string_view name) {
+  function_base()->RecordRename(this);
   name_ = function_base()->UniquifyNodeName(name);
 }
 
 void Node::ClearName() {
   XLS_CHECK(!Is<Param>());
+  function_base()->RecordRename(this);
   name_ = "";
 }
 
@@ -685,6 +687,7 @@ bool Node::ReplaceOperand(Node* old_operand, Node* new_operand) {
   if (this == new_operand) {
     return true;
   }
+  function_base()->RecordOperandsChange(this);
   bool did_replace = false;
   for (int64_t i = 0; i < operand_count(); ++i) {
     if (operands_[i] == old_operand) {
@@ -709,6 +712,7 @@ absl::Status Node::ReplaceOperandNumber(int64_t operand_no, Node* new_operand,
         << " new operand type: " << new_operand->GetType()->ToString();
   }
 
+  function_base()->RecordOperandsChange(this);
   // AddUser is idempotent so even if the new operand is already used by this
   // node in another operand slot, it is safe to call.
   new_operand->AddUser(this);
@@ -724,6 +728,12 @@ absl::Status Node::ReplaceOperandNumber(int64_t operand_no, Node* new_operand,
   return absl::OkStatus();
 }
 
+void Node::SwapOperands(int64_t a, int64_t b) {
+  function_base()->RecordOperandsChange(this);
+  // Operand/user chains already set up properly.
+  std::swap(operands_[a], operands_[b]);
+}
+
 absl::Status Node::ReplaceUsesWith(Node* replacement) {
   XLS_RET_CHECK(replacement != nullptr);
   XLS_RET_CHECK(GetType() == replacement->GetType())
@@ -744,6 +754,7 @@ absl::Status Node::ReplaceUsesWith(Node* replacement) {
   if (!Is<Param>() && HasAssignedName() && !replacement->HasAssignedName()) {
     // Do not use SetName because we do not want the name to be uniqued which
     // would add a suffix because (clearly) the name already exists.
+    function_base()->RecordRename(replacement);
     replacement->name_ = name_;
     ClearName();
   }
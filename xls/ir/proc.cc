@@ -81,6 +81,7 @@ absl::Status Proc::SetNextToken(Node* next) {
         "Cannot set next token to \"%s\", expected token type but has type %s",
         next->GetName(), next->GetType()->ToString()));
   }
+  RecordUndo([this, old = next_token_]() { next_token_ = old; });
   next_token_ = next;
   return absl::OkStatus();
 }
@@ -115,6 +116,9 @@ absl::Status Proc::SetNextStateElement(int64_t index, Node* next) {
         index, next->GetName(), next->GetType()->ToString(),
         GetStateElementType(index)->ToString()));
   }
+  RecordUndo([this, index, old = next_state_[index]]() {
+    next_state_[index] = old;
+  });
   next_state_[index] = next;
   return absl::OkStatus();
 }
@@ -173,13 +177,20 @@ absl::StatusOr<Param*> Proc::ReplaceStateElement(
 
 absl::Status Proc::RemoveStateElement(int64_t index) {
   XLS_RET_CHECK_LT(index, GetStateElementCount());
-  next_state_.erase(next_state_.begin() + index);
   if (!StateParams()[index]->users().empty()) {
     return absl::InvalidArgumentError(
         absl::StrFormat("Cannot remove state element %d of proc %s, existing "
                         "state param %s has uses",
                         index, name(), StateParams()[index]->GetName()));
   }
+  // Recorded before the param removal so it is reverted after the param is
+  // restored.
+  RecordUndo([this, index, next = next_state_[index],
+              init_value = init_values_[index]]() {
+    next_state_.insert(next_state_.begin() + index, next);
+    init_values_.insert(init_values_.begin() + index, init_value);
+  });
+  next_state_.erase(next_state_.begin() + index);
   XLS_RETURN_IF_ERROR(RemoveNode(StateParams()[index]));
 
   init_values_.erase(init_values_.begin() + index);
@@ -215,6 +226,10 @@ absl::StatusOr<Param*> Proc::InsertStateElement(
     next_state_.insert(next_state_.begin() + index, param);
   }
   init_values_.insert(init_values_.begin() + index, init_value);
+  RecordUndo([this, index]() {
+    next_state_.erase(next_state_.begin() + index);
+    init_values_.erase(init_values_.begin() + index);
+  });
   return param;
 }
 
@@ -145,6 +145,29 @@ TEST_F(ProcTest, AddAndRemoveState) {
               HasSubstr("next (my_after_all, foo, my_add, baz, bar"));
 }
 
+TEST_F(ProcTest, RollbackStateChanges) {
+  auto p = CreatePackage();
+  ProcBuilder pb("p", "tkn", p.get());
+  BValue state = pb.StateElement("x", Value(UBits(42, 32)));
+  BValue add = pb.Add(pb.Literal(UBits(1, 32)), state);
+  XLS_ASSERT_OK_AND_ASSIGN(Proc * proc, pb.Build(pb.GetTokenParam(), {add}));
+  std::string original = proc->DumpIr();
+
+  proc->Checkpoint();
+  XLS_ASSERT_OK(proc->SetNextStateElement(0, proc->GetStateParam(0)));
+  XLS_ASSERT_OK(proc->RemoveNode(add.node()));
+  XLS_ASSERT_OK(proc->RemoveStateElement(0));
+  XLS_ASSERT_OK(proc->AppendStateElement("y", Value(UBits(1, 8))).status());
+  EXPECT_EQ(proc->GetStateParam(0)->GetName(), "y");
+
+  XLS_ASSERT_OK(proc->Rollback());
+  EXPECT_EQ(proc->DumpIr(), original);
+  EXPECT_EQ(proc->GetStateElementCount(), 1);
+  EXPECT_EQ(proc->GetInitValueElement(0), Value(UBits(42, 32)));
+  EXPECT_EQ(proc->GetNextStateElement(0), add.node());
+  EXPECT_THAT(proc->params(), ElementsAre(proc->TokenParam(), state.node()));
+}
+
 TEST_F(ProcTest, ReplaceState) {
   auto p = CreatePackage();
   ProcBuilder pb("p", "tkn", p.get());
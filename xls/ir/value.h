@@ -15,6 +15,8 @@
 #ifndef XLS_IR_VALUE_H_
 #define XLS_IR_VALUE_H_
 
+#include <utility>
+
 #include "absl/status/statusor.h"
 #include "absl/types/span.h"
 #include "absl/types/variant.h"
@@ -156,6 +158,20 @@ class Value {
   bool operator==(const Value& other) const;
   bool operator!=(const Value& other) const { return !(*this == other); }
 
+  template <typename H>
+  friend H AbslHashValue(H h, const Value& value) {
+    h = H::combine(std::move(h), value.kind_);
+    switch (value.kind_) {
+      case ValueKind::kBits:
+        return H::combine(std::move(h), value.bits());
+      case ValueKind::kTuple:
+      case ValueKind::kArray:
+        return H::combine(std::move(h), value.elements());
+      default:
+        return h;
+    }
+  }
+
  private:
   Value(ValueKind kind, absl::Span<const Value> elements)
       : kind_(kind),
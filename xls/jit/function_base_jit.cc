@@ -14,6 +14,8 @@
 #include "xls/jit/function_base_jit.h"
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_format.h"
+#include "absl/types/span.h"
 #include "llvm/include/llvm/IR/Constants.h"
 #include "llvm/include/llvm/IR/DerivedTypes.h"
 #include "llvm/include/llvm/IR/Function.h"
@@ -878,6 +880,25 @@ absl::Status UnpackValue(llvm::Value* packed_buffer,
       Type* element_xls_type = array_type->element_type();
       llvm::Type* array_llvm_type =
           type_converter.ConvertToLlvmType(array_type);
+      if (type_converter.IsPackedArray(array_type)) {
+        // Unpack each element into a temporary buffer and insert it into the
+        // (zero-initialized) packed array.
+        builder->CreateStore(LlvmTypeConverter::ZeroOfType(array_llvm_type),
+                             unpacked_buffer);
+        llvm::Type* element_llvm_type =
+            type_converter.ConvertToLlvmType(element_xls_type);
+        llvm::Value* element_buffer = builder->CreateAlloca(element_llvm_type);
+        for (uint32_t i = 0; i < array_type->size(); i++) {
+          XLS_RETURN_IF_ERROR(UnpackValue(packed_buffer, element_buffer,
+                                          element_xls_type, bit_offset,
+                                          type_converter, builder));
+          type_converter.StorePackedArrayElement(
+              builder->CreateLoad(element_llvm_type, element_buffer),
+              unpacked_buffer, array_type, builder->getInt64(i), *builder);
+          bit_offset += element_xls_type->GetFlatBitCount();
+        }
+        return absl::OkStatus();
+      }
       for (uint32_t i = 0; i < array_type->size(); i++) {
         llvm::Value* unpacked_element_ptr =
             builder->CreateGEP(array_llvm_type, unpacked_buffer,
@@ -988,6 +1009,23 @@ absl::Status PackValue(llvm::Value* unpacked_buffer, llvm::Value* packed_buffer,
       Type* element_xls_type = array_type->element_type();
       llvm::Type* array_llvm_type =
           type_converter.ConvertToLlvmType(array_type);
+      if (type_converter.IsPackedArray(array_type)) {
+        // Extract each element of the packed array into a temporary buffer
+        // and pack it from there.
+        llvm::Value* element_buffer = builder->CreateAlloca(
+            type_converter.ConvertToLlvmType(element_xls_type));
+        for (uint32_t i = 0; i < array_type->size(); i++) {
+          builder->CreateStore(
+              type_converter.LoadPackedArrayElement(
+                  unpacked_buffer, array_type, builder->getInt64(i), *builder),
+              element_buffer);
+          XLS_RETURN_IF_ERROR(PackValue(element_buffer, packed_buffer,
+                                        element_xls_type, bit_offset,
+                                        type_converter, builder));
+          bit_offset += element_xls_type->GetFlatBitCount();
+        }
+        return absl::OkStatus();
+      }
       for (uint32_t i = 0; i < array_type->size(); i++) {
         llvm::Value* unpacked_element_ptr =
             builder->CreateGEP(array_llvm_type, unpacked_buffer,
@@ -1135,28 +1173,14 @@ absl::StatusOr<llvm::Function*> BuildPackedWrapper(
   return wrapper.function();
 }
 
-// Jits a function implementing `xls_function`. Also jits all transitively
-// dependent xls::Functions which may be called by `xls_function`.
-absl::StatusOr<JittedFunctionBase> BuildFunctionAndDependencies(
-    FunctionBase* xls_function, JitBuilderContext& jit_context,
-    bool build_packed_wrapper) {
-  std::vector<FunctionBase*> functions = GetDependentFunctions(xls_function);
-  BufferAllocator allocator(&jit_context.type_converter());
-  llvm::Function* top_function = nullptr;
-  std::vector<Partition> top_partitions;
-  for (FunctionBase* f : functions) {
-    XLS_ASSIGN_OR_RETURN(
-        PartitionedFunction partitioned_function,
-        BuildFunctionInternal(f, allocator, jit_context,
-                              /*unpoison_outputs=*/f == xls_function));
-    jit_context.SetLlvmFunction(f, partitioned_function.function);
-    if (f == xls_function) {
-      top_function = partitioned_function.function;
-      top_partitions = std::move(partitioned_function.partitions);
-    }
-  }
-  XLS_RET_CHECK(top_function != nullptr);
-
+// Compiles the module of `jit_context` in which `top_function` implementing
+// `xls_function` has been built and returns the resulting JittedFunctionBase.
+// `temp_buffer_size` is the size of the temporary buffer required by
+// `top_function`.
+absl::StatusOr<JittedFunctionBase> CompileJittedFunction(
+    FunctionBase* xls_function, llvm::Function* top_function,
+    absl::Span<const Partition> top_partitions, int64_t temp_buffer_size,
+    bool build_packed_wrapper, JitBuilderContext& jit_context) {
   std::string function_name = top_function->getName().str();
   std::string packed_wrapper_name;
   if (build_packed_wrapper) {
@@ -1171,6 +1195,7 @@ absl::StatusOr<JittedFunctionBase> BuildFunctionAndDependencies(
 
   JittedFunctionBase jitted_function;
 
+  jitted_function.function_base = xls_function;
   jitted_function.function_name = function_name;
   XLS_ASSIGN_OR_RETURN(auto fn_address,
                        jit_context.orc_jit().LoadSymbol(function_name));
@@ -1196,7 +1221,7 @@ absl::StatusOr<JittedFunctionBase> BuildFunctionAndDependencies(
     jitted_function.packed_output_buffer_sizes.push_back(
         jit_context.type_converter().GetPackedTypeByteSize(output->GetType()));
   }
-  jitted_function.temp_buffer_size = allocator.size();
+  jitted_function.temp_buffer_size = temp_buffer_size;
 
   // Indicate which nodes correspond to which early exit points.
   for (const Partition& partition : top_partitions) {
@@ -1210,6 +1235,77 @@ absl::StatusOr<JittedFunctionBase> BuildFunctionAndDependencies(
   return std::move(jitted_function);
 }
 
+// Jits a function implementing `xls_function`. Also jits all transitively
+// dependent xls::Functions which may be called by `xls_function`.
+absl::StatusOr<JittedFunctionBase> BuildFunctionAndDependencies(
+    FunctionBase* xls_function, JitBuilderContext& jit_context,
+    bool build_packed_wrapper) {
+  std::vector<FunctionBase*> functions = GetDependentFunctions(xls_function);
+  BufferAllocator allocator(&jit_context.type_converter());
+  llvm::Function* top_function = nullptr;
+  std::vector<Partition> top_partitions;
+  for (FunctionBase* f : functions) {
+    XLS_ASSIGN_OR_RETURN(
+        PartitionedFunction partitioned_function,
+        BuildFunctionInternal(f, allocator, jit_context,
+                              /*unpoison_outputs=*/f == xls_function));
+    jit_context.SetLlvmFunction(f, partitioned_function.function);
+    if (f == xls_function) {
+      top_function = partitioned_function.function;
+      top_partitions = std::move(partitioned_function.partitions);
+    }
+  }
+  XLS_RET_CHECK(top_function != nullptr);
+
+  return CompileJittedFunction(xls_function, top_function, top_partitions,
+                               allocator.size(), build_packed_wrapper,
+                               jit_context);
+}
+
+// Creates a function with internal linkage in the module of `jit_context`
+// which forwards its arguments to the previously compiled jitted function
+// `callee`. The function has the same signature as `callee` so it can stand in
+// for the callee when building calls to it. The body is added later by
+// DefineLinkFunction once the offset of the callee's temporary storage within
+// the caller's temporary buffer is known.
+llvm::Function* DeclareLinkFunction(const JittedFunctionBase& callee,
+                                    JitBuilderContext& jit_context) {
+  llvm::Type* ptr_type = llvm::PointerType::get(jit_context.context(), 0);
+  llvm::Type* i64_type = llvm::Type::getInt64Ty(jit_context.context());
+  std::vector<llvm::Type*> param_types(6, ptr_type);
+  param_types.push_back(i64_type);
+  llvm::FunctionType* function_type =
+      llvm::FunctionType::get(i64_type, param_types, /*isVarArg=*/false);
+  return llvm::Function::Create(
+      function_type, llvm::GlobalValue::InternalLinkage,
+      absl::StrFormat("__%s_link", callee.function_name),
+      jit_context.module());
+}
+
+// Adds the body to a function created by DeclareLinkFunction. The callee's
+// temporary storage is placed at `temp_buffer_offset` bytes within the temp
+// buffer passed to the link function. The call to the callee is resolved by
+// the linker against the symbol already compiled into the JITDylib.
+void DefineLinkFunction(llvm::Function* link_function,
+                        const JittedFunctionBase& callee,
+                        int64_t temp_buffer_offset,
+                        JitBuilderContext& jit_context) {
+  llvm::FunctionCallee external =
+      jit_context.module()->getOrInsertFunction(
+          callee.function_name, link_function->getFunctionType());
+  llvm::BasicBlock* block = llvm::BasicBlock::Create(
+      jit_context.context(), "entry", link_function, /*InsertBefore=*/nullptr);
+  llvm::IRBuilder<> builder(block);
+  std::vector<llvm::Value*> args;
+  for (llvm::Argument& arg : link_function->args()) {
+    args.push_back(&arg);
+  }
+  // The temp buffer is the third argument (see JitFunctionType).
+  args[2] = builder.CreateGEP(builder.getInt8Ty(), args[2],
+                              builder.getInt64(temp_buffer_offset));
+  builder.CreateRet(builder.CreateCall(external, args));
+}
+
 }  // namespace
 
 absl::StatusOr<JittedFunctionBase> BuildFunction(Function* xls_function,
@@ -1226,4 +1322,50 @@ absl::StatusOr<JittedFunctionBase> BuildProcFunction(
                                       /*build_packed_wrapper=*/false);
 }
 
+absl::StatusOr<JittedFunctionBase> BuildFunctionWithCompiledCallees(
+    Function* xls_function,
+    const absl::flat_hash_map<FunctionBase*, const JittedFunctionBase*>&
+        compiled_callees,
+    OrcJit& orc_jit) {
+  JitBuilderContext jit_context(orc_jit);
+  std::vector<std::pair<llvm::Function*, const JittedFunctionBase*>> links;
+  int64_t callee_temp_buffer_size = 0;
+  for (FunctionBase* f : GetDependentFunctions(xls_function)) {
+    if (f == xls_function) {
+      continue;
+    }
+    auto it = compiled_callees.find(f);
+    XLS_RET_CHECK(it != compiled_callees.end())
+        << absl::StreamFormat("Callee `%s` of `%s` has not been compiled",
+                              f->name(), xls_function->name());
+    llvm::Function* link_function = DeclareLinkFunction(*it->second, jit_context);
+    jit_context.SetLlvmFunction(f, link_function);
+    links.push_back({link_function, it->second});
+    callee_temp_buffer_size =
+        std::max(callee_temp_buffer_size, it->second->temp_buffer_size);
+  }
+
+  BufferAllocator allocator(&jit_context.type_converter());
+  XLS_ASSIGN_OR_RETURN(
+      PartitionedFunction partitioned_function,
+      BuildFunctionInternal(xls_function, allocator, jit_context,
+                            /*unpoison_outputs=*/true));
+  jit_context.SetLlvmFunction(xls_function, partitioned_function.function);
+
+  // Callees never execute concurrently with each other within a single
+  // invocation so they all share the region following the caller's own
+  // temporary storage. Allocations are multiples of the minimum alignment so
+  // the region is suitably aligned.
+  int64_t callee_temp_buffer_offset = allocator.size();
+  for (auto [link_function, callee] : links) {
+    DefineLinkFunction(link_function, *callee, callee_temp_buffer_offset,
+                       jit_context);
+  }
+  return CompileJittedFunction(
+      xls_function, partitioned_function.function,
+      partitioned_function.partitions,
+      callee_temp_buffer_offset + callee_temp_buffer_size,
+      /*build_packed_wrapper=*/true, jit_context);
+}
+
 }  // namespace xls
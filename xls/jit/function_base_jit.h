@@ -95,6 +95,17 @@ absl::StatusOr<JittedFunctionBase> BuildFunction(Function* xls_function,
 absl::StatusOr<JittedFunctionBase> BuildProcFunction(
     Proc* proc, JitChannelQueueManager* queue_mgr, OrcJit& orc_jit);
 
+// As BuildFunction but functions called by `xls_function` are not rebuilt.
+// Instead calls are linked against the jitted functions in `compiled_callees`
+// which must contain every function transitively called by `xls_function` and
+// which must have been compiled into `orc_jit`. The temp buffer of the returned
+// function includes space for the temporary storage of the callees.
+absl::StatusOr<JittedFunctionBase> BuildFunctionWithCompiledCallees(
+    Function* xls_function,
+    const absl::flat_hash_map<FunctionBase*, const JittedFunctionBase*>&
+        compiled_callees,
+    OrcJit& orc_jit);
+
 }  // namespace xls
 
 #endif  // XLS_JIT_FUNCTION_BASE_JIT_H_
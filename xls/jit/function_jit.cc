@@ -14,25 +14,55 @@
 
 #include "xls/jit/function_jit.h"
 
+#include <algorithm>
+
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/types/span.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/ir/call_graph.h"
 #include "xls/ir/format_preference.h"
 #include "xls/ir/keyword_args.h"
+#include "xls/ir/nodes.h"
 #include "xls/ir/type.h"
 #include "xls/ir/value.h"
 #include "xls/ir/value_helpers.h"
 #include "xls/jit/jit_runtime.h"
+#include "xls/passes/constant_folding_pass.h"
+#include "xls/passes/dce_pass.h"
+#include "xls/passes/passes.h"
+#include "xls/passes/select_simplification_pass.h"
 
 namespace xls {
+namespace {
+
+// The subset of the optimization pipeline run on specialized functions. These
+// passes are cheap and do most of the work of propagating the fixed argument
+// values through the function.
+class SpecializationSimplificationPass : public FixedPointCompoundPass {
+ public:
+  explicit SpecializationSimplificationPass(int64_t opt_level)
+      : FixedPointCompoundPass("specialization_simp",
+                               "Specialization simplification") {
+    Add<ConstantFoldingPass>();
+    Add<DeadCodeEliminationPass>();
+    Add<SelectSimplificationPass>(opt_level);
+    Add<DeadCodeEliminationPass>();
+  }
+};
+
+}  // namespace
 
 absl::StatusOr<std::unique_ptr<FunctionJit>> FunctionJit::Create(
-    Function* xls_function, int64_t opt_level) {
-  return CreateInternal(xls_function, opt_level, /*emit_object_code=*/false);
+    Function* xls_function, int64_t opt_level,
+    int64_t packed_array_threshold) {
+  return CreateInternal(xls_function, opt_level, /*emit_object_code=*/false,
+                        packed_array_threshold);
 }
 
 absl::StatusOr<JitObjectCode> FunctionJit::CreateObjectCode(
@@ -50,29 +80,89 @@ absl::StatusOr<JitObjectCode> FunctionJit::CreateObjectCode(
 }
 
 absl::StatusOr<std::unique_ptr<FunctionJit>> FunctionJit::CreateInternal(
-    Function* xls_function, int64_t opt_level, bool emit_object_code) {
+    Function* xls_function, int64_t opt_level, bool emit_object_code,
+    int64_t packed_array_threshold) {
   auto jit = absl::WrapUnique(new FunctionJit(xls_function));
   XLS_ASSIGN_OR_RETURN(jit->orc_jit_,
-                       OrcJit::Create(opt_level, emit_object_code));
+                       OrcJit::Create(opt_level, emit_object_code,
+                                      packed_array_threshold));
   XLS_ASSIGN_OR_RETURN(llvm::DataLayout data_layout,
                        OrcJit::CreateDataLayout());
-  jit->jit_runtime_ = std::make_unique<JitRuntime>(data_layout);
+  jit->owned_jit_runtime_ =
+      std::make_unique<JitRuntime>(data_layout, packed_array_threshold);
+  jit->jit_runtime_ = jit->owned_jit_runtime_.get();
   XLS_ASSIGN_OR_RETURN(jit->jitted_function_base_,
                        BuildFunction(xls_function, *jit->orc_jit_));
+  jit->InitializeBuffers();
+  return jit;
+}
 
-  // Pre-allocate argument, result, and temporary buffers.
-  for (int64_t i = 0; i < xls_function->params().size(); ++i) {
-    jit->arg_buffers_.push_back(std::vector<uint8_t>(jit->GetArgTypeSize(i)));
-    jit->arg_buffer_ptrs_.push_back(jit->arg_buffers_.back().data());
+absl::StatusOr<std::unique_ptr<FunctionJit>> FunctionJit::CreateSpecialized(
+    Function* xls_function,
+    const absl::flat_hash_map<int64_t, Value>& fixed_args, int64_t opt_level) {
+  std::vector<Param*> original_params(xls_function->params().begin(),
+                                      xls_function->params().end());
+  for (const auto& [index, value] : fixed_args) {
+    if (index < 0 || index >= original_params.size()) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Cannot specialize parameter %d of function '%s' which has %d "
+          "parameters",
+          index, xls_function->name(), original_params.size()));
+    }
+    if (!ValueConformsToType(value, original_params[index]->GetType())) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Got value %s for parameter %d which is not of type %s",
+          value.ToString(), index,
+          original_params[index]->GetType()->ToString()));
+    }
   }
-  jit->result_buffer_.resize(jit->GetReturnTypeSize());
-  jit->temp_buffer_.resize(jit->GetTempBufferSize());
 
+  // Clone the function (and any functions it calls) into a fresh package so
+  // the specialization does not modify the original package.
+  auto package = std::make_unique<Package>(
+      absl::StrCat(xls_function->package()->name(), "_specialized"));
+  XLS_ASSIGN_OR_RETURN(Function * clone,
+                       CloneFunctionAndItsDependencies(
+                           xls_function, xls_function->name(), package.get()));
+  std::vector<Param*> params(clone->params().begin(), clone->params().end());
+  XLS_RET_CHECK_EQ(params.size(), original_params.size());
+  for (const auto& [index, value] : fixed_args) {
+    Param* param = params[index];
+    XLS_RETURN_IF_ERROR(param->ReplaceUsesWithNew<Literal>(value).status());
+    XLS_RETURN_IF_ERROR(clone->RemoveNode(param));
+  }
+
+  SpecializationSimplificationPass pass(opt_level);
+  PassResults results;
+  XLS_RETURN_IF_ERROR(
+      pass.Run(package.get(), PassOptions(), &results).status());
+  XLS_VLOG(3) << "Specialized function:\n" << clone->DumpIr();
+
+  XLS_ASSIGN_OR_RETURN(
+      std::unique_ptr<FunctionJit> jit,
+      CreateInternal(clone, opt_level, /*emit_object_code=*/false));
+  jit->specialized_package_ = std::move(package);
   return jit;
 }
 
+FunctionJitBuffers::FunctionJitBuffers(absl::Span<const int64_t> arg_sizes,
+                                       int64_t result_size, int64_t temp_size)
+    : result_buffer_(result_size), temp_buffer_(temp_size) {
+  arg_buffers_.reserve(arg_sizes.size());
+  for (int64_t size : arg_sizes) {
+    arg_buffers_.push_back(std::vector<uint8_t>(size));
+    arg_buffer_ptrs_.push_back(arg_buffers_.back().data());
+  }
+}
+
+std::unique_ptr<FunctionJitBuffers> FunctionJit::CreateBuffers() const {
+  return absl::WrapUnique(new FunctionJitBuffers(
+      jitted_function_base_.input_buffer_sizes, GetReturnTypeSize(),
+      GetTempBufferSize()));
+}
+
 absl::StatusOr<InterpreterResult<Value>> FunctionJit::Run(
-    absl::Span<const Value> args) {
+    absl::Span<const Value> args, FunctionJitBuffers* buffers) const {
   absl::Span<Param* const> params = xls_function_->params();
   if (args.size() != params.size()) {
     return absl::InvalidArgumentError(absl::StrFormat(
@@ -94,13 +184,14 @@ absl::StatusOr<InterpreterResult<Value>> FunctionJit::Run(
   }
 
   // Allocate argument buffers and copy in arg Values.
-  XLS_RETURN_IF_ERROR(jit_runtime_->PackArgs(args, param_types,
-                                             absl::MakeSpan(arg_buffer_ptrs_)));
+  XLS_RETURN_IF_ERROR(jit_runtime_->PackArgs(
+      args, param_types, absl::MakeSpan(buffers->arg_buffer_ptrs_)));
 
   InterpreterEvents events;
-  InvokeJitFunction(arg_buffer_ptrs_, result_buffer_.data(), &events);
+  InvokeJitFunction(buffers->arg_buffer_ptrs_, buffers->result_buffer_.data(),
+                    &events, buffers);
   Value result = jit_runtime_->UnpackBuffer(
-      result_buffer_.data(), xls_function_->return_value()->GetType());
+      buffers->result_buffer_.data(), xls_function_->return_value()->GetType());
 
   return InterpreterResult<Value>{std::move(result), std::move(events)};
 }
@@ -114,7 +205,8 @@ absl::StatusOr<InterpreterResult<Value>> FunctionJit::Run(
 
 absl::Status FunctionJit::RunWithViews(absl::Span<uint8_t* const> args,
                                        absl::Span<uint8_t> result_buffer,
-                                       InterpreterEvents* events) {
+                                       InterpreterEvents* events,
+                                       FunctionJitBuffers* buffers) const {
   absl::Span<Param* const> params = xls_function_->params();
   if (args.size() != params.size()) {
     return absl::InvalidArgumentError(
@@ -128,17 +220,45 @@ absl::Status FunctionJit::RunWithViews(absl::Span<uint8_t* const> args,
                      GetReturnTypeSize()));
   }
 
-  InvokeJitFunction(args, result_buffer.data(), events);
+  InvokeJitFunction(args, result_buffer.data(), events, buffers);
   return absl::OkStatus();
 }
 
 void FunctionJit::InvokeJitFunction(absl::Span<uint8_t* const> arg_buffers,
                                     uint8_t* output_buffer,
-                                    InterpreterEvents* events) {
+                                    InterpreterEvents* events,
+                                    FunctionJitBuffers* buffers) const {
   uint8_t* output_buffers[1] = {output_buffer};
   jitted_function_base_.function(
-      arg_buffers.data(), output_buffers, temp_buffer_.data(), events,
+      arg_buffers.data(), output_buffers, buffers->temp_buffer_.data(), events,
       /*user_data=*/nullptr, runtime(), /*continuation_point=*/0);
 }
 
+absl::StatusOr<FunctionJit*> SpecializedFunctionJitCache::GetOrCreate(
+    const absl::flat_hash_map<int64_t, Value>& fixed_args) {
+  Key key(fixed_args.begin(), fixed_args.end());
+  std::sort(key.begin(), key.end(),
+            [](const std::pair<int64_t, Value>& a,
+               const std::pair<int64_t, Value>& b) {
+              return a.first < b.first;
+            });
+
+  absl::MutexLock lock(&mutex_);
+  auto it = specializations_.find(key);
+  if (it != specializations_.end()) {
+    return it->second.get();
+  }
+  XLS_ASSIGN_OR_RETURN(
+      std::unique_ptr<FunctionJit> jit,
+      FunctionJit::CreateSpecialized(function_, fixed_args, opt_level_));
+  FunctionJit* result = jit.get();
+  specializations_[std::move(key)] = std::move(jit);
+  return result;
+}
+
+int64_t SpecializedFunctionJitCache::size() const {
+  absl::MutexLock lock(&mutex_);
+  return specializations_.size();
+}
+
 }  // namespace xls
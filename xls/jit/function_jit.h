@@ -15,12 +15,21 @@
 #ifndef XLS_JIT_FUNCTION_JIT_H_
 #define XLS_JIT_FUNCTION_JIT_H_
 
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/ir/events.h"
 #include "xls/ir/function.h"
+#include "xls/ir/package.h"
 #include "xls/ir/value.h"
 #include "xls/ir/value_view.h"
 #include "xls/jit/function_base_jit.h"
@@ -29,6 +38,8 @@
 
 namespace xls {
 
+class PackageJit;
+
 // Data structure containing jitted object code and metadata about how to call
 // it.
 struct JitObjectCode {
@@ -44,23 +55,74 @@ struct JitObjectCode {
   int64_t temp_buffer_size;
 };
 
+// The mutable state used by a single invocation of a FunctionJit: buffers for
+// the arguments, the result, and temporary values. Created by
+// FunctionJit::CreateBuffers.
+class FunctionJitBuffers {
+ public:
+  FunctionJitBuffers(const FunctionJitBuffers&) = delete;
+  FunctionJitBuffers& operator=(const FunctionJitBuffers&) = delete;
+
+ private:
+  friend class FunctionJit;
+
+  FunctionJitBuffers(absl::Span<const int64_t> arg_sizes, int64_t result_size,
+                     int64_t temp_size);
+
+  std::vector<std::vector<uint8_t>> arg_buffers_;
+  // Raw pointers to the buffers held in `arg_buffers_`.
+  std::vector<uint8_t*> arg_buffer_ptrs_;
+  std::vector<uint8_t> result_buffer_;
+  std::vector<uint8_t> temp_buffer_;
+};
+
 // This class provides a facility to execute XLS functions (on the host) by
-// converting it to LLVM IR, compiling it, and finally executing it. Not
-// thread-safe due to sharing of result and temporary buffers between
-// invocations of Run.
+// converting it to LLVM IR, compiling it, and finally executing it.
+//
+// The compiled code is immutable. The methods which take a FunctionJitBuffers
+// argument are const and may be called concurrently from multiple threads as
+// long as each thread uses its own buffers. The methods without a buffers
+// argument share buffers held by the FunctionJit between invocations and are
+// therefore not thread-safe.
 class FunctionJit {
  public:
   // Returns an object containing a host-compiled version of the specified XLS
-  // function.
+  // function. If `packed_array_threshold` is non-zero, arrays of at least that
+  // many narrow bits elements use a bit-packed native layout (see
+  // LlvmTypeConverter::IsPackedArray). The views of value_view.h do not
+  // support the packed layout; buffers holding packed arrays must be written
+  // and read with the JitRuntime (see runtime()).
   static absl::StatusOr<std::unique_ptr<FunctionJit>> Create(
-      Function* xls_function, int64_t opt_level = 3);
+      Function* xls_function, int64_t opt_level = 3,
+      int64_t packed_array_threshold = 0);
+
+  // Returns an object containing a host-compiled version of the specified XLS
+  // function specialized for fixed values of some of its parameters.
+  // `fixed_args` maps parameter indices to the values of those parameters. The
+  // fixed parameters are replaced with literals in a clone of the function
+  // which is simplified (constant folding, select simplification and DCE)
+  // before being compiled. The returned object takes only the remaining
+  // parameters in their original order and function() returns the specialized
+  // clone. See SpecializedFunctionJitCache for reusing specializations.
+  static absl::StatusOr<std::unique_ptr<FunctionJit>> CreateSpecialized(
+      Function* xls_function,
+      const absl::flat_hash_map<int64_t, Value>& fixed_args,
+      int64_t opt_level = 3);
 
   // Returns the bytes of an object file containing the compiled XLS function.
   static absl::StatusOr<JitObjectCode> CreateObjectCode(Function* xls_function,
                                                         int64_t opt_level = 3);
 
+  // Returns a new set of buffers for invoking the compiled function. Each
+  // thread calling the FunctionJit concurrently needs its own buffers.
+  std::unique_ptr<FunctionJitBuffers> CreateBuffers() const;
+
   // Executes the compiled function with the specified arguments.
-  absl::StatusOr<InterpreterResult<Value>> Run(absl::Span<const Value> args);
+  absl::StatusOr<InterpreterResult<Value>> Run(absl::Span<const Value> args) {
+    return Run(args, &default_buffers());
+  }
+  absl::StatusOr<InterpreterResult<Value>> Run(
+      absl::Span<const Value> args, FunctionJitBuffers* buffers) const;
 
   // As above, buth with arguments as key-value pairs.
   absl::StatusOr<InterpreterResult<Value>> Run(
@@ -80,7 +142,13 @@ class FunctionJit {
   // (or if their performance-focused execution means events are unimportant).
   absl::Status RunWithViews(absl::Span<uint8_t* const> args,
                             absl::Span<uint8_t> result_buffer,
-                            InterpreterEvents* events);
+                            InterpreterEvents* events) {
+    return RunWithViews(args, result_buffer, events, &default_buffers());
+  }
+  absl::Status RunWithViews(absl::Span<uint8_t* const> args,
+                            absl::Span<uint8_t> result_buffer,
+                            InterpreterEvents* events,
+                            FunctionJitBuffers* buffers) const;
 
   // Similar to RunWithViews(), except the arguments here are _packed_views_ -
   // views whose data elements are tightly packed, with no padding bits or bytes
@@ -103,6 +171,14 @@ class FunctionJit {
   // TODO(rspringer): Add user data support here.
   template <typename... ArgsT>
   absl::Status RunWithPackedViews(ArgsT... args) {
+    return RunWithPackedViewsAndBuffers(&default_buffers(), args...);
+  }
+
+  // As above, but using the given buffers. Thread-safe if each thread uses its
+  // own buffers.
+  template <typename... ArgsT>
+  absl::Status RunWithPackedViewsAndBuffers(FunctionJitBuffers* buffers,
+                                            ArgsT... args) const {
     XLS_RET_CHECK(jitted_function_base_.packed_function.has_value());
     uint8_t* arg_buffers[sizeof...(ArgsT)];
     uint8_t* result_buffer;
@@ -112,14 +188,14 @@ class FunctionJit {
     InterpreterEvents events;
     uint8_t* output_buffers[1] = {result_buffer};
     jitted_function_base_.packed_function.value()(
-        arg_buffers, output_buffers, temp_buffer_.data(), &events,
+        arg_buffers, output_buffers, buffers->temp_buffer_.data(), &events,
         /*user_data=*/nullptr, runtime(), /*continuation_point=*/0);
 
     return InterpreterEventsToStatus(events);
   }
 
   // Returns the function that the JIT executes.
-  Function* function() { return xls_function_; }
+  Function* function() const { return xls_function_; }
 
   // Gets the size of the compiled function's arguments (or return value) in the
   // native LLVM data layout (not the packed layout).
@@ -151,13 +227,24 @@ class FunctionJit {
     return jitted_function_base_.function_name;
   }
 
-  JitRuntime* runtime() const { return jit_runtime_.get(); }
+  JitRuntime* runtime() const { return jit_runtime_; }
 
  private:
+  // PackageJit creates FunctionJits which execute code compiled into its
+  // shared session.
+  friend class PackageJit;
+
   explicit FunctionJit(Function* xls_function) : xls_function_(xls_function) {}
 
   static absl::StatusOr<std::unique_ptr<FunctionJit>> CreateInternal(
-      Function* xls_function, int64_t opt_level, bool emit_object_code);
+      Function* xls_function, int64_t opt_level, bool emit_object_code,
+      int64_t packed_array_threshold = 0);
+
+  // Allocates the buffers used by the methods which do not take a
+  // FunctionJitBuffers argument.
+  void InitializeBuffers() { default_buffers_ = CreateBuffers(); }
+
+  FunctionJitBuffers& default_buffers() { return *default_buffers_; }
 
   // Builds a function which wraps the natively compiled XLS function `callee`
   // (as built by xls::BuildFunction) with another function which accepts the
@@ -183,38 +270,77 @@ class FunctionJit {
   // Simple templates to walk down the arg tree and populate the corresponding
   // arg/buffer pointer.
   template <typename FrontT, typename... RestT>
-  void PackArgBuffers(uint8_t** arg_buffers, uint8_t** result_buffer,
-                      FrontT front, RestT... rest) {
+  static void PackArgBuffers(uint8_t** arg_buffers, uint8_t** result_buffer,
+                             FrontT front, RestT... rest) {
     arg_buffers[0] = front.buffer();
     PackArgBuffers(&arg_buffers[1], result_buffer, rest...);
   }
 
   // Base case for the above recursive template.
   template <typename LastT>
-  void PackArgBuffers(uint8_t** arg_buffers, uint8_t** result_buffer,
-                      LastT front) {
+  static void PackArgBuffers(uint8_t** arg_buffers, uint8_t** result_buffer,
+                             LastT front) {
     *result_buffer = front.buffer();
   }
 
   // Invokes the jitted function with the given argument and outputs.
   void InvokeJitFunction(absl::Span<uint8_t* const> arg_buffers,
-                         uint8_t* output_buffer, InterpreterEvents* events);
+                         uint8_t* output_buffer, InterpreterEvents* events,
+                         FunctionJitBuffers* buffers) const;
 
+  // The JIT and runtime are only owned by FunctionJits created with Create.
+  // FunctionJits created by a PackageJit use the JIT and runtime of the
+  // PackageJit.
   std::unique_ptr<OrcJit> orc_jit_;
+  std::unique_ptr<JitRuntime> owned_jit_runtime_;
+
+  // Package holding the specialized clone of the function for FunctionJits
+  // created with CreateSpecialized. Null otherwise.
+  std::unique_ptr<Package> specialized_package_;
 
   Function* xls_function_;
 
-  // Buffers to hold the arguments, result, temporary storage. This is allocated
-  // once and then re-used with each invocation of Run. Not thread-safe.
-  std::vector<std::vector<uint8_t>> arg_buffers_;
-  std::vector<uint8_t> result_buffer_;
-  std::vector<uint8_t> temp_buffer_;
-
-  // Raw pointers to the buffers held in `arg_buffers_`.
-  std::vector<uint8_t*> arg_buffer_ptrs_;
+  // Buffers used by the methods which do not take a FunctionJitBuffers
+  // argument. This is allocated once and then re-used with each invocation of
+  // Run. Not thread-safe.
+  std::unique_ptr<FunctionJitBuffers> default_buffers_;
 
   JittedFunctionBase jitted_function_base_;
-  std::unique_ptr<JitRuntime> jit_runtime_;
+  JitRuntime* jit_runtime_ = nullptr;
+};
+
+// A cache of the specializations (see FunctionJit::CreateSpecialized) of a
+// single function keyed by the values of the fixed arguments. Each distinct set
+// of fixed arguments is compiled once. The cache is unbounded. GetOrCreate is
+// thread-safe; concurrent callers of the returned FunctionJits must use their
+// own FunctionJitBuffers.
+class SpecializedFunctionJitCache {
+ public:
+  explicit SpecializedFunctionJitCache(Function* function,
+                                       int64_t opt_level = 3)
+      : function_(function), opt_level_(opt_level) {}
+
+  // Returns the specialization of the function for the given fixed arguments,
+  // compiling it if it is not already in the cache. The returned FunctionJit is
+  // owned by the cache.
+  absl::StatusOr<FunctionJit*> GetOrCreate(
+      const absl::flat_hash_map<int64_t, Value>& fixed_args);
+
+  // Returns the number of specializations in the cache.
+  int64_t size() const;
+
+  Function* function() const { return function_; }
+
+ private:
+  // The fixed arguments as (parameter index, value) pairs sorted by index.
+  using Key = std::vector<std::pair<int64_t, Value>>;
+
+  Function* function_;
+  int64_t opt_level_;
+
+  mutable absl::Mutex mutex_;
+  absl::flat_hash_map<Key, std::unique_ptr<FunctionJit>> specializations_
+      ABSL_GUARDED_BY(mutex_);
 };
 
 }  // namespace xls
@@ -14,8 +14,10 @@
 
 #include "xls/jit/function_jit.h"
 
+#include <algorithm>
 #include <cstdio>
 #include <random>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -24,6 +26,7 @@
 #include "absl/strings/substitute.h"
 #include "xls/common/status/matchers.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/common/thread.h"
 #include "xls/interpreter/channel_queue.h"
 #include "xls/interpreter/ir_evaluator_test_base.h"
 #include "xls/interpreter/random_value.h"
@@ -55,6 +58,27 @@ INSTANTIATE_TEST_SUITE_P(
           return jit->Run(kwargs);
         })));
 
+// Run the evaluator tests with a bit-packed layout for every array of narrow
+// bits elements.
+INSTANTIATE_TEST_SUITE_P(
+    FunctionJitPackedArrayTest, IrEvaluatorTestBase,
+    testing::Values(IrEvaluatorTestParam(
+        [](Function* function, absl::Span<const Value> args)
+            -> absl::StatusOr<InterpreterResult<Value>> {
+          XLS_ASSIGN_OR_RETURN(
+              auto jit, FunctionJit::Create(function, /*opt_level=*/3,
+                                            /*packed_array_threshold=*/1));
+          return jit->Run(args);
+        },
+        [](Function* function,
+           const absl::flat_hash_map<std::string, Value>& kwargs)
+            -> absl::StatusOr<InterpreterResult<Value>> {
+          XLS_ASSIGN_OR_RETURN(
+              auto jit, FunctionJit::Create(function, /*opt_level=*/3,
+                                            /*packed_array_threshold=*/1));
+          return jit->Run(kwargs);
+        })));
+
 absl::StatusOr<Value> RunJitNoEvents(FunctionJit* jit,
                                      absl::Span<const Value> args) {
   XLS_ASSIGN_OR_RETURN(InterpreterResult<Value> result, jit->Run(args));
@@ -703,5 +727,191 @@ TEST(FunctionJitTest, CompoundTokenCompareError) {
               StatusIs(absl::StatusCode::kInvalidArgument,
                        testing::HasSubstr("Tokens are incomparable")));
 }
+
+// Calls a single FunctionJit concurrently from several threads, each with its
+// own buffers.
+TEST(FunctionJitTest, ConcurrentCallsWithSeparateBuffers) {
+  Package package("my_package");
+  std::string ir_text = R"(
+  fn f(x: bits[32], y: bits[32]) -> bits[32] {
+    sum: bits[32] = add(x, y)
+    ret prod: bits[32] = umul(sum, x)
+  }
+  )";
+  XLS_ASSERT_OK_AND_ASSIGN(Function * function,
+                           Parser::ParseFunction(ir_text, &package));
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<FunctionJit> jit,
+                           FunctionJit::Create(function));
+
+  constexpr int64_t kThreadCount = 8;
+  constexpr int64_t kIterations = 1000;
+  std::vector<int64_t> mismatches(kThreadCount, 0);
+  std::vector<std::unique_ptr<Thread>> threads;
+  for (int64_t t = 0; t < kThreadCount; ++t) {
+    threads.push_back(std::make_unique<Thread>([&, t]() {
+      std::unique_ptr<FunctionJitBuffers> buffers = jit->CreateBuffers();
+      for (int64_t i = 0; i < kIterations; ++i) {
+        uint32_t x = t * kIterations + i;
+        uint32_t y = i * 7;
+        absl::StatusOr<InterpreterResult<Value>> result =
+            jit->Run({Value(UBits(x, 32)), Value(UBits(y, 32))},
+                     buffers.get());
+        if (!result.ok() ||
+            result->value != Value(UBits(static_cast<uint32_t>((x + y) * x),
+                                         32))) {
+          ++mismatches[t];
+        }
+
+        uint32_t packed_x = x;
+        uint32_t packed_y = y;
+        uint32_t packed_result;
+        PackedBitsView<32> x_view(reinterpret_cast<uint8_t*>(&packed_x), 0);
+        PackedBitsView<32> y_view(reinterpret_cast<uint8_t*>(&packed_y), 0);
+        PackedBitsView<32> result_view(
+            reinterpret_cast<uint8_t*>(&packed_result), 0);
+        if (!jit->RunWithPackedViewsAndBuffers(buffers.get(), x_view, y_view,
+                                               result_view)
+                 .ok() ||
+            packed_result != static_cast<uint32_t>((x + y) * x)) {
+          ++mismatches[t];
+        }
+      }
+    }));
+  }
+  for (std::unique_ptr<Thread>& thread : threads) {
+    thread->Join();
+  }
+  EXPECT_THAT(mismatches, testing::Each(0));
+}
+
+TEST(FunctionJitTest, Specialized) {
+  Package package("my_package");
+  std::string ir_text = R"(
+  fn f(x: bits[32], mode: bits[1], y: bits[32]) -> bits[32] {
+    sum: bits[32] = add(x, y)
+    diff: bits[32] = sub(x, y)
+    ret result: bits[32] = sel(mode, cases=[sum, diff])
+  }
+  )";
+  XLS_ASSERT_OK_AND_ASSIGN(Function * function,
+                           Parser::ParseFunction(ir_text, &package));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<FunctionJit> jit,
+      FunctionJit::CreateSpecialized(function, {{1, Value(UBits(1, 1))}}));
+
+  // The fixed parameter is removed and the select is simplified away.
+  EXPECT_EQ(jit->function()->params().size(), 2);
+  EXPECT_EQ(jit->function()->return_value()->op(), Op::kSub);
+  EXPECT_THAT(RunJitNoEvents(jit.get(),
+                             {Value(UBits(42, 32)), Value(UBits(10, 32))}),
+              IsOkAndHolds(Value(UBits(32, 32))));
+
+  // The original function is unchanged.
+  EXPECT_EQ(function->params().size(), 3);
+  EXPECT_EQ(function->return_value()->op(), Op::kSel);
+}
+
+TEST(FunctionJitTest, SpecializedInvalidArguments) {
+  Package package("my_package");
+  std::string ir_text = R"(
+  fn f(x: bits[32], y: bits[32]) -> bits[32] {
+    ret sum: bits[32] = add(x, y)
+  }
+  )";
+  XLS_ASSERT_OK_AND_ASSIGN(Function * function,
+                           Parser::ParseFunction(ir_text, &package));
+  EXPECT_THAT(
+      FunctionJit::CreateSpecialized(function, {{2, Value(UBits(1, 32))}}),
+      StatusIs(absl::StatusCode::kInvalidArgument,
+               testing::HasSubstr("Cannot specialize parameter 2")));
+  EXPECT_THAT(
+      FunctionJit::CreateSpecialized(function, {{0, Value(UBits(1, 8))}}),
+      StatusIs(absl::StatusCode::kInvalidArgument,
+               testing::HasSubstr("not of type bits[32]")));
+}
+
+TEST(FunctionJitTest, SpecializedFunctionJitCache) {
+  Package package("my_package");
+  std::string ir_text = R"(
+  fn f(x: bits[32], y: bits[32]) -> bits[32] {
+    ret prod: bits[32] = umul(x, y)
+  }
+  )";
+  XLS_ASSERT_OK_AND_ASSIGN(Function * function,
+                           Parser::ParseFunction(ir_text, &package));
+  SpecializedFunctionJitCache cache(function);
+
+  XLS_ASSERT_OK_AND_ASSIGN(FunctionJit * times_three,
+                           cache.GetOrCreate({{1, Value(UBits(3, 32))}}));
+  XLS_ASSERT_OK_AND_ASSIGN(FunctionJit * times_five,
+                           cache.GetOrCreate({{1, Value(UBits(5, 32))}}));
+  XLS_ASSERT_OK_AND_ASSIGN(FunctionJit * times_three_again,
+                           cache.GetOrCreate({{1, Value(UBits(3, 32))}}));
+  EXPECT_NE(times_three, times_five);
+  EXPECT_EQ(times_three, times_three_again);
+  EXPECT_EQ(cache.size(), 2);
+
+  EXPECT_THAT(RunJitNoEvents(times_three, {Value(UBits(7, 32))}),
+              IsOkAndHolds(Value(UBits(21, 32))));
+  EXPECT_THAT(RunJitNoEvents(times_five, {Value(UBits(7, 32))}),
+              IsOkAndHolds(Value(UBits(35, 32))));
+}
+
+TEST(FunctionJitTest, PackedArrayLayout) {
+  Package package("my_package");
+  // A 100-element array of 3-bit values spans several 64-bit words with 16
+  // elements per word.
+  std::string ir_text = R"(
+  fn f(a: bits[3][100], i: bits[32], v: bits[3]) -> (bits[3][100], bits[3], bits[3][10], bits[1], bits[3][200]) {
+    update: bits[3][100] = array_update(a, v, indices=[i])
+    index: bits[3] = array_index(update, indices=[i])
+    slice: bits[3][10] = array_slice(update, i, width=10)
+    eq: bits[1] = eq(a, update)
+    concat: bits[3][200] = array_concat(a, update)
+    ret result: (bits[3][100], bits[3], bits[3][10], bits[1], bits[3][200]) = tuple(update, index, slice, eq, concat)
+  }
+  )";
+  XLS_ASSERT_OK_AND_ASSIGN(Function * function,
+                           Parser::ParseFunction(ir_text, &package));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<FunctionJit> jit,
+      FunctionJit::Create(function, /*opt_level=*/3,
+                          /*packed_array_threshold=*/8));
+  EXPECT_EQ(jit->runtime()->packed_array_threshold(), 8);
+
+  std::vector<uint64_t> elements(100);
+  for (int64_t i = 0; i < elements.size(); ++i) {
+    elements[i] = (i * 5) % 8;
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(Value a, Value::UBitsArray(elements, 3));
+  for (int64_t i : {0, 15, 16, 17, 63, 95, 99, 100, 1000}) {
+    std::vector<uint64_t> updated = elements;
+    if (i < updated.size()) {
+      updated[i] = 7 - updated[i];
+    }
+    uint64_t v = i < elements.size() ? updated[i] : 6;
+    XLS_ASSERT_OK_AND_ASSIGN(Value expected_update,
+                             Value::UBitsArray(updated, 3));
+    int64_t clamped = std::min<int64_t>(i, updated.size() - 1);
+    std::vector<uint64_t> sliced;
+    for (int64_t j = 0; j < 10; ++j) {
+      sliced.push_back(updated[std::min<int64_t>(clamped + j, 99)]);
+    }
+    XLS_ASSERT_OK_AND_ASSIGN(Value expected_slice,
+                             Value::UBitsArray(sliced, 3));
+    std::vector<uint64_t> concatenated = elements;
+    concatenated.insert(concatenated.end(), updated.begin(), updated.end());
+    XLS_ASSERT_OK_AND_ASSIGN(Value expected_concat,
+                             Value::UBitsArray(concatenated, 3));
+    Value expected = Value::Tuple(
+        {expected_update, Value(UBits(updated[clamped], 3)), expected_slice,
+         Value::Bool(i >= elements.size()), expected_concat});
+    EXPECT_THAT(RunJitNoEvents(jit.get(), {a, Value(UBits(i, 32)),
+                                           Value(UBits(v, 3))}),
+                IsOkAndHolds(expected))
+        << "i = " << i;
+  }
+}
+
 }  // namespace
 }  // namespace xls
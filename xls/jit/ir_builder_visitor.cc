@@ -325,7 +325,8 @@ struct CompareTerm {
 // terms to compare.
 absl::StatusOr<std::vector<CompareTerm>> ExpandTerms(
     Node* lhs, llvm::Value* llvm_lhs, Node* rhs, llvm::Value* llvm_rhs,
-    Node* src, llvm::IRBuilder<>* builder) {
+    Node* src, const LlvmTypeConverter& type_converter,
+    llvm::IRBuilder<>* builder) {
   XLS_RET_CHECK(lhs->GetType() == rhs->GetType()) << absl::StreamFormat(
       "The lhs and rhs of %s have different types: lhs %s rhs %s",
       src->ToString(), lhs->GetType()->ToString(), rhs->GetType()->ToString());
@@ -355,6 +356,17 @@ absl::StatusOr<std::vector<CompareTerm>> ExpandTerms(
         terms.push_back(CompareTerm{next.lhs, next.rhs});
         break;
       case TypeKind::kArray: {
+        if (type_converter.IsPackedArray(next.ty)) {
+          // All bits of a packed array which do not hold element data are
+          // zero so packed arrays can be compared word by word.
+          uint32_t word_count = next.lhs->getType()->getArrayNumElements();
+          for (uint32_t i = 0; i < word_count; i++) {
+            terms.push_back(
+                CompareTerm{builder->CreateExtractValue(next.lhs, {i}),
+                            builder->CreateExtractValue(next.rhs, {i})});
+          }
+          break;
+        }
         ArrayType* array_type = next.ty->AsArrayOrDie();
         Type* element_type = array_type->element_type();
         // Cast once so we do not have to cast when calling CreateExtractValue
@@ -415,6 +427,43 @@ llvm::Value* ClampIndexInBounds(llvm::Value* index, ArrayType* array_type,
   return inbounds_index;
 }
 
+// Returns the value of element `index` (an in-bounds i64 value) of the array of
+// bits elements of type `array_type` pointed to by `array_ptr`. The array may
+// use the packed array layout.
+llvm::Value* LoadBitsArrayElement(llvm::Value* array_ptr, ArrayType* array_type,
+                                  llvm::Value* index,
+                                  const LlvmTypeConverter& type_converter,
+                                  llvm::IRBuilder<>& builder) {
+  if (type_converter.IsPackedArray(array_type)) {
+    return type_converter.LoadPackedArrayElement(array_ptr, array_type, index,
+                                                 builder);
+  }
+  llvm::Value* element_ptr =
+      builder.CreateGEP(type_converter.ConvertToLlvmType(array_type),
+                        array_ptr, {builder.getInt32(0), index});
+  return builder.CreateLoad(
+      type_converter.ConvertToLlvmType(array_type->element_type()),
+      element_ptr);
+}
+
+// Stores `element` as element `index` (an in-bounds i64 value) of the array of
+// bits elements of type `array_type` pointed to by `array_ptr`. The array may
+// use the packed array layout.
+void StoreBitsArrayElement(llvm::Value* element, llvm::Value* array_ptr,
+                           ArrayType* array_type, llvm::Value* index,
+                           const LlvmTypeConverter& type_converter,
+                           llvm::IRBuilder<>& builder) {
+  if (type_converter.IsPackedArray(array_type)) {
+    type_converter.StorePackedArrayElement(element, array_ptr, array_type,
+                                           index, builder);
+    return;
+  }
+  llvm::Value* element_ptr =
+      builder.CreateGEP(type_converter.ConvertToLlvmType(array_type),
+                        array_ptr, {builder.getInt32(0), index});
+  builder.CreateStore(element, element_ptr);
+}
+
 // This is a shim to let JIT code add a new trace fragment to an existing trace
 // buffer.
 void PerformStringStep(char* step_string, std::string* buffer) {
@@ -1123,9 +1172,31 @@ absl::Status IrBuilderVisitor::HandleArray(Array* array) {
 
   llvm::Type* array_type =
       type_converter()->ConvertToLlvmType(array->GetType());
+  llvm::Value* output_buffer = node_context.GetOutputPtr(0);
+  if (type_converter()->IsPackedArray(array->GetType())) {
+    // Assemble each word of the packed array in a register and store it.
+    int64_t slot_bit_count = LlvmTypeConverter::PackedArraySlotBitCount(
+        array->GetType()->AsArrayOrDie());
+    int64_t elements_per_word = 64 / slot_bit_count;
+    for (uint32_t w = 0; w < array_type->getArrayNumElements(); ++w) {
+      llvm::Value* word = b.getInt64(0);
+      for (int64_t j = 0; j < elements_per_word &&
+                          w * elements_per_word + j < array->size();
+           ++j) {
+        llvm::Value* element = b.CreateZExt(
+            node_context.LoadOperand(w * elements_per_word + j),
+            b.getInt64Ty());
+        word = b.CreateOr(word, b.CreateShl(element, j * slot_bit_count));
+      }
+      b.CreateStore(word, b.CreateGEP(array_type, output_buffer,
+                                      {b.getInt32(0), b.getInt32(w)}));
+    }
+    return FinalizeNodeIrContextWithPointerToValue(std::move(node_context),
+                                                   output_buffer);
+  }
+
   int64_t element_size = type_converter()->GetTypeByteSize(
       array->GetType()->AsArrayOrDie()->element_type());
-  llvm::Value* output_buffer = node_context.GetOutputPtr(0);
   for (uint32_t i = 0; i < array->size(); ++i) {
     llvm::Value* output_element = b.CreateGEP(
         array_type, output_buffer,
@@ -1228,8 +1299,18 @@ absl::Status IrBuilderVisitor::HandleArrayIndex(ArrayIndex* index) {
   Type* array_type = index->array()->GetType();
   for (int64_t i = 1; i < index->operand_count(); ++i) {
     llvm::Value* index_value = node_context.LoadOperand(i);
-    gep_indices.push_back(
-        ClampIndexInBounds(index_value, array_type->AsArrayOrDie(), b));
+    llvm::Value* clamped_index =
+        ClampIndexInBounds(index_value, array_type->AsArrayOrDie(), b);
+    if (type_converter()->IsPackedArray(array_type)) {
+      // The elements of a packed array are bits so this is the last index.
+      llvm::Value* packed_array = b.CreateGEP(
+          type_converter()->ConvertToLlvmType(index->array()->GetType()),
+          node_context.GetOperandPtr(0), gep_indices);
+      llvm::Value* element = type_converter()->LoadPackedArrayElement(
+          packed_array, array_type->AsArrayOrDie(), clamped_index, b);
+      return FinalizeNodeIrContextWithValue(std::move(node_context), element);
+    }
+    gep_indices.push_back(clamped_index);
     array_type = array_type->AsArrayOrDie()->element_type();
   }
   llvm::Value* indexed_element = b.CreateGEP(
@@ -1265,6 +1346,17 @@ absl::Status IrBuilderVisitor::HandleArraySlice(ArraySlice* slice) {
                      llvm::ConstantInt::get(i64, input_array_size));
   clamped_start->setName("clamped_start");
 
+  llvm::Value* operand_buffer = node_context.GetOperandPtr(0);
+  llvm::Value* output_buffer = node_context.GetOutputPtr(0);
+  ArrayType* output_array_type = slice->GetType()->AsArrayOrDie();
+  bool is_packed = type_converter()->IsPackedArray(input_array_type) ||
+                   type_converter()->IsPackedArray(output_array_type);
+  if (type_converter()->IsPackedArray(output_array_type)) {
+    b.CreateStore(LlvmTypeConverter::ZeroOfType(
+                      type_converter()->ConvertToLlvmType(output_array_type)),
+                  output_buffer);
+  }
+
   // Create a loop which copies one array element at a time.
   LlvmIrLoop loop(width, node_context.entry_builder());
 
@@ -1277,8 +1369,20 @@ absl::Status IrBuilderVisitor::HandleArraySlice(ArraySlice* slice) {
       loop.body_builder().CreateICmpULE(index, max_index), index, max_index);
   clamped_index->setName("clamped_index");
 
+  if (is_packed) {
+    // Packed arrays have bits elements which are copied by value.
+    llvm::Value* element = LoadBitsArrayElement(
+        operand_buffer, input_array_type, clamped_index, *type_converter(),
+        loop.body_builder());
+    StoreBitsArrayElement(element, output_buffer, output_array_type,
+                          loop.index(), *type_converter(),
+                          loop.body_builder());
+    loop.Finalize();
+    return FinalizeNodeIrContextWithPointerToValue(
+        std::move(node_context), output_buffer, &loop.exit_builder());
+  }
+
   // Compute the address of the element in the operand array.
-  llvm::Value* operand_buffer = node_context.GetOperandPtr(0);
   llvm::Type* src_array_type =
       type_converter()->ConvertToLlvmType(input_array_type);
   llvm::Value* src_element = loop.body_builder().CreateGEP(
@@ -1287,7 +1391,6 @@ absl::Status IrBuilderVisitor::HandleArraySlice(ArraySlice* slice) {
   src_element->setName("src_element");
 
   // Compute the address of the element in the result array.
-  llvm::Value* output_buffer = node_context.GetOutputPtr(0);
   llvm::Type* tgt_array_type =
       type_converter()->ConvertToLlvmType(slice->GetType());
   llvm::Value* tgt_element = loop.body_builder().CreateGEP(
@@ -1330,6 +1433,10 @@ absl::Status IrBuilderVisitor::HandleArrayUpdate(ArrayUpdate* update) {
       llvm::ConstantInt::get(llvm::Type::getInt32Ty(ctx()), 0),
   };
   llvm::Type* i64 = llvm::Type::getInt64Ty(ctx());
+  // If the updated element is an element of a packed array, the type of the
+  // packed array and the index of the element in it.
+  ArrayType* packed_array_type = nullptr;
+  llvm::Value* packed_index = nullptr;
   for (int64_t i = 2; i < update->operand_count(); ++i) {
     llvm::Value* index_value = node_context.LoadOperand(i);
     is_inbounds = b.CreateAnd(
@@ -1339,8 +1446,15 @@ absl::Status IrBuilderVisitor::HandleArrayUpdate(ArrayUpdate* update) {
     // indices of unusual widths. This is safe because if the cast to i64 ends
     // up truncating the value, the gep is unused because the index is
     // necessarily out of bounds.
-    gep_indices.push_back(
-        b.CreateIntCast(index_value, i64, /*isSigned=*/false));
+    llvm::Value* i64_index =
+        b.CreateIntCast(index_value, i64, /*isSigned=*/false);
+    if (type_converter()->IsPackedArray(array_type)) {
+      // The elements of a packed array are bits so this is the last index.
+      packed_array_type = array_type->AsArrayOrDie();
+      packed_index = i64_index;
+    } else {
+      gep_indices.push_back(i64_index);
+    }
     array_type = array_type->AsArrayOrDie()->element_type();
   }
 
@@ -1357,9 +1471,15 @@ absl::Status IrBuilderVisitor::HandleArrayUpdate(ArrayUpdate* update) {
   llvm::Value* output_element = inbounds_builder.CreateGEP(
       type_converter()->ConvertToLlvmType(update->GetType()), output_buffer,
       gep_indices);
-  LlvmMemcpy(output_element, node_context.GetOperandPtr(1),
-             type_converter()->GetTypeByteSize(update->operand(1)->GetType()),
-             inbounds_builder);
+  if (packed_array_type != nullptr) {
+    type_converter()->StorePackedArrayElement(
+        node_context.LoadOperand(1, &inbounds_builder), output_element,
+        packed_array_type, packed_index, inbounds_builder);
+  } else {
+    LlvmMemcpy(output_element, node_context.GetOperandPtr(1),
+               type_converter()->GetTypeByteSize(update->operand(1)->GetType()),
+               inbounds_builder);
+  }
   inbounds_builder.CreateBr(exit_block);
 
   // From the entry block, branch to the inbounds block if the index is
@@ -1381,6 +1501,45 @@ absl::Status IrBuilderVisitor::HandleArrayConcat(ArrayConcat* concat) {
       type_converter()->ConvertToLlvmType(concat->GetType());
 
   llvm::Value* output_buffer = node_context.GetOutputPtr(0);
+  bool is_packed = type_converter()->IsPackedArray(concat->GetType());
+  for (Node* operand : concat->operands()) {
+    is_packed |= type_converter()->IsPackedArray(operand->GetType());
+  }
+  if (is_packed) {
+    // Packed arrays have bits elements. Copy the elements of each operand by
+    // value with a loop.
+    if (type_converter()->IsPackedArray(concat->GetType())) {
+      b.CreateStore(LlvmTypeConverter::ZeroOfType(result_array_type),
+                    output_buffer);
+    }
+    std::vector<llvm::Value*> operand_buffers;
+    for (int64_t i = 0; i < concat->operand_count(); ++i) {
+      operand_buffers.push_back(node_context.GetOperandPtr(i));
+    }
+    llvm::IRBuilder<>* builder = &b;
+    std::unique_ptr<llvm::IRBuilder<>> exit_builder;
+    int64_t result_index = 0;
+    for (int64_t i = 0; i < concat->operand_count(); ++i) {
+      ArrayType* operand_array_type =
+          concat->operand(i)->GetType()->AsArrayOrDie();
+      LlvmIrLoop loop(operand_array_type->size(), *builder);
+      llvm::Value* element = LoadBitsArrayElement(
+          operand_buffers[i], operand_array_type, loop.index(),
+          *type_converter(), loop.body_builder());
+      StoreBitsArrayElement(
+          element, output_buffer, concat->GetType()->AsArrayOrDie(),
+          loop.body_builder().CreateAdd(
+              loop.index(), loop.body_builder().getInt64(result_index)),
+          *type_converter(), loop.body_builder());
+      loop.Finalize();
+      exit_builder = loop.ConsumeExitBuilder();
+      builder = exit_builder.get();
+      result_index += operand_array_type->size();
+    }
+    return FinalizeNodeIrContextWithPointerToValue(std::move(node_context),
+                                                   output_buffer, builder);
+  }
+
   int64_t result_index = 0;
   for (int64_t i = 0; i < concat->operand_count(); ++i) {
     ArrayType* operand_array_type =
@@ -1846,7 +2005,8 @@ absl::Status IrBuilderVisitor::HandleEq(CompareOp* eq) {
   // TODO(meheff): 2022/09/09 Rather than loading each element and comparing
   // individually, do a memcmp of the buffers.
   XLS_ASSIGN_OR_RETURN(std::vector<CompareTerm> eq_terms,
-                       ExpandTerms(lhs, llvm_lhs, rhs, llvm_rhs, eq, &b));
+                       ExpandTerms(lhs, llvm_lhs, rhs, llvm_rhs, eq,
+                                   *type_converter(), &b));
 
   llvm::Value* result = b.getTrue();
 
@@ -1935,16 +2095,45 @@ absl::Status IrBuilderVisitor::HandleMap(Map* map) {
   llvm::Value* input_buffer = node_context.GetOperandPtr(0);
   llvm::Value* output_buffer = node_context.GetOutputPtr(0);
 
+  // Elements of packed arrays are not addressable so they are passed to and
+  // from the map function through temporary buffers.
+  llvm::IRBuilder<>& b = node_context.entry_builder();
+  bool input_is_packed = type_converter()->IsPackedArray(input_array_type);
+  bool output_is_packed = type_converter()->IsPackedArray(result_array_type);
+  llvm::Value* input_element_buffer = nullptr;
+  llvm::Value* output_element_buffer = nullptr;
+  if (input_is_packed) {
+    input_element_buffer = b.CreateAlloca(
+        type_converter()->ConvertToLlvmType(input_array_type->element_type()));
+  }
+  if (output_is_packed) {
+    output_element_buffer = b.CreateAlloca(
+        type_converter()->ConvertToLlvmType(result_array_type->element_type()));
+    b.CreateStore(LlvmTypeConverter::ZeroOfType(output_type), output_buffer);
+  }
+
   // Loop through each index of the arrays.
   LlvmIrLoop loop(result_array_type->size(), node_context.entry_builder());
 
   // Compute address of input and output elements.
   llvm::Type* i32 = llvm::Type::getInt32Ty(ctx());
-  llvm::Value* input_element = loop.body_builder().CreateGEP(
-      input_type, input_buffer, {llvm::ConstantInt::get(i32, 0), loop.index()});
-  llvm::Value* output_element = loop.body_builder().CreateGEP(
-      output_type, output_buffer,
-      {llvm::ConstantInt::get(i32, 0), loop.index()});
+  llvm::Value* input_element;
+  if (input_is_packed) {
+    loop.body_builder().CreateStore(
+        type_converter()->LoadPackedArrayElement(
+            input_buffer, input_array_type, loop.index(), loop.body_builder()),
+        input_element_buffer);
+    input_element = input_element_buffer;
+  } else {
+    input_element = loop.body_builder().CreateGEP(
+        input_type, input_buffer,
+        {llvm::ConstantInt::get(i32, 0), loop.index()});
+  }
+  llvm::Value* output_element =
+      output_is_packed ? output_element_buffer
+                       : loop.body_builder().CreateGEP(
+                             output_type, output_buffer,
+                             {llvm::ConstantInt::get(i32, 0), loop.index()});
 
   // Call map function to compute the output element in situ.
   XLS_ASSIGN_OR_RETURN(llvm::Function * to_apply, GetFunction(map->to_apply()));
@@ -1955,6 +2144,14 @@ absl::Status IrBuilderVisitor::HandleMap(Map* map) {
                                    node_context.GetJitRuntimeArg(),
                                    loop.body_builder())
                           .status());
+  if (output_is_packed) {
+    type_converter()->StorePackedArrayElement(
+        loop.body_builder().CreateLoad(
+            type_converter()->ConvertToLlvmType(
+                result_array_type->element_type()),
+            output_element_buffer),
+        output_buffer, result_array_type, loop.index(), loop.body_builder());
+  }
   loop.Finalize();
 
   return FinalizeNodeIrContextWithPointerToValue(
@@ -2098,7 +2295,8 @@ absl::Status IrBuilderVisitor::HandleNe(CompareOp* ne) {
 
   // TODO(meheff): 2022/09/09 Use memcmp.
   XLS_ASSIGN_OR_RETURN(std::vector<CompareTerm> ne_terms,
-                       ExpandTerms(lhs, llvm_lhs, rhs, llvm_rhs, ne, &b));
+                       ExpandTerms(lhs, llvm_lhs, rhs, llvm_rhs, ne,
+                                   *type_converter(), &b));
 
   llvm::Value* result = b.getFalse();
 
@@ -2191,6 +2389,24 @@ std::unique_ptr<llvm::IRBuilder<>> OrInPlace(
     builder->CreateStore(result, tgt_buffer);
     return builder;
   }
+  if (type_converter->IsPackedArray(xls_type)) {
+    // Bits of packed arrays which do not hold element data are zero so the
+    // arrays can be ORed word by word.
+    llvm::Type* llvm_type = type_converter->ConvertToLlvmType(xls_type);
+    LlvmIrLoop loop(llvm_type->getArrayNumElements(), *builder, /*stride=*/1,
+                    insert_before);
+    llvm::IRBuilder<>& body = loop.body_builder();
+    llvm::Value* src_word_ptr = body.CreateGEP(
+        llvm_type, src_buffer, {body.getInt32(0), loop.index()});
+    llvm::Value* tgt_word_ptr = body.CreateGEP(
+        llvm_type, tgt_buffer, {body.getInt32(0), loop.index()});
+    body.CreateStore(
+        body.CreateOr(body.CreateLoad(body.getInt64Ty(), src_word_ptr),
+                      body.CreateLoad(body.getInt64Ty(), tgt_word_ptr)),
+        tgt_word_ptr);
+    loop.Finalize();
+    return loop.ConsumeExitBuilder();
+  }
   if (xls_type->IsArray()) {
     // Create a loop in LLVM and iterate through each element.
     ArrayType* array_type = xls_type->AsArrayOrDie();
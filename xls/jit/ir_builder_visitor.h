@@ -39,7 +39,8 @@ class JitBuilderContext {
       : module_(orc_jit.NewModule("__module")),
         orc_jit_(orc_jit),
         type_converter_(orc_jit.GetContext(),
-                        orc_jit.CreateDataLayout().value()),
+                        orc_jit.CreateDataLayout().value(),
+                        orc_jit.packed_array_threshold()),
         queue_manager_(queue_mgr) {}
 
   llvm::Module* module() const { return module_.get(); }
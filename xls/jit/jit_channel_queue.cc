@@ -108,9 +108,10 @@ std::optional<Value> ThreadUnsafeJitChannelQueue::ReadInternal() {
 }
 
 /* static */ absl::StatusOr<std::unique_ptr<JitChannelQueueManager>>
-JitChannelQueueManager::CreateThreadSafe(Package* package) {
+JitChannelQueueManager::CreateThreadSafe(Package* package,
+                                         int64_t packed_array_threshold) {
   XLS_ASSIGN_OR_RETURN(std::unique_ptr<JitRuntime> runtime,
-                       JitRuntime::Create());
+                       JitRuntime::Create(packed_array_threshold));
   std::vector<std::unique_ptr<ChannelQueue>> queues;
   for (Channel* channel : package->channels()) {
     queues.push_back(
@@ -121,9 +122,10 @@ JitChannelQueueManager::CreateThreadSafe(Package* package) {
 }
 
 /* static */ absl::StatusOr<std::unique_ptr<JitChannelQueueManager>>
-JitChannelQueueManager::CreateThreadUnsafe(Package* package) {
+JitChannelQueueManager::CreateThreadUnsafe(Package* package,
+                                           int64_t packed_array_threshold) {
   XLS_ASSIGN_OR_RETURN(std::unique_ptr<JitRuntime> runtime,
-                       JitRuntime::Create());
+                       JitRuntime::Create(packed_array_threshold));
   std::vector<std::unique_ptr<ChannelQueue>> queues;
   for (Channel* channel : package->channels()) {
     queues.push_back(
@@ -203,11 +203,12 @@ class JitChannelQueueManager : public ChannelQueueManager {
   virtual ~JitChannelQueueManager() = default;
 
   // Factories which create a queue manager with exclusively ThreadSafe/Unsafe
-  // queues.
+  // queues. `packed_array_threshold` is passed to the JitRuntime (see
+  // JitRuntime::packed_array_threshold).
   static absl::StatusOr<std::unique_ptr<JitChannelQueueManager>>
-  CreateThreadSafe(Package* package);
+  CreateThreadSafe(Package* package, int64_t packed_array_threshold = 0);
   static absl::StatusOr<std::unique_ptr<JitChannelQueueManager>>
-  CreateThreadUnsafe(Package* package);
+  CreateThreadUnsafe(Package* package, int64_t packed_array_threshold = 0);
 
   JitChannelQueue& GetJitQueue(Channel* channel);
 
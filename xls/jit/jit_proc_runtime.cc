@@ -27,11 +27,12 @@
 namespace xls {
 
 absl::StatusOr<std::unique_ptr<SerialProcRuntime>> CreateJitSerialProcRuntime(
-    Package* package) {
+    Package* package, int64_t packed_array_threshold) {
   // Create a queue manager for the queues. This factory verifies that there an
   // receive only queue for every receive only channel.
   XLS_ASSIGN_OR_RETURN(std::unique_ptr<JitChannelQueueManager> queue_manager,
-                       JitChannelQueueManager::CreateThreadSafe(package));
+                       JitChannelQueueManager::CreateThreadSafe(
+                           package, packed_array_threshold));
 
   // Create a ProcJit for each Proc.
   std::vector<std::unique_ptr<ProcEvaluator>> proc_jits;
@@ -15,6 +15,7 @@
 #ifndef XLS_JIT_JIT_PROC_RUNTIME_H_
 #define XLS_JIT_JIT_PROC_RUNTIME_H_
 
+#include <cstdint>
 #include <memory>
 
 #include "absl/status/statusor.h"
@@ -23,9 +24,11 @@
 
 namespace xls {
 
-// Create a SerialProcRuntime composed of ProcJits.
+// Create a SerialProcRuntime composed of ProcJits. If `packed_array_threshold`
+// is non-zero, arrays of at least that many narrow bits elements use a
+// bit-packed native layout (see LlvmTypeConverter::IsPackedArray).
 absl::StatusOr<std::unique_ptr<SerialProcRuntime>> CreateJitSerialProcRuntime(
-    Package* package);
+    Package* package, int64_t packed_array_threshold = 0);
 
 }  // namespace xls
 
@@ -14,6 +14,9 @@
 
 #include "xls/jit/jit_runtime.h"
 
+#include <utility>
+#include <vector>
+
 #include "absl/strings/str_format.h"
 #include "llvm/include/llvm/IR/DataLayout.h"
 #include "xls/common/status/status_macros.h"
@@ -25,16 +28,34 @@
 
 namespace xls {
 
-JitRuntime::JitRuntime(llvm::DataLayout data_layout)
+namespace {
+
+// Returns the word of a packed array buffer holding element `index` and the
+// bit offset of the element within the word.
+std::pair<int64_t, int64_t> PackedArrayElementPosition(
+    const ArrayType* array_type, int64_t index) {
+  int64_t slot_bit_count =
+      LlvmTypeConverter::PackedArraySlotBitCount(array_type);
+  int64_t elements_per_word = 64 / slot_bit_count;
+  return {index / elements_per_word,
+          (index % elements_per_word) * slot_bit_count};
+}
+
+}  // namespace
+
+JitRuntime::JitRuntime(llvm::DataLayout data_layout,
+                       int64_t packed_array_threshold)
     : data_layout_(std::move(data_layout)),
+      packed_array_threshold_(packed_array_threshold),
       context_(std::make_unique<llvm::LLVMContext>()),
-      type_converter_(
-          std::make_unique<LlvmTypeConverter>(context_.get(), data_layout_)) {}
+      type_converter_(std::make_unique<LlvmTypeConverter>(
+          context_.get(), data_layout_, packed_array_threshold)) {}
 
-/* static */ absl::StatusOr<std::unique_ptr<JitRuntime>> JitRuntime::Create() {
+/* static */ absl::StatusOr<std::unique_ptr<JitRuntime>> JitRuntime::Create(
+    int64_t packed_array_threshold) {
   XLS_ASSIGN_OR_RETURN(llvm::DataLayout data_layout,
                        xls::OrcJit::CreateDataLayout());
-  return std::make_unique<JitRuntime>(data_layout);
+  return std::make_unique<JitRuntime>(data_layout, packed_array_threshold);
 }
 
 absl::Status JitRuntime::PackArgs(absl::Span<const Value> args,
@@ -102,6 +123,24 @@ Value JitRuntime::UnpackBufferInternal(const uint8_t* buffer,
       }
 
       const Type* element_type = array_type->element_type();
+      if (type_converter_->IsPackedArray(array_type)) {
+        int64_t bit_count = element_type->GetFlatBitCount();
+#ifdef ABSL_HAVE_MEMORY_SANITIZER
+        if (unpoison) {
+          __msan_unpoison(buffer, type_converter_->GetTypeByteSize(array_type));
+        }
+#endif  // ABSL_HAVE_MEMORY_SANITIZER
+        std::vector<Value> values;
+        values.reserve(array_type->size());
+        for (int64_t i = 0; i < array_type->size(); ++i) {
+          auto [word_index, shift] = PackedArrayElementPosition(array_type, i);
+          uint64_t word;
+          memcpy(&word, buffer + word_index * sizeof(uint64_t), sizeof(word));
+          values.push_back(
+              Value(UBits((word >> shift) & Mask(bit_count), bit_count)));
+        }
+        return Value::ArrayOwned(std::move(values));
+      }
       llvm::Type* llvm_element_type =
           type_converter_->ConvertToLlvmType(array_type->element_type());
       std::vector<Value> values;
@@ -157,6 +196,17 @@ void JitRuntime::BlitValueToBufferInternal(const Value& value, const Type* type,
     if (remainder_bits != 0) {
       buffer[byte_count - 1] &= static_cast<uint8_t>(Mask(remainder_bits));
     }
+  } else if (value.IsArray() && type_converter_->IsPackedArray(type)) {
+    // The buffer is zeroed so the elements can simply be ORed into the words.
+    const ArrayType* array_type = type->AsArrayOrDie();
+    for (int64_t i = 0; i < value.size(); ++i) {
+      auto [word_index, shift] = PackedArrayElementPosition(array_type, i);
+      uint64_t word;
+      uint8_t* word_ptr = buffer.data() + word_index * sizeof(uint64_t);
+      memcpy(&word, word_ptr, sizeof(word));
+      word |= value.element(i).bits().ToUint64().value() << shift;
+      memcpy(word_ptr, &word, sizeof(word));
+    }
   } else if (value.IsArray()) {
     const ArrayType* array_type = type->AsArrayOrDie();
     int64_t element_size =
@@ -31,8 +31,12 @@ namespace xls {
 // data out of a flat character buffer, thus these routines are necessary.
 class JitRuntime {
  public:
-  JitRuntime(llvm::DataLayout data_layout);
-  static absl::StatusOr<std::unique_ptr<JitRuntime>> Create();
+  // `packed_array_threshold` selects which arrays use the packed array layout
+  // (see LlvmTypeConverter) and must match the value used to compile the code
+  // which the runtime exchanges values with.
+  JitRuntime(llvm::DataLayout data_layout, int64_t packed_array_threshold = 0);
+  static absl::StatusOr<std::unique_ptr<JitRuntime>> Create(
+      int64_t packed_array_threshold = 0);
 
   // Packs the specified values into a flat buffer with the data layout
   // expected by LLVM.
@@ -56,6 +60,8 @@ class JitRuntime {
 
   const llvm::DataLayout& data_layout() { return data_layout_; }
 
+  int64_t packed_array_threshold() const { return packed_array_threshold_; }
+
   int64_t GetTypeByteSize(Type* xls_type) {
     absl::MutexLock lock(&mutex_);
     return type_converter_->GetTypeByteSize(xls_type);
@@ -71,6 +77,7 @@ class JitRuntime {
   mutable absl::Mutex mutex_;
 
   const llvm::DataLayout data_layout_;
+  const int64_t packed_array_threshold_;
   std::unique_ptr<llvm::LLVMContext> context_ ABSL_GUARDED_BY(mutex_);
   std::unique_ptr<LlvmTypeConverter> type_converter_ ABSL_GUARDED_BY(mutex_);
 };
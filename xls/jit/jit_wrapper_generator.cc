@@ -311,7 +311,7 @@ std::string CreateImplSpecialization(const Function& function,
   param_names.push_back("return_value_view");
   return absl::StrFormat(R"(%s {
 %s;
-  XLS_RETURN_IF_ERROR(jit_->RunWithPackedViews(%s));
+  XLS_RETURN_IF_ERROR(jit_->RunWithPackedViewsAndBuffers(buffers_.get(), %s));
   return return_value;
 })",
                          signature, absl::StrJoin(param_conversions, ";\n"),
@@ -347,22 +347,29 @@ std::string GenerateWrapperHeader(const Function& function,
 
 namespace {{namespace}} {
 
-// JIT execution wrapper for the {{function_name}} XLS IR module.
+// JIT execution wrapper for the {{function_name}} XLS IR module. A wrapper is
+// not thread-safe. To run the function on multiple threads, create one wrapper
+// per thread with CreateInstanceSharingJit(); such wrappers share the compiled
+// code and only hold their own buffers.
 class {{class_name}} {
  public:
   static absl::StatusOr<std::unique_ptr<{{class_name}}>> Create();
-  xls::FunctionJit* jit() { return jit_.get(); }
+  std::unique_ptr<{{class_name}}> CreateInstanceSharingJit() const;
+  // The FunctionJit is shared with other instances, so only its const entry
+  // points, which take the caller's buffers (see CreateBuffers), are exposed.
+  const xls::FunctionJit* jit() const { return jit_.get(); }
 
   absl::StatusOr<xls::Value> Run({{params}});
   absl::Status Run({{packed_params}});
   {{specialization}}
 
  private:
-  {{class_name}}(std::unique_ptr<xls::Package> package,
-                 std::unique_ptr<xls::FunctionJit> jit);
+  {{class_name}}(std::shared_ptr<xls::Package> package,
+                 std::shared_ptr<xls::FunctionJit> jit);
 
-  std::unique_ptr<xls::Package> package_;
-  std::unique_ptr<xls::FunctionJit> jit_;
+  std::shared_ptr<xls::Package> package_;
+  std::shared_ptr<xls::FunctionJit> jit_;
+  std::unique_ptr<xls::FunctionJitBuffers> buffers_;
 };
 
 }  // namespace {{namespace}}
@@ -442,23 +449,28 @@ absl::StatusOr<std::unique_ptr<{{class_name}}>> {{class_name}}::Create() {
   return absl::WrapUnique(new {{class_name}}(std::move(package), std::move(jit)));
 }
 
-{{class_name}}::{{class_name}}(std::unique_ptr<xls::Package> package,
-                               std::unique_ptr<xls::FunctionJit> jit)
-    : package_(std::move(package)), jit_(std::move(jit)) { }
+std::unique_ptr<{{class_name}}> {{class_name}}::CreateInstanceSharingJit() const {
+  return absl::WrapUnique(new {{class_name}}(package_, jit_));
+}
+
+{{class_name}}::{{class_name}}(std::shared_ptr<xls::Package> package,
+                               std::shared_ptr<xls::FunctionJit> jit)
+    : package_(std::move(package)), jit_(std::move(jit)),
+      buffers_(jit_->CreateBuffers()) { }
 
 absl::StatusOr<xls::Value> {{class_name}}::Run({{params}}) {
   {{value_locals}}
   xls::Value args[{{args_size}}] = { {{args}} };
   // Special form to handle zero-argument spans.
   XLS_ASSIGN_OR_RETURN(xls::Value _retval,
-                       DropInterpreterEvents(jit_->Run(absl::MakeSpan(args, {{args_size}}))));
+                       DropInterpreterEvents(jit_->Run(absl::MakeSpan(args, {{args_size}}), buffers_.get())));
   {{value_postprocessing}}
   return _retval;
 }
 
 absl::Status {{class_name}}::Run({{run_params}}) {
   {{packed_locals}}
-  return jit_->RunWithPackedViews({{run_packed_params}});
+  return jit_->RunWithPackedViewsAndBuffers(buffers_.get(), {{run_packed_params}});
 }
 
 {{specialization}}
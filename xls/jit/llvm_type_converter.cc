@@ -14,16 +14,57 @@
 
 #include "xls/jit/llvm_type_converter.h"
 
+#include <algorithm>
+#include <vector>
+
 #include "absl/status/statusor.h"
 #include "llvm/include/llvm/IR/DerivedTypes.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/status/status_macros.h"
 
 namespace xls {
+namespace {
+
+// The width of the words holding the elements of packed arrays.
+constexpr int64_t kPackedArrayWordBitCount = 64;
+
+int64_t PackedArrayWordCount(const ArrayType* array_type) {
+  return CeilOfRatio(array_type->size() *
+                         LlvmTypeConverter::PackedArraySlotBitCount(array_type),
+                     kPackedArrayWordBitCount);
+}
+
+// The location of an element of a packed array: a pointer to the word holding
+// the element and the bit offset of the element within the word (an i64).
+struct PackedArrayElementLocation {
+  llvm::Value* word_ptr;
+  llvm::Value* shift;
+};
+
+PackedArrayElementLocation GetPackedArrayElementLocation(
+    llvm::Type* llvm_array_type, const ArrayType* array_type,
+    llvm::Value* array_ptr, llvm::Value* index, llvm::IRBuilder<>& builder) {
+  int64_t slot_bit_count =
+      LlvmTypeConverter::PackedArraySlotBitCount(array_type);
+  int64_t elements_per_word = kPackedArrayWordBitCount / slot_bit_count;
+  llvm::Value* word_index =
+      builder.CreateUDiv(index, builder.getInt64(elements_per_word));
+  llvm::Value* slot_index =
+      builder.CreateURem(index, builder.getInt64(elements_per_word));
+  return PackedArrayElementLocation{
+      .word_ptr = builder.CreateGEP(llvm_array_type, array_ptr,
+                                    {builder.getInt32(0), word_index}),
+      .shift = builder.CreateMul(slot_index, builder.getInt64(slot_bit_count))};
+}
+
+}  // namespace
 
 LlvmTypeConverter::LlvmTypeConverter(llvm::LLVMContext* context,
-                                     const llvm::DataLayout& data_layout)
-    : context_(*context), data_layout_(data_layout) {}
+                                     const llvm::DataLayout& data_layout,
+                                     int64_t packed_array_threshold)
+    : context_(*context),
+      data_layout_(data_layout),
+      packed_array_threshold_(packed_array_threshold) {}
 
 int64_t LlvmTypeConverter::GetLlvmBitCount(int64_t xls_bit_count) const {
   // LLVM does not accept 0-bit types, and we want to be able to JIT-compile
@@ -53,6 +94,10 @@ llvm::Type* LlvmTypeConverter::ConvertToLlvmType(const Type* xls_type) const {
     }
 
     llvm_type = llvm::StructType::get(context_, tuple_types);
+  } else if (IsPackedArray(xls_type)) {
+    llvm_type = llvm::ArrayType::get(
+        llvm::IntegerType::get(context_, kPackedArrayWordBitCount),
+        PackedArrayWordCount(xls_type->AsArrayOrDie()));
   } else if (xls_type->IsArray()) {
     const ArrayType* array_type = xls_type->AsArrayOrDie();
     llvm::Type* element_type = ConvertToLlvmType(array_type->element_type());
@@ -84,9 +129,115 @@ int64_t LlvmTypeConverter::GetPackedTypeByteSize(const Type* type) const {
 
 absl::StatusOr<llvm::Constant*> LlvmTypeConverter::ToLlvmConstant(
     const Type* type, const Value& value) const {
+  if (packed_array_threshold_ <= 0) {
+    // Without packed arrays the LLVM type fully determines the constant.
+    return ToLlvmConstant(ConvertToLlvmType(type), value);
+  }
+  if (IsPackedArray(type)) {
+    return ToPackedArrayConstant(type->AsArrayOrDie(), value);
+  }
+  if (type->IsArray()) {
+    const ArrayType* array_type = type->AsArrayOrDie();
+    std::vector<llvm::Constant*> elements;
+    for (const Value& element : value.elements()) {
+      XLS_ASSIGN_OR_RETURN(
+          llvm::Constant * llvm_element,
+          ToLlvmConstant(array_type->element_type(), element));
+      elements.push_back(llvm_element);
+    }
+    return llvm::ConstantArray::get(
+        llvm::cast<llvm::ArrayType>(ConvertToLlvmType(type)), elements);
+  }
+  if (type->IsTuple()) {
+    const TupleType* tuple_type = type->AsTupleOrDie();
+    std::vector<llvm::Constant*> elements;
+    for (int64_t i = 0; i < tuple_type->size(); ++i) {
+      XLS_ASSIGN_OR_RETURN(
+          llvm::Constant * llvm_element,
+          ToLlvmConstant(tuple_type->element_type(i), value.element(i)));
+      elements.push_back(llvm_element);
+    }
+    return llvm::ConstantStruct::get(
+        llvm::cast<llvm::StructType>(ConvertToLlvmType(type)), elements);
+  }
   return ToLlvmConstant(ConvertToLlvmType(type), value);
 }
 
+llvm::Constant* LlvmTypeConverter::ToPackedArrayConstant(
+    const ArrayType* array_type, const Value& value) const {
+  int64_t slot_bit_count = PackedArraySlotBitCount(array_type);
+  int64_t elements_per_word = kPackedArrayWordBitCount / slot_bit_count;
+  std::vector<uint64_t> words(PackedArrayWordCount(array_type), 0);
+  for (int64_t i = 0; i < value.size(); ++i) {
+    uint64_t element = value.element(i).bits().ToUint64().value();
+    words[i / elements_per_word] |= element
+                                    << ((i % elements_per_word) *
+                                        slot_bit_count);
+  }
+  llvm::Type* word_type =
+      llvm::IntegerType::get(context_, kPackedArrayWordBitCount);
+  std::vector<llvm::Constant*> llvm_words;
+  for (uint64_t word : words) {
+    llvm_words.push_back(llvm::ConstantInt::get(word_type, word));
+  }
+  return llvm::ConstantArray::get(
+      llvm::cast<llvm::ArrayType>(ConvertToLlvmType(array_type)), llvm_words);
+}
+
+bool LlvmTypeConverter::IsPackedArray(const Type* type) const {
+  if (packed_array_threshold_ <= 0 || !type->IsArray()) {
+    return false;
+  }
+  const ArrayType* array_type = type->AsArrayOrDie();
+  if (!array_type->element_type()->IsBits()) {
+    return false;
+  }
+  int64_t bit_count = array_type->element_type()->AsBitsOrDie()->bit_count();
+  return bit_count > 0 && bit_count <= kMaxPackedArrayElementBitCount &&
+         array_type->size() >= packed_array_threshold_;
+}
+
+/* static */ int64_t LlvmTypeConverter::PackedArraySlotBitCount(
+    const ArrayType* array_type) {
+  int64_t bit_count = array_type->element_type()->GetFlatBitCount();
+  return int64_t{1} << CeilOfLog2(std::max(bit_count, int64_t{1}));
+}
+
+llvm::Value* LlvmTypeConverter::LoadPackedArrayElement(
+    llvm::Value* array_ptr, const ArrayType* array_type, llvm::Value* index,
+    llvm::IRBuilder<>& builder) const {
+  PackedArrayElementLocation location = GetPackedArrayElementLocation(
+      ConvertToLlvmType(array_type), array_type, array_ptr, index, builder);
+  llvm::Value* word =
+      builder.CreateLoad(builder.getInt64Ty(), location.word_ptr);
+  int64_t bit_count = array_type->element_type()->GetFlatBitCount();
+  llvm::Value* element =
+      builder.CreateAnd(builder.CreateLShr(word, location.shift),
+                        builder.getInt64((uint64_t{1} << bit_count) - 1));
+  return builder.CreateTrunc(element,
+                             ConvertToLlvmType(array_type->element_type()));
+}
+
+void LlvmTypeConverter::StorePackedArrayElement(
+    llvm::Value* element, llvm::Value* array_ptr, const ArrayType* array_type,
+    llvm::Value* index, llvm::IRBuilder<>& builder) const {
+  PackedArrayElementLocation location = GetPackedArrayElementLocation(
+      ConvertToLlvmType(array_type), array_type, array_ptr, index, builder);
+  llvm::Value* word =
+      builder.CreateLoad(builder.getInt64Ty(), location.word_ptr);
+  int64_t slot_bit_count = PackedArraySlotBitCount(array_type);
+  llvm::Value* slot_mask = builder.CreateShl(
+      builder.getInt64((uint64_t{1} << slot_bit_count) - 1), location.shift);
+  int64_t bit_count = array_type->element_type()->GetFlatBitCount();
+  llvm::Value* element_bits =
+      builder.CreateAnd(builder.CreateZExt(element, builder.getInt64Ty()),
+                        builder.getInt64((uint64_t{1} << bit_count) - 1));
+  llvm::Value* updated_word =
+      builder.CreateOr(builder.CreateAnd(word, builder.CreateNot(slot_mask)),
+                       builder.CreateShl(element_bits, location.shift));
+  builder.CreateStore(updated_word, location.word_ptr);
+}
+
 absl::StatusOr<llvm::Constant*> LlvmTypeConverter::ToLlvmConstant(
     llvm::Type* type, const Value& value) const {
   if (type->isIntegerTy()) {
@@ -225,6 +376,9 @@ llvm::Value* LlvmTypeConverter::ClearPaddingBits(
 
 void LlvmTypeConverter::ComputeElementLayouts(
     Type* xls_type, std::vector<ElementLayout>* layouts, int64_t offset) {
+  XLS_CHECK(!IsPackedArray(xls_type))
+      << "TypeLayout cannot describe packed array type "
+      << xls_type->ToString();
   if (xls_type->IsToken()) {
     layouts->push_back(ElementLayout{.offset = offset,
                                      .data_size = 0,
@@ -26,14 +26,23 @@
 
 namespace xls {
 
+// The maximum bit width of the elements of arrays which may use the packed
+// array layout (see LlvmTypeConverter::IsPackedArray). Wider elements gain
+// little from packing as each element already occupies at most a byte.
+inline constexpr int64_t kMaxPackedArrayElementBitCount = 4;
+
 // LlvmTypeConverter handles the work of translating from XLS types and values
 // into the corresponding LLVM elements.
 //
 // This class must live as long as its constructor argument module.
 class LlvmTypeConverter {
  public:
+  // If `packed_array_threshold` is positive, arrays of at least that many
+  // elements of bits types no wider than kMaxPackedArrayElementBitCount use the
+  // packed array layout. Otherwise no arrays are packed.
   LlvmTypeConverter(llvm::LLVMContext* context,
-                    const llvm::DataLayout& data_layout);
+                    const llvm::DataLayout& data_layout,
+                    int64_t packed_array_threshold = 0);
 
   llvm::Type* ConvertToLlvmType(const Type* type) const;
   llvm::Type* ConvertToPointerToLlvmType(const Type* type) const {
@@ -125,7 +134,40 @@ class LlvmTypeConverter {
       llvm::Value* value, Type* xls_type, llvm::IRBuilder<>& builder,
       std::optional<llvm::Type*> dest_type = std::nullopt) const;
 
+  // Returns true if the given type is an array stored in the packed array
+  // layout. In the default layout each array element occupies at least one
+  // byte. In the packed layout the elements are instead stored in consecutive
+  // slots of 1, 2 or 4 bits (the element bit width rounded up to a power of
+  // two) of an array of i64 words, so an element never straddles two words.
+  // Element i is in bits [(i % E) * S, (i % E + 1) * S) of word i / E where S
+  // is the slot width and E = 64 / S. All bits not holding element data are
+  // zero.
+  bool IsPackedArray(const Type* type) const;
+  int64_t packed_array_threshold() const { return packed_array_threshold_; }
+
+  // Returns the width in bits of the slot holding each element of the given
+  // packed array type.
+  static int64_t PackedArraySlotBitCount(const ArrayType* array_type);
+
+  // Emits IR which loads element `index` of the packed array of type
+  // `array_type` pointed to by `array_ptr`. `index` must be an in-bounds i64
+  // value. The element is returned in the native LLVM type of the element.
+  llvm::Value* LoadPackedArrayElement(llvm::Value* array_ptr,
+                                      const ArrayType* array_type,
+                                      llvm::Value* index,
+                                      llvm::IRBuilder<>& builder) const;
+
+  // Emits IR which stores `element` (in the native LLVM type of the element)
+  // as element `index` of the packed array of type `array_type` pointed to by
+  // `array_ptr`. `index` must be an in-bounds i64 value. The other elements
+  // are unchanged.
+  void StorePackedArrayElement(llvm::Value* element, llvm::Value* array_ptr,
+                               const ArrayType* array_type, llvm::Value* index,
+                               llvm::IRBuilder<>& builder) const;
+
   // Creates a TypeLayout object describing the native layout of given xls type.
+  // Packed arrays cannot be described by a TypeLayout so the type must not
+  // contain any.
   TypeLayout CreateTypeLayout(Type* xls_type);
 
  private:
@@ -141,8 +183,13 @@ class LlvmTypeConverter {
                              std::vector<ElementLayout>* layouts,
                              int64_t offset);
 
+  // Returns the LLVM constant for the given value of a packed array type.
+  llvm::Constant* ToPackedArrayConstant(const ArrayType* array_type,
+                                        const Value& value) const;
+
   llvm::LLVMContext& context_;
   llvm::DataLayout data_layout_;
+  int64_t packed_array_threshold_;
 };
 
 }  // namespace xls
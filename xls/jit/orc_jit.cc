@@ -87,7 +87,8 @@ char BadOptLevelError::ID;
 
 }  // namespace
 
-OrcJit::OrcJit(int64_t opt_level, bool emit_object_code)
+OrcJit::OrcJit(int64_t opt_level, bool emit_object_code,
+               int64_t packed_array_threshold)
     : context_(std::make_unique<llvm::LLVMContext>()),
       execution_session_(
           std::make_unique<llvm::orc::UnsupportedExecutorProcessControl>()),
@@ -97,6 +98,7 @@ OrcJit::OrcJit(int64_t opt_level, bool emit_object_code)
       dylib_(execution_session_.createBareJITDylib("main")),
       opt_level_(opt_level),
       emit_object_code_(emit_object_code),
+      packed_array_threshold_(packed_array_threshold),
       data_layout_("") {}
 
 OrcJit::~OrcJit() {
@@ -175,11 +177,11 @@ llvm::Expected<llvm::orc::ThreadSafeModule> OrcJit::Optimizer(
   return module;
 }
 
-absl::StatusOr<std::unique_ptr<OrcJit>> OrcJit::Create(int64_t opt_level,
-                                                       bool emit_object_code) {
+absl::StatusOr<std::unique_ptr<OrcJit>> OrcJit::Create(
+    int64_t opt_level, bool emit_object_code, int64_t packed_array_threshold) {
   absl::call_once(once, OnceInit);
-  std::unique_ptr<OrcJit> jit =
-      absl::WrapUnique(new OrcJit(opt_level, emit_object_code));
+  std::unique_ptr<OrcJit> jit = absl::WrapUnique(
+      new OrcJit(opt_level, emit_object_code, packed_array_threshold));
   XLS_RETURN_IF_ERROR(jit->Init());
   return std::move(jit);
 }
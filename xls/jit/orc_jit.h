@@ -34,9 +34,12 @@ class OrcJit {
   ~OrcJit();
   // Create an LLVM ORC JIT instance which compiles at the given optimization
   // level. If `emit_object_code` is true then `GetObjectCode` can be called
-  // after compilation to get the object code.
+  // after compilation to get the object code. `packed_array_threshold` selects
+  // the arrays which use the packed array layout in code compiled by this JIT
+  // (see LlvmTypeConverter); zero disables packing.
   static absl::StatusOr<std::unique_ptr<OrcJit>> Create(
-      int64_t opt_level = 3, bool emit_object_code = false);
+      int64_t opt_level = 3, bool emit_object_code = false,
+      int64_t packed_array_threshold = 0);
 
   // Creates and returns a new LLVM module of the given name.
   std::unique_ptr<llvm::Module> NewModule(std::string_view name);
@@ -58,8 +61,11 @@ class OrcJit {
   // Creates and returns a data layout object.
   static absl::StatusOr<llvm::DataLayout> CreateDataLayout();
 
+  int64_t packed_array_threshold() const { return packed_array_threshold_; }
+
  private:
-  OrcJit(int64_t opt_level, bool emit_object_code);
+  OrcJit(int64_t opt_level, bool emit_object_code,
+         int64_t packed_array_threshold);
   absl::Status Init();
 
   static absl::StatusOr<std::unique_ptr<llvm::TargetMachine>>
@@ -78,6 +84,7 @@ class OrcJit {
 
   int64_t opt_level_;
   bool emit_object_code_;
+  int64_t packed_array_threshold_;
 
   std::unique_ptr<llvm::TargetMachine> target_machine_;
   llvm::DataLayout data_layout_;
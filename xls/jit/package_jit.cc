@@ -0,0 +1,91 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/jit/package_jit.h"
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_format.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/call_graph.h"
+
+namespace xls {
+
+absl::StatusOr<std::unique_ptr<PackageJit>> PackageJit::Create(
+    Package* package, int64_t opt_level) {
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<OrcJit> orc_jit,
+                       OrcJit::Create(opt_level, /*emit_object_code=*/false));
+  XLS_ASSIGN_OR_RETURN(llvm::DataLayout data_layout,
+                       OrcJit::CreateDataLayout());
+  return absl::WrapUnique(new PackageJit(
+      package, std::move(orc_jit), std::make_unique<JitRuntime>(data_layout)));
+}
+
+absl::StatusOr<const JittedFunctionBase*> PackageJit::GetOrCompile(
+    Function* function) {
+  XLS_RET_CHECK_EQ(function->package(), package_) << absl::StreamFormat(
+      "Function `%s` is not in package `%s`", function->name(),
+      package_->name());
+  absl::MutexLock lock(&mutex_);
+  // Dependent functions are returned callees first so every callee is
+  // compiled before its callers.
+  for (FunctionBase* f : GetDependentFunctions(function)) {
+    if (compiled_functions_.contains(f)) {
+      continue;
+    }
+    XLS_VLOG(2) << absl::StreamFormat("Compiling `%s` into package JIT of %s",
+                                      f->name(), package_->name());
+    XLS_ASSIGN_OR_RETURN(JittedFunctionBase jitted_function,
+                         BuildFunctionWithCompiledCallees(
+                             f->AsFunctionOrDie(), compiled_functions_,
+                             *orc_jit_));
+    jitted_functions_.push_back(
+        std::make_unique<JittedFunctionBase>(std::move(jitted_function)));
+    compiled_functions_[f] = jitted_functions_.back().get();
+  }
+  return compiled_functions_.at(function);
+}
+
+absl::Status PackageJit::CompileAll() {
+  for (const std::unique_ptr<Function>& function : package_->functions()) {
+    XLS_RETURN_IF_ERROR(GetOrCompile(function.get()).status());
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::unique_ptr<FunctionJit>> PackageJit::CreateFunctionJit(
+    Function* function) {
+  XLS_ASSIGN_OR_RETURN(const JittedFunctionBase* jitted_function,
+                       GetOrCompile(function));
+  auto jit = absl::WrapUnique(new FunctionJit(function));
+  jit->jitted_function_base_ = *jitted_function;
+  jit->jit_runtime_ = jit_runtime_.get();
+  jit->InitializeBuffers();
+  return jit;
+}
+
+absl::StatusOr<std::unique_ptr<FunctionJit>> PackageJit::CreateFunctionJit(
+    std::string_view function_name) {
+  XLS_ASSIGN_OR_RETURN(Function * function,
+                       package_->GetFunction(function_name));
+  return CreateFunctionJit(function);
+}
+
+int64_t PackageJit::compiled_function_count() const {
+  absl::MutexLock lock(&mutex_);
+  return compiled_functions_.size();
+}
+
+}  // namespace xls
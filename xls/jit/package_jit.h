@@ -0,0 +1,98 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_JIT_PACKAGE_JIT_H_
+#define XLS_JIT_PACKAGE_JIT_H_
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "xls/ir/function.h"
+#include "xls/ir/package.h"
+#include "xls/jit/function_base_jit.h"
+#include "xls/jit/function_jit.h"
+#include "xls/jit/jit_runtime.h"
+#include "xls/jit/orc_jit.h"
+
+namespace xls {
+
+// A JIT session shared by all functions of a package. Each XLS function is
+// compiled at most once into a single JITDylib. Invokes (and the bodies of
+// maps and counted fors) are linked as direct calls to the already compiled
+// code of the callee rather than being rebuilt inside every caller as
+// FunctionJit::Create does. This avoids recompiling shared callees when many
+// functions of a package are jitted, e.g., when evaluating every function of a
+// package or when a large library function is invoked from many places. The
+// cost is that LLVM cannot inline across function boundaries.
+//
+// Compilation is thread-safe. The FunctionJits returned by CreateFunctionJit
+// are lightweight handles holding only their own argument, result and
+// temporary buffers; like any FunctionJit each handle is not thread-safe but
+// different handles may be used concurrently. Handles must not outlive the
+// PackageJit which created them.
+class PackageJit {
+ public:
+  static absl::StatusOr<std::unique_ptr<PackageJit>> Create(
+      Package* package, int64_t opt_level = 3);
+
+  // Returns the jitted function implementing `function`, compiling it and any
+  // callees which have not been compiled yet.
+  absl::StatusOr<const JittedFunctionBase*> GetOrCompile(Function* function);
+
+  // Compiles every function in the package.
+  absl::Status CompileAll();
+
+  // Returns a FunctionJit executing the code for `function` compiled into this
+  // session. Compiles the function if necessary.
+  absl::StatusOr<std::unique_ptr<FunctionJit>> CreateFunctionJit(
+      Function* function);
+  absl::StatusOr<std::unique_ptr<FunctionJit>> CreateFunctionJit(
+      std::string_view function_name);
+
+  // Returns the number of functions compiled into the session so far.
+  int64_t compiled_function_count() const;
+
+  Package* package() const { return package_; }
+  JitRuntime* runtime() const { return jit_runtime_.get(); }
+
+ private:
+  PackageJit(Package* package, std::unique_ptr<OrcJit> orc_jit,
+             std::unique_ptr<JitRuntime> jit_runtime)
+      : package_(package),
+        orc_jit_(std::move(orc_jit)),
+        jit_runtime_(std::move(jit_runtime)) {}
+
+  Package* package_;
+
+  mutable absl::Mutex mutex_;
+  std::unique_ptr<OrcJit> orc_jit_ ABSL_GUARDED_BY(mutex_);
+  std::unique_ptr<JitRuntime> jit_runtime_;
+
+  // The compiled functions. Held by unique_ptr for pointer stability.
+  std::vector<std::unique_ptr<JittedFunctionBase>> jitted_functions_
+      ABSL_GUARDED_BY(mutex_);
+  absl::flat_hash_map<FunctionBase*, const JittedFunctionBase*>
+      compiled_functions_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace xls
+
+#endif  // XLS_JIT_PACKAGE_JIT_H_
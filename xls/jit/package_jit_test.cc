@@ -0,0 +1,160 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/jit/package_jit.h"
+
+#include <memory>
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/statusor.h"
+#include "xls/common/status/matchers.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/interpreter/ir_evaluator_test_base.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/ir_parser.h"
+#include "xls/ir/value.h"
+
+namespace xls {
+namespace {
+
+using status_testing::IsOkAndHolds;
+using status_testing::StatusIs;
+
+INSTANTIATE_TEST_SUITE_P(
+    PackageJitTest, IrEvaluatorTestBase,
+    testing::Values(IrEvaluatorTestParam(
+        [](Function* function, absl::Span<const Value> args)
+            -> absl::StatusOr<InterpreterResult<Value>> {
+          XLS_ASSIGN_OR_RETURN(std::unique_ptr<PackageJit> package_jit,
+                               PackageJit::Create(function->package()));
+          XLS_ASSIGN_OR_RETURN(std::unique_ptr<FunctionJit> jit,
+                               package_jit->CreateFunctionJit(function));
+          return jit->Run(args);
+        },
+        [](Function* function,
+           const absl::flat_hash_map<std::string, Value>& kwargs)
+            -> absl::StatusOr<InterpreterResult<Value>> {
+          XLS_ASSIGN_OR_RETURN(std::unique_ptr<PackageJit> package_jit,
+                               PackageJit::Create(function->package()));
+          XLS_ASSIGN_OR_RETURN(std::unique_ptr<FunctionJit> jit,
+                               package_jit->CreateFunctionJit(function));
+          return jit->Run(kwargs);
+        })));
+
+absl::StatusOr<Value> RunJit(FunctionJit* jit, absl::Span<const Value> args) {
+  XLS_ASSIGN_OR_RETURN(InterpreterResult<Value> result, jit->Run(args));
+  XLS_RETURN_IF_ERROR(InterpreterEventsToStatus(result.events));
+  return result.value;
+}
+
+constexpr char kSharedCalleePackage[] = R"(
+package shared_callee
+
+fn add1(x: bits[32]) -> bits[32] {
+  one: bits[32] = literal(value=1)
+  ret add.2: bits[32] = add(x, one)
+}
+
+fn body(i: bits[32], accum: bits[32]) -> bits[32] {
+  inc: bits[32] = invoke(accum, to_apply=add1)
+  ret add.5: bits[32] = add(inc, i)
+}
+
+fn twice(x: bits[32]) -> bits[32] {
+  a: bits[32] = invoke(x, to_apply=add1)
+  ret b: bits[32] = invoke(a, to_apply=add1)
+}
+
+fn loop(x: bits[32]) -> bits[32] {
+  ret counted_for.10: bits[32] = counted_for(x, trip_count=4, stride=1, body=body)
+}
+
+fn mapped(x: bits[32][3]) -> bits[32][3] {
+  ret map.12: bits[32][3] = map(x, to_apply=add1)
+}
+
+fn top(x: bits[32]) -> bits[32] {
+  t: bits[32] = invoke(x, to_apply=twice)
+  l: bits[32] = invoke(x, to_apply=loop)
+  ret add.15: bits[32] = add(t, l)
+}
+)";
+
+TEST(PackageJitTest, FunctionsAreCompiledOnce) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> package,
+                           Parser::ParsePackage(kSharedCalleePackage));
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<PackageJit> package_jit,
+                           PackageJit::Create(package.get()));
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<FunctionJit> twice,
+                           package_jit->CreateFunctionJit("twice"));
+  EXPECT_EQ(package_jit->compiled_function_count(), 2);
+  EXPECT_THAT(RunJit(twice.get(), {Value(UBits(40, 32))}),
+              IsOkAndHolds(Value(UBits(42, 32))));
+
+  // `top` reuses the compiled code of `twice` and `add1`; only `body`, `loop`
+  // and `top` itself are compiled.
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<FunctionJit> top,
+                           package_jit->CreateFunctionJit("top"));
+  EXPECT_EQ(package_jit->compiled_function_count(), 5);
+  // twice(10) = 12, loop(10) = 10 + 4 * 1 + (0 + 1 + 2 + 3) = 20.
+  EXPECT_THAT(RunJit(top.get(), {Value(UBits(10, 32))}),
+              IsOkAndHolds(Value(UBits(32, 32))));
+
+  // Creating another handle does not compile anything.
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<FunctionJit> top2,
+                           package_jit->CreateFunctionJit("top"));
+  EXPECT_EQ(package_jit->compiled_function_count(), 5);
+  EXPECT_THAT(RunJit(top2.get(), {Value(UBits(0, 32))}),
+              IsOkAndHolds(Value(UBits(12, 32))));
+  EXPECT_THAT(RunJit(twice.get(), {Value(UBits(0, 32))}),
+              IsOkAndHolds(Value(UBits(2, 32))));
+}
+
+TEST(PackageJitTest, CompileAll) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> package,
+                           Parser::ParsePackage(kSharedCalleePackage));
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<PackageJit> package_jit,
+                           PackageJit::Create(package.get()));
+  XLS_ASSERT_OK(package_jit->CompileAll());
+  EXPECT_EQ(package_jit->compiled_function_count(), 6);
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<FunctionJit> mapped,
+                           package_jit->CreateFunctionJit("mapped"));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Value input, Value::UBitsArray({1, 2, 3}, /*bit_count=*/32));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Value expected, Value::UBitsArray({2, 3, 4}, /*bit_count=*/32));
+  EXPECT_THAT(RunJit(mapped.get(), {input}), IsOkAndHolds(expected));
+  EXPECT_EQ(package_jit->compiled_function_count(), 6);
+}
+
+TEST(PackageJitTest, FunctionFromOtherPackage) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> package,
+                           Parser::ParsePackage(kSharedCalleePackage));
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> other,
+                           Parser::ParsePackage(kSharedCalleePackage));
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<PackageJit> package_jit,
+                           PackageJit::Create(package.get()));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, other->GetFunction("add1"));
+  EXPECT_THAT(package_jit->CreateFunctionJit(f),
+              StatusIs(absl::StatusCode::kInternal));
+  EXPECT_THAT(package_jit->CreateFunctionJit("not_a_function"),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
+}  // namespace
+}  // namespace xls
@@ -0,0 +1,135 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "include/benchmark/benchmark.h"
+#include "xls/common/logging/logging.h"
+#include "xls/interpreter/random_value.h"
+#include "xls/interpreter/serial_proc_runtime.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/function.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_parser.h"
+#include "xls/ir/package.h"
+#include "xls/ir/proc.h"
+#include "xls/ir/value.h"
+#include "xls/jit/function_jit.h"
+#include "xls/jit/jit_proc_runtime.h"
+
+namespace xls {
+namespace {
+
+// Measure the performance of jitted code operating on large arrays of narrow
+// elements with and without the bit-packed array layout. The function is a
+// step of a sieve-like bitmap algorithm: it tests a flag in a bitmap of 4096
+// one-bit flags, sets several flags, and compares the result against the
+// input.
+constexpr const char* kBitmapFunction = R"(
+fn bitmap_step(bitmap: bits[1][4096], i: bits[32]) -> (bits[1][4096], bits[1], bits[1]) {
+  one: bits[1] = literal(value=1)
+  stride: bits[32] = literal(value=3)
+  i1: bits[32] = add(i, stride)
+  i2: bits[32] = add(i1, stride)
+  i3: bits[32] = add(i2, stride)
+  flag: bits[1] = array_index(bitmap, indices=[i])
+  u0: bits[1][4096] = array_update(bitmap, one, indices=[i1])
+  u1: bits[1][4096] = array_update(u0, one, indices=[i2])
+  u2: bits[1][4096] = array_update(u1, one, indices=[i3])
+  unchanged: bits[1] = eq(u2, bitmap)
+  ret result: (bits[1][4096], bits[1], bits[1]) = tuple(u2, flag, unchanged)
+}
+)";
+
+// The benchmark argument is the packed array threshold (zero disables the
+// packed layout).
+static void BM_BitmapStep(benchmark::State& state) {
+  Package package("BM");
+  Function* function = Parser::ParseFunction(kBitmapFunction, &package).value();
+  std::unique_ptr<FunctionJit> jit =
+      FunctionJit::Create(function, /*opt_level=*/3,
+                          /*packed_array_threshold=*/state.range(0))
+          .value();
+
+  std::minstd_rand bitgen;
+  Type* bitmap_type = function->param(0)->GetType();
+  std::vector<uint8_t> bitmap_buffer(jit->GetArgTypeSize(0));
+  jit->runtime()->BlitValueToBuffer(RandomValue(bitmap_type, &bitgen),
+                                    bitmap_type,
+                                    absl::MakeSpan(bitmap_buffer));
+  std::vector<uint8_t> index_buffer(jit->GetArgTypeSize(1));
+  jit->runtime()->BlitValueToBuffer(Value(UBits(1234, 32)),
+                                    function->param(1)->GetType(),
+                                    absl::MakeSpan(index_buffer));
+  std::vector<uint8_t*> args = {bitmap_buffer.data(), index_buffer.data()};
+  std::vector<uint8_t> result_buffer(jit->GetReturnTypeSize());
+  InterpreterEvents events;
+  for (auto _ : state) {
+    XLS_CHECK_OK(
+        jit->RunWithViews(args, absl::MakeSpan(result_buffer), &events));
+    benchmark::DoNotOptimize(result_buffer.data());
+  }
+  state.counters["buffer_bytes"] = bitmap_buffer.size();
+}
+
+BENCHMARK(BM_BitmapStep)->Arg(0)->Arg(1);
+
+// Builds a proc performing the step of kBitmapFunction in every tick with the
+// bitmap and the index held in state elements, so the bitmap is passed between
+// ticks in the native layout of the JIT.
+Proc* BuildBitmapProc(Package* package) {
+  ProcBuilder pb("bitmap_proc", "tkn", package);
+  std::vector<Value> bits(4096, Value(UBits(0, 1)));
+  BValue bitmap = pb.StateElement("bitmap", Value::ArrayOrDie(bits));
+  BValue i = pb.StateElement("i", Value(UBits(0, 32)));
+  BValue one = pb.Literal(UBits(1, 1));
+  BValue stride = pb.Literal(UBits(3, 32));
+  BValue i1 = pb.Add(i, stride);
+  BValue i2 = pb.Add(i1, stride);
+  BValue i3 = pb.Add(i2, stride);
+  BValue flag = pb.ArrayIndex(bitmap, {i});
+  BValue u0 = pb.ArrayUpdate(bitmap, one, {i1});
+  BValue u1 = pb.ArrayUpdate(u0, one, {i2});
+  BValue u2 = pb.ArrayUpdate(u1, one, {i3});
+  BValue unchanged = pb.Eq(u2, bitmap);
+  // Wrap the index around the bitmap so every tick updates it.
+  BValue next_i =
+      pb.And(pb.Select(flag, pb.Select(unchanged, i3, i1), i2),
+             pb.Literal(UBits(4095, 32)));
+  return pb.Build(pb.GetTokenParam(), {u2, next_i}).value();
+}
+
+// The benchmark argument is the packed array threshold (zero disables the
+// packed layout).
+static void BM_BitmapProcTick(benchmark::State& state) {
+  Package package("BM");
+  BuildBitmapProc(&package);
+  std::unique_ptr<SerialProcRuntime> runtime =
+      CreateJitSerialProcRuntime(&package,
+                                 /*packed_array_threshold=*/state.range(0))
+          .value();
+  for (auto _ : state) {
+    XLS_CHECK_OK(runtime->Tick());
+  }
+}
+
+BENCHMARK(BM_BitmapProcTick)->Arg(0)->Arg(1);
+
+BENCHMARK_MAIN();
+
+}  // namespace
+}  // namespace xls
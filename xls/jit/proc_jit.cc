@@ -74,7 +74,12 @@ void ProcJitContinuation::NextTick() {
 
 absl::StatusOr<std::unique_ptr<ProcJit>> ProcJit::Create(
     Proc* proc, JitRuntime* jit_runtime, JitChannelQueueManager* queue_mgr) {
-  XLS_ASSIGN_OR_RETURN(std::unique_ptr<OrcJit> orc_jit, OrcJit::Create());
+  // The native layout of the compiled code must match the runtime which packs
+  // and unpacks state and channel values.
+  XLS_ASSIGN_OR_RETURN(
+      std::unique_ptr<OrcJit> orc_jit,
+      OrcJit::Create(/*opt_level=*/3, /*emit_object_code=*/false,
+                     jit_runtime->packed_array_threshold()));
   auto jit =
       absl::WrapUnique(new ProcJit(proc, jit_runtime, std::move(orc_jit)));
   XLS_ASSIGN_OR_RETURN(jit->jitted_function_base_,
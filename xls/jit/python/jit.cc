@@ -0,0 +1,354 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Python bindings for evaluating functions and proc networks with the JIT.
+//
+// Values are passed in and out in the native layout of the JIT via the buffer
+// protocol (e.g. NumPy arrays) so a batch of evaluations requires no
+// conversion to or from xls::Value. The GIL is released while compiling and
+// while running compiled code so Python threads can evaluate in parallel.
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "pybind11/numpy.h"
+#include "pybind11/pybind11.h"
+#include "pybind11/stl.h"
+#include "pybind11_abseil/absl_casters.h"
+#include "pybind11_abseil/status_caster.h"
+#include "pybind11_abseil/statusor_caster.h"
+#include "xls/common/status/import_status_module.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/interpreter/serial_proc_runtime.h"
+#include "xls/ir/events.h"
+#include "xls/ir/python/wrapper_types.h"
+#include "xls/jit/function_jit.h"
+#include "xls/jit/jit_channel_queue.h"
+#include "xls/jit/jit_proc_runtime.h"
+
+namespace py = pybind11;
+
+namespace xls {
+namespace {
+
+// Returns the number of elements of `element_size` bytes held in the given
+// buffer. The buffer must be C-contiguous so that the elements can be passed
+// to the JIT without copying.
+absl::StatusOr<int64_t> GetElementCount(const py::buffer_info& info,
+                                        int64_t element_size,
+                                        std::string_view name) {
+  int64_t expected_stride = info.itemsize;
+  for (int64_t i = info.ndim - 1; i >= 0; --i) {
+    if (info.shape[i] > 1 && info.strides[i] != expected_stride) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Buffer for %s is not C-contiguous", name));
+    }
+    expected_stride *= info.shape[i];
+  }
+  int64_t byte_count = info.size * info.itemsize;
+  if (element_size == 0 || byte_count % element_size != 0) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Buffer for %s has %d bytes which is not a multiple of the native "
+        "size of the type (%d bytes)",
+        name, byte_count, element_size));
+  }
+  return byte_count / element_size;
+}
+
+// Returns a new array holding `count` elements of the given type in the native
+// layout of the JIT. Bits types whose native size is that of a NumPy unsigned
+// integer type produce a one-dimensional array of that type; other types
+// produce an array of bytes with one row per element.
+py::array MakeNativeArray(Type* type, int64_t element_size, int64_t count) {
+  if (type->IsBits()) {
+    switch (element_size) {
+      case 1:
+        return py::array_t<uint8_t>(count);
+      case 2:
+        return py::array_t<uint16_t>(count);
+      case 4:
+        return py::array_t<uint32_t>(count);
+      case 8:
+        return py::array_t<uint64_t>(count);
+      default:
+        break;
+    }
+  }
+  return py::array_t<uint8_t>({count, element_size});
+}
+
+// Wrapper owning a FunctionJit which keeps the package of the compiled function
+// alive.
+class FunctionJitHolder {
+ public:
+  static absl::StatusOr<FunctionJitHolder> Create(FunctionHolder function,
+                                                  int64_t opt_level) {
+    std::unique_ptr<FunctionJit> jit;
+    {
+      py::gil_scoped_release release;
+      XLS_ASSIGN_OR_RETURN(jit,
+                           FunctionJit::Create(&function.deref(), opt_level));
+    }
+    return FunctionJitHolder(function.package(), std::move(jit));
+  }
+
+  // Runs the function on a batch of arguments. `args` holds one buffer per
+  // parameter containing the values of that parameter for every element of
+  // the batch. Returns an array holding the result for every element.
+  absl::StatusOr<py::array> RunBatch(const std::vector<py::buffer>& args) {
+    Function* function = jit_->function();
+    if (args.size() != function->params().size()) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Expected %d arguments, got %d",
+                          function->params().size(), args.size()));
+    }
+    std::vector<py::buffer_info> infos;
+    std::vector<uint8_t*> arg_data;
+    std::vector<int64_t> arg_sizes;
+    std::optional<int64_t> batch_size;
+    for (int64_t i = 0; i < args.size(); ++i) {
+      infos.push_back(args[i].request());
+      arg_data.push_back(static_cast<uint8_t*>(infos.back().ptr));
+      arg_sizes.push_back(jit_->GetArgTypeSize(i));
+      if (arg_sizes.back() == 0) {
+        // Zero-width parameters carry no data.
+        continue;
+      }
+      XLS_ASSIGN_OR_RETURN(
+          int64_t count,
+          GetElementCount(infos.back(), arg_sizes.back(),
+                          function->param(i)->GetName()));
+      if (batch_size.has_value() && count != *batch_size) {
+        return absl::InvalidArgumentError(absl::StrFormat(
+            "Argument %s has %d elements, expected %d",
+            function->param(i)->GetName(), count, *batch_size));
+      }
+      batch_size = count;
+    }
+    if (!batch_size.has_value()) {
+      return absl::InvalidArgumentError(
+          "Batch size cannot be determined from zero-width arguments");
+    }
+
+    int64_t result_size = jit_->GetReturnTypeSize();
+    py::array result =
+        MakeNativeArray(function->return_value()->GetType(), result_size,
+                        *batch_size);
+    uint8_t* result_data = static_cast<uint8_t*>(result.mutable_data());
+
+    absl::Status status;
+    {
+      py::gil_scoped_release release;
+      status = RunBatchInternal(absl::MakeSpan(arg_data), arg_sizes,
+                                result_data, result_size, *batch_size);
+    }
+    XLS_RETURN_IF_ERROR(status);
+    return result;
+  }
+
+  std::vector<int64_t> GetArgSizes() const {
+    std::vector<int64_t> sizes;
+    for (int64_t i = 0; i < jit_->function()->params().size(); ++i) {
+      sizes.push_back(jit_->GetArgTypeSize(i));
+    }
+    return sizes;
+  }
+  int64_t GetResultSize() const { return jit_->GetReturnTypeSize(); }
+
+ private:
+  FunctionJitHolder(std::shared_ptr<Package> package,
+                    std::unique_ptr<FunctionJit> jit)
+      : package_(std::move(package)), jit_(std::move(jit)) {}
+
+  // Runs the batch without touching any Python objects; called with the GIL
+  // released. Each call uses its own buffers so that batches may run
+  // concurrently on the same FunctionJit.
+  absl::Status RunBatchInternal(absl::Span<uint8_t*> arg_data,
+                                absl::Span<const int64_t> arg_sizes,
+                                uint8_t* result_data, int64_t result_size,
+                                int64_t batch_size) const {
+    std::unique_ptr<FunctionJitBuffers> buffers = jit_->CreateBuffers();
+    for (int64_t i = 0; i < batch_size; ++i) {
+      // Fresh events per element so that traces and assertion failures of one
+      // element are not attributed to the following ones.
+      InterpreterEvents events;
+      XLS_RETURN_IF_ERROR(jit_->RunWithViews(
+          arg_data, absl::MakeSpan(result_data, result_size), &events,
+          buffers.get()));
+      XLS_RETURN_IF_ERROR(InterpreterEventsToStatus(events))
+          << absl::StreamFormat("(batch element %d)", i);
+      for (int64_t j = 0; j < arg_data.size(); ++j) {
+        arg_data[j] += arg_sizes[j];
+      }
+      result_data += result_size;
+    }
+    return absl::OkStatus();
+  }
+
+  std::shared_ptr<Package> package_;
+  std::unique_ptr<FunctionJit> jit_;
+};
+
+// Wrapper owning a JIT-compiled proc network which keeps its package alive.
+// Ticking the network and accessing its channel queues may be done from any
+// thread; the accesses are serialized by a mutex which is only acquired with
+// the GIL released.
+class ProcRuntimeHolder {
+ public:
+  static absl::StatusOr<std::unique_ptr<ProcRuntimeHolder>> Create(
+      PackageHolder package) {
+    std::unique_ptr<SerialProcRuntime> runtime;
+    {
+      py::gil_scoped_release release;
+      XLS_ASSIGN_OR_RETURN(runtime,
+                           CreateJitSerialProcRuntime(&package.deref()));
+    }
+    XLS_ASSIGN_OR_RETURN(JitChannelQueueManager * queue_manager,
+                         runtime->GetJitChannelQueueManager());
+    return absl::WrapUnique(new ProcRuntimeHolder(
+        package.package(), std::move(runtime), queue_manager));
+  }
+
+  // Enqueues every element of the buffer on the given channel.
+  absl::Status Send(std::string_view channel_name, const py::buffer& data) {
+    py::buffer_info info = data.request();
+    py::gil_scoped_release release;
+    absl::MutexLock lock(&mu_);
+    XLS_ASSIGN_OR_RETURN(JitChannelQueue * queue, GetQueue(channel_name));
+    int64_t element_size = GetElementSize(queue);
+    XLS_ASSIGN_OR_RETURN(int64_t count,
+                         GetElementCount(info, element_size, channel_name));
+    const uint8_t* bytes = static_cast<const uint8_t*>(info.ptr);
+    for (int64_t i = 0; i < count; ++i) {
+      queue->WriteRaw(bytes + i * element_size);
+    }
+    return absl::OkStatus();
+  }
+
+  // Dequeues all elements of the given channel. The elements are staged in a
+  // native buffer as the result array can only be created with the GIL held.
+  absl::StatusOr<py::array> Receive(std::string_view channel_name) {
+    Type* type;
+    int64_t element_size;
+    int64_t count;
+    std::vector<uint8_t> bytes;
+    {
+      py::gil_scoped_release release;
+      absl::MutexLock lock(&mu_);
+      XLS_ASSIGN_OR_RETURN(JitChannelQueue * queue, GetQueue(channel_name));
+      type = queue->channel()->type();
+      element_size = GetElementSize(queue);
+      count = queue->GetSize();
+      bytes.resize(count * element_size);
+      for (int64_t i = 0; i < count; ++i) {
+        if (!queue->ReadRaw(bytes.data() + i * element_size)) {
+          return absl::InternalError(absl::StrFormat(
+              "Channel %s has fewer than %d elements", channel_name, count));
+        }
+      }
+    }
+    py::array result = MakeNativeArray(type, element_size, count);
+    if (!bytes.empty()) {
+      std::memcpy(result.mutable_data(), bytes.data(), bytes.size());
+    }
+    return result;
+  }
+
+  absl::Status Tick() {
+    py::gil_scoped_release release;
+    absl::MutexLock lock(&mu_);
+    return runtime_->Tick();
+  }
+
+  absl::StatusOr<int64_t> TickUntilBlocked(std::optional<int64_t> max_ticks) {
+    py::gil_scoped_release release;
+    absl::MutexLock lock(&mu_);
+    return runtime_->TickUntilBlocked(max_ticks);
+  }
+
+  absl::StatusOr<int64_t> TickUntilOutput(std::string_view channel_name,
+                                          int64_t count,
+                                          std::optional<int64_t> max_ticks) {
+    XLS_ASSIGN_OR_RETURN(Channel * channel, package_->GetChannel(channel_name));
+    py::gil_scoped_release release;
+    absl::MutexLock lock(&mu_);
+    return runtime_->TickUntilOutput({{channel, count}}, max_ticks);
+  }
+
+ private:
+  ProcRuntimeHolder(std::shared_ptr<Package> package,
+                    std::unique_ptr<SerialProcRuntime> runtime,
+                    JitChannelQueueManager* queue_manager)
+      : package_(std::move(package)),
+        runtime_(std::move(runtime)),
+        queue_manager_(queue_manager) {}
+
+  absl::StatusOr<JitChannelQueue*> GetQueue(std::string_view channel_name)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    XLS_ASSIGN_OR_RETURN(Channel * channel, package_->GetChannel(channel_name));
+    return &queue_manager_->GetJitQueue(channel);
+  }
+
+  int64_t GetElementSize(JitChannelQueue* queue)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    return queue_manager_->runtime().GetTypeByteSize(queue->channel()->type());
+  }
+
+  std::shared_ptr<Package> package_;
+  absl::Mutex mu_;
+  std::unique_ptr<SerialProcRuntime> runtime_ ABSL_GUARDED_BY(mu_);
+  JitChannelQueueManager* queue_manager_ ABSL_PT_GUARDED_BY(mu_);
+};
+
+}  // namespace
+
+PYBIND11_MODULE(jit, m) {
+  ImportStatusModule();
+  py::module::import("xls.ir.python.function");
+  py::module::import("xls.ir.python.package");
+
+  py::class_<FunctionJitHolder>(m, "FunctionJit")
+      .def_static("create", &FunctionJitHolder::Create, py::arg("function"),
+                  py::arg("opt_level") = 3)
+      .def("run_batch", &FunctionJitHolder::RunBatch, py::arg("args"))
+      .def_property_readonly("arg_sizes", &FunctionJitHolder::GetArgSizes)
+      .def_property_readonly("result_size", &FunctionJitHolder::GetResultSize);
+
+  py::class_<ProcRuntimeHolder>(m, "ProcRuntime")
+      .def_static("create", &ProcRuntimeHolder::Create, py::arg("package"))
+      .def("send", &ProcRuntimeHolder::Send, py::arg("channel"),
+           py::arg("data"))
+      .def("receive", &ProcRuntimeHolder::Receive, py::arg("channel"))
+      .def("tick", &ProcRuntimeHolder::Tick)
+      .def("tick_until_blocked", &ProcRuntimeHolder::TickUntilBlocked,
+           py::arg("max_ticks") = absl::nullopt)
+      .def("tick_until_output", &ProcRuntimeHolder::TickUntilOutput,
+           py::arg("channel"), py::arg("count"),
+           py::arg("max_ticks") = absl::nullopt);
+}
+
+}  // namespace xls
@@ -0,0 +1,134 @@
+#
+# Copyright 2023 The XLS Authors
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+
+"""Tests for xls.jit.python.jit."""
+
+import threading
+
+import numpy as np
+
+from xls.ir.python import ir_parser
+from xls.jit.python import jit
+from absl.testing import absltest
+
+ADD_IR = """package test
+
+top fn add(x: bits[32], y: bits[32]) -> bits[32] {
+  ret add.3: bits[32] = add(x, y, id=3)
+}
+"""
+
+TUPLE_IR = """package test
+
+top fn swap(x: (bits[8], bits[8])) -> (bits[8], bits[8]) {
+  tuple_index.2: bits[8] = tuple_index(x, index=0, id=2)
+  tuple_index.3: bits[8] = tuple_index(x, index=1, id=3)
+  ret tuple.4: (bits[8], bits[8]) = tuple(tuple_index.3, tuple_index.2, id=4)
+}
+"""
+
+ASSERT_IR = """package test
+
+top fn check(tkn: token, x: bits[8]) -> token {
+  literal.3: bits[8] = literal(value=7, id=3)
+  ult.4: bits[1] = ult(x, literal.3, id=4)
+  ret assert.5: token = assert(tkn, ult.4, message="x is too big", id=5)
+}
+"""
+
+PROC_IR = """package test
+
+chan input(bits[32], id=0, kind=streaming, ops=receive_only, flow_control=ready_valid, metadata=\"\"\"\"\"\")
+chan output(bits[32], id=1, kind=streaming, ops=send_only, flow_control=ready_valid, metadata=\"\"\"\"\"\")
+
+proc double(tkn: token, init={}) {
+  receive.2: (token, bits[32]) = receive(tkn, channel_id=0, id=2)
+  tuple_index.3: token = tuple_index(receive.2, index=0, id=3)
+  tuple_index.4: bits[32] = tuple_index(receive.2, index=1, id=4)
+  add.5: bits[32] = add(tuple_index.4, tuple_index.4, id=5)
+  send.6: token = send(tuple_index.3, add.5, channel_id=1, id=6)
+  next (send.6)
+}
+"""
+
+
+class JitTest(absltest.TestCase):
+
+  def test_run_batch(self):
+    pkg = ir_parser.Parser.parse_package(ADD_IR)
+    f = jit.FunctionJit.create(pkg.get_function('add'))
+    self.assertEqual(f.arg_sizes, [4, 4])
+    self.assertEqual(f.result_size, 4)
+    x = np.arange(1000, dtype=np.uint32)
+    y = np.full(1000, 0xffffffff, dtype=np.uint32)
+    result = f.run_batch([x, y])
+    self.assertEqual(result.dtype, np.uint32)
+    np.testing.assert_array_equal(result, x + y)
+
+  def test_run_batch_aggregate_type(self):
+    pkg = ir_parser.Parser.parse_package(TUPLE_IR)
+    f = jit.FunctionJit.create(pkg.get_function('swap'))
+    x = np.array([[1, 2], [3, 4], [5, 6]], dtype=np.uint8)
+    result = f.run_batch([x])
+    self.assertEqual(result.shape, (3, 2))
+    np.testing.assert_array_equal(result, x[:, ::-1])
+
+  def test_run_batch_mismatched_sizes(self):
+    pkg = ir_parser.Parser.parse_package(ADD_IR)
+    f = jit.FunctionJit.create(pkg.get_function('add'))
+    with self.assertRaisesRegex(Exception, 'has 3 elements, expected 4'):
+      f.run_batch([
+          np.zeros(4, dtype=np.uint32),
+          np.zeros(3, dtype=np.uint32)
+      ])
+
+  def test_run_batch_assertion(self):
+    pkg = ir_parser.Parser.parse_package(ASSERT_IR)
+    f = jit.FunctionJit.create(pkg.get_function('check'))
+    tokens = np.zeros(3 * f.arg_sizes[0], dtype=np.uint8)
+    with self.assertRaisesRegex(Exception, 'x is too big'):
+      f.run_batch([tokens, np.array([1, 2, 9], dtype=np.uint8)])
+
+  def test_run_batch_from_threads(self):
+    pkg = ir_parser.Parser.parse_package(ADD_IR)
+    f = jit.FunctionJit.create(pkg.get_function('add'))
+    results = [None] * 4
+
+    def run(i):
+      x = np.arange(10000, dtype=np.uint32)
+      results[i] = f.run_batch([x, np.full(10000, i, dtype=np.uint32)])
+
+    threads = [threading.Thread(target=run, args=(i,)) for i in range(4)]
+    for t in threads:
+      t.start()
+    for t in threads:
+      t.join()
+    for i, result in enumerate(results):
+      np.testing.assert_array_equal(result, np.arange(10000) + i)
+
+  def test_proc_runtime(self):
+    pkg = ir_parser.Parser.parse_package(PROC_IR)
+    runtime = jit.ProcRuntime.create(pkg)
+    runtime.send('input', np.array([1, 2, 3, 100], dtype=np.uint32))
+    runtime.tick_until_output('output', 4)
+    result = runtime.receive('output')
+    self.assertEqual(result.dtype, np.uint32)
+    np.testing.assert_array_equal(result, [2, 4, 6, 200])
+    self.assertEmpty(runtime.receive('output'))
+
+
+if __name__ == '__main__':
+  absltest.main()
@@ -0,0 +1,166 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/jit/tiered_function_jit.h"
+
+#include <memory>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_format.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/interpreter/function_interpreter.h"
+#include "xls/ir/ir_parser.h"
+
+namespace xls {
+
+std::string JitBaselineTierToString(JitBaselineTier tier) {
+  switch (tier) {
+    case JitBaselineTier::kInterpreter:
+      return "interpreter";
+    case JitBaselineTier::kUnoptimizedJit:
+      return "unoptimized_jit";
+  }
+  XLS_LOG(FATAL) << "Invalid baseline tier: " << static_cast<int>(tier);
+}
+
+std::string TieredJitStats::ToString() const {
+  return absl::StrFormat(
+      "baseline: compile %s, %d runs in %s; optimized: compile %s, %d runs in "
+      "%s",
+      absl::FormatDuration(baseline_compile_time), baseline_runs,
+      absl::FormatDuration(baseline_run_time),
+      optimized_compile_time.has_value()
+          ? absl::FormatDuration(*optimized_compile_time)
+          : std::string("pending"),
+      optimized_runs, absl::FormatDuration(optimized_run_time));
+}
+
+absl::StatusOr<std::unique_ptr<TieredFunctionJit>> TieredFunctionJit::Create(
+    Function* xls_function, const TieredJitOptions& options) {
+  // The optimized code is compiled from a copy of the package so that the
+  // compilation can outlive the TieredFunctionJit and the original function.
+  auto compile = std::make_shared<CompileState>();
+  compile->options = options;
+  compile->baseline_name = JitBaselineTierToString(options.baseline);
+  XLS_ASSIGN_OR_RETURN(compile->package,
+                       Parser::ParsePackage(xls_function->package()->DumpIr()));
+  XLS_ASSIGN_OR_RETURN(compile->function,
+                       compile->package->GetFunction(xls_function->name()));
+
+  auto jit =
+      absl::WrapUnique(new TieredFunctionJit(xls_function, compile));
+  if (options.baseline == JitBaselineTier::kUnoptimizedJit) {
+    absl::Time start = absl::Now();
+    XLS_ASSIGN_OR_RETURN(jit->baseline_jit_,
+                         FunctionJit::Create(xls_function, /*opt_level=*/0));
+    jit->baseline_compile_time_ = absl::Now() - start;
+  }
+  jit->compile_thread_ = std::make_unique<Thread>(
+      [compile = std::move(compile)]() { CompileOptimized(compile.get()); });
+  return jit;
+}
+
+TieredFunctionJit::~TieredFunctionJit() {
+  compile_->cancelled.store(true, std::memory_order_relaxed);
+  if (compile_thread_ != nullptr) {
+    // The thread holds its own reference to the compile state.
+    compile_thread_->Detach();
+  }
+}
+
+void TieredFunctionJit::CompileOptimized(CompileState* compile) {
+  if (compile->options.before_optimized_compile) {
+    compile->options.before_optimized_compile();
+  }
+  if (compile->cancelled.load(std::memory_order_relaxed)) {
+    return;
+  }
+  absl::Time start = absl::Now();
+  absl::StatusOr<std::unique_ptr<FunctionJit>> optimized =
+      FunctionJit::Create(compile->function, compile->options.opt_level);
+  absl::Duration elapsed = absl::Now() - start;
+  if (compile->cancelled.load(std::memory_order_relaxed)) {
+    return;
+  }
+
+  absl::MutexLock lock(&compile->mutex);
+  compile->done = true;
+  if (!optimized.ok()) {
+    XLS_LOG(WARNING) << absl::StreamFormat(
+        "Optimized JIT compilation of `%s` failed, continuing in the %s tier: "
+        "%s",
+        compile->function->name(), compile->baseline_name,
+        optimized.status().message());
+    compile->status = optimized.status();
+    return;
+  }
+  XLS_VLOG(1) << absl::StreamFormat("Optimized JIT of `%s` ready after %s",
+                                    compile->function->name(),
+                                    absl::FormatDuration(elapsed));
+  compile->compile_time = elapsed;
+  compile->optimized_jit_owner = std::move(optimized).value();
+  compile->optimized_jit.store(compile->optimized_jit_owner.get(),
+                               std::memory_order_release);
+}
+
+absl::StatusOr<InterpreterResult<Value>> TieredFunctionJit::Run(
+    absl::Span<const Value> args) {
+  absl::Time start = absl::Now();
+  FunctionJit* optimized =
+      compile_->optimized_jit.load(std::memory_order_acquire);
+  absl::StatusOr<InterpreterResult<Value>> result;
+  if (optimized != nullptr) {
+    result = optimized->Run(args);
+    optimized_runs_.fetch_add(1, std::memory_order_relaxed);
+    optimized_run_nanos_.fetch_add(
+        absl::ToInt64Nanoseconds(absl::Now() - start),
+        std::memory_order_relaxed);
+    return result;
+  }
+  if (baseline_jit_ != nullptr) {
+    result = baseline_jit_->Run(args);
+  } else {
+    result = InterpretFunction(xls_function_, args);
+  }
+  baseline_runs_.fetch_add(1, std::memory_order_relaxed);
+  baseline_run_nanos_.fetch_add(absl::ToInt64Nanoseconds(absl::Now() - start),
+                                std::memory_order_relaxed);
+  return result;
+}
+
+absl::Status TieredFunctionJit::WaitForOptimizedCode() {
+  absl::MutexLock lock(&compile_->mutex);
+  compile_->mutex.Await(absl::Condition(&compile_->done));
+  return compile_->status;
+}
+
+TieredJitStats TieredFunctionJit::GetStats() const {
+  TieredJitStats stats;
+  stats.baseline_compile_time = baseline_compile_time_;
+  {
+    absl::MutexLock lock(&compile_->mutex);
+    stats.optimized_compile_time = compile_->compile_time;
+  }
+  stats.baseline_runs = baseline_runs_.load(std::memory_order_relaxed);
+  stats.optimized_runs = optimized_runs_.load(std::memory_order_relaxed);
+  stats.baseline_run_time = absl::Nanoseconds(
+      baseline_run_nanos_.load(std::memory_order_relaxed));
+  stats.optimized_run_time = absl::Nanoseconds(
+      optimized_run_nanos_.load(std::memory_order_relaxed));
+  return stats;
+}
+
+}  // namespace xls
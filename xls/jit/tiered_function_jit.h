@@ -0,0 +1,170 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_JIT_TIERED_FUNCTION_JIT_H_
+#define XLS_JIT_TIERED_FUNCTION_JIT_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "xls/common/thread.h"
+#include "xls/ir/events.h"
+#include "xls/ir/function.h"
+#include "xls/ir/package.h"
+#include "xls/ir/value.h"
+#include "xls/jit/function_jit.h"
+
+namespace xls {
+
+// The tier used to execute a function until the optimized code is ready.
+enum class JitBaselineTier {
+  // The IR interpreter. No compilation is required at all.
+  kInterpreter,
+  // The JIT with LLVM optimizations disabled which compiles much faster than
+  // an optimized build.
+  kUnoptimizedJit,
+};
+
+std::string JitBaselineTierToString(JitBaselineTier tier);
+
+struct TieredJitOptions {
+  JitBaselineTier baseline = JitBaselineTier::kUnoptimizedJit;
+
+  // The LLVM optimization level of the code compiled in the background.
+  int64_t opt_level = 3;
+
+  // If set, called on the background thread before the optimized code is
+  // compiled. Used in tests to control when the compilation happens.
+  std::function<void()> before_optimized_compile;
+};
+
+// Counters describing where a TieredFunctionJit spent its time.
+struct TieredJitStats {
+  // Time to compile the baseline tier (zero for the interpreter) and the
+  // optimized tier. The optimized compile time is only set once the optimized
+  // code is ready.
+  absl::Duration baseline_compile_time;
+  std::optional<absl::Duration> optimized_compile_time;
+
+  // Number of calls to Run executed in each tier and the total time spent in
+  // those calls.
+  int64_t baseline_runs = 0;
+  int64_t optimized_runs = 0;
+  absl::Duration baseline_run_time;
+  absl::Duration optimized_run_time;
+
+  std::string ToString() const;
+};
+
+// Executes an XLS function with tiered compilation. Creation returns as soon
+// as the baseline tier is available (immediately for the interpreter, after a
+// fast unoptimized compile for the JIT) while the optimized JIT is compiled on
+// a background thread. Once the optimized code is ready subsequent calls to
+// Run switch to it. This favors short runs such as DSLX tests and fuzz
+// samples where the time to compile optimized code can exceed the execution
+// time by orders of magnitude.
+//
+// Like FunctionJit, Run is not thread-safe. The optimized code is compiled
+// from a copy of the function's package taken by Create, so the function may
+// be modified or destroyed afterwards (the optimized tier then executes the
+// function as it was at creation). Destruction does not wait for the
+// background compilation; its result is discarded.
+class TieredFunctionJit {
+ public:
+  static absl::StatusOr<std::unique_ptr<TieredFunctionJit>> Create(
+      Function* xls_function,
+      const TieredJitOptions& options = TieredJitOptions());
+
+  ~TieredFunctionJit();
+
+  // Executes the function with the specified arguments in the highest tier
+  // which is currently available.
+  absl::StatusOr<InterpreterResult<Value>> Run(absl::Span<const Value> args);
+
+  // Blocks until the background compilation has finished. Returns the status
+  // of the compilation. If the compilation failed, execution continues in the
+  // baseline tier.
+  absl::Status WaitForOptimizedCode();
+
+  // Returns whether calls to Run currently execute optimized code.
+  bool IsOptimized() const {
+    return compile_->optimized_jit.load(std::memory_order_acquire) != nullptr;
+  }
+
+  TieredJitStats GetStats() const;
+
+  Function* function() const { return xls_function_; }
+
+ private:
+  // State of the background compilation. It is shared with the compile thread
+  // so that the TieredFunctionJit can be destroyed while the thread runs.
+  struct CompileState {
+    TieredJitOptions options;
+    std::string baseline_name;
+
+    // Private copy of the package of the function being compiled.
+    std::unique_ptr<Package> package;
+    Function* function = nullptr;
+
+    // Set when the TieredFunctionJit is destroyed. The compilation is skipped
+    // if it has not started yet and its result is discarded otherwise.
+    std::atomic<bool> cancelled = false;
+
+    // The optimized JIT is owned by `optimized_jit_owner` and published to Run
+    // through `optimized_jit` once compilation completes.
+    std::unique_ptr<FunctionJit> optimized_jit_owner;
+    std::atomic<FunctionJit*> optimized_jit = nullptr;
+
+    absl::Mutex mutex;
+    bool done ABSL_GUARDED_BY(mutex) = false;
+    absl::Status status ABSL_GUARDED_BY(mutex);
+    std::optional<absl::Duration> compile_time ABSL_GUARDED_BY(mutex);
+  };
+
+  TieredFunctionJit(Function* xls_function,
+                    std::shared_ptr<CompileState> compile)
+      : xls_function_(xls_function), compile_(std::move(compile)) {}
+
+  // Compiles the optimized tier. Run on the background thread.
+  static void CompileOptimized(CompileState* compile);
+
+  Function* xls_function_;
+  std::shared_ptr<CompileState> compile_;
+
+  // The baseline JIT. Null if the baseline tier is the interpreter.
+  std::unique_ptr<FunctionJit> baseline_jit_;
+  absl::Duration baseline_compile_time_;
+
+  std::atomic<int64_t> baseline_runs_ = 0;
+  std::atomic<int64_t> optimized_runs_ = 0;
+  std::atomic<int64_t> baseline_run_nanos_ = 0;
+  std::atomic<int64_t> optimized_run_nanos_ = 0;
+
+  std::unique_ptr<Thread> compile_thread_;
+};
+
+}  // namespace xls
+
+#endif  // XLS_JIT_TIERED_FUNCTION_JIT_H_
@@ -0,0 +1,117 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/jit/tiered_function_jit.h"
+
+#include <memory>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/value.h"
+
+namespace xls {
+namespace {
+
+class TieredFunctionJitTest
+    : public IrTestBase,
+      public testing::WithParamInterface<JitBaselineTier> {
+ protected:
+  // Builds a function computing (x + y) * x.
+  absl::StatusOr<Function*> BuildFunction(Package* p) {
+    FunctionBuilder fb("f", p);
+    BValue x = fb.Param("x", p->GetBitsType(32));
+    BValue y = fb.Param("y", p->GetBitsType(32));
+    fb.UMul(fb.Add(x, y), x);
+    return fb.Build();
+  }
+
+  Value Run(TieredFunctionJit* jit, int64_t x, int64_t y) {
+    absl::StatusOr<InterpreterResult<Value>> result =
+        jit->Run({Value(UBits(x, 32)), Value(UBits(y, 32))});
+    XLS_CHECK_OK(result.status());
+    return result->value;
+  }
+};
+
+TEST_P(TieredFunctionJitTest, SwitchesToOptimizedCode) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, BuildFunction(p.get()));
+  TieredJitOptions options;
+  options.baseline = GetParam();
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<TieredFunctionJit> jit,
+                           TieredFunctionJit::Create(f, options));
+
+  // The result is the same regardless of which tier executes the call.
+  EXPECT_EQ(Run(jit.get(), 3, 4), Value(UBits(21, 32)));
+
+  XLS_ASSERT_OK(jit->WaitForOptimizedCode());
+  EXPECT_TRUE(jit->IsOptimized());
+  TieredJitStats before = jit->GetStats();
+  EXPECT_EQ(before.baseline_runs + before.optimized_runs, 1);
+  EXPECT_TRUE(before.optimized_compile_time.has_value());
+
+  EXPECT_EQ(Run(jit.get(), 5, 6), Value(UBits(55, 32)));
+  EXPECT_EQ(Run(jit.get(), 0, 7), Value(UBits(0, 32)));
+  TieredJitStats after = jit->GetStats();
+  EXPECT_EQ(after.baseline_runs, before.baseline_runs);
+  EXPECT_EQ(after.optimized_runs, before.optimized_runs + 2);
+  if (GetParam() == JitBaselineTier::kInterpreter) {
+    EXPECT_EQ(after.baseline_compile_time, absl::ZeroDuration());
+  }
+}
+
+TEST_P(TieredFunctionJitTest, DestroyBeforeOptimizedCodeIsReady) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, BuildFunction(p.get()));
+  // The optimized compilation is held back until the JIT and the package have
+  // been destroyed. If destruction waited for it, this test would deadlock.
+  auto release = std::make_shared<absl::Notification>();
+  TieredJitOptions options;
+  options.baseline = GetParam();
+  options.before_optimized_compile = [release]() {
+    release->WaitForNotification();
+  };
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<TieredFunctionJit> jit,
+                           TieredFunctionJit::Create(f, options));
+  options.before_optimized_compile = nullptr;
+  EXPECT_EQ(Run(jit.get(), 1, 1), Value(UBits(2, 32)));
+  jit.reset();
+  p.reset();
+  release->Notify();
+
+  // Wait for the background thread to drop its reference to the notification
+  // so that it does not outlive the test.
+  while (release.use_count() > 1) {
+    absl::SleepFor(absl::Milliseconds(1));
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    TieredFunctionJitTestInstantiation, TieredFunctionJitTest,
+    testing::Values(JitBaselineTier::kInterpreter,
+                    JitBaselineTier::kUnoptimizedJit),
+    [](const testing::TestParamInfo<JitBaselineTier>& info) {
+      return JitBaselineTierToString(info.param);
+    });
+
+}  // namespace
+}  // namespace xls
@@ -36,12 +36,17 @@
 #include "xls/common/status/status_macros.h"
 #include "xls/ir/ir_parser.h"
 #include "xls/solvers/z3_ir_translator.h"
+#include "xls/solvers/z3_portfolio.h"
 #include "xls/solvers/z3_utils.h"
 #include "../z3/src/api/z3_api.h"
 #include "../z3/src/api/z3_fpa.h"
 
 ABSL_FLAG(absl::Duration, timeout, absl::InfiniteDuration(),
           "How long to wait for the proof to complete.");
+ABSL_FLAG(bool, solver_portfolio, false,
+          "Race several Z3 configurations (tactics and random seeds) in "
+          "parallel and report the first definitive answer. The timeout "
+          "applies to each configuration.");
 ABSL_FLAG(bool, flush_subnormals, true,
           "Flush input and output subnormals to 0. If this flag is false, "
           "the proof (and this test) will fail, as it expects ZERO (0.0f) "
@@ -138,7 +143,8 @@ absl::StatusOr<std::unique_ptr<Package>> GetIr(bool opt_ir) {
 }
 
 absl::Status CompareToReference(bool use_opt_ir, uint32_t error_bound,
-                                bool flush_subnormals, absl::Duration timeout) {
+                                bool flush_subnormals, absl::Duration timeout,
+                                bool solver_portfolio) {
   XLS_ASSIGN_OR_RETURN(auto package, GetIr(use_opt_ir));
   XLS_ASSIGN_OR_RETURN(auto function, package->GetFunction(kFunctionName));
 
@@ -158,12 +164,27 @@ absl::Status CompareToReference(bool use_opt_ir, uint32_t error_bound,
   Z3_ast bounds = Z3_mk_fpa_numeral_float(
       ctx, absl::bit_cast<float>(error_bound), Z3_mk_fpa_sort_32(ctx));
 
+  Z3_ast objective = Z3_mk_fpa_gt(ctx, error, bounds);
+  if (solver_portfolio) {
+    solvers::z3::PortfolioOptions options;
+    options.timeout = timeout;
+    XLS_ASSIGN_OR_RETURN(
+        solvers::z3::PortfolioResult result,
+        solvers::z3::SolvePortfolio(ctx, {objective}, options));
+    std::cout << solvers::z3::SolverResultToString(ctx, result.model,
+                                                   result.satisfiable)
+              << std::endl;
+    if (result.model.has_value()) {
+      Z3_model_dec_ref(ctx, result.model.value());
+    }
+    return absl::OkStatus();
+  }
+
   // Push all that work into z3, and have the solver do its work.
   translator->SetTimeout(timeout);
 
   Z3_solver solver =
       solvers::z3::CreateSolver(ctx, std::thread::hardware_concurrency());
-  Z3_ast objective = Z3_mk_fpa_gt(ctx, error, bounds);
   Z3_solver_assert(ctx, solver, objective);
 
   // Finally, print the output to the terminal in gorgeous two-color ASCII.
@@ -183,6 +204,6 @@ int main(int argc, char** argv) {
   XLS_QCHECK_OK(xls::CompareToReference(
       absl::GetFlag(FLAGS_reference_use_opt_ir),
       absl::GetFlag(FLAGS_error_bound), absl::GetFlag(FLAGS_flush_subnormals),
-      absl::GetFlag(FLAGS_timeout)));
+      absl::GetFlag(FLAGS_timeout), absl::GetFlag(FLAGS_solver_portfolio)));
   return 0;
 }
@@ -72,9 +72,11 @@ bool CompareResults(float a, float b) {
 }
 
 absl::Status RealMain(uint64_t num_samples, int num_threads) {
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<fp::Fp32FastRsqrt> jit,
+                       fp::Fp32FastRsqrt::Create());
   TestbenchBuilder<float, float, fp::Fp32FastRsqrt> builder(
-      ComputeExpected, ComputeActual,
-      []() { return fp::Fp32FastRsqrt::Create().value(); });
+      ComputeExpected, ComputeActual);
+  builder.SetSharedJit(std::move(jit));
   builder.SetCompareResultsFn(CompareResults).SetNumSamples(num_samples);
   if (num_threads != 0) {
     builder.SetNumThreads(num_threads);
@@ -21,6 +21,7 @@
 #include "xls/common/init_xls.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/math_util.h"
+#include "xls/common/status/status_macros.h"
 #include "xls/modules/fp/fp32_fma_jit_wrapper.h"
 #include "xls/tools/testbench.h"
 #include "xls/tools/testbench_builder.h"
@@ -91,9 +92,11 @@ std::string PrintInput(const Float3x32& input) {
 }
 
 absl::Status RealMain(int64_t num_samples, int num_threads) {
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<fp::Fp32Fma> jit,
+                       fp::Fp32Fma::Create());
   TestbenchBuilder<Float3x32, float, fp::Fp32Fma> builder(
-      ComputeExpected, ComputeActual,
-      []() { return fp::Fp32Fma::Create().value(); });
+      ComputeExpected, ComputeActual);
+  builder.SetSharedJit(std::move(jit));
   builder.SetCompareResultsFn(CompareResults)
       .SetIndexToInputFn(IndexToInput)
       .SetPrintInputFn(PrintInput)
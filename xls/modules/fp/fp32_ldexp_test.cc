@@ -82,9 +82,11 @@ void LogMismatch(uint64_t index, Float32xint input, float expected,
 }
 
 absl::Status RealMain(uint64_t num_samples, int num_threads) {
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<fp::Fp32Ldexp> jit,
+                       fp::Fp32Ldexp::Create());
   TestbenchBuilder<Float32xint, float, fp::Fp32Ldexp> builder(
-      ComputeExpected, ComputeActual,
-      []() { return fp::Fp32Ldexp::Create().value(); });
+      ComputeExpected, ComputeActual);
+  builder.SetSharedJit(std::move(jit));
   builder.SetIndexToInputFn(IndexToInput)
       .SetCompareResultsFn(CompareResults)
       .SetLogErrorsFn(LogMismatch)
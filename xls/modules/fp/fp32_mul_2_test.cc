@@ -74,9 +74,11 @@ bool CompareResults(float a, float b) {
 }
 
 absl::Status RealMain(uint64_t num_samples, int num_threads) {
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<fp::Fp32Mul2> jit,
+                       fp::Fp32Mul2::Create());
   TestbenchBuilder<Float2x32, float, fp::Fp32Mul2> builder(
-      ComputeActual, ComputeExpected,
-      []() { return fp::Fp32Mul2::Create().value(); });
+      ComputeActual, ComputeExpected);
+  builder.SetSharedJit(std::move(jit));
   builder.SetCompareResultsFn(CompareResults).SetNumSamples(num_samples);
   if (num_threads != 0) {
     builder.SetNumThreads(num_threads);
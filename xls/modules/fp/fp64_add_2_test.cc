@@ -62,13 +62,12 @@ bool CompareResults(double a, double b) {
          (ZeroOrSubnormal(a) && ZeroOrSubnormal(b));
 }
 
-std::unique_ptr<fp::Fp64Add2> CreateJit() {
-  return fp::Fp64Add2::Create().value();
-}
-
 absl::Status RealMain(uint64_t num_samples, int num_threads) {
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<fp::Fp64Add2> jit,
+                       fp::Fp64Add2::Create());
   TestbenchBuilder<Float2x64, double, fp::Fp64Add2> builder(
-      ComputeExpected, ComputeActual, CreateJit);
+      ComputeExpected, ComputeActual);
+  builder.SetSharedJit(std::move(jit));
   builder.SetCompareResultsFn(CompareResults).SetNumSamples(num_samples);
   if (num_threads != 0) {
     builder.SetNumThreads(num_threads);
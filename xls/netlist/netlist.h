@@ -131,6 +131,33 @@ class AbstractCell {
     return absl::OkStatus();
   }
 
+  // Replaces the library entry of this cell, e.g. to resize the cell to a
+  // variant of a different drive strength. The new entry must be of the same
+  // kind and have the same pinout as the current one.
+  absl::Status SetCellLibraryEntry(
+      const AbstractCellLibraryEntry<EvalT>* cell_library_entry) {
+    if (cell_library_entry->kind() != kind() ||
+        cell_library_entry->clock_name() != cell_library_entry_->clock_name() ||
+        cell_library_entry->input_names() !=
+            cell_library_entry_->input_names() ||
+        cell_library_entry->output_pin_to_function().size() !=
+            outputs_.size()) {
+      return absl::InvalidArgumentError(absl::Substitute(
+          "Cell library entry $0 does not match the pinout of cell $1 ($2)",
+          cell_library_entry->name(), name(), cell_library_entry_->name()));
+    }
+    for (const OutputPin& output : outputs_) {
+      if (!cell_library_entry->output_pin_to_function().contains(
+              output.name)) {
+        return absl::InvalidArgumentError(absl::Substitute(
+            "Cell library entry $0 has no output pin $1",
+            cell_library_entry->name(), output.name));
+      }
+    }
+    cell_library_entry_ = cell_library_entry;
+    return absl::OkStatus();
+  }
+
  private:
   AbstractCell(const AbstractCellLibraryEntry<EvalT>* cell_library_entry,
                std::string_view name, const std::vector<Pin>& inputs,
@@ -0,0 +1,1181 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/netlist/static_timing.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/strip.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/netlist/logical_effort.h"
+
+namespace xls {
+namespace netlist {
+namespace {
+
+constexpr double kInfinity = std::numeric_limits<double>::infinity();
+
+// Table index variables which are normalized to index_2 of a TimingTable.
+constexpr std::string_view kLoadVariable = "total_output_net_capacitance";
+constexpr std::string_view kRelatedTransitionVariable =
+    "related_pin_transition";
+
+using TemplateMap = absl::flat_hash_map<std::string, const cell_lib::Block*>;
+
+// Returns the value of the first key/value entry of `block` with the given
+// key, if any.
+std::optional<std::string_view> FindValue(const cell_lib::Block& block,
+                                          std::string_view key) {
+  for (const cell_lib::BlockEntry& entry : block.entries) {
+    if (const auto* kv = std::get_if<cell_lib::KVEntry>(&entry);
+        kv != nullptr && kv->key == key) {
+      return kv->value;
+    }
+  }
+  return std::nullopt;
+}
+
+// Returns the first sub-block of `block` of the given kind, if any.
+const cell_lib::Block* FindSubBlock(const cell_lib::Block& block,
+                                    std::string_view kind) {
+  std::vector<const cell_lib::Block*> blocks = block.GetSubBlocks(kind);
+  return blocks.empty() ? nullptr : blocks.front();
+}
+
+// Parses the numbers of a table attribute such as `index_1 ("0.1, 0.2")` or
+// `values ("1, 2", "3, 4")`.
+absl::StatusOr<std::vector<double>> ParseNumbers(
+    const cell_lib::Block& block) {
+  std::vector<double> numbers;
+  for (const std::string& arg : block.args) {
+    for (std::string_view piece : absl::StrSplit(arg, ',')) {
+      piece = absl::StripAsciiWhitespace(absl::StripPrefix(
+          absl::StripAsciiWhitespace(piece), "\\"));
+      if (piece.empty()) {
+        continue;
+      }
+      double number;
+      if (!absl::SimpleAtod(piece, &number)) {
+        return absl::InvalidArgumentError(absl::StrFormat(
+            "Invalid number in Liberty %s: \"%s\"", block.kind, piece));
+      }
+      numbers.push_back(number);
+    }
+  }
+  return numbers;
+}
+
+absl::StatusOr<std::vector<double>> ParseIndex(
+    const cell_lib::Block& table, const cell_lib::Block* lut_template,
+    std::string_view kind) {
+  const cell_lib::Block* index = FindSubBlock(table, kind);
+  if (index == nullptr && lut_template != nullptr) {
+    index = FindSubBlock(*lut_template, kind);
+  }
+  if (index == nullptr) {
+    return std::vector<double>{0.0};
+  }
+  return ParseNumbers(*index);
+}
+
+// Parses a lookup table, transposing it if the template of the table has
+// `index_2_variable` as its first variable.
+absl::StatusOr<TimingTable> ParseTable(const cell_lib::Block& table,
+                                       const TemplateMap& templates,
+                                       std::string_view index_2_variable) {
+  const cell_lib::Block* lut_template = nullptr;
+  if (!table.args.empty()) {
+    auto it = templates.find(table.args.front());
+    if (it != templates.end()) {
+      lut_template = it->second;
+    }
+  }
+  TimingTable result;
+  XLS_ASSIGN_OR_RETURN(result.index_1,
+                       ParseIndex(table, lut_template, "index_1"));
+  XLS_ASSIGN_OR_RETURN(result.index_2,
+                       ParseIndex(table, lut_template, "index_2"));
+  const cell_lib::Block* values = FindSubBlock(table, "values");
+  if (values == nullptr) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Liberty %s table has no values", table.kind));
+  }
+  XLS_ASSIGN_OR_RETURN(result.values, ParseNumbers(*values));
+  if (result.index_1.empty() || result.index_2.empty() ||
+      result.values.size() != result.index_1.size() * result.index_2.size()) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Liberty %s table has %d values for a %dx%d index", table.kind,
+        result.values.size(), result.index_1.size(), result.index_2.size()));
+  }
+
+  if (lut_template != nullptr &&
+      FindValue(*lut_template, "variable_1") == index_2_variable) {
+    TimingTable transposed;
+    transposed.index_1 = result.index_2;
+    transposed.index_2 = result.index_1;
+    transposed.values.reserve(result.values.size());
+    for (int64_t j = 0; j < result.index_2.size(); ++j) {
+      for (int64_t i = 0; i < result.index_1.size(); ++i) {
+        transposed.values.push_back(
+            result.values[i * result.index_2.size() + j]);
+      }
+    }
+    return transposed;
+  }
+  return result;
+}
+
+// Returns the arc in `arcs` with the given pins, adding it if there is none.
+TimingArc& GetOrAddArc(std::vector<TimingArc>& arcs,
+                       std::string_view related_pin, std::string_view pin) {
+  for (TimingArc& arc : arcs) {
+    if (arc.related_pin == related_pin && arc.pin == pin) {
+      return arc;
+    }
+  }
+  arcs.push_back(TimingArc{.related_pin = std::string(related_pin),
+                           .pin = std::string(pin)});
+  return arcs.back();
+}
+
+// Adds the tables of the given kinds in `timing` to `tables`.
+absl::Status AddTables(const cell_lib::Block& timing,
+                       absl::Span<const std::string_view> kinds,
+                       const TemplateMap& templates,
+                       std::string_view index_2_variable,
+                       std::vector<TimingTable>& tables) {
+  for (std::string_view kind : kinds) {
+    for (const cell_lib::Block* table : timing.GetSubBlocks(kind)) {
+      XLS_ASSIGN_OR_RETURN(TimingTable parsed,
+                           ParseTable(*table, templates, index_2_variable));
+      tables.push_back(std::move(parsed));
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status AddTimingGroup(const cell_lib::Block& timing,
+                            std::string_view pin,
+                            const TemplateMap& templates,
+                            CellTiming& cell) {
+  std::string_view timing_type =
+      FindValue(timing, "timing_type").value_or("combinational");
+  std::vector<std::string_view> related_pins = absl::StrSplit(
+      FindValue(timing, "related_pin").value_or(""), ' ', absl::SkipEmpty());
+  if (absl::StartsWith(timing_type, "combinational")) {
+    for (std::string_view related_pin : related_pins) {
+      TimingArc& arc =
+          GetOrAddArc(cell.combinational_arcs, related_pin, pin);
+      XLS_RETURN_IF_ERROR(AddTables(timing, {"cell_rise", "cell_fall"},
+                                    templates, kLoadVariable, arc.delays));
+      XLS_RETURN_IF_ERROR(AddTables(timing,
+                                    {"rise_transition", "fall_transition"},
+                                    templates, kLoadVariable,
+                                    arc.transitions));
+    }
+  } else if (timing_type == "rising_edge" || timing_type == "falling_edge") {
+    TimingArc& arc = GetOrAddArc(cell.clock_arcs, "", pin);
+    XLS_RETURN_IF_ERROR(AddTables(timing, {"cell_rise", "cell_fall"},
+                                  templates, kLoadVariable, arc.delays));
+    XLS_RETURN_IF_ERROR(AddTables(timing,
+                                  {"rise_transition", "fall_transition"},
+                                  templates, kLoadVariable, arc.transitions));
+  } else if (timing_type == "setup_rising" ||
+             timing_type == "setup_falling") {
+    TimingArc& arc = GetOrAddArc(cell.setup_checks, "", pin);
+    XLS_RETURN_IF_ERROR(AddTables(timing,
+                                  {"rise_constraint", "fall_constraint"},
+                                  templates, kRelatedTransitionVariable,
+                                  arc.delays));
+  }
+  // Other checks (hold, recovery, ...) do not constrain the maximum delay.
+  return absl::OkStatus();
+}
+
+// Returns the index of the segment [xs[i], xs[i + 1]] used to interpolate at
+// `x` and the position of `x` in it.
+std::pair<int64_t, double> FindSegment(absl::Span<const double> xs, double x) {
+  if (xs.size() < 2) {
+    return {0, 0.0};
+  }
+  int64_t i = std::upper_bound(xs.begin() + 1, xs.end() - 1, x) - xs.begin() -
+              1;
+  double width = xs[i + 1] - xs[i];
+  return {i, width == 0.0 ? 0.0 : (x - xs[i]) / width};
+}
+
+// Returns the logical effort and parasitic delay of a cell. Kinds which the
+// logical effort helpers do not cover (e.g. buffers and complex gates) are
+// modeled as a NAND gate with the same number of inputs, i.e., as an inverter
+// if they have a single input.
+std::pair<double, double> LogicalEffortModel(CellKind kind,
+                                             int64_t input_count) {
+  absl::StatusOr<double> g =
+      logical_effort::GetLogicalEffort(kind, input_count);
+  absl::StatusOr<double> p =
+      logical_effort::GetParasiticDelay(kind, input_count);
+  if (g.ok() && p.ok()) {
+    return {*g, *p};
+  }
+  double n = std::max<int64_t>(input_count, 1);
+  return {(n + 2.0) / 3.0, n};
+}
+
+}  // namespace
+
+double TimingTable::Lookup(double x1, double x2) const {
+  auto [i, t] = FindSegment(index_1, x1);
+  auto [j, u] = FindSegment(index_2, x2);
+  int64_t columns = index_2.size();
+  int64_t i1 = std::min<int64_t>(i + 1, index_1.size() - 1);
+  int64_t j1 = std::min<int64_t>(j + 1, columns - 1);
+  double v0 =
+      values[i * columns + j] * (1.0 - u) + values[i * columns + j1] * u;
+  double v1 =
+      values[i1 * columns + j] * (1.0 - u) + values[i1 * columns + j1] * u;
+  return v0 * (1.0 - t) + v1 * t;
+}
+
+double TimingArc::Delay(double x1, double x2) const {
+  double delay = -kInfinity;
+  for (const TimingTable& table : delays) {
+    delay = std::max(delay, table.Lookup(x1, x2));
+  }
+  return delays.empty() ? 0.0 : delay;
+}
+
+std::optional<double> TimingArc::Transition(double input_transition,
+                                            double load) const {
+  if (transitions.empty()) {
+    return std::nullopt;
+  }
+  double transition = -kInfinity;
+  for (const TimingTable& table : transitions) {
+    transition =
+        std::max(transition, table.Lookup(input_transition, load));
+  }
+  return transition;
+}
+
+const TimingArc* CellTiming::GetCombinationalArc(std::string_view related_pin,
+                                                 std::string_view pin) const {
+  for (const TimingArc& arc : combinational_arcs) {
+    if (arc.related_pin == related_pin && arc.pin == pin) {
+      return &arc;
+    }
+  }
+  return nullptr;
+}
+
+bool CellTiming::HasCombinationalArcTo(std::string_view pin) const {
+  return std::any_of(combinational_arcs.begin(), combinational_arcs.end(),
+                     [&](const TimingArc& arc) { return arc.pin == pin; });
+}
+
+const TimingArc* CellTiming::GetClockArc(std::string_view pin) const {
+  for (const TimingArc& arc : clock_arcs) {
+    if (arc.pin == pin) {
+      return &arc;
+    }
+  }
+  return nullptr;
+}
+
+const TimingArc* CellTiming::GetSetupCheck(std::string_view pin) const {
+  for (const TimingArc& arc : setup_checks) {
+    if (arc.pin == pin) {
+      return &arc;
+    }
+  }
+  return nullptr;
+}
+
+/* static */ absl::flat_hash_set<std::string> TimingLibrary::GetBlockKinds() {
+  return {"library",         "lu_table_template", "cell",
+          "pin",             "timing",            "cell_rise",
+          "cell_fall",       "rise_transition",   "fall_transition",
+          "rise_constraint", "fall_constraint"};
+}
+
+/* static */ absl::StatusOr<TimingLibrary> TimingLibrary::FromLibertyBlock(
+    const cell_lib::Block& library) {
+  XLS_RET_CHECK_EQ(library.kind, "library");
+  TemplateMap templates;
+  for (const cell_lib::Block* lut_template :
+       library.GetSubBlocks("lu_table_template")) {
+    if (!lut_template->args.empty()) {
+      templates[lut_template->args.front()] = lut_template;
+    }
+  }
+
+  TimingLibrary result;
+  for (const cell_lib::Block* cell : library.GetSubBlocks("cell")) {
+    XLS_RET_CHECK(!cell->args.empty()) << "Liberty cell without a name";
+    auto timing = std::make_unique<CellTiming>();
+    for (const cell_lib::Block* pin : cell->GetSubBlocks("pin")) {
+      for (const std::string& pin_name : pin->args) {
+        if (std::optional<std::string_view> capacitance =
+                FindValue(*pin, "capacitance")) {
+          double value;
+          if (!absl::SimpleAtod(*capacitance, &value)) {
+            return absl::InvalidArgumentError(absl::StrFormat(
+                "Invalid capacitance of pin %s of cell %s: \"%s\"", pin_name,
+                cell->args.front(), *capacitance));
+          }
+          timing->pin_capacitances[pin_name] = value;
+        }
+        for (const cell_lib::Block* group : pin->GetSubBlocks("timing")) {
+          XLS_RETURN_IF_ERROR(
+              AddTimingGroup(*group, pin_name, templates, *timing));
+        }
+      }
+    }
+    result.cells_[cell->args.front()] = std::move(timing);
+  }
+  return result;
+}
+
+const CellTiming* TimingLibrary::GetCell(std::string_view name) const {
+  auto it = cells_.find(name);
+  return it == cells_.end() ? nullptr : it->second.get();
+}
+
+/* static */ absl::StatusOr<std::unique_ptr<StaticTimingAnalysis>>
+StaticTimingAnalysis::Create(const rtl::Module* module,
+                             const TimingLibrary* library,
+                             const StaOptions& options) {
+  auto analysis = absl::WrapUnique(
+      new StaticTimingAnalysis(module, library, options));
+  XLS_RETURN_IF_ERROR(analysis->Build());
+  return analysis;
+}
+
+absl::Status StaticTimingAnalysis::Build() {
+  cell_count_ = module_->cells().size();
+  rtl::NetRef dummy = module_->GetDummyRef();
+  std::vector<rtl::NetRef> nets;
+  absl::flat_hash_map<rtl::NetRef, int32_t> net_index;
+  for (const auto& net : module_->nets()) {
+    if (net.get() != dummy) {
+      net_index[net.get()] = nets.size();
+      nets.push_back(net.get());
+    }
+  }
+  auto node_of = [&](rtl::NetRef net) -> absl::StatusOr<int32_t> {
+    auto it = net_index.find(net);
+    if (it == net_index.end()) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Net %s is not part of module %s", net == nullptr ? "<null>"
+                                                            : net->name(),
+          module_->name()));
+    }
+    return it->second;
+  };
+
+  // Gather the arcs, startpoints, endpoints and pin loads of the graph with
+  // nodes numbered in net declaration order.
+  struct PendingArc {
+    int32_t from;
+    int32_t to;
+    const rtl::Cell* cell;
+    int32_t input_pin;
+    int32_t output_pin;
+  };
+  std::vector<PendingArc> arcs;
+  std::vector<Source> sources;
+  std::vector<Endpoint> endpoints;
+  std::vector<std::pair<int32_t, Sink>> sinks;
+  for (const auto& cell_ptr : module_->cells()) {
+    const rtl::Cell* cell = cell_ptr.get();
+    absl::Span<const rtl::Cell::Pin> inputs = cell->inputs();
+    absl::Span<const rtl::Cell::OutputPin> outputs = cell->outputs();
+    for (int64_t i = 0; i < inputs.size(); ++i) {
+      XLS_ASSIGN_OR_RETURN(int32_t node, node_of(inputs[i].netref));
+      sinks.push_back({node, Sink{cell, i}});
+    }
+    if (cell->clock().has_value()) {
+      XLS_ASSIGN_OR_RETURN(int32_t node, node_of(*cell->clock()));
+      sinks.push_back({node, Sink{cell, -1}});
+    }
+    if (cell->kind() == CellKind::kFlop) {
+      for (int64_t o = 0; o < outputs.size(); ++o) {
+        if (outputs[o].netref == dummy) {
+          continue;
+        }
+        XLS_ASSIGN_OR_RETURN(int32_t node, node_of(outputs[o].netref));
+        sources.push_back(Source{.node = node,
+                                 .cell = cell,
+                                 .output_pin = o,
+                                 .clock_arc = nullptr,
+                                 .name = cell->name()});
+      }
+      for (int64_t i = 0; i < inputs.size(); ++i) {
+        XLS_ASSIGN_OR_RETURN(int32_t node, node_of(inputs[i].netref));
+        endpoints.push_back(Endpoint{.node = node,
+                                     .cell = cell,
+                                     .input_pin = i,
+                                     .setup_check = nullptr,
+                                     .name = cell->name(),
+                                     .required = kInfinity});
+      }
+      continue;
+    }
+    for (int64_t o = 0; o < outputs.size(); ++o) {
+      if (outputs[o].netref == dummy) {
+        continue;
+      }
+      XLS_ASSIGN_OR_RETURN(int32_t to, node_of(outputs[o].netref));
+      for (int64_t i = 0; i < inputs.size(); ++i) {
+        XLS_ASSIGN_OR_RETURN(int32_t from, node_of(inputs[i].netref));
+        arcs.push_back(PendingArc{from, to, cell, static_cast<int32_t>(i),
+                                  static_cast<int32_t>(o)});
+      }
+    }
+  }
+  for (rtl::NetRef net : module_->inputs()) {
+    XLS_ASSIGN_OR_RETURN(int32_t node, node_of(net));
+    sources.push_back(Source{.node = node,
+                             .cell = nullptr,
+                             .output_pin = -1,
+                             .clock_arc = nullptr,
+                             .name = net->name()});
+  }
+  for (rtl::NetRef net : module_->outputs()) {
+    XLS_ASSIGN_OR_RETURN(int32_t node, node_of(net));
+    endpoints.push_back(Endpoint{.node = node,
+                                 .cell = nullptr,
+                                 .input_pin = -1,
+                                 .setup_check = nullptr,
+                                 .name = net->name(),
+                                 .required = kInfinity});
+  }
+  for (const auto& [lhs, rhs] : module_->assigns()) {
+    XLS_ASSIGN_OR_RETURN(int32_t from, node_of(rhs));
+    XLS_ASSIGN_OR_RETURN(int32_t to, node_of(lhs));
+    arcs.push_back(PendingArc{from, to, nullptr, -1, -1});
+  }
+
+  // Levelize: the level of a node is the length of the longest path to it.
+  int64_t node_count = nets.size();
+  std::vector<int64_t> level(node_count, 0);
+  std::vector<int64_t> indegree(node_count, 0);
+  std::vector<std::vector<int32_t>> successors(node_count);
+  for (const PendingArc& arc : arcs) {
+    ++indegree[arc.to];
+    successors[arc.from].push_back(arc.to);
+  }
+  std::vector<int32_t> ready;
+  for (int32_t node = 0; node < node_count; ++node) {
+    if (indegree[node] == 0) {
+      ready.push_back(node);
+    }
+  }
+  int64_t visited = 0;
+  level_count_ = node_count == 0 ? 0 : 1;
+  while (!ready.empty()) {
+    int32_t node = ready.back();
+    ready.pop_back();
+    ++visited;
+    for (int32_t successor : successors[node]) {
+      level[successor] = std::max(level[successor], level[node] + 1);
+      level_count_ = std::max(level_count_, level[successor] + 1);
+      if (--indegree[successor] == 0) {
+        ready.push_back(successor);
+      }
+    }
+  }
+  if (visited != node_count) {
+    for (int32_t node = 0; node < node_count; ++node) {
+      if (indegree[node] != 0) {
+        return absl::InvalidArgumentError(
+            absl::StrFormat("Combinational cycle through net %s of module %s",
+                            nets[node]->name(), module_->name()));
+      }
+    }
+  }
+  std::vector<int32_t> order(node_count);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](int32_t a, int32_t b) {
+    return level[a] < level[b];
+  });
+  std::vector<int32_t> position(node_count);
+  for (int32_t i = 0; i < node_count; ++i) {
+    position[order[i]] = i;
+  }
+
+  // Renumber everything in levelized order and lay it out in flat arrays.
+  nets_.resize(node_count);
+  net_to_node_.clear();
+  for (int32_t i = 0; i < node_count; ++i) {
+    nets_[i] = nets[order[i]];
+    net_to_node_[nets_[i]] = i;
+  }
+  for (PendingArc& arc : arcs) {
+    arc.from = position[arc.from];
+    arc.to = position[arc.to];
+  }
+  std::stable_sort(arcs.begin(), arcs.end(),
+                   [](const PendingArc& a, const PendingArc& b) {
+                     return std::tie(a.to, a.from) < std::tie(b.to, b.from);
+                   });
+  int64_t arc_count = arcs.size();
+  fanin_begin_.assign(node_count + 1, 0);
+  arc_from_.resize(arc_count);
+  arc_to_.resize(arc_count);
+  arc_cell_.resize(arc_count);
+  arc_input_pin_.resize(arc_count);
+  arc_output_pin_.resize(arc_count);
+  for (int32_t a = 0; a < arc_count; ++a) {
+    arc_from_[a] = arcs[a].from;
+    arc_to_[a] = arcs[a].to;
+    arc_cell_[a] = arcs[a].cell;
+    arc_input_pin_[a] = arcs[a].input_pin;
+    arc_output_pin_[a] = arcs[a].output_pin;
+    ++fanin_begin_[arcs[a].to + 1];
+  }
+  std::partial_sum(fanin_begin_.begin(), fanin_begin_.end(),
+                   fanin_begin_.begin());
+  fanout_arcs_.resize(arc_count);
+  std::iota(fanout_arcs_.begin(), fanout_arcs_.end(), 0);
+  std::stable_sort(fanout_arcs_.begin(), fanout_arcs_.end(),
+                   [&](int32_t a, int32_t b) {
+                     return arc_from_[a] < arc_from_[b];
+                   });
+  fanout_begin_.assign(node_count + 1, 0);
+  for (int32_t a = 0; a < arc_count; ++a) {
+    ++fanout_begin_[arc_from_[a] + 1];
+  }
+  std::partial_sum(fanout_begin_.begin(), fanout_begin_.end(),
+                   fanout_begin_.begin());
+  arc_delay_.assign(arc_count, 0.0);
+  arc_kind_.assign(arc_count, ArcKind::kWire);
+  arc_liberty_.assign(arc_count, nullptr);
+  arc_effort_.assign(arc_count, 0.0);
+  arc_parasitic_.assign(arc_count, 0.0);
+
+  sources_ = std::move(sources);
+  source_.assign(node_count, -1);
+  for (int32_t s = 0; s < sources_.size(); ++s) {
+    sources_[s].node = position[sources_[s].node];
+    if (source_[sources_[s].node] == -1) {
+      source_[sources_[s].node] = s;
+    }
+  }
+  for (Endpoint& endpoint : endpoints) {
+    endpoint.node = position[endpoint.node];
+  }
+  std::stable_sort(endpoints.begin(), endpoints.end(),
+                   [](const Endpoint& a, const Endpoint& b) {
+                     return a.node < b.node;
+                   });
+  endpoints_ = std::move(endpoints);
+  endpoint_begin_.assign(node_count + 1, 0);
+  for (const Endpoint& endpoint : endpoints_) {
+    ++endpoint_begin_[endpoint.node + 1];
+  }
+  std::partial_sum(endpoint_begin_.begin(), endpoint_begin_.end(),
+                   endpoint_begin_.begin());
+  for (auto& [node, sink] : sinks) {
+    node = position[node];
+  }
+  std::stable_sort(sinks.begin(), sinks.end(),
+                   [](const auto& a, const auto& b) {
+                     return a.first < b.first;
+                   });
+  sinks_.clear();
+  sink_begin_.assign(node_count + 1, 0);
+  for (const auto& [node, sink] : sinks) {
+    sinks_.push_back(sink);
+    ++sink_begin_[node + 1];
+  }
+  std::partial_sum(sink_begin_.begin(), sink_begin_.end(),
+                   sink_begin_.begin());
+
+  cell_refs_.clear();
+  for (const auto& cell : module_->cells()) {
+    cell_refs_[cell.get()];
+  }
+  for (int32_t a = 0; a < arc_count; ++a) {
+    if (arc_cell_[a] != nullptr) {
+      cell_refs_[arc_cell_[a]].arcs.push_back(a);
+    }
+  }
+  for (int32_t s = 0; s < sources_.size(); ++s) {
+    if (sources_[s].cell != nullptr) {
+      cell_refs_[sources_[s].cell].sources.push_back(s);
+    }
+  }
+  for (int32_t e = 0; e < endpoints_.size(); ++e) {
+    if (endpoints_[e].cell != nullptr) {
+      cell_refs_[endpoints_[e].cell].endpoints.push_back(e);
+    }
+  }
+  for (int32_t node = 0; node < node_count; ++node) {
+    for (int32_t s = sink_begin_[node]; s < sink_begin_[node + 1]; ++s) {
+      std::vector<int32_t>& loaded = cell_refs_[sinks_[s].cell].loaded_nodes;
+      if (loaded.empty() || loaded.back() != node) {
+        loaded.push_back(node);
+      }
+    }
+  }
+
+  // Resolve the delay models and loads.
+  for (int32_t a = 0; a < arc_count; ++a) {
+    ResolveArc(a);
+  }
+  for (Source& source : sources_) {
+    ResolveSource(source);
+  }
+  for (Endpoint& endpoint : endpoints_) {
+    ResolveEndpoint(endpoint);
+  }
+  load_.resize(node_count);
+  fanout_.resize(node_count);
+  for (int32_t node = 0; node < node_count; ++node) {
+    load_[node] = ComputeLoad(node);
+    fanout_[node] = sink_begin_[node + 1] - sink_begin_[node];
+    for (int32_t e = endpoint_begin_[node]; e < endpoint_begin_[node + 1];
+         ++e) {
+      fanout_[node] += endpoints_[e].cell == nullptr ? 1 : 0;
+    }
+  }
+  arrival_.assign(node_count, -kInfinity);
+  transition_.assign(node_count, options_.input_transition);
+  required_.assign(node_count, kInfinity);
+  queued_.assign(node_count, false);
+
+  XLS_VLOG(2) << absl::StreamFormat(
+      "Timing graph of module %s: %d nodes, %d arcs, %d levels",
+      module_->name(), node_count, arc_count, level_count_);
+  PropagateAll();
+  return absl::OkStatus();
+}
+
+const CellTiming* StaticTimingAnalysis::GetCellTiming(
+    const rtl::Cell* cell) const {
+  if (library_ == nullptr) {
+    return nullptr;
+  }
+  return library_->GetCell(cell->cell_library_entry()->name());
+}
+
+void StaticTimingAnalysis::ResolveArc(int32_t arc) {
+  const rtl::Cell* cell = arc_cell_[arc];
+  arc_liberty_[arc] = nullptr;
+  arc_effort_[arc] = 0.0;
+  arc_parasitic_[arc] = 0.0;
+  if (cell == nullptr) {
+    arc_kind_[arc] = ArcKind::kWire;
+    return;
+  }
+  const std::string& input = cell->inputs()[arc_input_pin_[arc]].name;
+  const std::string& output = cell->outputs()[arc_output_pin_[arc]].name;
+  const CellTiming* timing = GetCellTiming(cell);
+  if (timing != nullptr && timing->HasCombinationalArcTo(output)) {
+    arc_liberty_[arc] = timing->GetCombinationalArc(input, output);
+    arc_kind_[arc] = arc_liberty_[arc] == nullptr ? ArcKind::kDisabled
+                                                  : ArcKind::kLiberty;
+    return;
+  }
+  arc_kind_[arc] = ArcKind::kLogicalEffort;
+  std::tie(arc_effort_[arc], arc_parasitic_[arc]) =
+      LogicalEffortModel(cell->kind(), cell->inputs().size());
+}
+
+void StaticTimingAnalysis::ResolveSource(Source& source) {
+  const CellTiming* timing =
+      source.cell == nullptr ? nullptr : GetCellTiming(source.cell);
+  source.clock_arc =
+      timing == nullptr
+          ? nullptr
+          : timing->GetClockArc(source.cell->outputs()[source.output_pin].name);
+}
+
+void StaticTimingAnalysis::ResolveEndpoint(Endpoint& endpoint) {
+  const CellTiming* timing =
+      endpoint.cell == nullptr ? nullptr : GetCellTiming(endpoint.cell);
+  endpoint.setup_check =
+      timing == nullptr ? nullptr
+                        : timing->GetSetupCheck(
+                              endpoint.cell->inputs()[endpoint.input_pin].name);
+}
+
+double StaticTimingAnalysis::ComputeLoad(int32_t node) const {
+  double load = 0.0;
+  for (int32_t s = sink_begin_[node]; s < sink_begin_[node + 1]; ++s) {
+    const Sink& sink = sinks_[s];
+    double capacitance = options_.default_pin_capacitance;
+    if (const CellTiming* timing = GetCellTiming(sink.cell);
+        timing != nullptr) {
+      std::string pin =
+          sink.pin < 0
+              ? sink.cell->cell_library_entry()->clock_name().value_or("")
+              : sink.cell->inputs()[sink.pin].name;
+      auto it = timing->pin_capacitances.find(pin);
+      if (it != timing->pin_capacitances.end()) {
+        capacitance = it->second;
+      }
+    }
+    load += capacitance;
+  }
+  for (int32_t e = endpoint_begin_[node]; e < endpoint_begin_[node + 1]; ++e) {
+    if (endpoints_[e].cell == nullptr) {
+      load += options_.output_load;
+    }
+  }
+  return load;
+}
+
+double StaticTimingAnalysis::ArcDelay(int32_t arc) const {
+  switch (arc_kind_[arc]) {
+    case ArcKind::kLiberty:
+      return arc_liberty_[arc]->Delay(transition_[arc_from_[arc]],
+                                      load_[arc_to_[arc]]);
+    case ArcKind::kLogicalEffort:
+      return options_.tau * (arc_effort_[arc] * fanout_[arc_to_[arc]] +
+                             arc_parasitic_[arc]);
+    case ArcKind::kWire:
+    case ArcKind::kDisabled:
+      return 0.0;
+  }
+  XLS_LOG(FATAL) << "Invalid arc kind";
+}
+
+double StaticTimingAnalysis::ArcTransition(int32_t arc) const {
+  switch (arc_kind_[arc]) {
+    case ArcKind::kLiberty:
+      return arc_liberty_[arc]
+          ->Transition(transition_[arc_from_[arc]], load_[arc_to_[arc]])
+          .value_or(options_.input_transition);
+    case ArcKind::kWire:
+      return transition_[arc_from_[arc]];
+    case ArcKind::kLogicalEffort:
+    case ArcKind::kDisabled:
+      return options_.input_transition;
+  }
+  XLS_LOG(FATAL) << "Invalid arc kind";
+}
+
+double StaticTimingAnalysis::EndpointRequired(const Endpoint& endpoint) const {
+  if (endpoint.cell == nullptr) {
+    return options_.clock_period - options_.output_delay;
+  }
+  double setup = endpoint.setup_check == nullptr
+                     ? options_.tau * options_.flop_setup
+                     : endpoint.setup_check->Delay(transition_[endpoint.node],
+                                                   options_.input_transition);
+  return options_.clock_period - setup;
+}
+
+bool StaticTimingAnalysis::UpdateArrival(int32_t node,
+                                         std::vector<int32_t>* changed_arcs) {
+  double arrival = -kInfinity;
+  double transition = options_.input_transition;
+  bool is_source = source_[node] >= 0;
+  if (is_source) {
+    const Source& source = sources_[source_[node]];
+    if (source.cell == nullptr) {
+      arrival = options_.input_delay;
+    } else if (source.clock_arc != nullptr) {
+      arrival =
+          source.clock_arc->Delay(options_.input_transition, load_[node]);
+      transition =
+          source.clock_arc->Transition(options_.input_transition, load_[node])
+              .value_or(transition);
+    } else {
+      arrival = options_.tau * options_.flop_clock_to_q;
+    }
+  }
+  double fanin_transition = -kInfinity;
+  for (int32_t arc = fanin_begin_[node]; arc < fanin_begin_[node + 1]; ++arc) {
+    double delay = ArcDelay(arc);
+    if (delay != arc_delay_[arc]) {
+      arc_delay_[arc] = delay;
+      changed_arcs->push_back(arc);
+    }
+    if (is_source || arc_kind_[arc] == ArcKind::kDisabled) {
+      continue;
+    }
+    arrival = std::max(arrival, arrival_[arc_from_[arc]] + delay);
+    fanin_transition = std::max(fanin_transition, ArcTransition(arc));
+  }
+  if (fanin_transition != -kInfinity) {
+    transition = fanin_transition;
+  }
+  bool changed = arrival != arrival_[node] || transition != transition_[node];
+  arrival_[node] = arrival;
+  transition_[node] = transition;
+  return changed;
+}
+
+double StaticTimingAnalysis::ComputeRequired(int32_t node) const {
+  double required = kInfinity;
+  for (int32_t e = endpoint_begin_[node]; e < endpoint_begin_[node + 1]; ++e) {
+    required = std::min(required, endpoints_[e].required);
+  }
+  for (int32_t i = fanout_begin_[node]; i < fanout_begin_[node + 1]; ++i) {
+    int32_t arc = fanout_arcs_[i];
+    if (arc_kind_[arc] != ArcKind::kDisabled) {
+      required = std::min(required, required_[arc_to_[arc]] - arc_delay_[arc]);
+    }
+  }
+  return required;
+}
+
+void StaticTimingAnalysis::PropagateAll() {
+  std::vector<int32_t> changed_arcs;
+  for (int32_t node = 0; node < nets_.size(); ++node) {
+    UpdateArrival(node, &changed_arcs);
+  }
+  for (Endpoint& endpoint : endpoints_) {
+    endpoint.required = EndpointRequired(endpoint);
+  }
+  for (int32_t node = nets_.size() - 1; node >= 0; --node) {
+    required_[node] = ComputeRequired(node);
+  }
+}
+
+absl::Status StaticTimingAnalysis::UpdateCells(
+    absl::Span<const rtl::Cell* const> cells) {
+  if (module_->cells().size() != cell_count_) {
+    XLS_VLOG(2) << "Cells were added to module " << module_->name()
+                << "; rebuilding its timing graph";
+    StaticTimingAnalysis rebuilt(module_, library_, options_);
+    XLS_RETURN_IF_ERROR(rebuilt.Build());
+    *this = std::move(rebuilt);
+    return absl::OkStatus();
+  }
+
+  // Nodes are numbered in topological order so processing the changed nodes
+  // in increasing (decreasing) order visits each at most once in the forward
+  // (backward) sweep.
+  std::priority_queue<int32_t, std::vector<int32_t>, std::greater<>> forward;
+  auto enqueue_forward = [&](int32_t node) {
+    if (!queued_[node]) {
+      queued_[node] = true;
+      forward.push(node);
+    }
+  };
+  for (const rtl::Cell* cell : cells) {
+    auto it = cell_refs_.find(cell);
+    if (it == cell_refs_.end()) {
+      return absl::NotFoundError(absl::StrFormat(
+          "Cell %s is not part of module %s", cell->name(), module_->name()));
+    }
+    const CellRefs& refs = it->second;
+    for (int32_t arc : refs.arcs) {
+      ResolveArc(arc);
+      enqueue_forward(arc_to_[arc]);
+    }
+    for (int32_t s : refs.sources) {
+      ResolveSource(sources_[s]);
+      enqueue_forward(sources_[s].node);
+    }
+    for (int32_t e : refs.endpoints) {
+      ResolveEndpoint(endpoints_[e]);
+      enqueue_forward(endpoints_[e].node);
+    }
+    for (int32_t node : refs.loaded_nodes) {
+      double load = ComputeLoad(node);
+      if (load != load_[node]) {
+        load_[node] = load;
+        enqueue_forward(node);
+      }
+    }
+  }
+
+  std::vector<int32_t> changed_arcs;
+  std::vector<int32_t> backward_seeds;
+  int64_t forward_count = 0;
+  while (!forward.empty()) {
+    int32_t node = forward.top();
+    forward.pop();
+    queued_[node] = false;
+    ++forward_count;
+    if (UpdateArrival(node, &changed_arcs)) {
+      for (int32_t i = fanout_begin_[node]; i < fanout_begin_[node + 1]; ++i) {
+        enqueue_forward(arc_to_[fanout_arcs_[i]]);
+      }
+    }
+    for (int32_t e = endpoint_begin_[node]; e < endpoint_begin_[node + 1];
+         ++e) {
+      double required = EndpointRequired(endpoints_[e]);
+      if (required != endpoints_[e].required) {
+        endpoints_[e].required = required;
+        backward_seeds.push_back(node);
+      }
+    }
+  }
+
+  std::priority_queue<int32_t> backward;
+  auto enqueue_backward = [&](int32_t node) {
+    if (!queued_[node]) {
+      queued_[node] = true;
+      backward.push(node);
+    }
+  };
+  for (int32_t node : backward_seeds) {
+    enqueue_backward(node);
+  }
+  for (int32_t arc : changed_arcs) {
+    enqueue_backward(arc_from_[arc]);
+  }
+  int64_t backward_count = 0;
+  while (!backward.empty()) {
+    int32_t node = backward.top();
+    backward.pop();
+    queued_[node] = false;
+    ++backward_count;
+    double required = ComputeRequired(node);
+    if (required != required_[node]) {
+      required_[node] = required;
+      for (int32_t arc = fanin_begin_[node]; arc < fanin_begin_[node + 1];
+           ++arc) {
+        enqueue_backward(arc_from_[arc]);
+      }
+    }
+  }
+  XLS_VLOG(3) << absl::StreamFormat(
+      "Re-timed %d cells of module %s: %d forward and %d backward node "
+      "updates of %d nodes",
+      cells.size(), module_->name(), forward_count, backward_count,
+      nets_.size());
+  return absl::OkStatus();
+}
+
+absl::StatusOr<double> StaticTimingAnalysis::GetArrivalTime(
+    rtl::NetRef net) const {
+  auto it = net_to_node_.find(net);
+  if (it == net_to_node_.end()) {
+    return absl::NotFoundError(
+        absl::StrFormat("Net %s is not in the timing graph", net->name()));
+  }
+  return arrival_[it->second];
+}
+
+absl::StatusOr<double> StaticTimingAnalysis::GetRequiredTime(
+    rtl::NetRef net) const {
+  auto it = net_to_node_.find(net);
+  if (it == net_to_node_.end()) {
+    return absl::NotFoundError(
+        absl::StrFormat("Net %s is not in the timing graph", net->name()));
+  }
+  return required_[it->second];
+}
+
+absl::StatusOr<double> StaticTimingAnalysis::GetSlack(rtl::NetRef net) const {
+  XLS_ASSIGN_OR_RETURN(double arrival, GetArrivalTime(net));
+  XLS_ASSIGN_OR_RETURN(double required, GetRequiredTime(net));
+  return required - arrival;
+}
+
+double StaticTimingAnalysis::GetWorstSlack() const {
+  double worst = kInfinity;
+  for (const Endpoint& endpoint : endpoints_) {
+    if (arrival_[endpoint.node] != -kInfinity) {
+      worst = std::min(worst, endpoint.required - arrival_[endpoint.node]);
+    }
+  }
+  return worst;
+}
+
+std::string StaticTimingAnalysis::StartpointName(int32_t node) const {
+  return source_[node] >= 0 ? sources_[source_[node]].name
+                            : nets_[node]->name();
+}
+
+TimingPath StaticTimingAnalysis::TraceCriticalPath(int32_t node) const {
+  std::vector<int32_t> nodes = {node};
+  int32_t current = node;
+  while (source_[current] < 0) {
+    int32_t latest = -1;
+    double latest_arrival = -kInfinity;
+    for (int32_t arc = fanin_begin_[current]; arc < fanin_begin_[current + 1];
+         ++arc) {
+      double arrival = arrival_[arc_from_[arc]] + arc_delay_[arc];
+      if (arc_kind_[arc] != ArcKind::kDisabled && arrival > latest_arrival) {
+        latest = arc;
+        latest_arrival = arrival;
+      }
+    }
+    if (latest == -1) {
+      break;
+    }
+    current = arc_from_[latest];
+    nodes.push_back(current);
+  }
+  TimingPath path;
+  path.startpoint = StartpointName(current);
+  path.arrival = arrival_[node];
+  for (auto it = nodes.rbegin(); it != nodes.rend(); ++it) {
+    path.nets.push_back(nets_[*it]->name());
+  }
+  return path;
+}
+
+absl::StatusOr<TimingPath> StaticTimingAnalysis::GetCriticalPath() const {
+  const Endpoint* worst = nullptr;
+  for (const Endpoint& endpoint : endpoints_) {
+    if (arrival_[endpoint.node] == -kInfinity) {
+      continue;
+    }
+    if (worst == nullptr || endpoint.required - arrival_[endpoint.node] <
+                                worst->required - arrival_[worst->node]) {
+      worst = &endpoint;
+    }
+  }
+  if (worst == nullptr) {
+    return absl::NotFoundError(absl::StrFormat(
+        "No endpoint of module %s is reachable from a startpoint",
+        module_->name()));
+  }
+  TimingPath path = TraceCriticalPath(worst->node);
+  path.endpoint = worst->name;
+  path.required = worst->required;
+  path.slack = path.required - path.arrival;
+  return path;
+}
+
+std::vector<TimingPath> StaticTimingAnalysis::GetWorstPathsByRegisterPair()
+    const {
+  // Group the sources by startpoint (a register may have several outputs).
+  std::vector<std::vector<int32_t>> startpoints;
+  absl::flat_hash_map<std::string_view, int64_t> startpoint_index;
+  for (int32_t s = 0; s < sources_.size(); ++s) {
+    auto [it, inserted] =
+        startpoint_index.try_emplace(sources_[s].name, startpoints.size());
+    if (inserted) {
+      startpoints.emplace_back();
+    }
+    startpoints[it->second].push_back(s);
+  }
+
+  // Propagate the arrival times of each startpoint through its fanout cone
+  // alone, recording the latest fanin arc of each node in the cone.
+  int64_t node_count = nets_.size();
+  std::vector<double> arrival(node_count, -kInfinity);
+  std::vector<int32_t> latest_arc(node_count, -1);
+  std::vector<bool> in_cone(node_count, false);
+  absl::flat_hash_map<std::pair<std::string, std::string>, TimingPath> worst;
+  for (const std::vector<int32_t>& startpoint : startpoints) {
+    const std::string& name = sources_[startpoint.front()].name;
+    std::vector<int32_t> cone;
+    for (int32_t s : startpoint) {
+      int32_t node = sources_[s].node;
+      if (!in_cone[node]) {
+        in_cone[node] = true;
+        arrival[node] = arrival_[node];
+        cone.push_back(node);
+      }
+    }
+    int64_t seed_count = cone.size();
+    for (int64_t i = 0; i < cone.size(); ++i) {
+      for (int32_t j = fanout_begin_[cone[i]]; j < fanout_begin_[cone[i] + 1];
+           ++j) {
+        int32_t arc = fanout_arcs_[j];
+        if (arc_kind_[arc] != ArcKind::kDisabled && !in_cone[arc_to_[arc]]) {
+          in_cone[arc_to_[arc]] = true;
+          cone.push_back(arc_to_[arc]);
+        }
+      }
+    }
+    std::sort(cone.begin() + seed_count, cone.end());
+    for (int64_t i = seed_count; i < cone.size(); ++i) {
+      int32_t node = cone[i];
+      for (int32_t arc = fanin_begin_[node]; arc < fanin_begin_[node + 1];
+           ++arc) {
+        int32_t from = arc_from_[arc];
+        if (!in_cone[from] || arc_kind_[arc] == ArcKind::kDisabled) {
+          continue;
+        }
+        if (arrival[from] + arc_delay_[arc] > arrival[node]) {
+          arrival[node] = arrival[from] + arc_delay_[arc];
+          latest_arc[node] = arc;
+        }
+      }
+    }
+
+    for (int32_t node : cone) {
+      if (arrival[node] == -kInfinity) {
+        continue;
+      }
+      for (int32_t e = endpoint_begin_[node]; e < endpoint_begin_[node + 1];
+           ++e) {
+        const Endpoint& endpoint = endpoints_[e];
+        double slack = endpoint.required - arrival[node];
+        auto [it, inserted] = worst.try_emplace({name, endpoint.name});
+        if (!inserted && slack >= it->second.slack) {
+          continue;
+        }
+        TimingPath& path = it->second;
+        path.startpoint = name;
+        path.endpoint = endpoint.name;
+        path.arrival = arrival[node];
+        path.required = endpoint.required;
+        path.slack = slack;
+        path.nets.clear();
+        for (int32_t n = node; n != -1;
+             n = latest_arc[n] == -1 ? -1 : arc_from_[latest_arc[n]]) {
+          path.nets.push_back(nets_[n]->name());
+        }
+        std::reverse(path.nets.begin(), path.nets.end());
+      }
+    }
+
+    for (int32_t node : cone) {
+      arrival[node] = -kInfinity;
+      latest_arc[node] = -1;
+      in_cone[node] = false;
+    }
+  }
+
+  std::vector<TimingPath> paths;
+  paths.reserve(worst.size());
+  for (auto& [pair, path] : worst) {
+    paths.push_back(std::move(path));
+  }
+  std::sort(paths.begin(), paths.end(),
+            [](const TimingPath& a, const TimingPath& b) {
+              return std::tie(a.slack, a.startpoint, a.endpoint) <
+                     std::tie(b.slack, b.startpoint, b.endpoint);
+            });
+  return paths;
+}
+
+}  // namespace netlist
+}  // namespace xls
@@ -0,0 +1,316 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Levelized static timing analysis over parsed netlists.
+//
+// Cell delays come from Liberty timing tables (as parsed by lib_parser) for
+// cells which have them and from the method of logical effort otherwise.
+
+#ifndef XLS_NETLIST_STATIC_TIMING_H_
+#define XLS_NETLIST_STATIC_TIMING_H_
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "xls/netlist/lib_parser.h"
+#include "xls/netlist/netlist.h"
+
+namespace xls {
+namespace netlist {
+
+// A Liberty lookup table such as "cell_rise". Tables are normalized on parsing
+// so that for delay and transition tables index_1 is the input transition and
+// index_2 the output load, and for constraint tables index_1 is the
+// transition of the constrained pin and index_2 that of the related (clock)
+// pin. Missing dimensions have a single index of zero.
+struct TimingTable {
+  std::vector<double> index_1;
+  std::vector<double> index_2;
+  // Row-major: values[i * index_2.size() + j] is the value at index_1[i],
+  // index_2[j].
+  std::vector<double> values;
+
+  // Bilinearly interpolates the table, extrapolating linearly outside of it.
+  double Lookup(double x1, double x2) const;
+};
+
+// A timing arc of a Liberty cell, i.e., a "timing" group of an output pin (or
+// of the constrained input pin for setup checks). Arcs with the same pins but
+// different conditions are merged; rise and fall are not distinguished and
+// lookups return the worst value of all of the tables.
+struct TimingArc {
+  std::string related_pin;
+  std::string pin;
+  // cell_rise/cell_fall tables, or rise_constraint/fall_constraint tables for
+  // setup checks.
+  std::vector<TimingTable> delays;
+  // rise_transition/fall_transition tables.
+  std::vector<TimingTable> transitions;
+
+  double Delay(double x1, double x2) const;
+  std::optional<double> Transition(double input_transition,
+                                   double load) const;
+};
+
+// The timing data of a single Liberty cell.
+struct CellTiming {
+  absl::flat_hash_map<std::string, double> pin_capacitances;
+  std::vector<TimingArc> combinational_arcs;
+  // Clock-to-output arcs of sequential cells ("rising_edge" and
+  // "falling_edge" timing types), merged per output pin.
+  std::vector<TimingArc> clock_arcs;
+  // Setup checks ("setup_rising" and "setup_falling"), merged per pin.
+  std::vector<TimingArc> setup_checks;
+
+  // Returns the combinational arc from `related_pin` to `pin`, or nullptr if
+  // there is none.
+  const TimingArc* GetCombinationalArc(std::string_view related_pin,
+                                       std::string_view pin) const;
+  // Returns whether any combinational arc ends at `pin`.
+  bool HasCombinationalArcTo(std::string_view pin) const;
+  const TimingArc* GetClockArc(std::string_view pin) const;
+  const TimingArc* GetSetupCheck(std::string_view pin) const;
+};
+
+// Timing data of the cells of a Liberty library.
+class TimingLibrary {
+ public:
+  // Returns the block kinds to pass as the allowlist of cell_lib::Parser so
+  // that only the data needed for timing analysis is retained.
+  static absl::flat_hash_set<std::string> GetBlockKinds();
+
+  // Extracts the timing data from a parsed Liberty "library" block.
+  static absl::StatusOr<TimingLibrary> FromLibertyBlock(
+      const cell_lib::Block& library);
+
+  // Returns the timing data of the given cell, or nullptr if the library has
+  // none.
+  const CellTiming* GetCell(std::string_view name) const;
+
+ private:
+  absl::flat_hash_map<std::string, std::unique_ptr<CellTiming>> cells_;
+};
+
+struct StaOptions {
+  // Required time at register inputs (less their setup time) and at module
+  // outputs (less output_delay).
+  double clock_period = 0.0;
+  // Arrival time at module inputs.
+  double input_delay = 0.0;
+  double output_delay = 0.0;
+  // Transition time at module inputs and at clock pins.
+  double input_transition = 0.0;
+  // Load on module outputs.
+  double output_load = 0.0;
+  // Capacitance of pins which have none in the timing library.
+  double default_pin_capacitance = 0.0;
+  // Delay of a unit of logical effort delay (the delay of a fanout-of-one
+  // inverter, less parasitics) in library time units. Logical effort delays
+  // are multiplied by this to combine them with Liberty delays.
+  double tau = 1.0;
+  // Clock-to-output delay and setup time, in units of tau, of sequential
+  // cells which have no timing data in the library.
+  double flop_clock_to_q = 4.0;
+  double flop_setup = 2.0;
+};
+
+// A path from a startpoint (a module input or a register) to an endpoint (a
+// module output or a register).
+struct TimingPath {
+  // The name of the register cell or of the module port.
+  std::string startpoint;
+  std::string endpoint;
+  double arrival;
+  double required;
+  double slack;
+  // Names of the nets along the path, starting at the startpoint.
+  std::vector<std::string> nets;
+};
+
+// Static timing analysis of a module. The timing graph has a node per net and
+// an arc per cell input/output pin pair (and per assign); registers are cut
+// into a startpoint at their outputs and an endpoint at their inputs. Nodes
+// are numbered in levelized (topological) order and all per-node and per-arc
+// data is held in flat arrays, so arrival times are computed in a single
+// forward sweep and required times in a single backward sweep over them.
+//
+// After local edits of the netlist, e.g. resizing cells with
+// Cell::SetCellLibraryEntry, UpdateCells re-times only the fanout and fanin
+// cones which actually change.
+class StaticTimingAnalysis {
+ public:
+  // `library` may be null in which case all delays are estimated with logical
+  // effort. The module and the library must outlive the analysis.
+  static absl::StatusOr<std::unique_ptr<StaticTimingAnalysis>> Create(
+      const rtl::Module* module, const TimingLibrary* library,
+      const StaOptions& options);
+
+  // Re-times the module after the given cells have been edited in place. If
+  // cells have been added to the module the timing graph is rebuilt.
+  absl::Status UpdateCells(absl::Span<const rtl::Cell* const> cells);
+
+  absl::StatusOr<double> GetArrivalTime(rtl::NetRef net) const;
+  absl::StatusOr<double> GetRequiredTime(rtl::NetRef net) const;
+  absl::StatusOr<double> GetSlack(rtl::NetRef net) const;
+
+  // Returns the smallest slack of any endpoint, or infinity if no endpoint is
+  // reachable from a startpoint.
+  double GetWorstSlack() const;
+
+  // Returns the path with the smallest slack.
+  absl::StatusOr<TimingPath> GetCriticalPath() const;
+
+  // Returns the worst path between each pair of startpoint and endpoint which
+  // are connected, sorted by increasing slack.
+  std::vector<TimingPath> GetWorstPathsByRegisterPair() const;
+
+  int64_t node_count() const { return nets_.size(); }
+  int64_t arc_count() const { return arc_from_.size(); }
+  int64_t level_count() const { return level_count_; }
+
+ private:
+  enum class ArcKind : uint8_t {
+    kWire,
+    kLiberty,
+    kLogicalEffort,
+    // The cell has Liberty arcs for the output but none from this input.
+    kDisabled,
+  };
+
+  struct Source {
+    int32_t node;
+    // Null for module inputs.
+    const rtl::Cell* cell;
+    int64_t output_pin;
+    const TimingArc* clock_arc;
+    std::string name;
+  };
+
+  struct Endpoint {
+    int32_t node;
+    // Null for module outputs.
+    const rtl::Cell* cell;
+    int64_t input_pin;
+    const TimingArc* setup_check;
+    std::string name;
+    double required;
+  };
+
+  // A pin of a cell which loads a net; pin -1 is the clock pin.
+  struct Sink {
+    const rtl::Cell* cell;
+    int64_t pin;
+  };
+
+  // Indices of the arcs, sources and endpoints belonging to a cell and the
+  // nodes it loads.
+  struct CellRefs {
+    std::vector<int32_t> arcs;
+    std::vector<int32_t> sources;
+    std::vector<int32_t> endpoints;
+    std::vector<int32_t> loaded_nodes;
+  };
+
+  StaticTimingAnalysis(const rtl::Module* module, const TimingLibrary* library,
+                       const StaOptions& options)
+      : module_(module), library_(library), options_(options) {}
+
+  // Builds the timing graph and computes all arrival and required times.
+  absl::Status Build();
+  void PropagateAll();
+
+  const CellTiming* GetCellTiming(const rtl::Cell* cell) const;
+  void ResolveArc(int32_t arc);
+  void ResolveSource(Source& source);
+  void ResolveEndpoint(Endpoint& endpoint);
+  double ComputeLoad(int32_t node) const;
+
+  double ArcDelay(int32_t arc) const;
+  double ArcTransition(int32_t arc) const;
+  double EndpointRequired(const Endpoint& endpoint) const;
+
+  // Recomputes the arrival and transition time of `node` and the delays of
+  // its fanin arcs, appending the arcs whose delay changed to `changed_arcs`.
+  // Returns whether the arrival or transition time changed.
+  bool UpdateArrival(int32_t node, std::vector<int32_t>* changed_arcs);
+  double ComputeRequired(int32_t node) const;
+
+  // Returns the critical path to `node` by following the fanin arcs with the
+  // latest arrival times.
+  TimingPath TraceCriticalPath(int32_t node) const;
+  std::string StartpointName(int32_t node) const;
+
+  const rtl::Module* module_;
+  const TimingLibrary* library_;
+  StaOptions options_;
+  int64_t cell_count_ = 0;
+  int64_t level_count_ = 0;
+
+  // Per-node data, indexed by levelized node number.
+  std::vector<rtl::NetRef> nets_;
+  absl::flat_hash_map<rtl::NetRef, int32_t> net_to_node_;
+  std::vector<double> arrival_;
+  std::vector<double> transition_;
+  std::vector<double> required_;
+  std::vector<double> load_;
+  // Number of pins (and module outputs) loading each net, used as the
+  // electrical effort of logical effort arcs.
+  std::vector<double> fanout_;
+  // Index into sources_ or -1.
+  std::vector<int32_t> source_;
+  // The fanin arcs of node n are [fanin_begin_[n], fanin_begin_[n + 1]), its
+  // fanout arcs fanout_arcs_[fanout_begin_[n]..fanout_begin_[n + 1]), its
+  // endpoints endpoints_[endpoint_begin_[n]..endpoint_begin_[n + 1]) and its
+  // loads sinks_[sink_begin_[n]..sink_begin_[n + 1]).
+  std::vector<int32_t> fanin_begin_;
+  std::vector<int32_t> fanout_begin_;
+  std::vector<int32_t> fanout_arcs_;
+  std::vector<int32_t> endpoint_begin_;
+  std::vector<int32_t> sink_begin_;
+  std::vector<Sink> sinks_;
+
+  // Per-arc data, sorted by destination node.
+  std::vector<int32_t> arc_from_;
+  std::vector<int32_t> arc_to_;
+  std::vector<double> arc_delay_;
+  std::vector<ArcKind> arc_kind_;
+  std::vector<const TimingArc*> arc_liberty_;
+  std::vector<double> arc_effort_;
+  std::vector<double> arc_parasitic_;
+  // The cell and input/output pin indices of each arc; null for assigns.
+  std::vector<const rtl::Cell*> arc_cell_;
+  std::vector<int32_t> arc_input_pin_;
+  std::vector<int32_t> arc_output_pin_;
+
+  std::vector<Source> sources_;
+  std::vector<Endpoint> endpoints_;
+  absl::flat_hash_map<const rtl::Cell*, CellRefs> cell_refs_;
+
+  // Scratch marks used by UpdateCells; all false between calls.
+  std::vector<bool> queued_;
+};
+
+}  // namespace netlist
+}  // namespace xls
+
+#endif  // XLS_NETLIST_STATIC_TIMING_H_
@@ -0,0 +1,343 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/netlist/static_timing.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/statusor.h"
+#include "xls/common/status/matchers.h"
+#include "xls/netlist/fake_cell_library.h"
+#include "xls/netlist/lib_parser.h"
+#include "xls/netlist/netlist_parser.h"
+
+namespace xls {
+namespace netlist {
+namespace {
+
+using status_testing::IsOkAndHolds;
+using status_testing::StatusIs;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+
+// Delays of INV are 1 + transition + load (rise) and half that (fall), its
+// output transition is 0.5 + load. INV_X4 has four times the input
+// capacitance and a quarter of the load dependence of INV.
+constexpr const char kLiberty[] = R"(library (test) {
+  lu_table_template (delay_template) {
+    variable_1 : input_net_transition;
+    variable_2 : total_output_net_capacitance;
+    index_1 ("0.0, 1.0");
+    index_2 ("0.0, 1.0");
+  }
+  lu_table_template (load_first) {
+    variable_1 : total_output_net_capacitance;
+    variable_2 : input_net_transition;
+    index_1 ("0.0, 2.0");
+    index_2 ("0.0, 1.0");
+  }
+  cell (INV) {
+    pin (A) {
+      direction : input;
+      capacitance : 1.0;
+    }
+    pin (ZN) {
+      direction : output;
+      timing () {
+        related_pin : "A";
+        cell_rise (delay_template) {
+          values ("1.0, 2.0", "2.0, 3.0");
+        }
+        cell_fall (delay_template) {
+          values ("0.5, 1.0", "1.0, 1.5");
+        }
+        rise_transition (delay_template) {
+          values ("0.5, 1.5", "0.5, 1.5");
+        }
+      }
+    }
+  }
+  cell (INV_X4) {
+    pin (A) {
+      direction : input;
+      capacitance : 4.0;
+    }
+    pin (ZN) {
+      direction : output;
+      timing () {
+        related_pin : "A";
+        cell_rise (delay_template) {
+          values ("1.0, 1.25", "2.0, 2.25");
+        }
+        rise_transition (delay_template) {
+          values ("0.5, 0.75", "0.5, 0.75");
+        }
+      }
+    }
+  }
+  cell (AND) {
+    pin (A) {
+      direction : input;
+      capacitance : 1.0;
+    }
+    pin (B) {
+      direction : input;
+      capacitance : 1.0;
+    }
+    pin (Z) {
+      direction : output;
+      timing () {
+        related_pin : "A";
+        cell_rise (load_first) {
+          values ("1.0, 2.0", "3.0, 4.0");
+        }
+      }
+    }
+  }
+})";
+
+absl::StatusOr<TimingLibrary> ParseTimingLibrary() {
+  XLS_ASSIGN_OR_RETURN(cell_lib::CharStream cs,
+                       cell_lib::CharStream::FromText(kLiberty));
+  cell_lib::Scanner scanner(&cs);
+  cell_lib::Parser parser(&scanner, TimingLibrary::GetBlockKinds());
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<cell_lib::Block> block,
+                       parser.ParseLibrary());
+  return TimingLibrary::FromLibertyBlock(*block);
+}
+
+class StaticTimingTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    XLS_ASSERT_OK_AND_ASSIGN(cell_library_, MakeFakeCellLibrary());
+    XLS_ASSERT_OK(cell_library_.AddEntry(CellLibraryEntry(
+        CellKind::kInverter, "INV_X4", std::vector<std::string>{"A"},
+        CellLibraryEntry::OutputPinToFunction{{"ZN", "!A"}}, std::nullopt)));
+  }
+
+  absl::StatusOr<const rtl::Module*> Parse(std::string text) {
+    text_ = std::move(text);
+    rtl::Scanner scanner(text_);
+    XLS_ASSIGN_OR_RETURN(netlist_,
+                         rtl::Parser::ParseNetlist(&cell_library_, &scanner));
+    return netlist_->modules().front().get();
+  }
+
+  CellLibrary cell_library_;
+  std::string text_;
+  std::unique_ptr<rtl::Netlist> netlist_;
+};
+
+TEST(TimingLibraryTest, TableLookup) {
+  XLS_ASSERT_OK_AND_ASSIGN(TimingLibrary library, ParseTimingLibrary());
+  const CellTiming* inv = library.GetCell("INV");
+  ASSERT_NE(inv, nullptr);
+  EXPECT_EQ(library.GetCell("NAND"), nullptr);
+  EXPECT_EQ(inv->pin_capacitances.at("A"), 1.0);
+  const TimingArc* arc = inv->GetCombinationalArc("A", "ZN");
+  ASSERT_NE(arc, nullptr);
+  EXPECT_EQ(inv->GetCombinationalArc("B", "ZN"), nullptr);
+  EXPECT_DOUBLE_EQ(arc->Delay(0.5, 0.25), 1.75);
+  // Outside of the table the values are extrapolated.
+  EXPECT_DOUBLE_EQ(arc->Delay(2.0, 3.0), 6.0);
+  EXPECT_DOUBLE_EQ(arc->Transition(0.0, 2.0).value(), 2.5);
+
+  // Tables with the load as the first variable are transposed.
+  const TimingArc* and_arc = library.GetCell("AND")->GetCombinationalArc(
+      "A", "Z");
+  ASSERT_NE(and_arc, nullptr);
+  EXPECT_DOUBLE_EQ(and_arc->Delay(/*x1=*/0.5, /*x2=*/1.0), 2.5);
+  EXPECT_FALSE(and_arc->Transition(0.5, 1.0).has_value());
+}
+
+TEST_F(StaticTimingTest, LogicalEffortDelays) {
+  XLS_ASSERT_OK_AND_ASSIGN(const rtl::Module* m, Parse(R"(module fo4(i, o);
+  input i;
+  wire i_n;
+  output [3:0] o;
+
+  INV inv_0(.A(i), .ZN(i_n));
+  INV inv_fo0(.A(i_n), .ZN(o[0]));
+  INV inv_fo1(.A(i_n), .ZN(o[1]));
+  INV inv_fo2(.A(i_n), .ZN(o[2]));
+  INV inv_fo3(.A(i_n), .ZN(o[3]));
+endmodule)"));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<StaticTimingAnalysis> sta,
+      StaticTimingAnalysis::Create(m, /*library=*/nullptr,
+                                   StaOptions{.clock_period = 10.0}));
+  EXPECT_EQ(sta->level_count(), 3);
+  // A fanout-of-four inverter has a delay of 5 (Logical Effort example 1.2).
+  EXPECT_THAT(sta->GetArrivalTime(m->ResolveNet("i_n").value()),
+              IsOkAndHolds(5.0));
+  EXPECT_THAT(sta->GetArrivalTime(m->ResolveNet("o[2]").value()),
+              IsOkAndHolds(7.0));
+  EXPECT_THAT(sta->GetRequiredTime(m->ResolveNet("i").value()),
+              IsOkAndHolds(3.0));
+  EXPECT_DOUBLE_EQ(sta->GetWorstSlack(), 3.0);
+}
+
+TEST_F(StaticTimingTest, LibertyDelays) {
+  XLS_ASSERT_OK_AND_ASSIGN(const rtl::Module* m, Parse(R"(module main(a, o);
+  input a;
+  wire n1;
+  output o;
+
+  INV u0(.A(a), .ZN(n1));
+  INV u1(.A(n1), .ZN(o));
+endmodule)"));
+  XLS_ASSERT_OK_AND_ASSIGN(TimingLibrary library, ParseTimingLibrary());
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<StaticTimingAnalysis> sta,
+      StaticTimingAnalysis::Create(
+          m, &library, StaOptions{.clock_period = 10.0, .output_load = 0.5}));
+  // u0 drives a load of 1 with an input transition of 0; its output
+  // transition of 1.5 and the output load of 0.5 determine the delay of u1.
+  EXPECT_THAT(sta->GetArrivalTime(m->ResolveNet("n1").value()),
+              IsOkAndHolds(2.0));
+  EXPECT_THAT(sta->GetArrivalTime(m->ResolveNet("o").value()),
+              IsOkAndHolds(5.0));
+  EXPECT_THAT(sta->GetRequiredTime(m->ResolveNet("n1").value()),
+              IsOkAndHolds(7.0));
+  EXPECT_THAT(sta->GetSlack(m->ResolveNet("a").value()), IsOkAndHolds(5.0));
+
+  XLS_ASSERT_OK_AND_ASSIGN(TimingPath path, sta->GetCriticalPath());
+  EXPECT_EQ(path.startpoint, "a");
+  EXPECT_EQ(path.endpoint, "o");
+  EXPECT_DOUBLE_EQ(path.slack, 5.0);
+  EXPECT_THAT(path.nets, ElementsAre("a", "n1", "o"));
+}
+
+TEST_F(StaticTimingTest, WorstPathsByRegisterPair) {
+  XLS_ASSERT_OK_AND_ASSIGN(const rtl::Module* m,
+                           Parse(R"(module main(clk, a, o);
+  input clk;
+  input a;
+  output o;
+  wire q0, q1, n0, n1;
+
+  DFF r0(.D(a), .Q(q0), .CLK(clk));
+  DFF r1(.D(n0), .Q(q1), .CLK(clk));
+  INV i0(.A(q0), .ZN(n0));
+  NAND g0(.A(q0), .B(q1), .ZN(n1));
+  INV i1(.A(n1), .ZN(o));
+endmodule)"));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<StaticTimingAnalysis> sta,
+      StaticTimingAnalysis::Create(m, /*library=*/nullptr,
+                                   StaOptions{.clock_period = 10.0,
+                                              .flop_clock_to_q = 2.0,
+                                              .flop_setup = 1.0}));
+  std::vector<TimingPath> paths = sta->GetWorstPathsByRegisterPair();
+  ASSERT_EQ(paths.size(), 4);
+  // The registers launch at 2; the NAND has a delay of 4/3 + 2.
+  EXPECT_EQ(paths[0].startpoint, "r0");
+  EXPECT_EQ(paths[0].endpoint, "o");
+  EXPECT_DOUBLE_EQ(paths[0].arrival, 2.0 + 10.0 / 3.0 + 2.0);
+  EXPECT_THAT(paths[0].nets, ElementsAre("q0", "n1", "o"));
+  EXPECT_EQ(paths[1].startpoint, "r1");
+  EXPECT_EQ(paths[1].endpoint, "o");
+  EXPECT_THAT(paths[1].nets, ElementsAre("q1", "n1", "o"));
+  EXPECT_EQ(paths[2].startpoint, "r0");
+  EXPECT_EQ(paths[2].endpoint, "r1");
+  EXPECT_DOUBLE_EQ(paths[2].arrival, 4.0);
+  EXPECT_DOUBLE_EQ(paths[2].required, 9.0);
+  EXPECT_EQ(paths[3].startpoint, "a");
+  EXPECT_EQ(paths[3].endpoint, "r0");
+  EXPECT_DOUBLE_EQ(paths[3].slack, 9.0);
+  EXPECT_DOUBLE_EQ(sta->GetWorstSlack(), paths[0].slack);
+}
+
+TEST_F(StaticTimingTest, IncrementalUpdateMatchesFullAnalysis) {
+  XLS_ASSERT_OK_AND_ASSIGN(const rtl::Module* m,
+                           Parse(R"(module main(a, b, o, p);
+  input a;
+  input b;
+  wire n1, n2, n3;
+  output o;
+  output p;
+
+  INV u0(.A(a), .ZN(n1));
+  INV u1(.A(n1), .ZN(n2));
+  INV u2(.A(n2), .ZN(n3));
+  INV u3(.A(n3), .ZN(o));
+  NAND u4(.A(b), .B(n1), .ZN(p));
+endmodule)"));
+  XLS_ASSERT_OK_AND_ASSIGN(TimingLibrary library, ParseTimingLibrary());
+  StaOptions options{.clock_period = 10.0, .output_load = 2.0};
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<StaticTimingAnalysis> sta,
+                           StaticTimingAnalysis::Create(m, &library, options));
+  XLS_ASSERT_OK_AND_ASSIGN(double old_arrival,
+                           sta->GetArrivalTime(m->ResolveNet("o").value()));
+
+  XLS_ASSERT_OK_AND_ASSIGN(rtl::Cell * u2, m->ResolveCell("u2"));
+  XLS_ASSERT_OK_AND_ASSIGN(const CellLibraryEntry* inv_x4,
+                           cell_library_.GetEntry("INV_X4"));
+  XLS_ASSERT_OK(u2->SetCellLibraryEntry(inv_x4));
+  XLS_ASSERT_OK(sta->UpdateCells({u2}));
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<StaticTimingAnalysis> expected,
+                           StaticTimingAnalysis::Create(m, &library, options));
+  for (const auto& net : m->nets()) {
+    if (net.get() == m->GetDummyRef()) {
+      continue;
+    }
+    EXPECT_EQ(sta->GetArrivalTime(net.get()).value(),
+              expected->GetArrivalTime(net.get()).value())
+        << net->name();
+    EXPECT_EQ(sta->GetRequiredTime(net.get()).value(),
+              expected->GetRequiredTime(net.get()).value())
+        << net->name();
+  }
+  EXPECT_NE(sta->GetArrivalTime(m->ResolveNet("o").value()).value(),
+            old_arrival);
+  EXPECT_EQ(sta->GetWorstSlack(), expected->GetWorstSlack());
+}
+
+TEST_F(StaticTimingTest, SetCellLibraryEntryChecksPinout) {
+  XLS_ASSERT_OK_AND_ASSIGN(const rtl::Module* m, Parse(R"(module main(a, o);
+  input a;
+  output o;
+
+  INV u0(.A(a), .ZN(o));
+endmodule)"));
+  XLS_ASSERT_OK_AND_ASSIGN(rtl::Cell * u0, m->ResolveCell("u0"));
+  XLS_ASSERT_OK_AND_ASSIGN(const CellLibraryEntry* nand,
+                           cell_library_.GetEntry("NAND"));
+  EXPECT_THAT(u0->SetCellLibraryEntry(nand),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("does not match the pinout")));
+}
+
+TEST_F(StaticTimingTest, CombinationalCycle) {
+  XLS_ASSERT_OK_AND_ASSIGN(const rtl::Module* m, Parse(R"(module main(o);
+  output o;
+  wire x;
+
+  INV u0(.A(x), .ZN(o));
+  INV u1(.A(o), .ZN(x));
+endmodule)"));
+  EXPECT_THAT(StaticTimingAnalysis::Create(m, /*library=*/nullptr,
+                                           StaOptions{}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Combinational cycle")));
+}
+
+}  // namespace
+}  // namespace netlist
+}  // namespace xls
@@ -0,0 +1,32 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/passes/analysis_manager.h"
+
+#include <string>
+
+#include "absl/strings/str_format.h"
+
+namespace xls {
+
+std::string AnalysisManager::ToString() const {
+  int64_t cached = 0;
+  for (const auto& [f, analyses] : analyses_) {
+    cached += analyses.size();
+  }
+  return absl::StrFormat("analyses: %d hits, %d misses, %d cached", hit_count_,
+                         miss_count_, cached);
+}
+
+}  // namespace xls
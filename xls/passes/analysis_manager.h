@@ -0,0 +1,111 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_PASSES_ANALYSIS_MANAGER_H_
+#define XLS_PASSES_ANALYSIS_MANAGER_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <typeindex>
+#include <typeinfo>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/function_base.h"
+
+namespace xls {
+
+// Caches analyses of FunctionBases (query engines, post-dominator analyses,
+// etc) across passes so an analysis is only recomputed if the IR changed since
+// it was computed. An analysis is identified by the FunctionBase it analyzes
+// and a name which distinguishes different analyses (or different
+// configurations of the same analysis) of the FunctionBase.
+//
+// The manager is held by PassResults. Caching is enabled by compound passes
+// for the duration of a pipeline run; the passes report every change to the IR
+// which allows the manager to invalidate the analyses of changed
+// FunctionBases (see FunctionBasePass). Outside of a pipeline the IR may be
+// changed behind the manager's back so every request computes the analysis
+// anew.
+class AnalysisManager {
+ public:
+  template <typename T>
+  using Factory = std::function<absl::StatusOr<std::unique_ptr<T>>()>;
+
+  // Returns the analysis `name` of `f`. If no valid analysis is cached the
+  // analysis is created with `factory`. The returned pointer is valid until the
+  // analysis is invalidated or requested again while caching is disabled. The
+  // analysis may be modified by the caller (e.g., repopulated) as long as it
+  // remains valid for the current IR of `f`.
+  template <typename T>
+  absl::StatusOr<T*> GetOrCreate(FunctionBase* f, std::string_view name,
+                                 const Factory<T>& factory) {
+    absl::flat_hash_map<std::string, Entry>& analyses = analyses_[f];
+    if (caching_enabled_) {
+      auto it = analyses.find(name);
+      if (it != analyses.end()) {
+        XLS_CHECK(it->second.type == std::type_index(typeid(T)))
+            << "Analysis " << name << " requested with a different type";
+        ++hit_count_;
+        return static_cast<T*>(it->second.analysis.get());
+      }
+      ++miss_count_;
+    }
+    XLS_ASSIGN_OR_RETURN(std::unique_ptr<T> analysis, factory());
+    T* result = analysis.get();
+    analyses.insert_or_assign(
+        std::string(name),
+        Entry{.analysis = std::shared_ptr<T>(std::move(analysis)),
+              .type = std::type_index(typeid(T))});
+    return result;
+  }
+
+  // Invalidates all analyses of `f`. Must be called whenever `f` changes.
+  void Invalidate(FunctionBase* f) { analyses_.erase(f); }
+
+  // Invalidates all analyses of all FunctionBases.
+  void InvalidateAll() { analyses_.clear(); }
+
+  bool caching_enabled() const { return caching_enabled_; }
+  void set_caching_enabled(bool value) { caching_enabled_ = value; }
+
+  // The number of requests with caching enabled which were served from the
+  // cache and which required computing the analysis.
+  int64_t hit_count() const { return hit_count_; }
+  int64_t miss_count() const { return miss_count_; }
+
+  std::string ToString() const;
+
+ private:
+  struct Entry {
+    std::shared_ptr<void> analysis;
+    std::type_index type;
+  };
+
+  bool caching_enabled_ = false;
+  int64_t hit_count_ = 0;
+  int64_t miss_count_ = 0;
+  absl::flat_hash_map<FunctionBase*, absl::flat_hash_map<std::string, Entry>>
+      analyses_;
+};
+
+}  // namespace xls
+
+#endif  // XLS_PASSES_ANALYSIS_MANAGER_H_
@@ -0,0 +1,154 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/passes/analysis_manager.h"
+
+#include <memory>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/statusor.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/function.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/passes/dce_pass.h"
+#include "xls/passes/passes.h"
+#include "xls/passes/ternary_query_engine.h"
+
+namespace xls {
+namespace {
+
+using status_testing::IsOkAndHolds;
+
+// Pass which requests a ternary query engine for each function and records
+// the engines it receives. Does not change the IR.
+class QueryEngineUserPass : public FunctionBasePass {
+ public:
+  explicit QueryEngineUserPass(std::vector<TernaryQueryEngine*>* engines)
+      : FunctionBasePass("qe_user", "Query engine user"), engines_(engines) {}
+
+ protected:
+  absl::StatusOr<bool> RunOnFunctionBaseInternal(
+      FunctionBase* f, const PassOptions& options,
+      PassResults* results) const override {
+    XLS_ASSIGN_OR_RETURN(
+        TernaryQueryEngine * engine,
+        results->analysis_manager.GetOrCreate<TernaryQueryEngine>(
+            f, "ternary_query_engine",
+            [f]() -> absl::StatusOr<std::unique_ptr<TernaryQueryEngine>> {
+              auto engine = std::make_unique<TernaryQueryEngine>();
+              XLS_RETURN_IF_ERROR(engine->Populate(f).status());
+              return engine;
+            }));
+    engines_->push_back(engine);
+    return false;
+  }
+
+ private:
+  std::vector<TernaryQueryEngine*>* engines_;
+};
+
+class AnalysisManagerTest : public IrTestBase {};
+
+TEST_F(AnalysisManagerTest, CachedUntilFunctionChanges) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
+     fn func(x: bits[8]) -> bits[8] {
+       dead: bits[8] = neg(x)
+       ret not: bits[8] = not(x)
+     }
+  )",
+                                                       p.get()));
+  std::vector<TernaryQueryEngine*> engines;
+  CompoundPass pipeline("pipeline", "Pipeline");
+  pipeline.Add<QueryEngineUserPass>(&engines);
+  pipeline.Add<QueryEngineUserPass>(&engines);
+  pipeline.Add<DeadCodeEliminationPass>();
+  pipeline.Add<QueryEngineUserPass>(&engines);
+  pipeline.Add<DeadCodeEliminationPass>();
+  pipeline.Add<QueryEngineUserPass>(&engines);
+
+  PassResults results;
+  EXPECT_THAT(pipeline.Run(p.get(), PassOptions(), &results),
+              IsOkAndHolds(true));
+  // DCE removed the dead node.
+  EXPECT_EQ(f->node_count(), 2);
+  ASSERT_EQ(engines.size(), 4);
+  // The second request is served from the cache. DCE changes the function so
+  // the third request recomputes the engine. The second DCE does not change
+  // the function so the fourth request is served from the cache.
+  EXPECT_EQ(engines[0], engines[1]);
+  EXPECT_EQ(engines[2], engines[3]);
+  EXPECT_EQ(results.analysis_manager.hit_count(), 2);
+  EXPECT_EQ(results.analysis_manager.miss_count(), 2);
+  // Analyses are not retained after the pipeline completes.
+  EXPECT_FALSE(results.analysis_manager.caching_enabled());
+}
+
+TEST_F(AnalysisManagerTest, OtherFunctionsRemainCached) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK(ParseFunction(R"(
+     fn f(x: bits[8]) -> bits[8] {
+       dead: bits[8] = neg(x)
+       ret not: bits[8] = not(x)
+     }
+  )",
+                              p.get())
+                    .status());
+  XLS_ASSERT_OK(ParseFunction(R"(
+     fn g(x: bits[8]) -> bits[8] {
+       ret not: bits[8] = not(x)
+     }
+  )",
+                              p.get())
+                    .status());
+  std::vector<TernaryQueryEngine*> engines;
+  CompoundPass pipeline("pipeline", "Pipeline");
+  pipeline.Add<QueryEngineUserPass>(&engines);
+  pipeline.Add<DeadCodeEliminationPass>();
+  pipeline.Add<QueryEngineUserPass>(&engines);
+
+  PassResults results;
+  EXPECT_THAT(pipeline.Run(p.get(), PassOptions(), &results),
+              IsOkAndHolds(true));
+  // Only the analysis of `f` which DCE changed is recomputed.
+  EXPECT_EQ(results.analysis_manager.hit_count(), 1);
+  EXPECT_EQ(results.analysis_manager.miss_count(), 3);
+}
+
+TEST_F(AnalysisManagerTest, NotCachedOutsideOfPipeline) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
+     fn func(x: bits[8]) -> bits[8] {
+       ret not: bits[8] = not(x)
+     }
+  )",
+                                                       p.get()));
+  std::vector<TernaryQueryEngine*> engines;
+  QueryEngineUserPass pass(&engines);
+  PassResults results;
+  EXPECT_THAT(pass.RunOnFunctionBase(f, PassOptions(), &results),
+              IsOkAndHolds(false));
+  // The IR may change between passes run outside of a pipeline so each run
+  // recomputes the analysis.
+  EXPECT_THAT(pass.RunOnFunctionBase(f, PassOptions(), &results),
+              IsOkAndHolds(false));
+  EXPECT_EQ(engines.size(), 2);
+  EXPECT_EQ(results.analysis_manager.hit_count(), 0);
+  EXPECT_EQ(results.analysis_manager.miss_count(), 0);
+}
+
+}  // namespace
+}  // namespace xls
@@ -20,6 +20,7 @@
 #include "absl/container/flat_hash_map.h"
 #include "absl/hash/hash.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
 #include "xls/common/logging/log_lines.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/status/ret_check.h"
@@ -29,6 +30,7 @@
 #include "xls/ir/node.h"
 #include "xls/ir/node_iterator.h"
 #include "xls/passes/bdd_function.h"
+#include "xls/passes/bdd_query_engine.h"
 
 namespace xls {
 
@@ -94,8 +96,29 @@ absl::StatusOr<std::vector<Node*>> GetNodeOrder(FunctionBase* f) {
 
 absl::StatusOr<bool> BddCsePass::RunOnFunctionBaseInternal(
     FunctionBase* f, const PassOptions& options, PassResults* results) const {
-  XLS_ASSIGN_OR_RETURN(std::unique_ptr<BddFunction> bdd_function,
-                       BddFunction::Run(f, BddFunction::kDefaultPathLimit));
+  // The BDD of the query engine used by BddSimplificationPass is reused if
+  // the function has not changed since.
+  // Fall back to a smaller BDD if the time budget is running out.
+  int64_t path_limit = BddFunction::kDefaultPathLimit;
+  std::string_view analysis_name = "bdd_query_engine";
+  if (results->budget.ShouldDegrade()) {
+    path_limit = BddFunction::kReducedPathLimit;
+    analysis_name = "reduced_bdd_query_engine";
+    results->budget.RecordOnce(
+        short_name(),
+        absl::StrFormat("%s: reduced BDD path limit to %d starting with %s",
+                        short_name(), path_limit, f->name()));
+  }
+  XLS_ASSIGN_OR_RETURN(
+      BddQueryEngine * query_engine,
+      results->analysis_manager.GetOrCreate<BddQueryEngine>(
+          f, analysis_name,
+          [f, path_limit]() -> absl::StatusOr<std::unique_ptr<BddQueryEngine>> {
+            auto query_engine = std::make_unique<BddQueryEngine>(path_limit);
+            XLS_RETURN_IF_ERROR(query_engine->Populate(f).status());
+            return query_engine;
+          }));
+  const BddFunction* bdd_function = &query_engine->bdd_function();
 
   // To improve efficiency, bucket potentially common nodes together. The
   // bucketing is done via a int64_t hash value of the BDD node indices of each
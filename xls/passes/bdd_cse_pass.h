@@ -30,6 +30,8 @@ class BddCsePass : public FunctionBasePass {
                          "BDD-based Common Subexpression Elimination") {}
   ~BddCsePass() override {}
 
+  bool IsExpensive() const override { return true; }
+
  protected:
   absl::StatusOr<bool> RunOnFunctionBaseInternal(
       FunctionBase* f, const PassOptions& options,
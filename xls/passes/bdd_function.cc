@@ -266,20 +266,68 @@ bool ShouldEvaluate(Node* node) {
 
 /* static */ absl::StatusOr<std::unique_ptr<BddFunction>> BddFunction::Run(
     FunctionBase* f, int64_t path_limit,
-    std::optional<std::function<bool(const Node*)>> node_filter) {
+    std::optional<std::function<bool(const Node*)>> node_filter,
+    const BddVariableOrderOptions& order_options) {
   XLS_VLOG(1) << absl::StreamFormat("BddFunction::Run(%s):", f->name());
   XLS_VLOG_LINES(5, f->DumpIr());
 
   auto bdd_function = absl::WrapUnique(new BddFunction(f));
   SaturatingBddEvaluator evaluator(path_limit, &bdd_function->bdd());
 
+  // Returns true if the given bits-typed node is modeled as new BDD variables
+  // rather than evaluated: we shouldn't evaluate this node, or the node
+  // includes some non-bits-typed operands.
+  auto is_modeled_as_variables = [&](Node* node) {
+    return !ShouldEvaluate(node) ||
+           (node_filter.has_value() && !node_filter.value()(node)) ||
+           std::any_of(node->operands().begin(), node->operands().end(),
+                       [](Node* o) { return !o->GetType()->IsBits(); });
+  };
+
+  // Variables created up front for nodes modeled as variables to interleave
+  // the bits of operands of the same node.
+  absl::flat_hash_map<Node*, SaturatingBddNodeVector> preallocated_variables;
+  if (order_options.interleave_operands) {
+    for (Node* node : TopoSort(f)) {
+      if (!node->GetType()->IsBits() || is_modeled_as_variables(node)) {
+        continue;
+      }
+      std::vector<Node*> operands;
+      int64_t max_width = 0;
+      for (Node* operand : node->operands()) {
+        if (is_modeled_as_variables(operand) &&
+            !preallocated_variables.contains(operand) &&
+            std::find(operands.begin(), operands.end(), operand) ==
+                operands.end()) {
+          operands.push_back(operand);
+          max_width = std::max(max_width, operand->BitCountOrDie());
+        }
+      }
+      if (operands.size() < 2) {
+        continue;
+      }
+      for (int64_t i = 0; i < max_width; ++i) {
+        for (Node* operand : operands) {
+          if (i < operand->BitCountOrDie()) {
+            preallocated_variables[operand].push_back(
+                bdd_function->bdd().NewVariable());
+          }
+        }
+      }
+    }
+  }
+
   // Create and return a vector containing newly defined BDD variables.
   auto create_new_node_vector = [&](Node* n) {
+    bdd_function->saturated_expressions_.insert(n);
+    if (auto it = preallocated_variables.find(n);
+        it != preallocated_variables.end()) {
+      return it->second;
+    }
     SaturatingBddNodeVector v;
     for (int64_t i = 0; i < n->BitCountOrDie(); ++i) {
       v.push_back(bdd_function->bdd().NewVariable());
     }
-    bdd_function->saturated_expressions_.insert(n);
     return v;
   };
 
@@ -292,13 +340,9 @@ bool ShouldEvaluate(Node* node) {
                   << node->GetType()->ToString();
       continue;
     }
-    // If we shouldn't evaluate this node, the node is to be modeled as
-    // variables, or the node includes some non-bits-typed operands, then just
-    // create a vector of new BDD variables for this node.
-    if (!ShouldEvaluate(node) ||
-        (node_filter.has_value() && !node_filter.value()(node)) ||
-        std::any_of(node->operands().begin(), node->operands().end(),
-                    [](Node* o) { return !o->GetType()->IsBits(); })) {
+    // If the node is to be modeled as variables then just create a vector of
+    // new BDD variables for this node.
+    if (is_modeled_as_variables(node)) {
       XLS_VLOG(2) << "  node filtered out.";
       values[node] = create_new_node_vector(node);
     } else {
@@ -329,6 +373,18 @@ bool ShouldEvaluate(Node* node) {
               std::get<BddNodeIndex>(values.at(node)[i]),
               /*minterm_limit=*/15));
     }
+
+    // The expressions of the nodes evaluated so far are the only live BDD
+    // nodes so the BDD can be reordered here.
+    if (order_options.sift && bdd_function->bdd().ShouldSift()) {
+      std::vector<BddNodeIndex> roots;
+      for (const auto& [_, value] : values) {
+        for (const SaturatingBddNodeIndex& bit : value) {
+          roots.push_back(std::get<BddNodeIndex>(bit));
+        }
+      }
+      bdd_function->bdd().Sift(roots);
+    }
   }
 
   // Copy over the vector and BDD variables into the node map which is exposed
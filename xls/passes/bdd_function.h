@@ -28,6 +28,21 @@ namespace xls {
 using BddNodeVector = std::vector<BddNodeIndex>;
 using NodeMap = absl::flat_hash_map<const Node*, BddNodeVector>;
 
+// Options controlling the order of the BDD variables created by BddFunction.
+struct BddVariableOrderOptions {
+  // Interleave the variables of the bits of operands which are combined by the
+  // same node. For example, for `and(x, y)` where `x` and `y` are modeled as
+  // variables the order is x0, y0, x1, y1, ... rather than x0, x1, ..., y0,
+  // y1, ... For example, equality comparisons have BDDs linear in the width
+  // of the operands under the interleaved order. The effect on the BDDs of
+  // whole designs has not been measured yet (see bdd_stats).
+  bool interleave_operands = false;
+
+  // Reorder the variables with sifting whenever the BDD has grown enough (see
+  // BinaryDecisionDiagram::ShouldSift).
+  bool sift = false;
+};
+
 // A class which represents an XLS function using a binary decision diagram
 // (BDD). The BDD is constructed by an abstract evaluation of the operations in
 // the function using compositions of the And/Or/Not functions of the BDD. Only
@@ -48,6 +63,10 @@ class BddFunction {
   // variable. This provides a mechanism for limiting the growth of the BDD.
   static constexpr int64_t kDefaultPathLimit = 16 * 1024;
 
+  // The path limit used by passes in place of kDefaultPathLimit once the time
+  // budget of the pass pipeline is running out (see PassBudget).
+  static constexpr int64_t kReducedPathLimit = 1024;
+
   // Construct a BDD representing the given function/proc.
   // `node_filter` is an optional function which filters the nodes to be
   // evaluated. If this function returns false for a node then the node will not
@@ -58,7 +77,8 @@ class BddFunction {
   static absl::StatusOr<std::unique_ptr<BddFunction>> Run(
       FunctionBase* f, int64_t path_limit = 0,
       std::optional<std::function<bool(const Node*)>> node_filter =
-          absl::nullopt);
+          absl::nullopt,
+      const BddVariableOrderOptions& order_options = {});
 
   // Returns the underlying BDD.
   const BinaryDecisionDiagram& bdd() const { return bdd_; }
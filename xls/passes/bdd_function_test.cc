@@ -147,5 +147,38 @@ TEST_F(BddFunctionTest, BenchmarkTest) {
   }
 }
 
+TEST_F(BddFunctionTest, InterleavedVariableOrder) {
+  // Equality of two values computed bit-wise. With the bits of `x` ordered
+  // before the bits of `y` the BDD is exponential in the bit width.
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  Type* t = p->GetBitsType(12);
+  BValue x = fb.Param("x", t);
+  BValue y = fb.Param("y", t);
+  fb.Concat({fb.Not(fb.OrReduce(fb.Xor(x, y))), fb.And(x, y)});
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<BddFunction> default_order,
+                           BddFunction::Run(f));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<BddFunction> interleaved,
+      BddFunction::Run(f, /*path_limit=*/0, /*node_filter=*/std::nullopt,
+                       BddVariableOrderOptions{.interleave_operands = true,
+                                               .sift = true}));
+  EXPECT_GT(default_order->bdd().size(), 1 << 12);
+  EXPECT_LT(interleaved->bdd().size(), 256);
+
+  std::minstd_rand engine;
+  for (int64_t i = 0; i < 100; ++i) {
+    std::vector<Value> inputs = RandomFunctionArguments(f, &engine);
+    if (i % 2 == 0) {
+      inputs[1] = inputs[0];
+    }
+    XLS_ASSERT_OK_AND_ASSIGN(
+        Value expected, DropInterpreterEvents(InterpretFunction(f, inputs)));
+    EXPECT_THAT(interleaved->Evaluate(inputs), IsOkAndHolds(expected));
+  }
+}
+
 }  // namespace
 }  // namespace xls
@@ -21,6 +21,7 @@
 
 #include "absl/container/inlined_vector.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
 #include "absl/types/optional.h"
 #include "xls/common/logging/log_lines.h"
 #include "xls/common/logging/logging.h"
@@ -327,8 +328,27 @@ absl::StatusOr<bool> SimplifyNode(Node* node, const QueryEngine& query_engine,
 
 absl::StatusOr<bool> BddSimplificationPass::RunOnFunctionBaseInternal(
     FunctionBase* f, const PassOptions& options, PassResults* results) const {
-  BddQueryEngine query_engine(BddFunction::kDefaultPathLimit);
-  XLS_RETURN_IF_ERROR(query_engine.Populate(f).status());
+  // Fall back to a smaller BDD if the time budget is running out.
+  int64_t path_limit = BddFunction::kDefaultPathLimit;
+  std::string_view analysis_name = "bdd_query_engine";
+  if (results->budget.ShouldDegrade()) {
+    path_limit = BddFunction::kReducedPathLimit;
+    analysis_name = "reduced_bdd_query_engine";
+    results->budget.RecordOnce(
+        short_name(),
+        absl::StrFormat("%s: reduced BDD path limit to %d starting with %s",
+                        short_name(), path_limit, f->name()));
+  }
+  XLS_ASSIGN_OR_RETURN(
+      BddQueryEngine * cached_query_engine,
+      results->analysis_manager.GetOrCreate<BddQueryEngine>(
+          f, analysis_name,
+          [f, path_limit]() -> absl::StatusOr<std::unique_ptr<BddQueryEngine>> {
+            auto query_engine = std::make_unique<BddQueryEngine>(path_limit);
+            XLS_RETURN_IF_ERROR(query_engine->Populate(f).status());
+            return query_engine;
+          }));
+  const BddQueryEngine& query_engine = *cached_query_engine;
 
   bool modified = false;
   for (Node* node : TopoSort(f)) {
@@ -14,9 +14,13 @@
 
 #include "xls/passes/bdd_simplification_pass.h"
 
+#include <string_view>
+#include <vector>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/status/statusor.h"
+#include "absl/time/time.h"
 #include "xls/common/status/matchers.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/ir/bits.h"
@@ -34,6 +38,8 @@ namespace xls {
 namespace {
 
 using status_testing::IsOkAndHolds;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
 
 class BddSimplificationPassTest : public IrTestBase {
  protected:
@@ -482,5 +488,34 @@ TEST_F(BddSimplificationPassTest,
               m::Param("input"));
 }
 
+TEST_F(BddSimplificationPassTest, DegradedBudgetIsRecordedOncePerPass) {
+  auto p = CreatePackage();
+  std::vector<Function*> functions;
+  for (std::string_view name : {"f", "g"}) {
+    FunctionBuilder fb(name, p.get());
+    BValue x = fb.Param("x", p->GetBitsType(4));
+    fb.And(x, fb.Not(x));
+    XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+    functions.push_back(f);
+  }
+
+  // With the budget spent the passes degrade on every function they are run
+  // on, but each pass is only recorded once.
+  PassResults results;
+  results.budget = PassBudget(absl::ZeroDuration());
+  for (int64_t i = 0; i < 3; ++i) {
+    for (Function* f : functions) {
+      XLS_ASSERT_OK(BddSimplificationPass(kMaxOptLevel)
+                        .RunOnFunctionBase(f, PassOptions(), &results)
+                        .status());
+      XLS_ASSERT_OK(
+          BddCsePass().RunOnFunctionBase(f, PassOptions(), &results).status());
+    }
+  }
+  EXPECT_THAT(results.budget.report(),
+              ElementsAre(HasSubstr("bdd_simp: reduced BDD path limit"),
+                          HasSubstr("bdd_cse: reduced BDD path limit")));
+}
+
 }  // namespace
 }  // namespace xls
@@ -0,0 +1,274 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/passes/carry_save_compression_pass.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_join.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/delay_model/delay_estimator.h"
+#include "xls/delay_model/delay_estimators.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/bits_ops.h"
+#include "xls/ir/node.h"
+#include "xls/ir/node_iterator.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/op.h"
+#include "xls/ir/value.h"
+
+namespace xls {
+
+namespace {
+
+// Returns an estimate of the delay of the given node. As in BddCsePass, nodes
+// without a delay model are assumed to take no time.
+int64_t GetNodeDelay(Node* node) {
+  absl::StatusOr<int64_t> delay =
+      GetStandardDelayEstimator().GetOperationDelayInPs(node);
+  return delay.ok() ? delay.value() : 0;
+}
+
+// Returns the estimated time at which the value of `node` becomes available
+// and records it in `arrival`. The operands of `node` must already be present
+// in `arrival`.
+int64_t RecordArrival(Node* node,
+                      absl::flat_hash_map<Node*, int64_t>* arrival) {
+  int64_t start = 0;
+  for (Node* operand : node->operands()) {
+    start = std::max(start, arrival->at(operand));
+  }
+  int64_t time = start + GetNodeDelay(node);
+  (*arrival)[node] = time;
+  return time;
+}
+
+// Returns true if the node is an add or subtract whose operands have the same
+// type as the result.
+bool IsAddOrSub(Node* node) {
+  if (node->op() != Op::kAdd && node->op() != Op::kSub) {
+    return false;
+  }
+  return std::all_of(
+      node->operands().begin(), node->operands().end(),
+      [node](Node* o) { return o->GetType() == node->GetType(); });
+}
+
+struct AddSubLeaf {
+  bool negated;
+  Node* node;
+};
+
+// Walks the tree of adds and subtracts rooted at `node` and gathers its
+// leaves. Interior nodes other than the root must have a single use so that
+// the tree can be replaced as a whole without duplicating logic.
+absl::Status GatherAddends(Node* node, bool negated, bool is_root,
+                           std::vector<AddSubLeaf>* leaves,
+                           std::vector<Node*>* interior_nodes) {
+  if (!IsAddOrSub(node) ||
+      (!is_root && (node->users().size() != 1 ||
+                    node->function_base()->HasImplicitUse(node)))) {
+    leaves->push_back(AddSubLeaf{negated, node});
+    return absl::OkStatus();
+  }
+  interior_nodes->push_back(node);
+  XLS_RET_CHECK_EQ(node->operand_count(), 2);
+  for (int64_t operand_no = 0; operand_no < 2; ++operand_no) {
+    bool negated_next =
+        (operand_no == 1 && node->op() == Op::kSub) ? !negated : negated;
+    XLS_RETURN_IF_ERROR(GatherAddends(node->operand(operand_no), negated_next,
+                                      /*is_root=*/false, leaves,
+                                      interior_nodes));
+  }
+  return absl::OkStatus();
+}
+
+struct Addend {
+  Node* node;
+  int64_t arrival;
+};
+
+// Reduces the three addends `a`, `b` and `c` to a sum and a carry with a full
+// adder in each bit position. The carry is already shifted into place and is
+// omitted if the addends are a single bit wide.
+absl::StatusOr<std::vector<Addend>> Compress(
+    const SourceInfo& loc, const Addend& a, const Addend& b, const Addend& c,
+    absl::flat_hash_map<Node*, int64_t>* arrival) {
+  FunctionBase* f = a.node->function_base();
+  XLS_ASSIGN_OR_RETURN(
+      Node * a_xor_b,
+      f->MakeNode<NaryOp>(loc, std::vector<Node*>{a.node, b.node}, Op::kXor));
+  RecordArrival(a_xor_b, arrival);
+  XLS_ASSIGN_OR_RETURN(
+      Node * sum,
+      f->MakeNode<NaryOp>(loc, std::vector<Node*>{a_xor_b, c.node}, Op::kXor));
+  std::vector<Addend> result = {Addend{sum, RecordArrival(sum, arrival)}};
+
+  int64_t width = sum->BitCountOrDie();
+  if (width == 1) {
+    return result;
+  }
+  XLS_ASSIGN_OR_RETURN(
+      Node * generate,
+      f->MakeNode<NaryOp>(loc, std::vector<Node*>{a.node, b.node}, Op::kAnd));
+  RecordArrival(generate, arrival);
+  XLS_ASSIGN_OR_RETURN(
+      Node * propagate,
+      f->MakeNode<NaryOp>(loc, std::vector<Node*>{a_xor_b, c.node}, Op::kAnd));
+  RecordArrival(propagate, arrival);
+  XLS_ASSIGN_OR_RETURN(
+      Node * carry,
+      f->MakeNode<NaryOp>(loc, std::vector<Node*>{generate, propagate},
+                          Op::kOr));
+  RecordArrival(carry, arrival);
+  XLS_ASSIGN_OR_RETURN(Node * carry_low,
+                       f->MakeNode<BitSlice>(loc, carry, /*start=*/0,
+                                             /*width=*/width - 1));
+  RecordArrival(carry_low, arrival);
+  XLS_ASSIGN_OR_RETURN(Node * zero,
+                       f->MakeNode<Literal>(loc, Value(UBits(0, 1))));
+  RecordArrival(zero, arrival);
+  XLS_ASSIGN_OR_RETURN(
+      Node * shifted_carry,
+      f->MakeNode<Concat>(loc, std::vector<Node*>{carry_low, zero}));
+  result.push_back(
+      Addend{shifted_carry, RecordArrival(shifted_carry, arrival)});
+  return result;
+}
+
+// Returns a node equal to the sum of `addends`, built as a tree of carry-save
+// compressors and a single final adder.
+absl::StatusOr<Node*> CreateCompressedSum(
+    const SourceInfo& loc, std::vector<Addend> addends,
+    absl::flat_hash_map<Node*, int64_t>* arrival) {
+  XLS_RET_CHECK(!addends.empty());
+  auto earlier = [](const Addend& a, const Addend& b) {
+    return a.arrival < b.arrival ||
+           (a.arrival == b.arrival && a.node->id() < b.node->id());
+  };
+  while (addends.size() > 2) {
+    std::sort(addends.begin(), addends.end(), earlier);
+    XLS_ASSIGN_OR_RETURN(
+        std::vector<Addend> compressed,
+        Compress(loc, addends[0], addends[1], addends[2], arrival));
+    addends.erase(addends.begin(), addends.begin() + 3);
+    addends.insert(addends.end(), compressed.begin(), compressed.end());
+  }
+  if (addends.size() == 1) {
+    return addends.front().node;
+  }
+  return addends[0].node->function_base()->MakeNode<BinOp>(
+      loc, addends[0].node, addends[1].node, Op::kAdd);
+}
+
+}  // namespace
+
+absl::StatusOr<bool> CarrySaveCompressionPass::RunOnFunctionBaseInternal(
+    FunctionBase* f, const PassOptions& options, PassResults* results) const {
+  if (!options.carry_save_compression) {
+    return false;
+  }
+  absl::flat_hash_map<Node*, int64_t> arrival;
+  for (Node* node : TopoSort(f)) {
+    RecordArrival(node, &arrival);
+  }
+
+  bool changed = false;
+  // Nodes which are interior to an already considered tree.
+  absl::flat_hash_set<Node*> visited_nodes;
+  // Visit roots before the trees feeding them so every tree is maximal.
+  for (Node* node : ReverseTopoSort(f)) {
+    if (visited_nodes.contains(node) || !IsAddOrSub(node) ||
+        node->BitCountOrDie() == 0) {
+      continue;
+    }
+
+    std::vector<AddSubLeaf> leaves;
+    std::vector<Node*> interior_nodes;
+    XLS_RETURN_IF_ERROR(GatherAddends(node, /*negated=*/false,
+                                      /*is_root=*/true, &leaves,
+                                      &interior_nodes));
+    visited_nodes.insert(interior_nodes.begin(), interior_nodes.end());
+
+    // Literal terms are folded into a single constant, and `-x` is added as
+    // `~x + 1`.
+    int64_t width = node->BitCountOrDie();
+    Bits constant(width);
+    int64_t term_count = 0;
+    for (const AddSubLeaf& leaf : leaves) {
+      if (leaf.node->Is<Literal>()) {
+        const Bits& value = leaf.node->As<Literal>()->value().bits();
+        constant = bits_ops::Add(
+            constant, leaf.negated ? bits_ops::Negate(value) : value);
+        continue;
+      }
+      if (leaf.negated) {
+        constant = bits_ops::Add(constant, UBits(1, width));
+      }
+      ++term_count;
+    }
+    if (!constant.IsZero()) {
+      ++term_count;
+    }
+    // A single add or subtract is already a single carry-propagate adder.
+    if (interior_nodes.size() < 2 || term_count < 3) {
+      continue;
+    }
+
+    std::vector<Addend> addends;
+    for (const AddSubLeaf& leaf : leaves) {
+      if (leaf.node->Is<Literal>()) {
+        continue;
+      }
+      Node* term = leaf.node;
+      if (leaf.negated) {
+        XLS_ASSIGN_OR_RETURN(term,
+                             f->MakeNode<UnOp>(node->loc(), term, Op::kNot));
+        RecordArrival(term, &arrival);
+      }
+      addends.push_back(Addend{term, arrival.at(term)});
+    }
+    if (!constant.IsZero()) {
+      XLS_ASSIGN_OR_RETURN(Node * literal,
+                           f->MakeNode<Literal>(node->loc(), Value(constant)));
+      addends.push_back(Addend{literal, RecordArrival(literal, &arrival)});
+    }
+
+    if (XLS_VLOG_IS_ON(3)) {
+      std::vector<std::string> names;
+      for (const Addend& addend : addends) {
+        names.push_back(addend.node->GetName());
+      }
+      XLS_VLOG(3) << "Compressing " << node->GetName() << " = "
+                  << absl::StrJoin(names, " + ");
+    }
+    XLS_ASSIGN_OR_RETURN(
+        Node * replacement,
+        CreateCompressedSum(node->loc(), std::move(addends), &arrival));
+    RecordArrival(replacement, &arrival);
+    XLS_RETURN_IF_ERROR(node->ReplaceUsesWith(replacement));
+    changed = true;
+  }
+  return changed;
+}
+
+}  // namespace xls
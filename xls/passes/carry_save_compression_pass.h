@@ -0,0 +1,65 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_PASSES_CARRY_SAVE_COMPRESSION_PASS_H_
+#define XLS_PASSES_CARRY_SAVE_COMPRESSION_PASS_H_
+
+#include "absl/status/statusor.h"
+#include "xls/ir/function_base.h"
+#include "xls/passes/passes.h"
+
+namespace xls {
+
+// Pass which rewrites expression trees of three or more addends into a tree of
+// carry-save (3:2) compressors followed by a single carry-propagate adder. For
+// example:
+//
+//   a + b + c + d
+//
+// is a chain of three adders each of which propagates a carry across the full
+// width. After this pass it becomes two compressors, each built from bitwise
+// xor/and/or operations, and one adder:
+//
+//   (s0, c0) = csa(a, b, c)
+//   (s1, c1) = csa(s0, c0 << 1, d)
+//   result   = s1 + (c1 << 1)
+//
+// The addends are the leaves of trees of adds and subtracts in which every
+// interior node has a single use; subtracted terms are added as their one's
+// complement plus one. The partial products of umulp/smulp operations are
+// addends like any other, so a multiply-accumulate of partial products is
+// reduced by the same compressor tree. Compressors are formed from the three
+// addends which become available earliest (as estimated by the standard delay
+// model) so late-arriving addends pass through as few compressors as possible.
+//
+// Because the compressors are plain bitwise operations the delay model prices
+// each of them at a few gate delays rather than a full carry chain, so the
+// scheduler sees the shorter critical path. The pass runs late in the pipeline
+// as it hides the arithmetic structure from the other passes. It only runs if
+// PassOptions::carry_save_compression is set.
+class CarrySaveCompressionPass : public FunctionBasePass {
+ public:
+  CarrySaveCompressionPass()
+      : FunctionBasePass("carry_save", "Carry-save compression") {}
+  ~CarrySaveCompressionPass() override {}
+
+ protected:
+  absl::StatusOr<bool> RunOnFunctionBaseInternal(
+      FunctionBase* f, const PassOptions& options,
+      PassResults* results) const override;
+};
+
+}  // namespace xls
+
+#endif  // XLS_PASSES_CARRY_SAVE_COMPRESSION_PASS_H_
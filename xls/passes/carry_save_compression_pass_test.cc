@@ -0,0 +1,199 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/passes/carry_save_compression_pass.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "xls/common/status/matchers.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/interpreter/function_interpreter.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/function.h"
+#include "xls/ir/ir_matcher.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/value.h"
+#include "xls/passes/dce_pass.h"
+
+namespace xls {
+namespace {
+
+using status_testing::IsOkAndHolds;
+namespace m = ::xls::op_matchers;
+
+class CarrySaveCompressionPassTest : public IrTestBase {
+ protected:
+  CarrySaveCompressionPassTest() = default;
+
+  absl::StatusOr<bool> Run(Function* f) {
+    PassResults results;
+    PassOptions options;
+    options.carry_save_compression = true;
+    XLS_ASSIGN_OR_RETURN(bool changed,
+                         CarrySaveCompressionPass().RunOnFunctionBase(
+                             f, options, &results));
+    XLS_RETURN_IF_ERROR(DeadCodeEliminationPass()
+                            .RunOnFunctionBase(f, PassOptions(), &results)
+                            .status());
+    return changed;
+  }
+
+  // Evaluates `f` on each of the given argument lists.
+  absl::StatusOr<std::vector<Value>> Evaluate(
+      Function* f, absl::Span<const std::vector<Value>> args_set) {
+    std::vector<Value> results;
+    for (const std::vector<Value>& args : args_set) {
+      XLS_ASSIGN_OR_RETURN(Value result,
+                           DropInterpreterEvents(InterpretFunction(f, args)));
+      results.push_back(result);
+    }
+    return results;
+  }
+
+  // Runs the pass on `f` and checks that it changed the function without
+  // changing its results on `args_set`.
+  void RunAndExpectEquivalent(Function* f,
+                              absl::Span<const std::vector<Value>> args_set) {
+    XLS_ASSERT_OK_AND_ASSIGN(std::vector<Value> expected,
+                             Evaluate(f, args_set));
+    EXPECT_THAT(Run(f), IsOkAndHolds(true));
+    XLS_ASSERT_OK_AND_ASSIGN(std::vector<Value> actual, Evaluate(f, args_set));
+    EXPECT_EQ(actual, expected);
+  }
+};
+
+int64_t NumberOfOp(FunctionBase* f, Op op) {
+  int64_t result = 0;
+  for (Node* node : f->nodes()) {
+    if (node->op() == op) {
+      ++result;
+    }
+  }
+  return result;
+}
+
+std::vector<Value> Args(absl::Span<const uint64_t> values, int64_t width) {
+  std::vector<Value> args;
+  for (uint64_t value : values) {
+    args.push_back(Value(UBits(value, width)));
+  }
+  return args;
+}
+
+TEST_F(CarrySaveCompressionPassTest, FourOperandSum) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
+     fn f(a: bits[16], b: bits[16], c: bits[16], d: bits[16]) -> bits[16] {
+       add.1: bits[16] = add(a, b)
+       add.2: bits[16] = add(add.1, c)
+       ret add.3: bits[16] = add(add.2, d)
+     }
+  )",
+                                                       p.get()));
+  RunAndExpectEquivalent(f, {Args({0, 0, 0, 0}, 16),
+                             Args({1, 2, 3, 4}, 16),
+                             Args({0xffff, 0xffff, 0xffff, 0xffff}, 16),
+                             Args({0x8000, 0x7fff, 0x1234, 0xfedc}, 16),
+                             Args({0xaaaa, 0x5555, 0xaaaa, 0x5555}, 16)});
+  EXPECT_EQ(NumberOfOp(f, Op::kAdd), 1);
+  EXPECT_THAT(f->return_value(),
+              m::Add(m::Xor(), m::Concat(m::BitSlice(), m::Literal(0))));
+}
+
+TEST_F(CarrySaveCompressionPassTest, SubtractsAndLiterals) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
+     fn f(a: bits[8], b: bits[8], c: bits[8]) -> bits[8] {
+       literal.1: bits[8] = literal(value=5)
+       sub.2: bits[8] = sub(a, b)
+       add.3: bits[8] = add(sub.2, literal.1)
+       ret sub.4: bits[8] = sub(add.3, c)
+     }
+  )",
+                                                       p.get()));
+  RunAndExpectEquivalent(f, {Args({0, 0, 0}, 8), Args({1, 2, 3}, 8),
+                             Args({0xff, 0x01, 0x80}, 8),
+                             Args({0x10, 0xff, 0xff}, 8)});
+  EXPECT_EQ(NumberOfOp(f, Op::kAdd), 1);
+  EXPECT_EQ(NumberOfOp(f, Op::kSub), 0);
+}
+
+TEST_F(CarrySaveCompressionPassTest, PartialProducts) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
+     fn f(a: bits[8], b: bits[8], acc: bits[16]) -> bits[16] {
+       umulp.1: (bits[16], bits[16]) = umulp(a, b)
+       tuple_index.2: bits[16] = tuple_index(umulp.1, index=0)
+       tuple_index.3: bits[16] = tuple_index(umulp.1, index=1)
+       add.4: bits[16] = add(tuple_index.2, tuple_index.3)
+       ret add.5: bits[16] = add(add.4, acc)
+     }
+  )",
+                                                       p.get()));
+  std::vector<std::vector<Value>> args_set = {
+      {Value(UBits(3, 8)), Value(UBits(7, 8)), Value(UBits(100, 16))},
+      {Value(UBits(255, 8)), Value(UBits(255, 8)), Value(UBits(0xffff, 16))}};
+  RunAndExpectEquivalent(f, args_set);
+  EXPECT_EQ(NumberOfOp(f, Op::kAdd), 1);
+  EXPECT_EQ(NumberOfOp(f, Op::kUMulp), 1);
+}
+
+TEST_F(CarrySaveCompressionPassTest, SingleBitSum) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
+     fn f(a: bits[1], b: bits[1], c: bits[1]) -> bits[1] {
+       add.1: bits[1] = add(a, b)
+       ret add.2: bits[1] = add(add.1, c)
+     }
+  )",
+                                                       p.get()));
+  RunAndExpectEquivalent(f, {Args({0, 0, 0}, 1), Args({1, 0, 0}, 1),
+                             Args({1, 1, 0}, 1), Args({1, 1, 1}, 1)});
+  EXPECT_EQ(NumberOfOp(f, Op::kAdd), 0);
+}
+
+TEST_F(CarrySaveCompressionPassTest, SingleAdderUnchanged) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
+     fn f(a: bits[32], b: bits[32]) -> bits[32] {
+       ret sub.1: bits[32] = sub(a, b)
+     }
+  )",
+                                                       p.get()));
+  EXPECT_THAT(Run(f), IsOkAndHolds(false));
+}
+
+TEST_F(CarrySaveCompressionPassTest, SharedPartialSumIsALeaf) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
+     fn f(a: bits[32], b: bits[32], c: bits[32]) -> (bits[32], bits[32]) {
+       add.1: bits[32] = add(a, b)
+       add.2: bits[32] = add(add.1, c)
+       ret tuple.3: (bits[32], bits[32]) = tuple(add.1, add.2)
+     }
+  )",
+                                                       p.get()));
+  // Compressing add.2 would duplicate add.1, which is used elsewhere.
+  EXPECT_THAT(Run(f), IsOkAndHolds(false));
+  EXPECT_EQ(NumberOfOp(f, Op::kAdd), 2);
+}
+
+}  // namespace
+}  // namespace xls
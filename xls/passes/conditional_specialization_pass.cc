@@ -258,11 +258,30 @@ Node* GetSelectedCase(Select* select, const Bits& selector_value) {
 
 absl::StatusOr<bool> ConditionalSpecializationPass::RunOnFunctionBaseInternal(
     FunctionBase* f, const PassOptions& options, PassResults* results) const {
-  std::unique_ptr<BddQueryEngine> query_engine;
+  BddQueryEngine* query_engine = nullptr;
   if (use_bdd_) {
-    query_engine = std::make_unique<BddQueryEngine>(
-        BddFunction::kDefaultPathLimit, IsCheapForBdds);
-    XLS_RETURN_IF_ERROR(query_engine->Populate(f).status());
+    // Fall back to a smaller BDD if the time budget is running out.
+    int64_t path_limit = BddFunction::kDefaultPathLimit;
+    std::string_view analysis_name = "cheap_bdd_query_engine";
+    if (results->budget.ShouldDegrade()) {
+      path_limit = BddFunction::kReducedPathLimit;
+      analysis_name = "reduced_cheap_bdd_query_engine";
+      results->budget.RecordOnce(
+          short_name(),
+          absl::StrFormat("%s: reduced BDD path limit to %d starting with %s",
+                          short_name(), path_limit, f->name()));
+    }
+    XLS_ASSIGN_OR_RETURN(
+        query_engine,
+        results->analysis_manager.GetOrCreate<BddQueryEngine>(
+            f, analysis_name,
+            [f, path_limit]()
+                -> absl::StatusOr<std::unique_ptr<BddQueryEngine>> {
+              auto query_engine = std::make_unique<BddQueryEngine>(
+                  path_limit, IsCheapForBdds);
+              XLS_RETURN_IF_ERROR(query_engine->Populate(f).status());
+              return query_engine;
+            }));
   }
 
   ConditionMap condition_map(f);
@@ -335,7 +354,7 @@ absl::StatusOr<bool> ConditionalSpecializationPass::RunOnFunctionBaseInternal(
       // First check to see if the condition set directly implies a value for
       // the operand. If so replace with the implied value.
       if (std::optional<Bits> implied_value =
-              ImpliedNodeValue(edge_set, operand, query_engine.get());
+              ImpliedNodeValue(edge_set, operand, query_engine);
           implied_value.has_value()) {
         XLS_VLOG(3) << absl::StreamFormat("Replacing operand %d of %s with %s",
                                           operand_no, node->GetName(),
@@ -376,7 +395,7 @@ absl::StatusOr<bool> ConditionalSpecializationPass::RunOnFunctionBaseInternal(
             break;
           }
           std::optional<Bits> implied_selector = ImpliedNodeValue(
-              edge_set, select->selector(), query_engine.get());
+              edge_set, select->selector(), query_engine);
           if (!implied_selector.has_value()) {
             break;
           }
@@ -32,6 +32,8 @@ class ConditionalSpecializationPass : public FunctionBasePass {
         use_bdd_(use_bdd) {}
   ~ConditionalSpecializationPass() override {}
 
+  bool IsExpensive() const override { return use_bdd_; }
+
  protected:
   bool use_bdd_;
   absl::StatusOr<bool> RunOnFunctionBaseInternal(
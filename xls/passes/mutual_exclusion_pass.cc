@@ -785,6 +785,12 @@ absl::Status AddSelectPredicates(Predicates* p, FunctionBase* f) {
 }
 
 absl::Status ComputeMutualExclusion(Predicates* p, FunctionBase* f) {
+  return ComputeMutualExclusion(p, f, IsHeavyOp);
+}
+
+absl::Status ComputeMutualExclusion(
+    Predicates* p, FunctionBase* f,
+    absl::FunctionRef<bool(Op)> is_relevant_op) {
   if (f->IsBlock()) {
     return absl::OkStatus();
   }
@@ -838,7 +844,7 @@ absl::Status ComputeMutualExclusion(Predicates* p, FunctionBase* f) {
   {
     std::vector<Node*> irrelevant;
     for (const auto& [pred, ops] : ops_for_pred) {
-      if (!std::any_of(ops.begin(), ops.end(), IsHeavyOp)) {
+      if (!std::any_of(ops.begin(), ops.end(), is_relevant_op)) {
         irrelevant.push_back(pred);
       }
     }
@@ -15,8 +15,10 @@
 #ifndef XLS_PASSES_MUTUAL_EXCLUSION_PASS_H_
 #define XLS_PASSES_MUTUAL_EXCLUSION_PASS_H_
 
+#include "absl/functional/function_ref.h"
 #include "absl/status/statusor.h"
 #include "xls/ir/function.h"
+#include "xls/ir/op.h"
 #include "xls/passes/passes.h"
 
 namespace xls {
@@ -99,6 +101,12 @@ absl::Status AddSelectPredicates(Predicates* p, FunctionBase* f);
 // whether nodes are used in a mutually exclusive way.
 absl::Status ComputeMutualExclusion(Predicates* p, FunctionBase* f);
 
+// As above, but only pairs of predicates which both predicate operations of a
+// kind for which `is_relevant_op` returns true are analyzed.
+absl::Status ComputeMutualExclusion(
+    Predicates* p, FunctionBase* f,
+    absl::FunctionRef<bool(Op)> is_relevant_op);
+
 // Pass which merges together nodes that are determined to be mutually exclusive
 // via SMT solver analysis.
 class MutualExclusionPass : public FunctionBasePass {
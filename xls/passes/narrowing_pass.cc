@@ -15,6 +15,7 @@
 #include "xls/passes/narrowing_pass.h"
 
 #include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/math_util.h"
 #include "xls/common/status/ret_check.h"
@@ -907,32 +908,58 @@ absl::StatusOr<bool> MaybeReplacePreciseWithLiteral(
   return true;
 }
 
-static absl::StatusOr<std::unique_ptr<QueryEngine>> GetQueryEngine(
-    FunctionBase* f, bool use_range_analysis) {
-  std::unique_ptr<QueryEngine> query_engine;
-  if (use_range_analysis) {
-    auto ternary_query_engine = std::make_unique<TernaryQueryEngine>();
-    auto range_query_engine = std::make_unique<RangeQueryEngine>();
+// Returns a query engine for `f` combining ternary and range analysis.
+static absl::StatusOr<std::unique_ptr<QueryEngine>> CreateRangeQueryEngine(
+    FunctionBase* f) {
+  auto ternary_query_engine = std::make_unique<TernaryQueryEngine>();
+  auto range_query_engine = std::make_unique<RangeQueryEngine>();
 
-    if (XLS_VLOG_IS_ON(3)) {
-      RangeAnalysisLog(f, *ternary_query_engine, *range_query_engine);
-    }
-
-    std::vector<std::unique_ptr<QueryEngine>> engines;
-    engines.push_back(std::move(ternary_query_engine));
-    engines.push_back(std::move(range_query_engine));
-    query_engine = std::make_unique<UnionQueryEngine>(std::move(engines));
-  } else {
-    query_engine = std::make_unique<TernaryQueryEngine>();
+  if (XLS_VLOG_IS_ON(3)) {
+    RangeAnalysisLog(f, *ternary_query_engine, *range_query_engine);
   }
+
+  std::vector<std::unique_ptr<QueryEngine>> engines;
+  engines.push_back(std::move(ternary_query_engine));
+  engines.push_back(std::move(range_query_engine));
+  std::unique_ptr<QueryEngine> query_engine =
+      std::make_unique<UnionQueryEngine>(std::move(engines));
   XLS_RETURN_IF_ERROR(query_engine->Populate(f).status());
   return std::move(query_engine);
 }
 
+// Returns the (possibly cached) query engine for `f`.
+static absl::StatusOr<QueryEngine*> GetQueryEngine(
+    FunctionBase* f, bool use_range_analysis,
+    AnalysisManager& analysis_manager) {
+  if (!use_range_analysis) {
+    // Shared with other passes which use a ternary query engine.
+    return analysis_manager.GetOrCreate<TernaryQueryEngine>(
+        f, "ternary_query_engine",
+        [f]() -> absl::StatusOr<std::unique_ptr<TernaryQueryEngine>> {
+          auto query_engine = std::make_unique<TernaryQueryEngine>();
+          XLS_RETURN_IF_ERROR(query_engine->Populate(f).status());
+          return query_engine;
+        });
+  }
+  return analysis_manager.GetOrCreate<QueryEngine>(
+      f, "narrowing_union_query_engine",
+      [f]() { return CreateRangeQueryEngine(f); });
+}
+
 absl::StatusOr<bool> NarrowingPass::RunOnFunctionBaseInternal(
     FunctionBase* f, const PassOptions& options, PassResults* results) const {
-  XLS_ASSIGN_OR_RETURN(std::unique_ptr<QueryEngine> query_engine,
-                       GetQueryEngine(f, use_range_analysis_));
+  // Range analysis is dropped if the time budget is running out.
+  bool use_range_analysis = use_range_analysis_;
+  if (use_range_analysis && results->budget.ShouldDegrade()) {
+    use_range_analysis = false;
+    results->budget.RecordOnce(
+        short_name(),
+        absl::StrFormat("%s: skipped range analysis starting with %s",
+                        short_name(), f->name()));
+  }
+  XLS_ASSIGN_OR_RETURN(
+      QueryEngine * query_engine,
+      GetQueryEngine(f, use_range_analysis, results->analysis_manager));
 
   bool modified = false;
 
@@ -960,7 +987,7 @@ absl::StatusOr<bool> NarrowingPass::RunOnFunctionBaseInternal(
       case Op::kArrayIndex: {
         XLS_ASSIGN_OR_RETURN(
             node_modified,
-            MaybeNarrowArrayIndex(use_range_analysis_, options,
+            MaybeNarrowArrayIndex(use_range_analysis, options,
                                   node->As<ArrayIndex>(), *query_engine));
         break;
       }
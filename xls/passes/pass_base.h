@@ -19,22 +19,27 @@
 
 #include <filesystem>
 #include <memory>
+#include <optional>
 #include <set>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
 #include "absl/time/time.h"
+#include "absl/types/span.h"
 #include "xls/common/file/filesystem.h"
 #include "xls/common/logging/log_lines.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/ir/function.h"
 #include "xls/ir/package.h"
+#include "xls/passes/analysis_manager.h"
 
 namespace xls {
 
@@ -70,6 +75,76 @@ struct PassOptions {
   // chains of selects. Otherwise, this optimization is skipped, since it can
   // sometimes reduce output quality.
   std::optional<int64_t> convert_array_index_to_select = std::nullopt;
+
+  // Whether to share expensive arithmetic operations which are used under
+  // mutually exclusive conditions (see ResourceSharingPass). Sharing trades
+  // area for muxes in front of the shared operation, so it is opt-in.
+  bool resource_sharing = false;
+
+  // Whether to rewrite trees of three or more addends into carry-save
+  // compressors (see CarrySaveCompressionPass). This changes the structure of
+  // the IR and the quality of results of existing designs, so it is opt-in.
+  bool carry_save_compression = false;
+
+  // If present, the pipeline runs in budgeted mode with the given amount of
+  // time, measured from the start of the top-level compound pass. Once half
+  // of the budget is spent, passes which support it switch to cheaper
+  // analyses (e.g., smaller BDD path limits). Once the budget is exhausted,
+  // fixed-point compound passes stop iterating and expensive passes (see
+  // PassBase::IsExpensive) are skipped. Everything skipped or degraded is
+  // recorded in PassResults::budget.
+  std::optional<absl::Duration> time_budget;
+
+  // If present, the maximum number of iterations of each fixed-point compound
+  // pass invocation.
+  std::optional<int64_t> max_fixed_point_iterations;
+};
+
+// Tracks the time budget of a budgeted pipeline run (see
+// PassOptions::time_budget) and records the work skipped because of it.
+class PassBudget {
+ public:
+  // Creates an unlimited budget.
+  PassBudget() = default;
+
+  // Creates a budget of `duration` starting now.
+  explicit PassBudget(absl::Duration duration)
+      : start_(absl::Now()), duration_(duration) {}
+
+  bool IsLimited() const { return duration_ != absl::InfiniteDuration(); }
+
+  // Returns true if more than half of the budget has been spent. Passes with
+  // a cheaper fallback analysis should switch to it.
+  bool ShouldDegrade() const {
+    return IsLimited() && absl::Now() - start_ >= duration_ / 2;
+  }
+
+  // Returns true if the budget has been spent.
+  bool IsExhausted() const {
+    return IsLimited() && absl::Now() - start_ >= duration_;
+  }
+
+  // Records a description of work which was skipped or degraded.
+  void Record(std::string what) {
+    XLS_VLOG(1) << "Budget: " << what;
+    report_.push_back(std::move(what));
+  }
+
+  // Records `what` unless something was already recorded under `key` (e.g.,
+  // the name of a pass which degrades on every function it is run on).
+  void RecordOnce(std::string_view key, std::string what) {
+    if (recorded_keys_.insert(std::string(key)).second) {
+      Record(std::move(what));
+    }
+  }
+
+  absl::Span<const std::string> report() const { return report_; }
+
+ private:
+  absl::Time start_ = absl::InfinitePast();
+  absl::Duration duration_ = absl::InfiniteDuration();
+  std::vector<std::string> report_;
+  absl::flat_hash_set<std::string> recorded_keys_;
 };
 
 // An object containing information about the invocation of a pass (single call
@@ -90,6 +165,13 @@ struct PassInvocation {
 struct PassResults {
   // This vector contains and entry for each invocation of each pass.
   std::vector<PassInvocation> invocations;
+
+  // Analyses of the IR shared between the passes of a pipeline.
+  AnalysisManager analysis_manager;
+
+  // Time budget of the pipeline. Unlimited unless PassOptions::time_budget is
+  // set.
+  PassBudget budget;
 };
 
 // Base class for all compiler passes. Template parameters:
@@ -145,6 +227,15 @@ class PassBase {
   // Returns true if this is a compound pass.
   virtual bool IsCompound() const { return false; }
 
+  // Returns true if the pass itself invalidates the cached analyses (see
+  // AnalysisManager) of every FunctionBase it changes. Otherwise compound
+  // passes invalidate all cached analyses whenever the pass changes the IR.
+  virtual bool InvalidatesChangedAnalyses() const { return false; }
+
+  // Returns true if the pass is expensive and optional. Expensive passes are
+  // skipped once the time budget of the pipeline is exhausted.
+  virtual bool IsExpensive() const { return false; }
+
  protected:
   // Derived classes should override this function which is invoked from Run.
   virtual absl::StatusOr<bool> RunInternal(IrT* ir, const OptionsT& options,
@@ -221,8 +312,23 @@ class CompoundPassBase : public PassBase<IrT, OptionsT, ResultsT> {
                                  "start",
                                  /*ordinal=*/0, /*changed=*/false));
     }
-    return RunNested(ir, options, results, this->short_name(),
-                     /*invariant_checkers=*/{});
+    if (options.time_budget.has_value() && !results->budget.IsLimited()) {
+      results->budget = PassBudget(*options.time_budget);
+    }
+    // Analyses are cached only while the passes of the pipeline are run as
+    // they report every change to the IR.
+    AnalysisManager& analysis_manager = results->analysis_manager;
+    bool caching_was_enabled = analysis_manager.caching_enabled();
+    analysis_manager.InvalidateAll();
+    analysis_manager.set_caching_enabled(true);
+    absl::StatusOr<bool> changed =
+        RunNested(ir, options, results, this->short_name(),
+                  /*invariant_checkers=*/{});
+    analysis_manager.InvalidateAll();
+    analysis_manager.set_caching_enabled(caching_was_enabled);
+    XLS_VLOG(1) << absl::StreamFormat("Ran %s; %s", this->short_name(),
+                                      analysis_manager.ToString());
+    return changed;
   }
 
   // Internal implementation of Run for compound passes. Invoked when a compound
@@ -274,12 +380,30 @@ class FixedPointCompoundPassBase
           invariant_checkers) const override {
     bool local_changed = true;
     bool global_changed = false;
+    int64_t iteration = 0;
     while (local_changed) {
+      if (options.max_fixed_point_iterations.has_value() &&
+          iteration >= *options.max_fixed_point_iterations) {
+        results->budget.RecordOnce(
+            absl::StrCat(this->short_name(), " stopped"),
+            absl::StrFormat("%s stopped after %d iterations (iteration limit)",
+                            this->short_name(), iteration));
+        break;
+      }
+      if (iteration > 0 && results->budget.IsExhausted()) {
+        results->budget.RecordOnce(
+            absl::StrCat(this->short_name(), " stopped"),
+            absl::StrFormat(
+                "%s stopped after %d iterations (time budget exhausted)",
+                this->short_name(), iteration));
+        break;
+      }
       XLS_ASSIGN_OR_RETURN(
           local_changed,
           (CompoundPassBase<IrT, OptionsT, ResultsT>::RunNested(
               ir, options, results, top_level_name, invariant_checkers)));
       global_changed = global_changed || local_changed;
+      ++iteration;
     }
     return global_changed;
   }
@@ -339,6 +463,14 @@ absl::StatusOr<bool> CompoundPassBase<IrT, OptionsT, ResultsT>::RunNested(
       continue;
     }
 
+    if (pass->IsExpensive() && results->budget.IsExhausted()) {
+      results->budget.RecordOnce(
+          absl::StrCat("skipped ", pass->short_name()),
+          absl::StrFormat("skipped %s (time budget exhausted)",
+                          pass->short_name()));
+      continue;
+    }
+
 #ifdef DEBUG
     // Verify that the IR should change iff Run returns true. This is slow, so
     // do not check it in optimized builds.
@@ -373,6 +505,10 @@ absl::StatusOr<bool> CompoundPassBase<IrT, OptionsT, ResultsT>::RunNested(
     }
 #endif
     changed |= pass_changed;
+    if (pass_changed && !pass->IsCompound() &&
+        !pass->InvalidatesChangedAnalyses()) {
+      results->analysis_manager.InvalidateAll();
+    }
     XLS_VLOG(1) << absl::StreamFormat(
         "[elapsed %s] Pass %s %s.", FormatDuration(duration),
         pass->short_name(),
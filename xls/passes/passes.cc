@@ -32,6 +32,9 @@ absl::StatusOr<bool> FunctionBasePass::RunOnFunctionBase(
 
   XLS_ASSIGN_OR_RETURN(bool changed,
                        RunOnFunctionBaseInternal(f, options, results));
+  if (changed) {
+    results->analysis_manager.Invalidate(f);
+  }
 
   XLS_VLOG(3) << absl::StreamFormat("After [changed = %d]:", changed);
   XLS_VLOG_LINES(3, f->DumpIr());
@@ -45,6 +48,9 @@ absl::StatusOr<bool> FunctionBasePass::RunInternal(Package* p,
   for (FunctionBase* f : p->GetFunctionBases()) {
     XLS_ASSIGN_OR_RETURN(bool function_changed,
                          RunOnFunctionBaseInternal(f, options, results));
+    if (function_changed) {
+      results->analysis_manager.Invalidate(f);
+    }
     changed |= function_changed;
   }
   return changed;
@@ -96,6 +102,9 @@ absl::StatusOr<bool> ProcPass::RunOnProc(Proc* proc, const PassOptions& options,
   XLS_VLOG_LINES(3, proc->DumpIr());
 
   XLS_ASSIGN_OR_RETURN(bool changed, RunOnProcInternal(proc, options, results));
+  if (changed) {
+    results->analysis_manager.Invalidate(proc);
+  }
 
   XLS_VLOG(3) << absl::StreamFormat("After [changed = %d]:", changed);
   XLS_VLOG_LINES(3, proc->DumpIr());
@@ -109,6 +118,9 @@ absl::StatusOr<bool> ProcPass::RunInternal(Package* p,
   for (const auto& proc : p->procs()) {
     XLS_ASSIGN_OR_RETURN(bool proc_changed,
                          RunOnProcInternal(proc.get(), options, results));
+    if (proc_changed) {
+      results->analysis_manager.Invalidate(proc.get());
+    }
     changed |= proc_changed;
   }
   return changed;
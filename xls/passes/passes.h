@@ -59,6 +59,10 @@ class FunctionBasePass : public Pass {
                                          const PassOptions& options,
                                          PassResults* results) const;
 
+  // The cached analyses of each function/proc changed by the pass are
+  // invalidated after the pass runs on it.
+  bool InvalidatesChangedAnalyses() const override { return true; }
+
  protected:
   // Iterates over each function and proc in the package calling
   // RunOnFunctionBase.
@@ -92,6 +96,10 @@ class ProcPass : public Pass {
   absl::StatusOr<bool> RunOnProc(Proc* proc, const PassOptions& options,
                                  PassResults* results) const;
 
+  // The cached analyses of each proc changed by the pass are invalidated after
+  // the pass runs on it.
+  bool InvalidatesChangedAnalyses() const override { return true; }
+
  protected:
   // Iterates over each proc in the package calling RunOnProc.
   absl::StatusOr<bool> RunInternal(Package* p, const PassOptions& options,
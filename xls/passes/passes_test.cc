@@ -18,6 +18,7 @@
 #include "gtest/gtest.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
+#include "absl/time/time.h"
 #include "xls/common/casts.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/status/matchers.h"
@@ -477,5 +478,90 @@ TEST(PassesTest, TestTransformNodesToFixedPointWhileRemovingNodes) {
               IsOkAndHolds(false));
 }
 
+// Recording pass which is marked as expensive.
+class ExpensiveRecordingPass : public RecordingPass {
+ public:
+  using RecordingPass::RecordingPass;
+
+  bool IsExpensive() const override { return true; }
+};
+
+TEST(PassesTest, ExhaustedTimeBudget) {
+  std::unique_ptr<Package> p = BuildShift0().first;
+
+  std::vector<std::string> record;
+  CompoundPass compound("compound", "Compound pass");
+  compound.Add<RecordingPass>("foo", &record);
+  compound.Add<ExpensiveRecordingPass>("bar", &record);
+  auto fixed_point =
+      compound.Add<FixedPointCompoundPass>("fixed_point", "Fixed point pass");
+  fixed_point->Add<DummyPass>("changer", "Changer", /*change=*/true);
+  compound.Add<RecordingPass>("qux", &record);
+
+  PassOptions options;
+  options.time_budget = absl::ZeroDuration();
+  PassResults results;
+  EXPECT_THAT(compound.Run(p.get(), options, &results), IsOkAndHolds(true));
+  // The expensive pass is skipped and the fixed-point pass stops after a
+  // single iteration.
+  EXPECT_THAT(record, ElementsAre("foo", "qux"));
+  EXPECT_THAT(results.budget.report(),
+              ElementsAre("skipped bar (time budget exhausted)",
+                          "fixed_point stopped after 1 iterations (time "
+                          "budget exhausted)"));
+}
+
+TEST(PassesTest, UnlimitedTimeBudget) {
+  std::unique_ptr<Package> p = BuildShift0().first;
+
+  std::vector<std::string> record;
+  CompoundPass compound("compound", "Compound pass");
+  compound.Add<RecordingPass>("foo", &record);
+  compound.Add<ExpensiveRecordingPass>("bar", &record);
+
+  PassOptions options;
+  options.time_budget = absl::Hours(1);
+  PassResults results;
+  EXPECT_THAT(compound.Run(p.get(), options, &results), IsOkAndHolds(false));
+  EXPECT_THAT(record, ElementsAre("foo", "bar"));
+  EXPECT_THAT(results.budget.report(), ElementsAre());
+}
+
+TEST(PassesTest, MaxFixedPointIterations) {
+  std::unique_ptr<Package> p = BuildShift0().first;
+
+  FixedPointCompoundPass fixed_point("fixed_point", "Fixed point pass");
+  fixed_point.Add<DummyPass>("changer", "Changer", /*change=*/true);
+
+  PassOptions options;
+  options.max_fixed_point_iterations = 3;
+  PassResults results;
+  EXPECT_THAT(fixed_point.Run(p.get(), options, &results), IsOkAndHolds(true));
+  EXPECT_EQ(results.invocations.size(), 3);
+  EXPECT_THAT(results.budget.report(),
+              ElementsAre("fixed_point stopped after 3 iterations (iteration "
+                          "limit)"));
+}
+
+TEST(PassesTest, NestedFixedPointLimitIsRecordedOnce) {
+  std::unique_ptr<Package> p = BuildShift0().first;
+
+  FixedPointCompoundPass outer("outer", "Outer fixed point pass");
+  auto inner = outer.Add<FixedPointCompoundPass>("inner", "Inner fixed point");
+  inner->Add<DummyPass>("changer", "Changer", /*change=*/true);
+
+  PassOptions options;
+  options.max_fixed_point_iterations = 3;
+  PassResults results;
+  EXPECT_THAT(outer.Run(p.get(), options, &results), IsOkAndHolds(true));
+  // The inner pass hits the limit in each of the three iterations of the outer
+  // pass but is only recorded once.
+  EXPECT_EQ(results.invocations.size(), 9);
+  EXPECT_THAT(results.budget.report(),
+              ElementsAre("inner stopped after 3 iterations (iteration limit)",
+                          "outer stopped after 3 iterations (iteration "
+                          "limit)"));
+}
+
 }  // namespace
 }  // namespace xls
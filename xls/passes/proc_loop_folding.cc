@@ -13,13 +13,21 @@
 // limitations under the License.
 
 #include "xls/passes/proc_loop_folding.h"
+
+#include <algorithm>
+#include <map>
 #include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
 #include "xls/common/logging/logging.h"
@@ -31,32 +39,107 @@
 #include "xls/ir/node_util.h"
 #include "xls/ir/nodes.h"
 #include "xls/ir/op.h"
+#include "xls/ir/package.h"
 #include "xls/ir/value.h"
 #include "xls/ir/value_helpers.h"
 
 namespace xls {
+namespace {
+
+// Returns true if any operand of `countedfor` transitively depends on the
+// result of another CountedFor.
+bool DependsOnCountedFor(CountedFor* countedfor) {
+  std::vector<Node*> worklist(countedfor->operands().begin(),
+                              countedfor->operands().end());
+  absl::flat_hash_set<Node*> visited;
+  while (!worklist.empty()) {
+    Node* node = worklist.back();
+    worklist.pop_back();
+    if (!visited.insert(node).second) {
+      continue;
+    }
+    if (node->Is<CountedFor>()) {
+      return true;
+    }
+    worklist.insert(worklist.end(), node->operands().begin(),
+                    node->operands().end());
+  }
+  return false;
+}
+
+// Adds the number of operations of each kind in `f` times `multiplier` to
+// `counts`. Loop bodies are counted once per iteration.
+void CountOperations(FunctionBase* f, int64_t multiplier,
+                     std::map<Op, int64_t>* counts) {
+  for (Node* node : f->nodes()) {
+    if (node->Is<Param>() || node->Is<Literal>()) {
+      continue;
+    }
+    if (node->Is<CountedFor>()) {
+      CountedFor* countedfor = node->As<CountedFor>();
+      CountOperations(countedfor->body(),
+                      multiplier * countedfor->trip_count(), counts);
+      continue;
+    }
+    (*counts)[node->op()] += multiplier;
+  }
+}
+
+// Returns `base` if no function in `package` has that name, otherwise `base`
+// with the smallest numeric suffix which makes it unique.
+std::string UniqueFunctionName(Package* package, std::string_view base) {
+  std::string name(base);
+  for (int64_t i = 1; package->GetFunction(name).ok(); ++i) {
+    name = absl::StrFormat("%s_%d", base, i);
+  }
+  return name;
+}
 
-// This enum is used to demarcate what goes into each Tuple index for the new
-// proc state we will create.
-enum {
-  kOriginalState,
-  kLoopCounter,
-  kInductionVariable,
-  kLoopCarry,
-  kReceiveData,
-  kInvariantArgStart,
-};
+}  // namespace
+
+std::string LoopFoldingReport::ToString() const {
+  std::vector<std::string> lines;
+  lines.push_back(absl::StrFormat("Ticks per output: %d", ticks_per_output));
+  for (const FoldedLoop& loop : loops) {
+    lines.push_back(absl::StrFormat(
+        "  loop %s: trip count %d, unroll factor %d, %d ticks", loop.body_name,
+        loop.trip_count, loop.unroll_factor, loop.ticks));
+  }
+  lines.push_back("Operations (before -> after):");
+  std::map<Op, int64_t> all_ops = ops_before;
+  all_ops.insert(ops_after.begin(), ops_after.end());
+  for (const auto& [op, _] : all_ops) {
+    auto count = [op = op](const std::map<Op, int64_t>& counts) {
+      auto it = counts.find(op);
+      return it == counts.end() ? int64_t{0} : it->second;
+    };
+    lines.push_back(absl::StrFormat("  %s: %d -> %d", OpToString(op),
+                                    count(ops_before), count(ops_after)));
+  }
+  return absl::StrJoin(lines, "\n");
+}
 
 RollIntoProcPass::RollIntoProcPass(
-    std::optional<int64_t> unroll_factor) :
+    std::optional<int64_t> unroll_factor,
+    absl::flat_hash_map<std::string, int64_t> loop_unroll_factors) :
   ProcPass("roll_into_proc", "Re-roll an iterative set of nodes into a proc"),
-  unroll_factor_(unroll_factor) {}
+  unroll_factor_(unroll_factor),
+  loop_unroll_factors_(std::move(loop_unroll_factors)) {}
+
+std::optional<int64_t> RollIntoProcPass::GetUnrollFactor(
+    CountedFor* countedfor) const {
+  auto it = loop_unroll_factors_.find(countedfor->body()->name());
+  if (it != loop_unroll_factors_.end()) {
+    return it->second;
+  }
+  return unroll_factor_;
+}
 
 // We will use this function to unroll the CountedFor loop body by some factor.
 // For example, if unroll_factor is 2, we will clone the loopbody once into the
 // same function and wire it up as needed.
-// If unroll_factor does not divide the CountedFor trip count evenly, then we
-// do not perform any unrolling.
+// The unroll_factor must evenly divide the CountedFor trip count; callers skip
+// unrolling loops for which it does not.
 absl::StatusOr<CountedFor*> RollIntoProcPass::UnrollCountedForBody(
     Proc* proc, CountedFor* countedfor, int64_t unroll_factor) const {
   int64_t trip_count = countedfor->trip_count();
@@ -80,8 +163,10 @@ absl::StatusOr<CountedFor*> RollIntoProcPass::UnrollCountedForBody(
   Function* countedfor_loopbody = countedfor->body();
   // Clone the function so we don't change the original.
   std::string_view loopbody_name = countedfor_loopbody->name();
+  // Several loops may share a body, so the name of the clone is uniquified.
   XLS_ASSIGN_OR_RETURN(countedfor_loopbody, countedfor_loopbody->Clone(
-      absl::StrFormat("%s_unrolled", loopbody_name),
+      UniqueFunctionName(countedfor_loopbody->package(),
+                         absl::StrFormat("%s_unrolled", loopbody_name)),
       countedfor_loopbody->package()));
 
   // Create a map of original to cloned nodes. This is so we can wire up the
@@ -177,60 +262,6 @@ absl::StatusOr<CountedFor*> RollIntoProcPass::UnrollCountedForBody(
   return new_countedfor;
 }
 
-absl::StatusOr<Value> RollIntoProcPass::CreateInitialState(
-    Proc* proc, CountedFor* countedfor, Receive* recv) const {
-
-  // Get important values out of the countedfor.
-  Function* loopbody = countedfor->body();
-  Node* initial_value = countedfor->initial_value();
-  absl::Span<Node* const> loop_invariants = countedfor->invariant_args();
-  Value initial_induction_var = ZeroOfType(loopbody->param(0)->GetType());
-  Value initial_trip_counter = ZeroOfType(loopbody->param(0)->GetType());
-  std::vector<Value> new_state_vals;
-
-  // Order the new state in the following way:
-  // 0 - Original state
-  // 1 - Loop counter
-  // 2 - Induction variable
-  // 3 - Loop carry
-  // 4 - Receive data
-  // 5, 6, 7, ... - Invariant 1, 2, 3, ...
-  new_state_vals.push_back(proc->GetInitValueElement(0));
-  new_state_vals.push_back(ZeroOfType(loopbody->param(0)->GetType()));
-  new_state_vals.push_back(ZeroOfType(loopbody->param(0)->GetType()));
-  new_state_vals.push_back(ZeroOfType(initial_value->GetType()));
-  XLS_ASSIGN_OR_RETURN(Channel* recv_channel,
-                      proc->package()->GetChannel(recv->channel_id()));
-  new_state_vals.push_back(ZeroOfType(recv_channel->type()));
-  // Naively push the loop invariants into the state.
-  for (Node* invariant : loop_invariants) {
-    // We only want to handle invariants that aren't Literals.
-    if (!invariant->Is<Literal>()) {
-      new_state_vals.push_back(ZeroOfType(invariant->GetType()));
-    }
-  }
-  return Value::Tuple(new_state_vals);
-}
-
-absl::StatusOr<std::vector<Node*>> RollIntoProcPass::SelectBetween(
-  Proc* proc, CountedFor* countedfor, Node* selector,
-    absl::Span<Node* const> on_false, absl::Span<Node* const> on_true) const {
-  XLS_RET_CHECK_EQ(on_false.size(), on_true.size());
-  int64_t num_selects = on_false.size();
-  std::vector<Node*> selects(num_selects);
-  for (int64_t i = 0; i < num_selects; i++) {
-    std::vector<Node*> select_choices = {on_false.at(i), on_true.at(i)};
-    XLS_ASSIGN_OR_RETURN(auto select_invariant,
-                         proc->MakeNode<Select>(countedfor->loc(), selector,
-                                                select_choices, absl::nullopt));
-    selects[i] = select_invariant;
-    // on_true contains the original invariant nodes, whose uses will need to
-    // be replaced by the newly created Select.
-    XLS_RETURN_IF_ERROR(on_true.at(i)->ReplaceUsesWith(select_invariant));
-  }
-  return selects;
-}
-
 absl::StatusOr<Node*> RollIntoProcPass::CloneCountedFor(
     Proc* proc, CountedFor* countedfor, Node* loop_induction_variable,
     Node* loop_carry) const {
@@ -310,189 +341,241 @@ absl::StatusOr<Node*> RollIntoProcPass::ReplaceReceiveWithConditionalReceive(
   return receive_select;
 }
 
-absl::StatusOr<bool> RollIntoProcPass::RunOnProcInternal(
-    Proc* proc, const PassOptions& options, PassResults* results) const {
-
+absl::StatusOr<std::optional<LoopFoldingReport>> RollIntoProcPass::FoldLoops(
+    Proc* proc) const {
   // Find Send, Receive, and CountedFor nodes.
-  CountedFor* counted_for_node = nullptr;
+  std::vector<CountedFor*> counted_for_nodes;
   Receive* receive_node = nullptr;
   Send* send_node = nullptr;
-  for (Node* node : proc->nodes()) {
+  for (Node* node : TopoSort(proc)) {
     if (node->Is<CountedFor>()) {
-      // If more than one CountedFor, Receive or Send, give up.
-      if (counted_for_node != nullptr) {
-        return false;
-      }
-      counted_for_node = node->As<CountedFor>();
+      counted_for_nodes.push_back(node->As<CountedFor>());
     } else if (node->Is<Receive>()) {
+      // If more than one Receive or Send, give up.
       if (receive_node != nullptr) {
-        return false;
+        return std::nullopt;
       }
       receive_node = node->As<Receive>();
     } else if (node->Is<Send>()) {
       if (send_node != nullptr) {
-        return false;
+        return std::nullopt;
       }
       send_node = node->As<Send>();
     }
   }
 
   // Check if we found the CountedFor, ReceiveNode and SendNode.
-  if (counted_for_node == nullptr || receive_node == nullptr ||
+  if (counted_for_nodes.empty() || receive_node == nullptr ||
       send_node == nullptr) {
-    return false;
+    return std::nullopt;
   }
-
-  if (unroll_factor_.has_value()) {
-    XLS_ASSIGN_OR_RETURN(counted_for_node,
-                         UnrollCountedForBody(
-                             proc, counted_for_node, unroll_factor_.value()));
+  if (!receive_node->is_blocking() || receive_node->predicate().has_value()) {
+    return std::nullopt;
   }
 
-  // Get information from the CountedFor node.
-  Node* initial_value = counted_for_node->initial_value();
-  Function* loopbody = counted_for_node->body();
-  absl::Span<Node* const> loop_invariants = counted_for_node->invariant_args();
-  int64_t trip_count_value = counted_for_node->trip_count();
-  int64_t stride = counted_for_node->stride();
-
-  // Create a Tuple for the new state.
-  Value initial_induction_var = ZeroOfType(loopbody->param(0)->GetType());
-  Value initial_trip_counter = ZeroOfType(loopbody->param(0)->GetType());
-  XLS_ASSIGN_OR_RETURN(Value init_state_new,
-                      CreateInitialState(proc, counted_for_node, receive_node));
-
-  // The CountedFor iterator and loop value need to be rolled up into the Proc
-  // state. We also need to roll up the invariants, as well as keep track of the
-  // receive value. So we need to create a Tuple with all of these values
-  // included, along with the old proc state as well.
-
-  // Need to keep track of the old proc next state. We will use this when
-  // making the new proc state at the end of this pass.
-  Node* old_proc_next = proc->GetNextStateElement(0);
-  XLS_ASSIGN_OR_RETURN(
-      Literal * dummy_state_new,
-      proc->MakeNode<Literal>(proc->GetStateParam(0)->loc(), init_state_new));
+  // A loop which depends on the result of another loop can only start once
+  // that loop has finished. Such loops are left in place and evaluated in the
+  // final tick.
+  std::vector<CountedFor*> loops;
+  for (CountedFor* countedfor : counted_for_nodes) {
+    if (countedfor->trip_count() > 0 && !DependsOnCountedFor(countedfor)) {
+      loops.push_back(countedfor);
+    }
+  }
+  if (loops.empty()) {
+    return std::nullopt;
+  }
 
-  // Anything that used the old proc state now uses the tuple at index 0.
-  XLS_RETURN_IF_ERROR(
-      proc->GetStateParam(0)
-          ->ReplaceUsesWithNew<TupleIndex>(dummy_state_new, kOriginalState)
-          .status());
-
-  // We want to mux the invariants with their proc state versions so we can
-  // allow for CountedFor loops where an invariant is dependent on the receive
-  // node. The mux select line will be current trip counter == 0.
-  SourceInfo countedfor_loc = counted_for_node->loc();
-  XLS_ASSIGN_OR_RETURN(
-      auto trip_counter,
-      proc->MakeNode<TupleIndex>(SourceInfo(), dummy_state_new, kLoopCounter));
-
-  XLS_ASSIGN_OR_RETURN(auto zero, proc->MakeNode<Literal>(
-      countedfor_loc, ZeroOfType(loopbody->param(0)->GetType())));
-  XLS_ASSIGN_OR_RETURN(auto is_first_iteration,
-                       proc->MakeNode<CompareOp>(countedfor_loc, trip_counter,
-                                               zero, Op::kEq));
-
-  // Need to replace the invariants with a Select each, to choose between the
-  // proc state, or a modified version of the invariants when loop iteration
-  // equals 0. These will feed the CountedFor nodes as well as the next state.
-  int64_t proc_state_tuple_idx = kInvariantArgStart;
-  std::vector<Node*> select_true;
-  std::vector<Node*> select_false;
-  std::vector<Node*> invariant_selects;
-  for (Node* invariant : loop_invariants) {
-    // Only handle non-Literal invariants.
-    if (!invariant->Is<Literal>()) {
-      XLS_ASSIGN_OR_RETURN(auto tuple_idx,
-                           proc->MakeNode<TupleIndex>(countedfor_loc,
-                                                      dummy_state_new,
-                                                      proc_state_tuple_idx));
-      select_true.push_back(invariant);
-      select_false.push_back(tuple_idx);
-      proc_state_tuple_idx++;
+  LoopFoldingReport report;
+  CountOperations(proc, /*multiplier=*/1, &report.ops_before);
+
+  for (CountedFor*& loop : loops) {
+    LoopFoldingReport::FoldedLoop folded_loop{
+        .body_name = loop->body()->name(),
+        .trip_count = loop->trip_count(),
+        .unroll_factor = 1,
+        .ticks = loop->trip_count()};
+    std::optional<int64_t> unroll_factor = GetUnrollFactor(loop);
+    // A factor which does not evenly divide the trip count (e.g., a global
+    // factor chosen for other loops) leaves this loop rolled.
+    if (unroll_factor.has_value() && unroll_factor.value() > 1 &&
+        (unroll_factor.value() > loop->trip_count() ||
+         loop->trip_count() % unroll_factor.value() != 0)) {
+      XLS_VLOG(2) << absl::StreamFormat(
+          "Not unrolling loop %s: unroll factor %d does not divide trip count "
+          "%d",
+          loop->body()->name(), unroll_factor.value(), loop->trip_count());
+      unroll_factor = std::nullopt;
     }
+    if (unroll_factor.has_value() && unroll_factor.value() != 1) {
+      XLS_ASSIGN_OR_RETURN(
+          CountedFor * unrolled,
+          UnrollCountedForBody(proc, loop, unroll_factor.value()));
+      XLS_RETURN_IF_ERROR(proc->RemoveNode(loop));
+      loop = unrolled;
+      folded_loop.unroll_factor = unroll_factor.value();
+      folded_loop.ticks = loop->trip_count();
+    }
+    report.ticks_per_output =
+        std::max(report.ticks_per_output, folded_loop.ticks);
+    report.loops.push_back(folded_loop);
   }
-  XLS_ASSIGN_OR_RETURN(invariant_selects,
-                       SelectBetween(proc, counted_for_node, is_first_iteration,
-                                     select_false, select_true));
-
-  // Get the loop induction variable and loop carry variable from the new proc
-  // state, as these are parameters to the CountedFor node.
-  XLS_ASSIGN_OR_RETURN(auto loop_induction_variable,
-                       proc->MakeNode<TupleIndex>(SourceInfo(), dummy_state_new,
-                                                  kInductionVariable));
+
+  // The loops share a tick counter which counts from 0 to ticks_per_output-1.
+  // On the first tick the Receive fires and on the final tick the Send fires.
+  // The original proc state only advances on the final tick so, apart from the
+  // loop state, every node evaluates to the same value in every tick.
+  int64_t ticks = report.ticks_per_output;
+  int64_t counter_bits =
+      std::max(int64_t{1}, Bits::MinBitCountUnsigned(ticks - 1));
+  SourceInfo loc = loops.front()->loc();
+  int64_t original_state_count = proc->GetStateElementCount();
+
+  int64_t tick_counter_index = proc->GetStateElementCount();
+  XLS_ASSIGN_OR_RETURN(
+      Param * tick_counter,
+      proc->AppendStateElement("fold_tick", Value(UBits(0, counter_bits))));
+  XLS_ASSIGN_OR_RETURN(
+      auto zero, proc->MakeNode<Literal>(loc, Value(UBits(0, counter_bits))));
+  XLS_ASSIGN_OR_RETURN(
+      auto one, proc->MakeNode<Literal>(loc, Value(UBits(1, counter_bits))));
   XLS_ASSIGN_OR_RETURN(
-      auto loop_carry,
-      proc->MakeNode<TupleIndex>(SourceInfo(), dummy_state_new, kLoopCarry));
-
-  // Clone the CountedFor nodes into the proc and get the CountedFor return
-  // value, which we will use for the next proc state.
-  XLS_ASSIGN_OR_RETURN(Node* countedfor_return, CloneCountedFor(
-      proc, counted_for_node, loop_induction_variable, loop_carry));
-
-  // Create the next CountedFor loop nodes.
-  int64_t induction_bits = loopbody->param(0)->BitCountOrDie();
-  XLS_ASSIGN_OR_RETURN(auto trip_count,
-                       proc->MakeNode<Literal>(
-                           countedfor_loc, Value(UBits(
-                               trip_count_value-1, induction_bits))));
-  XLS_ASSIGN_OR_RETURN(auto is_final_iteration,
-                       proc->MakeNode<CompareOp>(countedfor_loc,
-                                               trip_counter, trip_count,
-                                               Op::kEq));
-  XLS_ASSIGN_OR_RETURN(auto initial_value_val,
-                       proc->MakeNode<Literal>(
-                           countedfor_loc, Value(UBits(0, induction_bits))));
-
-  // Increment the induction value by stride each time.
-  XLS_ASSIGN_OR_RETURN(auto induction_value_incr,
-                       proc->MakeNode<Literal>(
-                           countedfor_loc, Value(UBits(stride,
-                                                       induction_bits))));
-  XLS_ASSIGN_OR_RETURN(auto induction_value_next,
-                       proc->MakeNode<BinOp>(countedfor_loc,
-                                               loop_induction_variable,
-                                               induction_value_incr, Op::kAdd));
-  std::vector<Node*> next_induction_value_nodes = {induction_value_next,
-                                                   initial_value_val};
-  XLS_ASSIGN_OR_RETURN(auto next_loop_induction_value,
-                       proc->MakeNode<Select>(countedfor_loc,
-                                              is_final_iteration,
-                                              next_induction_value_nodes,
-                                              absl::nullopt));
-
-  // Increment the trip counter by 1 each time.
-  XLS_ASSIGN_OR_RETURN(auto trip_count_incr,
-                       proc->MakeNode<Literal>(
-                           countedfor_loc, Value(UBits(1, induction_bits))));
-  XLS_ASSIGN_OR_RETURN(auto trip_counter_next,
-                       proc->MakeNode<BinOp>(countedfor_loc, trip_counter,
-                                             trip_count_incr, Op::kAdd));
-  std::vector<Node*> next_loop_trip_count = {trip_counter_next,
-                                             initial_value_val};
-  XLS_ASSIGN_OR_RETURN(auto next_loop_trip_counter,
-                       proc->MakeNode<Select>(countedfor_loc,
-                                              is_final_iteration,
-                                              next_loop_trip_count,
-                                              absl::nullopt));
-
-  // Create the next loop accumulator value.
-  std::vector<Node*> next_loop_carry_sel = {countedfor_return, initial_value};
-  XLS_ASSIGN_OR_RETURN(auto next_loop_carry,
-                       proc->MakeNode<Select>(countedfor_loc,
-                                              is_final_iteration,
-                                              next_loop_carry_sel,
-                                              absl::nullopt));
-
-  // Create the "ReceiveIf" node.
+      auto last_tick,
+      proc->MakeNode<Literal>(loc, Value(UBits(ticks - 1, counter_bits))));
   XLS_ASSIGN_OR_RETURN(
-      auto receive_val_proc_state,
-      proc->MakeNode<TupleIndex>(SourceInfo(), dummy_state_new, kReceiveData));
+      auto is_first_iteration,
+      proc->MakeNode<CompareOp>(loc, tick_counter, zero, Op::kEq));
+  XLS_ASSIGN_OR_RETURN(
+      auto is_final_iteration,
+      proc->MakeNode<CompareOp>(loc, tick_counter, last_tick, Op::kEq));
+  XLS_ASSIGN_OR_RETURN(
+      auto tick_counter_incr,
+      proc->MakeNode<BinOp>(loc, tick_counter, one, Op::kAdd));
+  XLS_ASSIGN_OR_RETURN(
+      auto tick_counter_next,
+      proc->MakeNode<Select>(loc, is_final_iteration,
+                             std::vector<Node*>{tick_counter_incr, zero},
+                             absl::nullopt));
+  XLS_RETURN_IF_ERROR(
+      proc->SetNextStateElement(tick_counter_index, tick_counter_next));
+
+  // Create the "ReceiveIf" node. The received value is held in the proc state
+  // for the remaining ticks.
+  XLS_ASSIGN_OR_RETURN(Channel* recv_channel,
+                       proc->package()->GetChannel(receive_node->channel_id()));
+  int64_t receive_data_index = proc->GetStateElementCount();
+  XLS_ASSIGN_OR_RETURN(
+      Param * receive_data,
+      proc->AppendStateElement("fold_receive_data",
+                               ZeroOfType(recv_channel->type())));
   XLS_ASSIGN_OR_RETURN(auto receive_select,
-                       ReplaceReceiveWithConditionalReceive (
+                       ReplaceReceiveWithConditionalReceive(
                            proc, receive_node, is_first_iteration,
-                           receive_val_proc_state));
+                           receive_data));
+  XLS_ASSIGN_OR_RETURN(
+      auto receive_select_val,
+      proc->MakeNode<TupleIndex>(SourceInfo(), receive_select, 1));
+  XLS_RETURN_IF_ERROR(
+      proc->SetNextStateElement(receive_data_index, receive_select_val));
+
+  for (int64_t i = 0; i < loops.size(); ++i) {
+    CountedFor* loop = loops[i];
+    Function* loopbody = loop->body();
+    Type* induction_type = loopbody->param(0)->GetType();
+    int64_t induction_bits = induction_type->GetFlatBitCount();
+
+    // The loop induction variable and loop carry are rolled up into the proc
+    // state.
+    int64_t induction_index = proc->GetStateElementCount();
+    XLS_ASSIGN_OR_RETURN(
+        Param * loop_induction_variable,
+        proc->AppendStateElement(absl::StrFormat("fold_loop%d_induction", i),
+                                 ZeroOfType(induction_type)));
+    int64_t carry_index = proc->GetStateElementCount();
+    XLS_ASSIGN_OR_RETURN(
+        Param * loop_carry_state,
+        proc->AppendStateElement(absl::StrFormat("fold_loop%d_carry", i),
+                                 ZeroOfType(loop->GetType())));
+    XLS_ASSIGN_OR_RETURN(
+        auto loop_carry,
+        proc->MakeNode<Select>(
+            loop->loc(), is_first_iteration,
+            std::vector<Node*>{loop_carry_state, loop->initial_value()},
+            absl::nullopt));
+
+    // Clone the CountedFor nodes into the proc and get the CountedFor return
+    // value, which we will use for the next proc state.
+    XLS_ASSIGN_OR_RETURN(
+        Node * countedfor_return,
+        CloneCountedFor(proc, loop, loop_induction_variable, loop_carry));
+
+    // Increment the induction value by stride each time.
+    XLS_ASSIGN_OR_RETURN(
+        auto induction_value_incr,
+        proc->MakeNode<Literal>(
+            loop->loc(), Value(UBits(loop->stride(), induction_bits))));
+    XLS_ASSIGN_OR_RETURN(
+        auto induction_value_next,
+        proc->MakeNode<BinOp>(loop->loc(), loop_induction_variable,
+                              induction_value_incr, Op::kAdd));
+    XLS_ASSIGN_OR_RETURN(
+        auto initial_induction_value,
+        proc->MakeNode<Literal>(loop->loc(), ZeroOfType(induction_type)));
+    XLS_ASSIGN_OR_RETURN(
+        auto next_loop_induction_value,
+        proc->MakeNode<Select>(
+            loop->loc(), is_final_iteration,
+            std::vector<Node*>{induction_value_next, initial_induction_value},
+            absl::nullopt));
+    XLS_RETURN_IF_ERROR(proc->SetNextStateElement(induction_index,
+                                                  next_loop_induction_value));
+
+    // A loop with fewer ticks than the longest loop holds its result in the
+    // loop carry once it has finished.
+    Node* next_loop_carry = countedfor_return;
+    Node* loop_result = countedfor_return;
+    if (loop->trip_count() < ticks) {
+      XLS_ASSIGN_OR_RETURN(
+          auto loop_ticks,
+          proc->MakeNode<Literal>(loop->loc(),
+                                  Value(UBits(loop->trip_count(),
+                                              counter_bits))));
+      XLS_ASSIGN_OR_RETURN(
+          auto is_active,
+          proc->MakeNode<CompareOp>(loop->loc(), tick_counter, loop_ticks,
+                                    Op::kULt));
+      XLS_ASSIGN_OR_RETURN(
+          next_loop_carry,
+          proc->MakeNode<Select>(
+              loop->loc(), is_active,
+              std::vector<Node*>{loop_carry, countedfor_return},
+              absl::nullopt));
+      loop_result = loop_carry;
+    }
+    XLS_RETURN_IF_ERROR(
+        proc->SetNextStateElement(carry_index, next_loop_carry));
+
+    // The loop result is only complete in the final tick which is the only
+    // tick in which it is observed.
+    XLS_RETURN_IF_ERROR(loop->ReplaceUsesWith(loop_result));
+    XLS_RETURN_IF_ERROR(proc->RemoveNode(loop));
+  }
+
+  // The original proc state only advances on the final tick.
+  for (int64_t i = 0; i < original_state_count; ++i) {
+    Param* state_param = proc->GetStateParam(i);
+    Node* next_state = proc->GetNextStateElement(i);
+    if (next_state == state_param) {
+      continue;
+    }
+    XLS_ASSIGN_OR_RETURN(
+        auto select_original_proc_state,
+        proc->MakeNode<Select>(state_param->loc(), is_final_iteration,
+                               std::vector<Node*>{state_param, next_state},
+                               absl::nullopt));
+    XLS_RETURN_IF_ERROR(
+        proc->SetNextStateElement(i, select_original_proc_state));
+  }
 
   // Create the "SendIf" node.
   XLS_ASSIGN_OR_RETURN(auto new_send,
@@ -504,45 +587,19 @@ absl::StatusOr<bool> RollIntoProcPass::RunOnProcInternal(
   XLS_RETURN_IF_ERROR(send_node->ReplaceUsesWith(new_send));
   XLS_RETURN_IF_ERROR(proc->RemoveNode(send_node));
 
-  // Build the next state. We need to include the following:
-  // - next loop iteration value
-  // - new loop carry value
-  // - all of the loop invariant select nodes
-  // - a select node for the state from the original proc
-  std::vector<Node*> next_state_tuple;
-
-  // Select between the proc state and the old next state to update the state
-  // from the original proc.
-  XLS_ASSIGN_OR_RETURN(auto proc_state_old,
-                       proc->MakeNode<TupleIndex>(SourceInfo(), dummy_state_new,
-                                                  kOriginalState));
-  std::vector<Node*> invariant_nodes = {proc_state_old, old_proc_next};
-  XLS_ASSIGN_OR_RETURN(auto select_original_proc_state,
-                       proc->MakeNode<Select>(countedfor_loc,
-                                              is_first_iteration,
-                                              invariant_nodes, absl::nullopt));
-  next_state_tuple.push_back(select_original_proc_state);
-  next_state_tuple.push_back(next_loop_trip_counter);
-  next_state_tuple.push_back(next_loop_induction_value);
-  next_state_tuple.push_back(next_loop_carry);
-  XLS_ASSIGN_OR_RETURN(
-      auto receive_select_val,
-      proc->MakeNode<TupleIndex>(SourceInfo(), receive_select, 1));
-  next_state_tuple.push_back(receive_select_val);
-  for (Node* invariant : invariant_selects) {
-    next_state_tuple.push_back(invariant);
-  }
-
-  XLS_ASSIGN_OR_RETURN(
-      auto new_next_state,
-      proc->MakeNode<Tuple>(proc->GetStateParam(0)->loc(), next_state_tuple));
-  XLS_RETURN_IF_ERROR(proc->ReplaceStateElement(0,
-                                                proc->GetStateParam(0)->name(),
-                                                init_state_new, new_next_state)
-                          .status());
-  XLS_RETURN_IF_ERROR(dummy_state_new->ReplaceUsesWith(proc->GetStateParam(0)));
-  XLS_RETURN_IF_ERROR(proc->RemoveNode(dummy_state_new));
+  CountOperations(proc, /*multiplier=*/1, &report.ops_after);
+  return report;
+}
 
+absl::StatusOr<bool> RollIntoProcPass::RunOnProcInternal(
+    Proc* proc, const PassOptions& options, PassResults* results) const {
+  XLS_ASSIGN_OR_RETURN(std::optional<LoopFoldingReport> report,
+                       FoldLoops(proc));
+  if (!report.has_value()) {
+    return false;
+  }
+  XLS_VLOG(1) << absl::StreamFormat("Folded loops of proc %s:\n%s",
+                                    proc->name(), report->ToString());
   return true;
 }
 
@@ -15,18 +15,53 @@
 #ifndef XLS_PASSES_PROC_LOOP_FOLDING_H_
 #define XLS_PASSES_PROC_LOOP_FOLDING_H_
 
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/statusor.h"
 #include "absl/types/optional.h"
 #include "xls/ir/function.h"
+#include "xls/ir/op.h"
 #include "xls/passes/passes.h"
 
 namespace xls {
 
-// This pass will act upon a Proc that contains a single CountedFor node. The
-// goal is to move the state for the CountedFor node into the Proc state, and
-// adjusting the data flow to allow the CountedFor loop (and hence the proc) to
-// iterate the required number of times before placing any result on the output
-// channel. The driving example is the proc_fir_filter found in xls/examples.
+// Summary of the folding of the loops of a single proc.
+struct LoopFoldingReport {
+  struct FoldedLoop {
+    // Name of the (original) loop body function.
+    std::string body_name;
+    // Trip count of the loop before folding.
+    int64_t trip_count;
+    // Number of loop iterations evaluated per tick.
+    int64_t unroll_factor;
+    // Number of ticks the folded loop is active for each output.
+    int64_t ticks;
+  };
+  std::vector<FoldedLoop> loops;
+
+  // Number of ticks the folded proc takes to produce one output.
+  int64_t ticks_per_output = 1;
+
+  // Number of operations of each kind instantiated in the proc before and
+  // after folding. The bodies of CountedFor loops which remain in the proc
+  // count once per iteration as they are eventually unrolled.
+  std::map<Op, int64_t> ops_before;
+  std::map<Op, int64_t> ops_after;
+
+  std::string ToString() const;
+};
+
+// This pass will act upon a Proc that contains CountedFor nodes, a single
+// Receive and a single Send. The goal is to move the state for the CountedFor
+// nodes into the Proc state, and adjusting the data flow to allow the
+// CountedFor loops (and hence the proc) to iterate the required number of times
+// before placing any result on the output channel. The driving example is the
+// proc_fir_filter found in xls/examples.
 
 // In the FIR filter's case, the CountedFor is responsible for the convolution
 // (multiply-accumulate). Left alone, the CountedFor would be unrolled by
@@ -35,11 +70,28 @@ namespace xls {
 // often good to minimize how many there are. By rolling the CountedFor into
 // the proc state, we end up with only a single multiplier, which can be a
 // nice area and power consumption optimization.
+//
+// The loop bodies can be partially unrolled before folding to trade area for
+// throughput: with an unroll factor of F a loop of N iterations evaluates F
+// iterations per tick and takes N/F ticks. The factor is given for all loops
+// or per loop, keyed by the name of the loop body function.
+//
+// All CountedFor nodes which do not depend on the result of another CountedFor
+// are folded and advance in lockstep; the proc takes as many ticks per output
+// as the longest folded loop. Loops which depend on the result of another loop
+// and loops nested inside of a folded loop body are evaluated in full in the
+// tick in which their operands are available.
 class RollIntoProcPass : public ProcPass {
  public:
-  RollIntoProcPass(std::optional<int64_t> unroll_factor = absl::nullopt);
+  RollIntoProcPass(std::optional<int64_t> unroll_factor = absl::nullopt,
+                   absl::flat_hash_map<std::string, int64_t>
+                       loop_unroll_factors = {});
   ~RollIntoProcPass() override {}
 
+  // Folds the loops of the given proc. Returns std::nullopt if the proc is not
+  // of a form which can be folded.
+  absl::StatusOr<std::optional<LoopFoldingReport>> FoldLoops(Proc* proc) const;
+
  protected:
   absl::StatusOr<bool> RunOnProcInternal(
       Proc* proc, const PassOptions& options,
@@ -51,10 +103,6 @@ class RollIntoProcPass : public ProcPass {
                                                    CountedFor* countedfor,
                                                    int64_t unroll_factor) const;
 
-  // Create the new proc initial state that will be used for the folded loop.
-  absl::StatusOr<Value> CreateInitialState(Proc* proc, CountedFor* countedfor,
-                                           Receive* recv) const;
-
   // We will need to clone the CountedFor loop body into the proc. This function
   // takes care of that for us.
   absl::StatusOr<Node*> CloneCountedFor(Proc* proc, CountedFor* countedfor,
@@ -62,19 +110,18 @@ class RollIntoProcPass : public ProcPass {
                                         Node* loop_carry) const;
 
   // The Receive node needs to be replaced with a "ReceiveIf" node. Since this
-  // required a few steps (including muxing with one of the proc state Tuple
+  // required a few steps (including muxing with one of the proc state
   // elements), move this to a separate function.
   absl::StatusOr<Node*> ReplaceReceiveWithConditionalReceive(
       Proc* proc, Receive* original_receive, Node* receive_condition,
       Node* on_condition_false) const;
 
-  // Build a set of muxes that all use the same selector input.
-  absl::StatusOr<std::vector<Node*>> SelectBetween(
-      Proc* proc, CountedFor* countedfor, Node* selector,
-      absl::Span<Node* const> on_false, absl::Span<Node* const> on_true) const;
-
  private:
+  // Returns the unroll factor to apply to the given loop, if any.
+  std::optional<int64_t> GetUnrollFactor(CountedFor* countedfor) const;
+
   std::optional<int64_t> unroll_factor_;
+  absl::flat_hash_map<std::string, int64_t> loop_unroll_factors_;
 };
 
 }  // namespace xls
@@ -15,10 +15,14 @@
 #include "xls/passes/proc_loop_folding.h"
 
 #include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/status/statusor.h"
+#include "absl/types/span.h"
 #include "xls/common/status/matchers.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/examples/proc_fir_filter.h"
@@ -71,6 +75,55 @@ class RollIntoProcPassTest : public IrTestBase {
                             .status());
     return changed;
   }
+
+  absl::StatusOr<std::optional<LoopFoldingReport>> FoldLoops(
+      Proc* proc, const RollIntoProcPass& pass) {
+    XLS_ASSIGN_OR_RETURN(std::optional<LoopFoldingReport> report,
+                         pass.FoldLoops(proc));
+    PassResults results;
+    XLS_RETURN_IF_ERROR(DeadCodeEliminationPass()
+                            .RunOnFunctionBase(proc, PassOptions(), &results)
+                            .status());
+    return report;
+  }
+
+  // Sends each of `inputs` to the channel `<name>_in` of the package and
+  // expects the corresponding value of `outputs` on the channel `<name>_out`
+  // after exactly `ticks_per_output` ticks.
+  void ExpectOutputs(Package* p, std::string_view name,
+                     absl::Span<const int64_t> inputs,
+                     absl::Span<const int64_t> outputs,
+                     int64_t ticks_per_output) {
+    XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<SerialProcRuntime> pi,
+                             CreateInterpreterSerialProcRuntime(p));
+    XLS_ASSERT_OK_AND_ASSIGN(Channel* send,
+                             p->GetChannel(absl::StrFormat("%s_out", name)));
+    XLS_ASSERT_OK_AND_ASSIGN(Channel* recv,
+                             p->GetChannel(absl::StrFormat("%s_in", name)));
+    ChannelQueue& send_queue = pi->queue_manager().GetQueue(send);
+    ChannelQueue& recv_queue = pi->queue_manager().GetQueue(recv);
+    for (int64_t input : inputs) {
+      XLS_ASSERT_OK(recv_queue.Write({Value(UBits(input, 32))}));
+    }
+    for (int64_t output : outputs) {
+      for (int64_t j = 0; j < ticks_per_output; j++) {
+        ASSERT_THAT(pi->Tick(), IsOk());
+        EXPECT_EQ(send_queue.IsEmpty(), j < ticks_per_output - 1);
+      }
+      EXPECT_THAT(send_queue.Read(), Optional(Value(UBits(output, 32))));
+    }
+  }
+
+  // Returns a loop body which adds its first invariant to the loop carry.
+  absl::StatusOr<Function*> AccumulateInvariantBody(std::string_view name,
+                                                    Package* p) {
+    FunctionBuilder fb(name, p);
+    fb.Param("i", p->GetBitsType(32));
+    BValue loop_carry_data = fb.Param("loop_carry_data", p->GetBitsType(32));
+    BValue invar = fb.Param("invar", p->GetBitsType(32));
+    fb.Add(loop_carry_data, invar);
+    return fb.Build();
+  }
 };
 
 // Pass should do nothing if no CountedFor node present.
@@ -1200,6 +1253,249 @@ TEST_F(RollIntoProcPassTest, ImportFIRUnrollAll) {
   }
 }
 
+TEST_F(RollIntoProcPassTest, ImportFIRUnrollReport) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Value kernel_value,
+                           Value::UBitsArray({1, 2, 3, 4}, 32));
+  std::string_view name = "fir_proc";
+  Type* kernel_type = p->GetTypeForValue(kernel_value.element(0));
+  XLS_ASSERT_OK_AND_ASSIGN(StreamingChannel* x_in,
+                           p->CreateStreamingChannel(
+                               absl::StrFormat("%s_in", name),
+                               ChannelOps::kReceiveOnly, kernel_type));
+  XLS_ASSERT_OK_AND_ASSIGN(StreamingChannel* filter_out,
+                           p->CreateStreamingChannel(
+                               absl::StrFormat("%s_out", name),
+                               ChannelOps::kSendOnly, kernel_type));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Proc * f, CreateFirFilter(name, kernel_value, x_in, filter_out, p.get()));
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::optional<LoopFoldingReport> report,
+                           FoldLoops(f, RollIntoProcPass(2)));
+  ASSERT_TRUE(report.has_value());
+  EXPECT_EQ(report->ticks_per_output, 2);
+  ASSERT_EQ(report->loops.size(), 1);
+  EXPECT_EQ(report->loops[0].trip_count, 4);
+  EXPECT_EQ(report->loops[0].unroll_factor, 2);
+  EXPECT_EQ(report->loops[0].ticks, 2);
+  // Unrolling by two leaves two of the four multipliers.
+  EXPECT_EQ(report->ops_before.at(Op::kUMul), 4);
+  EXPECT_EQ(report->ops_after.at(Op::kUMul), 2);
+
+  ExpectOutputs(p.get(), name, {1, 2, 3, 4}, {1, 4, 10, 20},
+                /*ticks_per_output=*/2);
+}
+
+// Builds a proc which receives x and sends the sum of two independent loops:
+// one adding 1 four times and one adding x twice.
+absl::StatusOr<Proc*> CreateTwoLoopProc(std::string_view name, Package* p,
+                                        Function* add_one_body,
+                                        Function* add_x_body) {
+  Type* type = p->GetBitsType(32);
+  XLS_ASSIGN_OR_RETURN(
+      StreamingChannel * ch0,
+      p->CreateStreamingChannel(absl::StrFormat("%s_in", name),
+                                ChannelOps::kReceiveOnly, type));
+  XLS_ASSIGN_OR_RETURN(
+      StreamingChannel * ch1,
+      p->CreateStreamingChannel(absl::StrFormat("%s_out", name),
+                                ChannelOps::kSendOnly, type));
+  ProcBuilder pb(name, absl::StrFormat("%s_token", name), p);
+  pb.StateElement(absl::StrFormat("%s_state", name), Value(UBits(0, 32)));
+  BValue in = pb.Receive(ch0, pb.GetTokenParam());
+  BValue zero = pb.Literal(UBits(0, 32));
+  BValue add_one = pb.CountedFor(zero, 4, 1, add_one_body,
+                                 {pb.Literal(UBits(1, 32))});
+  BValue add_x = pb.CountedFor(zero, 2, 1, add_x_body, {pb.TupleIndex(in, 1)});
+  BValue result = pb.Add(add_one, add_x);
+  BValue out = pb.Send(ch1, pb.GetTokenParam(), result);
+  return pb.Build(pb.AfterAll({pb.TupleIndex(in, 0), out}), {result});
+}
+
+TEST_F(RollIntoProcPassTest, MultipleLoops) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * add_one_body,
+                           AccumulateInvariantBody("add_one_body", p.get()));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * add_x_body,
+                           AccumulateInvariantBody("add_x_body", p.get()));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Proc * proc,
+      CreateTwoLoopProc("two_loops", p.get(), add_one_body, add_x_body));
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::optional<LoopFoldingReport> report,
+                           FoldLoops(proc, RollIntoProcPass()));
+  ASSERT_TRUE(report.has_value());
+  for (Node* node : proc->nodes()) {
+    EXPECT_FALSE(node->Is<CountedFor>());
+  }
+  // The loops advance in lockstep, the shorter loop holds its result until the
+  // longer one is done.
+  EXPECT_EQ(report->ticks_per_output, 4);
+  ASSERT_EQ(report->loops.size(), 2);
+  EXPECT_EQ(report->loops[0].ticks + report->loops[1].ticks, 6);
+
+  ExpectOutputs(p.get(), "two_loops", {1, 2, 3}, {6, 8, 10},
+                /*ticks_per_output=*/4);
+}
+
+TEST_F(RollIntoProcPassTest, PerLoopUnrollFactor) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * add_one_body,
+                           AccumulateInvariantBody("add_one_body", p.get()));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * add_x_body,
+                           AccumulateInvariantBody("add_x_body", p.get()));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Proc * proc,
+      CreateTwoLoopProc("two_loops", p.get(), add_one_body, add_x_body));
+
+  // Unrolling the longer loop by two balances the loops.
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::optional<LoopFoldingReport> report,
+      FoldLoops(proc, RollIntoProcPass(/*unroll_factor=*/std::nullopt,
+                                       {{"add_one_body", 2}})));
+  ASSERT_TRUE(report.has_value());
+  EXPECT_EQ(report->ticks_per_output, 2);
+  for (const LoopFoldingReport::FoldedLoop& loop : report->loops) {
+    EXPECT_EQ(loop.ticks, 2) << loop.body_name;
+    EXPECT_EQ(loop.unroll_factor, loop.body_name == "add_one_body" ? 2 : 1);
+  }
+
+  ExpectOutputs(p.get(), "two_loops", {1, 2, 3}, {6, 8, 10},
+                /*ticks_per_output=*/2);
+}
+
+TEST_F(RollIntoProcPassTest, UnrollFactorNotDividingTripCount) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * add_one_body,
+                           AccumulateInvariantBody("add_one_body", p.get()));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * add_x_body,
+                           AccumulateInvariantBody("add_x_body", p.get()));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Proc * proc,
+      CreateTwoLoopProc("two_loops", p.get(), add_one_body, add_x_body));
+
+  // A factor of four fully unrolls the loop with trip count four, the loop
+  // with trip count two is left rolled.
+  XLS_ASSERT_OK_AND_ASSIGN(std::optional<LoopFoldingReport> report,
+                           FoldLoops(proc, RollIntoProcPass(4)));
+  ASSERT_TRUE(report.has_value());
+  EXPECT_EQ(report->ticks_per_output, 2);
+  ASSERT_EQ(report->loops.size(), 2);
+  for (const LoopFoldingReport::FoldedLoop& loop : report->loops) {
+    EXPECT_EQ(loop.unroll_factor, loop.body_name == "add_one_body" ? 4 : 1)
+        << loop.body_name;
+    EXPECT_EQ(loop.ticks, loop.body_name == "add_one_body" ? 1 : 2)
+        << loop.body_name;
+  }
+
+  ExpectOutputs(p.get(), "two_loops", {1, 2, 3}, {6, 8, 10},
+                /*ticks_per_output=*/2);
+}
+
+TEST_F(RollIntoProcPassTest, UnrollLoopsSharingBody) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * body,
+                           AccumulateInvariantBody("body", p.get()));
+  XLS_ASSERT_OK_AND_ASSIGN(Proc * proc,
+                           CreateTwoLoopProc("two_loops", p.get(), body, body));
+
+  // Each loop gets its own unrolled clone of the shared body.
+  XLS_ASSERT_OK_AND_ASSIGN(std::optional<LoopFoldingReport> report,
+                           FoldLoops(proc, RollIntoProcPass(2)));
+  ASSERT_TRUE(report.has_value());
+  EXPECT_EQ(report->ticks_per_output, 2);
+  ASSERT_EQ(report->loops.size(), 2);
+  EXPECT_EQ(report->loops[0].unroll_factor, 2);
+  EXPECT_EQ(report->loops[1].unroll_factor, 2);
+  EXPECT_THAT(p->GetFunction("body_unrolled"), IsOk());
+  EXPECT_THAT(p->GetFunction("body_unrolled_1"), IsOk());
+
+  ExpectOutputs(p.get(), "two_loops", {1, 2, 3}, {6, 8, 10},
+                /*ticks_per_output=*/2);
+}
+
+TEST_F(RollIntoProcPassTest, NestedLoops) {
+  auto p = CreatePackage();
+  std::string_view name = "nested";
+  Type* type = p->GetBitsType(32);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * inner_body,
+                           AccumulateInvariantBody("inner_body", p.get()));
+  FunctionBuilder fb("outer_body", p.get());
+  fb.Param("i", type);
+  BValue loop_carry_data = fb.Param("loop_carry_data", type);
+  BValue x = fb.Param("x", type);
+  fb.CountedFor(loop_carry_data, 3, 1, inner_body, {x});
+  XLS_ASSERT_OK_AND_ASSIGN(Function * outer_body, fb.Build());
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      StreamingChannel * ch0,
+      p->CreateStreamingChannel(absl::StrFormat("%s_in", name),
+                                ChannelOps::kReceiveOnly, type));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      StreamingChannel * ch1,
+      p->CreateStreamingChannel(absl::StrFormat("%s_out", name),
+                                ChannelOps::kSendOnly, type));
+  ProcBuilder pb(name, absl::StrFormat("%s_token", name), p.get());
+  pb.StateElement(absl::StrFormat("%s_state", name), Value(UBits(0, 32)));
+  BValue in = pb.Receive(ch0, pb.GetTokenParam());
+  BValue result = pb.CountedFor(pb.Literal(UBits(0, 32)), 2, 1, outer_body,
+                                {pb.TupleIndex(in, 1)});
+  BValue out = pb.Send(ch1, pb.GetTokenParam(), result);
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Proc * proc, pb.Build(pb.AfterAll({pb.TupleIndex(in, 0), out}),
+                            {result}));
+
+  // The outer loop is folded; the inner loop is evaluated in each tick.
+  XLS_ASSERT_OK_AND_ASSIGN(std::optional<LoopFoldingReport> report,
+                           FoldLoops(proc, RollIntoProcPass()));
+  ASSERT_TRUE(report.has_value());
+  EXPECT_EQ(report->ticks_per_output, 2);
+  EXPECT_EQ(report->ops_before.at(Op::kAdd), 6);
+  EXPECT_GE(report->ops_after.at(Op::kAdd), 3);
+  EXPECT_LT(report->ops_after.at(Op::kAdd), 6);
+
+  ExpectOutputs(p.get(), name, {1, 2}, {6, 12}, /*ticks_per_output=*/2);
+}
+
+TEST_F(RollIntoProcPassTest, DependentLoops) {
+  auto p = CreatePackage();
+  std::string_view name = "dependent";
+  Type* type = p->GetBitsType(32);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * add_x_body,
+                           AccumulateInvariantBody("add_x_body", p.get()));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * add_one_body,
+                           AccumulateInvariantBody("add_one_body", p.get()));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      StreamingChannel * ch0,
+      p->CreateStreamingChannel(absl::StrFormat("%s_in", name),
+                                ChannelOps::kReceiveOnly, type));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      StreamingChannel * ch1,
+      p->CreateStreamingChannel(absl::StrFormat("%s_out", name),
+                                ChannelOps::kSendOnly, type));
+  ProcBuilder pb(name, absl::StrFormat("%s_token", name), p.get());
+  pb.StateElement(absl::StrFormat("%s_state", name), Value(UBits(0, 32)));
+  BValue in = pb.Receive(ch0, pb.GetTokenParam());
+  BValue add_x = pb.CountedFor(pb.Literal(UBits(0, 32)), 2, 1, add_x_body,
+                               {pb.TupleIndex(in, 1)});
+  BValue result =
+      pb.CountedFor(add_x, 3, 1, add_one_body, {pb.Literal(UBits(1, 32))});
+  BValue out = pb.Send(ch1, pb.GetTokenParam(), result);
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Proc * proc, pb.Build(pb.AfterAll({pb.TupleIndex(in, 0), out}),
+                            {result}));
+
+  // Only the first loop is folded, the second one consumes its result in the
+  // final tick.
+  XLS_ASSERT_OK_AND_ASSIGN(std::optional<LoopFoldingReport> report,
+                           FoldLoops(proc, RollIntoProcPass()));
+  ASSERT_TRUE(report.has_value());
+  EXPECT_EQ(report->ticks_per_output, 2);
+  ASSERT_EQ(report->loops.size(), 1);
+  EXPECT_EQ(report->loops[0].body_name, "add_x_body");
+
+  ExpectOutputs(p.get(), name, {1, 2}, {5, 7}, /*ticks_per_output=*/2);
+}
 
 }  // namespace
 
@@ -0,0 +1,204 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/passes/proc_state_narrowing_pass.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/bits_ops.h"
+#include "xls/ir/node_iterator.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/op.h"
+#include "xls/passes/proc_state_range_analysis.h"
+
+namespace xls {
+namespace {
+
+// Returns the number of low bits of operand `operand_no` of `user` which
+// affect the low `user_demand` bits of `user`.
+int64_t OperandDemand(Node* user, int64_t operand_no, int64_t user_demand) {
+  Node* operand = user->operand(operand_no);
+  int64_t width = operand->GetType()->GetFlatBitCount();
+  if (!operand->GetType()->IsBits() || !user->GetType()->IsBits()) {
+    return user_demand > 0 ? width : 0;
+  }
+  switch (user->op()) {
+    case Op::kBitSlice: {
+      BitSlice* bit_slice = user->As<BitSlice>();
+      if (user_demand == 0) {
+        return 0;
+      }
+      return bit_slice->start() + std::min(user_demand, bit_slice->width());
+    }
+    case Op::kConcat: {
+      // Operands are ordered from most to least significant.
+      int64_t lsb = 0;
+      for (int64_t i = user->operand_count() - 1; i > operand_no; --i) {
+        lsb += user->operand(i)->GetType()->GetFlatBitCount();
+      }
+      return std::clamp(user_demand - lsb, int64_t{0}, width);
+    }
+    // The low bits of the result of these operations only depend on the low
+    // bits of the operands.
+    case Op::kAdd:
+    case Op::kSub:
+    case Op::kNeg:
+    case Op::kNot:
+    case Op::kAnd:
+    case Op::kOr:
+    case Op::kXor:
+    case Op::kNand:
+    case Op::kNor:
+    case Op::kUMul:
+    case Op::kSMul:
+    case Op::kIdentity:
+    case Op::kZeroExt:
+    case Op::kSignExt:
+      return std::min(user_demand, width);
+    case Op::kShll:
+      return operand_no == 0 ? std::min(user_demand, width)
+                             : (user_demand > 0 ? width : 0);
+    case Op::kSel:
+      if (operand_no == 0) {
+        return user_demand > 0 ? width : 0;
+      }
+      return std::min(user_demand, width);
+    default:
+      return user_demand > 0 ? width : 0;
+  }
+}
+
+// Computes for each state element the number of low bits which may affect a
+// side-effecting operation. The computation is a backwards dataflow analysis
+// iterated around the state-update loop to a fixed point.
+std::vector<int64_t> ComputeDemandedStateBits(Proc* proc) {
+  std::vector<int64_t> state_demand(proc->GetStateElementCount(), 0);
+  absl::flat_hash_map<Node*, int64_t> demand;
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    demand.clear();
+    for (Node* node : ReverseTopoSort(proc)) {
+      int64_t width = node->GetType()->GetFlatBitCount();
+      int64_t node_demand = 0;
+      if ((OpIsSideEffecting(node->op()) && !node->Is<Param>()) ||
+          node == proc->NextToken()) {
+        node_demand = width;
+      }
+      for (int64_t index : proc->GetNextStateIndices(node)) {
+        node_demand = std::max(node_demand, state_demand[index]);
+      }
+      for (Node* user : node->users()) {
+        for (int64_t i = 0; i < user->operand_count(); ++i) {
+          if (user->operand(i) == node) {
+            node_demand = std::max(node_demand,
+                                   OperandDemand(user, i, demand.at(user)));
+          }
+        }
+      }
+      if (!node->GetType()->IsBits() && node_demand > 0) {
+        node_demand = width;
+      }
+      demand[node] = std::min(node_demand, width);
+    }
+    for (int64_t i = 0; i < proc->GetStateElementCount(); ++i) {
+      int64_t param_demand = demand.at(proc->GetStateParam(i));
+      if (param_demand > state_demand[i]) {
+        state_demand[i] = param_demand;
+        changed = true;
+      }
+    }
+  }
+  return state_demand;
+}
+
+}  // namespace
+
+absl::StatusOr<bool> ProcStateNarrowingPass::RunOnProcInternal(
+    Proc* proc, const PassOptions& options, PassResults* results) const {
+  if (proc->GetStateElementCount() == 0) {
+    return false;
+  }
+  XLS_ASSIGN_OR_RETURN(std::vector<IntervalSetTree> ranges,
+                       ComputeProcStateRanges(proc));
+  std::vector<int64_t> demanded_bits = ComputeDemandedStateBits(proc);
+
+  bool changed = false;
+  // Iterate backwards as narrowing a state element replaces it with a new one
+  // at the same index and may remove it entirely.
+  for (int64_t i = proc->GetStateElementCount() - 1; i >= 0; --i) {
+    Type* type = proc->GetStateElementType(i);
+    Param* param = proc->GetStateParam(i);
+    Node* next = proc->GetNextStateElement(i);
+    if (!type->IsBits() || type->GetFlatBitCount() == 0 || next == param) {
+      continue;
+    }
+    int64_t width = type->GetFlatBitCount();
+    const IntervalSet& range = ranges[i].Get({});
+    Bits constant_prefix = bits_ops::LongestCommonPrefixMSB(
+        {range.LowerBound().value(), range.UpperBound().value()});
+    int64_t new_width =
+        std::min(width - constant_prefix.bit_count(), demanded_bits[i]);
+    if (new_width == width) {
+      continue;
+    }
+
+    // The high bits are the constant prefix from the range analysis followed
+    // by zeros for any additional bits which are dead.
+    Bits high_bits = bits_ops::Concat(
+        {constant_prefix,
+         Bits(width - new_width - constant_prefix.bit_count())});
+    XLS_VLOG(2) << absl::StreamFormat(
+        "Narrowing state element %s from %d to %d bits (range %s, %d bits "
+        "demanded)",
+        param->GetName(), width, new_width, range.ToString(),
+        demanded_bits[i]);
+
+    if (new_width == 0) {
+      XLS_RETURN_IF_ERROR(
+          param->ReplaceUsesWithNew<Literal>(Value(high_bits)).status());
+      XLS_RETURN_IF_ERROR(proc->RemoveStateElement(i));
+      changed = true;
+      continue;
+    }
+
+    std::string name = absl::StrCat(param->GetName(), "_narrowed");
+    XLS_ASSIGN_OR_RETURN(
+        Node * narrowed_next,
+        proc->MakeNode<BitSlice>(next->loc(), next, /*start=*/0, new_width));
+    Value narrowed_init(
+        proc->GetInitValueElement(i).bits().Slice(0, new_width));
+    XLS_ASSIGN_OR_RETURN(Param * narrowed_param,
+                         proc->InsertStateElement(i + 1, name, narrowed_init,
+                                                  narrowed_next));
+    XLS_ASSIGN_OR_RETURN(
+        Node * high, proc->MakeNode<Literal>(param->loc(), Value(high_bits)));
+    XLS_RETURN_IF_ERROR(param
+                            ->ReplaceUsesWithNew<Concat>(
+                                std::vector<Node*>{high, narrowed_param})
+                            .status());
+    XLS_RETURN_IF_ERROR(proc->RemoveStateElement(i));
+    changed = true;
+  }
+  return changed;
+}
+
+}  // namespace xls
@@ -0,0 +1,52 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_PASSES_PROC_STATE_NARROWING_PASS_H_
+#define XLS_PASSES_PROC_STATE_NARROWING_PASS_H_
+
+#include "absl/status/statusor.h"
+#include "xls/ir/proc.h"
+#include "xls/passes/passes.h"
+
+namespace xls {
+
+// Pass which narrows bits-typed proc state elements. The high bits of a state
+// element are removed from the state if either:
+//
+// (1) they are constant in every tick as determined by an inductive range
+//     analysis over the state-update loop (see ComputeProcStateRanges). For
+//     example, a 64-bit state element whose next-state value is always a
+//     zero-extended 12-bit value is narrowed to 12 bits.
+//
+// (2) they are dead: no side-effecting operation depends on them either
+//     directly or through the next-state values of other state elements. For
+//     example, a 64-bit counter of which only the low 12 bits are ever sent on
+//     a channel is narrowed to 12 bits.
+//
+// Uses of the state parameter are replaced with the narrowed parameter
+// concatenated with the constant (or, for dead bits, zero) high bits.
+class ProcStateNarrowingPass : public ProcPass {
+ public:
+  ProcStateNarrowingPass()
+      : ProcPass("proc_state_narrow", "Proc State Narrowing") {}
+  ~ProcStateNarrowingPass() override {}
+
+ protected:
+  absl::StatusOr<bool> RunOnProcInternal(Proc* proc, const PassOptions& options,
+                                         PassResults* results) const override;
+};
+
+}  // namespace xls
+
+#endif  // XLS_PASSES_PROC_STATE_NARROWING_PASS_H_
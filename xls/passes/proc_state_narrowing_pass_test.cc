@@ -0,0 +1,166 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/passes/proc_state_narrowing_pass.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/statusor.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_matcher.h"
+#include "xls/ir/ir_test_base.h"
+
+namespace m = ::xls::op_matchers;
+
+namespace xls {
+namespace {
+
+using status_testing::IsOkAndHolds;
+
+class ProcStateNarrowingPassTest : public IrTestBase {
+ protected:
+  ProcStateNarrowingPassTest() = default;
+
+  absl::StatusOr<bool> Run(Package* p) {
+    PassResults results;
+    return ProcStateNarrowingPass().Run(p, PassOptions(), &results);
+  }
+};
+
+TEST_F(ProcStateNarrowingPassTest, StatelessProc) {
+  auto p = CreatePackage();
+  ProcBuilder pb("p", "tkn", p.get());
+  XLS_ASSERT_OK(pb.Build(pb.GetTokenParam(), std::vector<BValue>()).status());
+
+  EXPECT_THAT(Run(p.get()), IsOkAndHolds(false));
+}
+
+TEST_F(ProcStateNarrowingPassTest, FullWidthCounterIsNotNarrowed) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * out, p->CreateStreamingChannel("out", ChannelOps::kSendOnly,
+                                               p->GetBitsType(32)));
+
+  TokenlessProcBuilder pb("p", "tkn", p.get());
+  BValue x = pb.StateElement("x", Value(UBits(0, 32)));
+  pb.Send(out, x);
+  XLS_ASSERT_OK_AND_ASSIGN(Proc * proc,
+                           pb.Build({pb.Add(x, pb.Literal(UBits(1, 32)))}));
+
+  EXPECT_THAT(Run(p.get()), IsOkAndHolds(false));
+  EXPECT_EQ(proc->GetStateElementType(0), p->GetBitsType(32));
+}
+
+TEST_F(ProcStateNarrowingPassTest, ZeroExtendedStateIsNarrowed) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * in, p->CreateStreamingChannel("in", ChannelOps::kReceiveOnly,
+                                              p->GetBitsType(12)));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * out, p->CreateStreamingChannel("out", ChannelOps::kSendOnly,
+                                               p->GetBitsType(64)));
+
+  TokenlessProcBuilder pb("p", "tkn", p.get());
+  BValue x = pb.StateElement("x", Value(UBits(0, 64)));
+  pb.Send(out, x);
+  BValue data = pb.Receive(in);
+  XLS_ASSERT_OK_AND_ASSIGN(Proc * proc, pb.Build({pb.ZeroExtend(data, 64)}));
+
+  EXPECT_THAT(Run(p.get()), IsOkAndHolds(true));
+  ASSERT_EQ(proc->GetStateElementCount(), 1);
+  EXPECT_EQ(proc->GetStateElementType(0), p->GetBitsType(12));
+  EXPECT_EQ(proc->GetInitValueElement(0), Value(UBits(0, 12)));
+  EXPECT_THAT(proc->GetNextStateElement(0),
+              m::BitSlice(m::ZeroExt(m::TupleIndex(m::Receive())), 0, 12));
+  EXPECT_THAT(
+      proc->GetStateParam(0)->users(),
+      testing::ElementsAre(m::Concat(m::Literal(UBits(0, 52)), m::Param())));
+
+  // Narrowing again should be a no-op.
+  EXPECT_THAT(Run(p.get()), IsOkAndHolds(false));
+}
+
+TEST_F(ProcStateNarrowingPassTest, ConstantHighBitsAreNarrowed) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * in, p->CreateStreamingChannel("in", ChannelOps::kReceiveOnly,
+                                              p->GetBitsType(8)));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * out, p->CreateStreamingChannel("out", ChannelOps::kSendOnly,
+                                               p->GetBitsType(16)));
+
+  TokenlessProcBuilder pb("p", "tkn", p.get());
+  BValue x = pb.StateElement("x", Value(UBits(0xab00, 16)));
+  // The state value is passed through another state element to exercise the
+  // iteration around the state-update loop.
+  BValue y = pb.StateElement("y", Value(UBits(0xab00, 16)));
+  pb.Send(out, x);
+  BValue data = pb.Receive(in);
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Proc * proc,
+      pb.Build({y, pb.Concat({pb.Literal(UBits(0xab, 8)), data})}));
+
+  EXPECT_THAT(Run(p.get()), IsOkAndHolds(true));
+  ASSERT_EQ(proc->GetStateElementCount(), 2);
+  EXPECT_EQ(proc->GetStateElementType(0), p->GetBitsType(8));
+  EXPECT_EQ(proc->GetStateElementType(1), p->GetBitsType(8));
+  EXPECT_THAT(proc->GetStateParam(0)->users(),
+              testing::ElementsAre(
+                  m::Concat(m::Literal(UBits(0xab, 8)), m::Param())));
+}
+
+TEST_F(ProcStateNarrowingPassTest, UnobservedHighBitsOfCounterAreNarrowed) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * out, p->CreateStreamingChannel("out", ChannelOps::kSendOnly,
+                                               p->GetBitsType(12)));
+
+  TokenlessProcBuilder pb("p", "tkn", p.get());
+  BValue x = pb.StateElement("x", Value(UBits(0, 64)));
+  pb.Send(out, pb.BitSlice(x, /*start=*/0, /*width=*/12));
+  XLS_ASSERT_OK_AND_ASSIGN(Proc * proc,
+                           pb.Build({pb.Add(x, pb.Literal(UBits(1, 64)))}));
+
+  EXPECT_THAT(Run(p.get()), IsOkAndHolds(true));
+  ASSERT_EQ(proc->GetStateElementCount(), 1);
+  EXPECT_EQ(proc->GetStateElementType(0), p->GetBitsType(12));
+  EXPECT_THAT(proc->GetNextStateElement(0),
+              m::BitSlice(m::Add(m::Concat(m::Literal(UBits(0, 52)),
+                                           m::Param()),
+                                 m::Literal(1)),
+                          0, 12));
+}
+
+TEST_F(ProcStateNarrowingPassTest, HighBitsObservedThroughOtherState) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * out, p->CreateStreamingChannel("out", ChannelOps::kSendOnly,
+                                               p->GetBitsType(1)));
+
+  // The MSB of `x` is observed through the state element `y`.
+  TokenlessProcBuilder pb("p", "tkn", p.get());
+  BValue x = pb.StateElement("x", Value(UBits(0, 32)));
+  BValue y = pb.StateElement("y", Value(UBits(0, 1)));
+  pb.Send(out, y);
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Proc * proc, pb.Build({pb.Add(x, pb.Literal(UBits(1, 32))),
+                             pb.BitSlice(x, /*start=*/31, /*width=*/1)}));
+
+  EXPECT_THAT(Run(p.get()), IsOkAndHolds(false));
+  EXPECT_EQ(proc->GetStateElementType(0), p->GetBitsType(32));
+}
+
+}  // namespace
+}  // namespace xls
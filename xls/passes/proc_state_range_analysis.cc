@@ -0,0 +1,123 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/passes/proc_state_range_analysis.h"
+
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/bits_ops.h"
+#include "xls/ir/interval.h"
+#include "xls/ir/interval_set.h"
+#include "xls/ir/value_helpers.h"
+
+namespace xls {
+namespace {
+
+// Number of iterations after which growing sets are widened.
+constexpr int64_t kWideningIteration = 4;
+
+// Upper bound on the number of iterations. Widening guarantees convergence well
+// before this for any reasonable proc; the limit only guards compile time.
+constexpr int64_t kMaxIterations = 256;
+
+// Widens `set` to the set of all values which share the longest common prefix
+// (from the MSB) of the lower and upper bounds of `set`. Repeated widening of a
+// growing set strictly shortens the prefix so the iteration terminates.
+IntervalSet WidenToCommonPrefix(const IntervalSet& set) {
+  if (set.BitCount() == 0 || set.IsEmpty()) {
+    return set;
+  }
+  Bits prefix = bits_ops::LongestCommonPrefixMSB(
+      {set.LowerBound().value(), set.UpperBound().value()});
+  int64_t suffix_width = set.BitCount() - prefix.bit_count();
+  IntervalSet result(set.BitCount());
+  result.AddInterval(
+      Interval(bits_ops::Concat({prefix, Bits(suffix_width)}),
+               bits_ops::Concat({prefix, Bits::AllOnes(suffix_width)})));
+  result.Normalize();
+  return result;
+}
+
+IntervalSet UnionIntervals(const IntervalSet& a, const IntervalSet& b) {
+  return MinimizeIntervals(IntervalSet::Combine(a, b));
+}
+
+}  // namespace
+
+absl::StatusOr<std::vector<IntervalSetTree>> ComputeProcStateRanges(
+    Proc* proc) {
+  std::vector<IntervalSetTree> ranges;
+  ranges.reserve(proc->GetStateElementCount());
+  for (int64_t i = 0; i < proc->GetStateElementCount(); ++i) {
+    XLS_ASSIGN_OR_RETURN(LeafTypeTree<Value> init,
+                         ValueToLeafTypeTree(proc->GetInitValueElement(i),
+                                             proc->GetStateElementType(i)));
+    ranges.push_back(init.Map<IntervalSet>([](const Value& value) {
+      return value.IsBits() ? IntervalSet::Precise(value.bits())
+                            : IntervalSet::Maximal(0);
+    }));
+  }
+
+  for (int64_t iteration = 0; iteration < kMaxIterations; ++iteration) {
+    RangeQueryEngine engine;
+    for (int64_t i = 0; i < proc->GetStateElementCount(); ++i) {
+      Param* param = proc->GetStateParam(i);
+      engine.InitializeNode(param);
+      engine.SetIntervalSetTree(param, ranges[i]);
+    }
+    XLS_RETURN_IF_ERROR(engine.Populate(proc).status());
+
+    bool changed = false;
+    for (int64_t i = 0; i < proc->GetStateElementCount(); ++i) {
+      IntervalSetTree next =
+          engine.GetIntervalSetTree(proc->GetNextStateElement(i));
+      IntervalSetTree updated =
+          IntervalSetTree::Zip<IntervalSet, IntervalSet>(UnionIntervals,
+                                                         ranges[i], next);
+      if (updated == ranges[i]) {
+        continue;
+      }
+      if (iteration >= kWideningIteration) {
+        updated = updated.Map<IntervalSet>(WidenToCommonPrefix);
+      }
+      ranges[i] = std::move(updated);
+      changed = true;
+    }
+    if (!changed) {
+      if (XLS_VLOG_IS_ON(3)) {
+        XLS_VLOG(3) << absl::StreamFormat(
+            "Proc state ranges of %s (%d iterations):", proc->name(),
+            iteration + 1);
+        for (int64_t i = 0; i < proc->GetStateElementCount(); ++i) {
+          XLS_VLOG(3) << absl::StreamFormat(
+              "  %s : %s", proc->GetStateParam(i)->GetName(),
+              IntervalSetTreeToString(ranges[i]));
+        }
+      }
+      return ranges;
+    }
+  }
+
+  XLS_VLOG(2) << absl::StreamFormat(
+      "Proc state range analysis of %s did not converge after %d iterations",
+      proc->name(), kMaxIterations);
+  for (int64_t i = 0; i < proc->GetStateElementCount(); ++i) {
+    ranges[i] = ranges[i].Map<IntervalSet>([](const IntervalSet& set) {
+      return IntervalSet::Maximal(set.BitCount());
+    });
+  }
+  return ranges;
+}
+
+}  // namespace xls
@@ -0,0 +1,46 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_PASSES_PROC_STATE_RANGE_ANALYSIS_H_
+#define XLS_PASSES_PROC_STATE_RANGE_ANALYSIS_H_
+
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "xls/ir/proc.h"
+#include "xls/passes/range_query_engine.h"
+
+namespace xls {
+
+// Computes for each state element of `proc` a set of values which is
+// inductively closed over the proc state-update loop. That is, the set of each
+// state element S_i contains the initial value of the element and
+//
+//   next_i(S_0, ..., S_n-1) ⊆ S_i
+//
+// where next_i(...) is the range of the next-state value of element i as
+// computed by the RangeQueryEngine with the state parameters constrained to
+// the current sets. The sets are therefore a sound over-approximation of the
+// values the state elements may take on in any tick.
+//
+// The sets are computed by iterating to a fixed point starting from the
+// initial values. To guarantee termination, after a few iterations growing
+// sets are widened to the set of all values sharing the most significant bits
+// common to the lower and upper bounds of the set.
+absl::StatusOr<std::vector<IntervalSetTree>> ComputeProcStateRanges(
+    Proc* proc);
+
+}  // namespace xls
+
+#endif  // XLS_PASSES_PROC_STATE_RANGE_ANALYSIS_H_
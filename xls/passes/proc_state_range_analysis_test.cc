@@ -0,0 +1,101 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/passes/proc_state_range_analysis.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/interval.h"
+#include "xls/ir/interval_set.h"
+#include "xls/ir/ir_test_base.h"
+
+namespace xls {
+namespace {
+
+class ProcStateRangeAnalysisTest : public IrTestBase {
+ protected:
+  static IntervalSet MakeRange(int64_t lo, int64_t hi, int64_t width) {
+    IntervalSet set(width);
+    set.AddInterval(Interval(UBits(lo, width), UBits(hi, width)));
+    set.Normalize();
+    return set;
+  }
+};
+
+TEST_F(ProcStateRangeAnalysisTest, ConstantState) {
+  auto p = CreatePackage();
+  TokenlessProcBuilder pb("p", "tkn", p.get());
+  BValue x = pb.StateElement("x", Value(UBits(42, 32)));
+  XLS_ASSERT_OK_AND_ASSIGN(Proc * proc, pb.Build({x}));
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::vector<IntervalSetTree> ranges,
+                           ComputeProcStateRanges(proc));
+  ASSERT_EQ(ranges.size(), 1);
+  EXPECT_EQ(ranges[0].Get({}), IntervalSet::Precise(UBits(42, 32)));
+}
+
+TEST_F(ProcStateRangeAnalysisTest, RangePropagatesThroughStateChain) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * in, p->CreateStreamingChannel("in", ChannelOps::kReceiveOnly,
+                                              p->GetBitsType(12)));
+  TokenlessProcBuilder pb("p", "tkn", p.get());
+  BValue x = pb.StateElement("x", Value(UBits(0, 32)));
+  BValue y = pb.StateElement("y", Value(UBits(0, 32)));
+  BValue z = pb.StateElement("z", Value(UBits(0, 32)));
+  BValue data = pb.Receive(in);
+  XLS_ASSERT_OK_AND_ASSIGN(Proc * proc,
+                           pb.Build({y, z, pb.ZeroExtend(data, 32)}));
+  (void)x;
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::vector<IntervalSetTree> ranges,
+                           ComputeProcStateRanges(proc));
+  ASSERT_EQ(ranges.size(), 3);
+  for (const IntervalSetTree& range : ranges) {
+    EXPECT_EQ(range.Get({}), MakeRange(0, 4095, 32));
+  }
+}
+
+TEST_F(ProcStateRangeAnalysisTest, UnboundedCounterIsWidened) {
+  auto p = CreatePackage();
+  TokenlessProcBuilder pb("p", "tkn", p.get());
+  BValue x = pb.StateElement("x", Value(UBits(0, 16)));
+  XLS_ASSERT_OK_AND_ASSIGN(Proc * proc,
+                           pb.Build({pb.Add(x, pb.Literal(UBits(1, 16)))}));
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::vector<IntervalSetTree> ranges,
+                           ComputeProcStateRanges(proc));
+  ASSERT_EQ(ranges.size(), 1);
+  EXPECT_TRUE(ranges[0].Get({}).IsMaximal());
+}
+
+TEST_F(ProcStateRangeAnalysisTest, TupleState) {
+  auto p = CreatePackage();
+  TokenlessProcBuilder pb("p", "tkn", p.get());
+  BValue x = pb.StateElement(
+      "x", Value::Tuple({Value(UBits(1, 8)), Value(UBits(2, 8))}));
+  BValue swapped = pb.Tuple({pb.TupleIndex(x, 1), pb.TupleIndex(x, 0)});
+  XLS_ASSERT_OK_AND_ASSIGN(Proc * proc, pb.Build({swapped}));
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::vector<IntervalSetTree> ranges,
+                           ComputeProcStateRanges(proc));
+  ASSERT_EQ(ranges.size(), 1);
+  EXPECT_EQ(ranges[0].Get({0}), MakeRange(1, 2, 8));
+  EXPECT_EQ(ranges[0].Get({1}), MakeRange(1, 2, 8));
+}
+
+}  // namespace
+}  // namespace xls
@@ -0,0 +1,412 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/passes/resource_sharing_pass.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/data_structures/graph_coloring.h"
+#include "xls/delay_model/delay_estimator.h"
+#include "xls/delay_model/delay_estimators.h"
+#include "xls/ir/node.h"
+#include "xls/ir/node_iterator.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/op.h"
+#include "xls/passes/bdd_function.h"
+#include "xls/passes/bdd_query_engine.h"
+#include "xls/passes/mutual_exclusion_pass.h"
+
+namespace xls {
+
+namespace {
+
+bool IsShareableOp(Op op) {
+  switch (op) {
+    case Op::kUMul:
+    case Op::kSMul:
+    case Op::kUDiv:
+    case Op::kSDiv:
+    case Op::kUMod:
+    case Op::kSMod:
+    case Op::kAdd:
+    case Op::kSub:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool IsShareCandidate(Node* node) {
+  if (!IsShareableOp(node->op()) || !node->GetType()->IsBits()) {
+    return false;
+  }
+  int64_t width = node->BitCountOrDie();
+  if (node->op() == Op::kAdd || node->op() == Op::kSub) {
+    return width >= ResourceSharingPass::kMinSharedAdderWidth;
+  }
+  return width > 1;
+}
+
+// Returns true if `a` and `b` can be implemented by the same operation, i.e.
+// they have the same op and the same operand and result types.
+bool HaveSameSignature(Node* a, Node* b) {
+  if (a->op() != b->op() || a->GetType() != b->GetType() ||
+      a->operand_count() != b->operand_count()) {
+    return false;
+  }
+  for (int64_t i = 0; i < a->operand_count(); ++i) {
+    if (a->operand(i)->GetType() != b->operand(i)->GetType()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns an estimate of the delay of the given node. As in BddCsePass, nodes
+// without a delay model are assumed to take no time.
+int64_t GetNodeDelay(Node* node) {
+  absl::StatusOr<int64_t> delay =
+      GetStandardDelayEstimator().GetOperationDelayInPs(node);
+  return delay.ok() ? delay.value() : 0;
+}
+
+// The time at which the output of each node becomes available, measured from
+// the start of the combinational path through the function.
+absl::flat_hash_map<Node*, int64_t> ComputeArrivalTimes(FunctionBase* f) {
+  absl::flat_hash_map<Node*, int64_t> arrival;
+  for (Node* node : TopoSort(f)) {
+    int64_t start = 0;
+    for (Node* operand : node->operands()) {
+      start = std::max(start, arrival.at(operand));
+    }
+    arrival[node] = start + GetNodeDelay(node);
+  }
+  return arrival;
+}
+
+// The latest time at which the output of each node may become available
+// without any path through the node exceeding `target`.
+absl::flat_hash_map<Node*, int64_t> ComputeRequiredTimes(FunctionBase* f,
+                                                         int64_t target) {
+  absl::flat_hash_map<Node*, int64_t> required;
+  for (Node* node : ReverseTopoSort(f)) {
+    int64_t latest = target;
+    for (Node* user : node->users()) {
+      latest = std::min(latest, required.at(user) - GetNodeDelay(user));
+    }
+    required[node] = latest;
+  }
+  return required;
+}
+
+// Returns the set of nodes on which the operands or the predicate of `node`
+// transitively depend.
+absl::flat_hash_set<Node*> MergeFanIn(Node* node, Node* predicate) {
+  std::vector<Node*> worklist(node->operands().begin(),
+                              node->operands().end());
+  worklist.push_back(predicate);
+  absl::flat_hash_set<Node*> fan_in;
+  while (!worklist.empty()) {
+    Node* n = worklist.back();
+    worklist.pop_back();
+    if (!fan_in.insert(n).second) {
+      continue;
+    }
+    worklist.insert(worklist.end(), n->operands().begin(),
+                    n->operands().end());
+  }
+  return fan_in;
+}
+
+// Removes the nodes in `nodes` which are dead, users first.
+absl::Status RemoveDeadNodes(FunctionBase* f,
+                             const absl::flat_hash_set<Node*>& nodes) {
+  std::vector<Node*> to_remove;
+  for (Node* node : ReverseTopoSort(f)) {
+    if (nodes.contains(node)) {
+      to_remove.push_back(node);
+    }
+  }
+  for (Node* node : to_remove) {
+    if (node->users().empty() && !f->HasImplicitUse(node)) {
+      XLS_RETURN_IF_ERROR(f->RemoveNode(node));
+    }
+  }
+  return absl::OkStatus();
+}
+
+// Attempts to replace the operations in `to_merge`, whose predicates are
+// pairwise mutually exclusive, with a single operation. Returns whether the
+// operations were merged. Operations are dropped from the group if merging
+// them would introduce a cycle, and the merge is abandoned if it would make
+// any path through the function longer than `target_ps`.
+absl::StatusOr<bool> MergeOperations(Predicates* p, FunctionBase* f,
+                                     absl::Span<Node* const> to_merge,
+                                     int64_t target_ps) {
+  // The merged operation depends on the operands and predicates of every
+  // member, and replaces every member, so no member may feed another.
+  std::vector<Node*> kept;
+  std::vector<absl::flat_hash_set<Node*>> kept_fan_in;
+  for (Node* node : to_merge) {
+    absl::flat_hash_set<Node*> fan_in =
+        MergeFanIn(node, p->GetPredicate(node).value());
+    bool independent = true;
+    for (int64_t i = 0; i < kept.size(); ++i) {
+      if (fan_in.contains(kept[i]) || kept_fan_in[i].contains(node)) {
+        independent = false;
+        break;
+      }
+    }
+    if (independent) {
+      kept.push_back(node);
+      kept_fan_in.push_back(std::move(fan_in));
+    }
+  }
+  if (kept.size() < 2) {
+    return false;
+  }
+
+  absl::flat_hash_map<Node*, int64_t> required =
+      ComputeRequiredTimes(f, target_ps);
+  int64_t required_ps = target_ps;
+  for (Node* node : kept) {
+    required_ps = std::min(required_ps, required.at(node));
+  }
+
+  absl::flat_hash_set<Node*> new_nodes;
+  std::vector<Node*> predicates;
+  for (Node* node : kept) {
+    predicates.push_back(p->GetPredicate(node).value());
+  }
+  XLS_ASSIGN_OR_RETURN(Node * selector,
+                       f->MakeNode<Concat>(SourceInfo(), predicates));
+  new_nodes.insert(selector);
+
+  std::vector<Node*> operands;
+  for (int64_t i = 0; i < kept.front()->operand_count(); ++i) {
+    std::vector<Node*> cases;
+    for (Node* node : kept) {
+      cases.push_back(node->operand(i));
+    }
+    if (std::all_of(cases.begin(), cases.end(),
+                    [&](Node* n) { return n == cases.front(); })) {
+      operands.push_back(cases.front());
+      continue;
+    }
+    // OneHotSelect takes the cases in reverse order of the selector concat.
+    std::reverse(cases.begin(), cases.end());
+    XLS_ASSIGN_OR_RETURN(
+        Node * mux, f->MakeNode<OneHotSelect>(SourceInfo(), selector, cases));
+    new_nodes.insert(mux);
+    operands.push_back(mux);
+  }
+  XLS_ASSIGN_OR_RETURN(Node * shared, kept.front()->Clone(operands));
+  new_nodes.insert(shared);
+
+  int64_t arrival_ps = ComputeArrivalTimes(f).at(shared);
+  std::vector<std::string> names;
+  for (Node* node : kept) {
+    names.push_back(node->GetName());
+  }
+  if (arrival_ps > required_ps) {
+    XLS_VLOG(3) << absl::StreamFormat(
+        "Not sharing %s: shared operation arrives at %dps, required by %dps",
+        absl::StrJoin(names, ", "), arrival_ps, required_ps);
+    XLS_RETURN_IF_ERROR(RemoveDeadNodes(f, new_nodes));
+    return false;
+  }
+
+  XLS_VLOG(2) << absl::StreamFormat("Sharing %s as %s (arrives at %dps)",
+                                    absl::StrJoin(names, ", "),
+                                    shared->GetName(), arrival_ps);
+  for (Node* node : kept) {
+    XLS_RETURN_IF_ERROR(node->ReplaceUsesWith(shared));
+    XLS_RETURN_IF_ERROR(f->RemoveNode(node));
+  }
+  return true;
+}
+
+}  // namespace
+
+absl::StatusOr<bool> ResourceSharingPass::RunOnFunctionBaseInternal(
+    FunctionBase* f, const PassOptions& options, PassResults* results) const {
+  if (!options.resource_sharing || f->IsBlock()) {
+    return false;
+  }
+
+  std::vector<Node*> candidates;
+  for (Node* node : TopoSort(f)) {
+    if (IsShareCandidate(node)) {
+      candidates.push_back(node);
+    }
+  }
+  if (candidates.size() < 2) {
+    return false;
+  }
+
+  // Predicates are built from new nodes which are removed again if they end
+  // up unused.
+  absl::flat_hash_set<Node*> original_nodes(f->nodes().begin(),
+                                            f->nodes().end());
+  Predicates p;
+  XLS_RETURN_IF_ERROR(AddSelectPredicates(&p, f));
+  absl::flat_hash_set<Node*> predicate_nodes;
+  for (Node* node : f->nodes()) {
+    if (!original_nodes.contains(node)) {
+      predicate_nodes.insert(node);
+    }
+  }
+
+  candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+                                  [&](Node* n) {
+                                    return !p.GetPredicate(n).has_value();
+                                  }),
+                   candidates.end());
+
+  // Pairs of candidates which could share an operation if their predicates
+  // are mutually exclusive.
+  std::vector<std::pair<int64_t, int64_t>> pairs;
+  for (int64_t i = 0; i < candidates.size(); ++i) {
+    for (int64_t j = i + 1; j < candidates.size(); ++j) {
+      Node* pred_i = p.GetPredicate(candidates[i]).value();
+      Node* pred_j = p.GetPredicate(candidates[j]).value();
+      if (pred_i != pred_j &&
+          HaveSameSignature(candidates[i], candidates[j])) {
+        pairs.push_back({i, j});
+      }
+    }
+  }
+  if (pairs.empty()) {
+    XLS_RETURN_IF_ERROR(RemoveDeadNodes(f, predicate_nodes));
+    return false;
+  }
+
+  // Try to prove exclusivity with a BDD first, which is cheap and handles
+  // predicates over narrow selectors exactly, then fall back to Z3 for the
+  // remaining pairs.
+  int64_t path_limit = results->budget.ShouldDegrade()
+                           ? BddFunction::kReducedPathLimit
+                           : BddFunction::kDefaultPathLimit;
+  BddQueryEngine query_engine(path_limit, IsCheapForBdds);
+  XLS_RETURN_IF_ERROR(query_engine.Populate(f).status());
+  bool any_unknown = false;
+  for (const auto& [i, j] : pairs) {
+    Node* pred_i = p.GetPredicate(candidates[i]).value();
+    Node* pred_j = p.GetPredicate(candidates[j]).value();
+    if (p.QueryMutuallyExclusive(pred_i, pred_j).has_value()) {
+      continue;
+    }
+    if (query_engine.AtMostOneNodeTrue({pred_i, pred_j})) {
+      XLS_RETURN_IF_ERROR(p.MarkMutuallyExclusive(pred_i, pred_j));
+    } else {
+      any_unknown = true;
+    }
+  }
+  if (any_unknown) {
+    if (results->budget.ShouldDegrade()) {
+      results->budget.RecordOnce(
+          short_name(),
+          absl::StrFormat(
+              "%s: skipped SMT mutual exclusion queries starting with %s",
+              short_name(), f->name()));
+    } else {
+      XLS_RETURN_IF_ERROR(ComputeMutualExclusion(&p, f, IsShareableOp));
+    }
+  }
+
+  // Group the candidates by coloring the graph of pairs which can not share.
+  absl::flat_hash_map<int64_t, absl::flat_hash_set<int64_t>> can_share;
+  for (const auto& [i, j] : pairs) {
+    Node* pred_i = p.GetPredicate(candidates[i]).value();
+    Node* pred_j = p.GetPredicate(candidates[j]).value();
+    if (p.QueryMutuallyExclusive(pred_i, pred_j) == std::make_optional(true)) {
+      can_share[i].insert(j);
+      can_share[j].insert(i);
+    }
+  }
+  std::vector<int64_t> iota(candidates.size());
+  std::iota(iota.begin(), iota.end(), 0);
+  absl::flat_hash_set<int64_t> vertices(iota.begin(), iota.end());
+  std::vector<absl::flat_hash_set<int64_t>> coloring =
+      RecursiveLargestFirstColoring<int64_t>(
+          vertices, [&](int64_t index) -> absl::flat_hash_set<int64_t> {
+            absl::flat_hash_set<int64_t> conflicts = vertices;
+            conflicts.erase(index);
+            if (can_share.contains(index)) {
+              for (int64_t other : can_share.at(index)) {
+                conflicts.erase(other);
+              }
+            }
+            return conflicts;
+          });
+
+  // Merge larger groups first and otherwise in topological order.
+  std::vector<std::vector<Node*>> groups;
+  for (const absl::flat_hash_set<int64_t>& color_class : coloring) {
+    if (color_class.size() < 2) {
+      continue;
+    }
+    std::vector<int64_t> indices(color_class.begin(), color_class.end());
+    std::sort(indices.begin(), indices.end());
+    std::vector<Node*> group;
+    for (int64_t index : indices) {
+      group.push_back(candidates[index]);
+    }
+    groups.push_back(std::move(group));
+  }
+  absl::flat_hash_map<Node*, int64_t> topo_index;
+  for (int64_t i = 0; i < candidates.size(); ++i) {
+    topo_index[candidates[i]] = i;
+  }
+  std::sort(groups.begin(), groups.end(),
+            [&](const std::vector<Node*>& a, const std::vector<Node*>& b) {
+              if (a.size() != b.size()) {
+                return a.size() > b.size();
+              }
+              return topo_index.at(a.front()) < topo_index.at(b.front());
+            });
+
+  bool changed = false;
+  for (const std::vector<Node*>& group : groups) {
+    int64_t critical_path_ps = 0;
+    for (const auto& [node, arrival] : ComputeArrivalTimes(f)) {
+      critical_path_ps = std::max(critical_path_ps, arrival);
+    }
+    int64_t target_ps =
+        std::max(critical_path_ps, clock_period_ps_.value_or(0));
+    XLS_ASSIGN_OR_RETURN(bool merged,
+                         MergeOperations(&p, f, group, target_ps));
+    changed |= merged;
+  }
+
+  // The predicates which are not used by a shared operation are removed so the
+  // function is unchanged if nothing was shared.
+  XLS_RETURN_IF_ERROR(RemoveDeadNodes(f, predicate_nodes));
+  return changed;
+}
+
+}  // namespace xls
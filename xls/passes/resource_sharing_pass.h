@@ -0,0 +1,77 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_PASSES_RESOURCE_SHARING_PASS_H_
+#define XLS_PASSES_RESOURCE_SHARING_PASS_H_
+
+#include <cstdint>
+#include <optional>
+
+#include "absl/status/statusor.h"
+#include "xls/ir/function_base.h"
+#include "xls/passes/passes.h"
+
+namespace xls {
+
+// Pass which merges expensive arithmetic operations (multipliers, dividers and
+// wide adders) which are never used at the same time into a single operation
+// whose operands are selected by the predicates of the merged operations. For
+// example:
+//
+//   sel(s, cases=[umul(a, b), umul(c, d)])
+//
+// becomes
+//
+//   sel(s, cases=[umul(x, y), umul(x, y)])
+//
+// where `x = one_hot_sel({s == 1, s == 0}, [c, a])` and similarly for `y`.
+//
+// Predicates are derived from the select arms which postdominate each
+// operation (see AddSelectPredicates). Mutual exclusion of the predicates is
+// established with a BDD and, failing that, with an SMT solver. Groups of
+// mutually exclusive operations are formed by graph coloring.
+//
+// Sharing inserts a mux in front of each operand which lengthens the paths
+// through the shared operation. A group is only merged if, as estimated by the
+// standard delay model, the critical path of the function does not become
+// longer than the larger of its current length and `clock_period_ps`.
+//
+// The pass only runs if PassOptions::resource_sharing is set.
+class ResourceSharingPass : public FunctionBasePass {
+ public:
+  // Adders and subtractors narrower than this are too cheap to be worth
+  // sharing. Multipliers and dividers are always considered.
+  static constexpr int64_t kMinSharedAdderWidth = 32;
+
+  explicit ResourceSharingPass(
+      std::optional<int64_t> clock_period_ps = std::nullopt)
+      : FunctionBasePass("resource_sharing",
+                         "Share mutually exclusive arithmetic operations"),
+        clock_period_ps_(clock_period_ps) {}
+  ~ResourceSharingPass() override {}
+
+  bool IsExpensive() const override { return true; }
+
+ protected:
+  absl::StatusOr<bool> RunOnFunctionBaseInternal(
+      FunctionBase* f, const PassOptions& options,
+      PassResults* results) const override;
+
+ private:
+  std::optional<int64_t> clock_period_ps_;
+};
+
+}  // namespace xls
+
+#endif  // XLS_PASSES_RESOURCE_SHARING_PASS_H_
@@ -0,0 +1,170 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/passes/resource_sharing_pass.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/statusor.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/function.h"
+#include "xls/ir/ir_matcher.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/passes/dce_pass.h"
+#include "xls/passes/passes.h"
+
+namespace xls {
+namespace {
+
+using status_testing::IsOkAndHolds;
+namespace m = ::xls::op_matchers;
+
+class ResourceSharingPassTest : public IrTestBase {
+ protected:
+  ResourceSharingPassTest() = default;
+
+  absl::StatusOr<bool> Run(FunctionBase* f,
+                           std::optional<int64_t> clock_period_ps,
+                           bool resource_sharing = true) {
+    PassOptions options;
+    options.resource_sharing = resource_sharing;
+    PassResults results;
+    XLS_ASSIGN_OR_RETURN(bool changed,
+                         ResourceSharingPass(clock_period_ps)
+                             .RunOnFunctionBase(f, options, &results));
+    XLS_RETURN_IF_ERROR(DeadCodeEliminationPass()
+                            .RunOnFunctionBase(f, options, &results)
+                            .status());
+    return changed;
+  }
+};
+
+int64_t NumberOfOp(FunctionBase* f, Op op) {
+  int64_t result = 0;
+  for (Node* node : f->nodes()) {
+    if (node->op() == op) {
+      ++result;
+    }
+  }
+  return result;
+}
+
+constexpr char kTwoMultipliers[] = R"(
+  package test_module
+
+  top fn main(s: bits[1], a: bits[32], b: bits[32], c: bits[32],
+              d: bits[32]) -> bits[32] {
+    umul.1: bits[32] = umul(a, b)
+    umul.2: bits[32] = umul(c, d)
+    ret sel.3: bits[32] = sel(s, cases=[umul.1, umul.2])
+  }
+)";
+
+TEST_F(ResourceSharingPassTest, MultipliersInSelectArms) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> p,
+                           ParsePackage(kTwoMultipliers));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, p->GetTopAsFunction());
+  EXPECT_THAT(Run(f, /*clock_period_ps=*/1000000), IsOkAndHolds(true));
+  EXPECT_EQ(NumberOfOp(f, Op::kUMul), 1);
+  EXPECT_THAT(f->return_value(),
+              m::Select(m::Param("s"),
+                        {m::UMul(m::OneHotSelect(m::Concat(), {m::Param("c"),
+                                                     m::Param("a")}),
+                                 m::OneHotSelect(m::Concat(), {m::Param("d"),
+                                                     m::Param("b")})),
+                         m::UMul()}));
+}
+
+TEST_F(ResourceSharingPassTest, SharingWouldLengthenCriticalPath) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> p,
+                           ParsePackage(kTwoMultipliers));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, p->GetTopAsFunction());
+  int64_t node_count = f->node_count();
+  // The muxes in front of the shared multiplier would lengthen the critical
+  // path, which is only allowed up to the clock period.
+  EXPECT_THAT(Run(f, /*clock_period_ps=*/std::nullopt), IsOkAndHolds(false));
+  EXPECT_EQ(NumberOfOp(f, Op::kUMul), 2);
+  EXPECT_EQ(f->node_count(), node_count);
+}
+
+TEST_F(ResourceSharingPassTest, DisabledByDefault) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> p,
+                           ParsePackage(kTwoMultipliers));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, p->GetTopAsFunction());
+  EXPECT_THAT(Run(f, /*clock_period_ps=*/1000000, /*resource_sharing=*/false),
+              IsOkAndHolds(false));
+  EXPECT_EQ(NumberOfOp(f, Op::kUMul), 2);
+}
+
+TEST_F(ResourceSharingPassTest, SharedOperandIsNotMuxed) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> p, ParsePackage(R"(
+    package test_module
+
+    top fn main(s: bits[2], a: bits[32], b: bits[32], c: bits[32],
+                d: bits[32]) -> bits[32] {
+      udiv.1: bits[32] = udiv(a, b)
+      udiv.2: bits[32] = udiv(a, c)
+      udiv.3: bits[32] = udiv(a, d)
+      ret sel.4: bits[32] = sel(s, cases=[udiv.1, udiv.2, udiv.3], default=a)
+    }
+  )"));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, p->GetTopAsFunction());
+  EXPECT_THAT(Run(f, /*clock_period_ps=*/1000000), IsOkAndHolds(true));
+  EXPECT_EQ(NumberOfOp(f, Op::kUDiv), 1);
+  EXPECT_THAT(f->return_value(),
+              m::Select(m::Param("s"),
+                        {m::UDiv(m::Param("a"), m::OneHotSelect()),
+                         m::UDiv(), m::UDiv()},
+                        m::Param("a")));
+}
+
+TEST_F(ResourceSharingPassTest, NotMutuallyExclusive) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> p, ParsePackage(R"(
+    package test_module
+
+    top fn main(s: bits[1], a: bits[32], b: bits[32], c: bits[32],
+                d: bits[32]) -> bits[32] {
+      umul.1: bits[32] = umul(a, b)
+      umul.2: bits[32] = umul(c, d)
+      sel.3: bits[32] = sel(s, cases=[umul.1, umul.2])
+      ret add.4: bits[32] = add(sel.3, umul.2)
+    }
+  )"));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, p->GetTopAsFunction());
+  EXPECT_THAT(Run(f, /*clock_period_ps=*/1000000), IsOkAndHolds(false));
+  EXPECT_EQ(NumberOfOp(f, Op::kUMul), 2);
+}
+
+TEST_F(ResourceSharingPassTest, NarrowAddersAreNotShared) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> p, ParsePackage(R"(
+    package test_module
+
+    top fn main(s: bits[1], a: bits[8], b: bits[8], c: bits[8],
+                d: bits[8]) -> bits[8] {
+      add.1: bits[8] = add(a, b)
+      add.2: bits[8] = add(c, d)
+      ret sel.3: bits[8] = sel(s, cases=[add.1, add.2])
+    }
+  )"));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, p->GetTopAsFunction());
+  EXPECT_THAT(Run(f, /*clock_period_ps=*/1000000), IsOkAndHolds(false));
+  EXPECT_EQ(NumberOfOp(f, Op::kAdd), 2);
+}
+
+}  // namespace
+}  // namespace xls
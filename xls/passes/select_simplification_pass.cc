@@ -969,8 +969,16 @@ absl::StatusOr<bool> SimplifyNode(Node* node, const QueryEngine& query_engine,
 absl::StatusOr<bool> SelectSimplificationPass::RunOnFunctionBaseInternal(
     FunctionBase* func, const PassOptions& options,
     PassResults* results) const {
-  TernaryQueryEngine query_engine;
-  XLS_RETURN_IF_ERROR(query_engine.Populate(func).status());
+  XLS_ASSIGN_OR_RETURN(
+      TernaryQueryEngine * cached_query_engine,
+      results->analysis_manager.GetOrCreate<TernaryQueryEngine>(
+          func, "ternary_query_engine",
+          [func]() -> absl::StatusOr<std::unique_ptr<TernaryQueryEngine>> {
+            auto query_engine = std::make_unique<TernaryQueryEngine>();
+            XLS_RETURN_IF_ERROR(query_engine->Populate(func).status());
+            return query_engine;
+          }));
+  const TernaryQueryEngine& query_engine = *cached_query_engine;
   bool changed = false;
   for (Node* node : TopoSort(func)) {
     XLS_ASSIGN_OR_RETURN(bool node_changed,
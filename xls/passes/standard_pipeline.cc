@@ -25,6 +25,7 @@
 #include "xls/passes/bit_slice_simplification_pass.h"
 #include "xls/passes/boolean_simplification_pass.h"
 #include "xls/passes/canonicalization_pass.h"
+#include "xls/passes/carry_save_compression_pass.h"
 #include "xls/passes/comparison_simplification_pass.h"
 #include "xls/passes/concat_simplification_pass.h"
 #include "xls/passes/conditional_specialization_pass.h"
@@ -40,8 +41,10 @@
 #include "xls/passes/narrowing_pass.h"
 #include "xls/passes/proc_inlining_pass.h"
 #include "xls/passes/proc_state_flattening_pass.h"
+#include "xls/passes/proc_state_narrowing_pass.h"
 #include "xls/passes/proc_state_optimization_pass.h"
 #include "xls/passes/reassociation_pass.h"
+#include "xls/passes/resource_sharing_pass.h"
 #include "xls/passes/select_simplification_pass.h"
 #include "xls/passes/sparsify_select_pass.h"
 #include "xls/passes/strength_reduction_pass.h"
@@ -164,8 +167,22 @@ std::unique_ptr<CompoundPass> CreateStandardPassPipeline(int64_t opt_level) {
   top->Add<ProcStateOptimizationPass>();
   top->Add<DeadCodeEliminationPass>();
 
+  // Narrow the remaining state elements and clean up the slices and concats
+  // introduced at the state boundary.
+  top->Add<ProcStateNarrowingPass>();
+  top->Add<DeadCodeEliminationPass>();
+  top->Add<SimplificationPass>(std::min(int64_t{3}, opt_level));
+  top->Add<DeadCodeEliminationPass>();
+
   top->Add<MutualExclusionPass>();
   top->Add<DeadCodeEliminationPass>();
+  top->Add<ResourceSharingPass>();
+  top->Add<DeadCodeEliminationPass>();
+
+  // Compress multi-operand additions once no other pass needs to see them as
+  // arithmetic.
+  top->Add<CarrySaveCompressionPass>();
+  top->Add<DeadCodeEliminationPass>();
   top->Add<SimplificationPass>(std::min(int64_t{3}, opt_level));
 
   top->Add<LiteralUncommoningPass>();
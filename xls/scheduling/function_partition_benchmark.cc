@@ -0,0 +1,91 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmarks of the min-cut computations underlying the MIN_CUT scheduling
+// strategy on the min-cut graphs of the example designs.
+
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "include/benchmark/benchmark.h"
+#include "xls/common/logging/logging.h"
+#include "xls/delay_model/delay_estimator.h"
+#include "xls/delay_model/delay_estimators.h"
+#include "xls/examples/sample_packages.h"
+#include "xls/ir/function.h"
+#include "xls/ir/node_iterator.h"
+#include "xls/ir/package.h"
+#include "xls/scheduling/function_partition.h"
+#include "xls/scheduling/pipeline_schedule.h"
+#include "xls/scheduling/scheduling_options.h"
+
+namespace xls {
+namespace {
+
+// Partitions the middle half (in topological order) of the nodes of the
+// benchmark function. This is the shape of the partitioning problem solved at
+// each pipeline stage boundary by the min-cut scheduler.
+static void BM_MinCostFunctionPartition(benchmark::State& state,
+                                        std::string_view benchmark_name) {
+  std::unique_ptr<Package> p =
+      sample_packages::GetBenchmark(benchmark_name, /*optimized=*/true).value();
+  Function* f = p->GetTopAsFunction().value();
+  std::vector<Node*> topo_sort;
+  for (Node* node : TopoSort(f)) {
+    topo_sort.push_back(node);
+  }
+  absl::Span<Node* const> partitionable_nodes =
+      absl::MakeConstSpan(topo_sort)
+          .subspan(topo_sort.size() / 4, topo_sort.size() / 2);
+  for (auto _ : state) {
+    auto partition = sched::MinCostFunctionPartition(f, partitionable_nodes);
+    benchmark::DoNotOptimize(partition);
+  }
+  state.counters["nodes"] = partitionable_nodes.size();
+}
+
+// Schedules the benchmark function into `state.range(0)` stages with the
+// MIN_CUT strategy which computes a min cut for each stage boundary.
+static void BM_MinCutSchedule(benchmark::State& state,
+                              std::string_view benchmark_name) {
+  std::unique_ptr<Package> p =
+      sample_packages::GetBenchmark(benchmark_name, /*optimized=*/true).value();
+  Function* f = p->GetTopAsFunction().value();
+  const DelayEstimator* delay_estimator = GetDelayEstimator("unit").value();
+  SchedulingOptions options(SchedulingStrategy::MIN_CUT);
+  options.pipeline_stages(state.range(0));
+  for (auto _ : state) {
+    absl::StatusOr<PipelineSchedule> schedule =
+        PipelineSchedule::Run(f, *delay_estimator, options);
+    XLS_CHECK_OK(schedule.status());
+    benchmark::DoNotOptimize(schedule);
+  }
+  state.counters["nodes"] = f->node_count();
+}
+
+BENCHMARK_CAPTURE(BM_MinCostFunctionPartition, adler32, "examples/adler32");
+BENCHMARK_CAPTURE(BM_MinCostFunctionPartition, crc32, "examples/crc32");
+BENCHMARK_CAPTURE(BM_MinCostFunctionPartition, sha256, "examples/sha256");
+
+BENCHMARK_CAPTURE(BM_MinCutSchedule, crc32, "examples/crc32")
+    ->Arg(2)
+    ->Arg(8);
+BENCHMARK_CAPTURE(BM_MinCutSchedule, sha256, "examples/sha256")
+    ->Arg(2)
+    ->Arg(8)
+    ->Arg(32);
+
+}  // namespace
+}  // namespace xls
@@ -20,6 +20,7 @@
 #include <random>
 
 #include "absl/container/btree_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
@@ -209,6 +210,67 @@ absl::StatusOr<int64_t> FindMinimumClockPeriod(
   return min_period;
 }
 
+// Duplicates each node in `recomputed_nodes` into each later cycle in which it
+// has users, so that the node's value need not be carried in pipeline
+// registers. Literal operands of the recomputed nodes are duplicated as well.
+// Nodes which become dead are removed. `cycle_map` is updated accordingly.
+absl::Status RecomputeNodes(FunctionBase* f,
+                            const absl::flat_hash_set<Node*>& recomputed_nodes,
+                            ScheduleCycleMap* cycle_map) {
+  auto clone_in_cycle = [&](Node* node, absl::Span<Node* const> operands,
+                            int64_t cycle) -> absl::StatusOr<Node*> {
+    XLS_ASSIGN_OR_RETURN(Node * clone, node->Clone(operands));
+    if (node->HasAssignedName()) {
+      clone->SetName(absl::StrFormat("%s_recompute_%d", node->GetName(), cycle));
+    }
+    (*cycle_map)[clone] = cycle;
+    return clone;
+  };
+  auto remove_if_dead = [&](Node* node) -> absl::Status {
+    if (node->users().empty() && !f->HasImplicitUse(node)) {
+      cycle_map->erase(node);
+      XLS_RETURN_IF_ERROR(f->RemoveNode(node));
+    }
+    return absl::OkStatus();
+  };
+
+  for (Node* node : TopoSort(f).AsVector()) {
+    if (!recomputed_nodes.contains(node)) {
+      continue;
+    }
+    int64_t node_cycle = cycle_map->at(node);
+    absl::btree_map<int64_t, std::vector<Node*>> users_by_cycle;
+    for (Node* user : node->users()) {
+      int64_t user_cycle = cycle_map->at(user);
+      if (user_cycle > node_cycle) {
+        users_by_cycle[user_cycle].push_back(user);
+      }
+    }
+    for (const auto& [cycle, users] : users_by_cycle) {
+      std::vector<Node*> operands;
+      for (Node* operand : node->operands()) {
+        if (operand->Is<Literal>()) {
+          XLS_ASSIGN_OR_RETURN(operand, clone_in_cycle(operand, {}, cycle));
+        }
+        operands.push_back(operand);
+      }
+      XLS_ASSIGN_OR_RETURN(Node * clone, clone_in_cycle(node, operands, cycle));
+      for (Node* user : users) {
+        user->ReplaceOperand(node, clone);
+      }
+    }
+    std::vector<Node*> operands(node->operands().begin(),
+                                node->operands().end());
+    XLS_RETURN_IF_ERROR(remove_if_dead(node));
+    for (Node* operand : operands) {
+      if (operand->Is<Literal>()) {
+        XLS_RETURN_IF_ERROR(remove_if_dead(operand));
+      }
+    }
+  }
+  return absl::OkStatus();
+}
+
 }  // namespace
 
 PipelineSchedule::PipelineSchedule(FunctionBase* function_base,
@@ -364,16 +426,34 @@ std::vector<Node*> PipelineSchedule::GetLiveOutOfCycle(int64_t c) const {
   }
 
   ScheduleCycleMap cycle_map;
+  int64_t recompute_flop_savings = 0;
   if (options.strategy() == SchedulingStrategy::MIN_CUT) {
     XLS_ASSIGN_OR_RETURN(
         cycle_map,
         MinCutScheduler(f, schedule_length, clock_period_ps, input_delay_added,
                         &bounds, options.constraints()));
   } else if (options.strategy() == SchedulingStrategy::SDC) {
+    absl::flat_hash_set<Node*> recomputed_nodes;
     XLS_ASSIGN_OR_RETURN(
         cycle_map,
         SDCScheduler(f, schedule_length, clock_period_ps, input_delay_added,
-                     &bounds, options.constraints()));
+                     &bounds, options.constraints(),
+                     /*check_feasibility=*/false,
+                     options.recompute_cheap_values() ? &recomputed_nodes
+                                                      : nullptr));
+    if (!recomputed_nodes.empty()) {
+      int64_t flops_before =
+          PipelineSchedule(f, cycle_map, options.pipeline_stages())
+              .CountFinalInteriorPipelineRegisters();
+      XLS_RETURN_IF_ERROR(RecomputeNodes(f, recomputed_nodes, &cycle_map));
+      int64_t flops_after =
+          PipelineSchedule(f, cycle_map, options.pipeline_stages())
+              .CountFinalInteriorPipelineRegisters();
+      recompute_flop_savings = flops_before - flops_after;
+      XLS_VLOG(2) << absl::StreamFormat(
+          "Recomputed %d nodes saving %d pipeline register bits",
+          recomputed_nodes.size(), recompute_flop_savings);
+    }
   } else if (options.strategy() == SchedulingStrategy::RANDOM) {
     std::mt19937_64 gen(options.seed().value_or(0));
 
@@ -398,6 +478,7 @@ std::vector<Node*> PipelineSchedule::GetLiveOutOfCycle(int64_t c) const {
   }
 
   auto schedule = PipelineSchedule(f, cycle_map, options.pipeline_stages());
+  schedule.recompute_flop_savings_ = recompute_flop_savings;
   XLS_RETURN_IF_ERROR(schedule.Verify());
   XLS_RETURN_IF_ERROR(
       schedule.VerifyTiming(clock_period_ps, input_delay_added));
@@ -31,7 +31,8 @@ namespace xls {
 class PipelineSchedule {
  public:
   // Produces a feed-forward pipeline schedule using the given delay model and
-  // scheduling options.
+  // scheduling options. If SchedulingOptions::recompute_cheap_values is set,
+  // nodes may be duplicated in `f` so that they are recomputed in later stages.
   static absl::StatusOr<PipelineSchedule> Run(
       FunctionBase* f, const DelayEstimator& delay_estimator,
       const SchedulingOptions& options);
@@ -94,6 +95,12 @@ class PipelineSchedule {
   // Returns the number of internal registers in this schedule.
   int64_t CountFinalInteriorPipelineRegisters() const;
 
+  // Returns the number of pipeline register bits saved by recomputing values
+  // in later stages rather than carrying them in registers. Only non-zero if
+  // the schedule was produced by Run with
+  // SchedulingOptions::recompute_cheap_values enabled.
+  int64_t recompute_flop_savings() const { return recompute_flop_savings_; }
+
  private:
   FunctionBase* function_base_;
 
@@ -102,6 +109,8 @@ class PipelineSchedule {
 
   // The nodes scheduled each cycle.
   std::vector<std::vector<Node*>> cycle_to_nodes_;
+
+  int64_t recompute_flop_savings_ = 0;
 };
 
 }  // namespace xls
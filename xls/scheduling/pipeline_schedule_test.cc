@@ -827,6 +827,48 @@ TEST_F(PipelineScheduleTest, ProcScheduleWithConstraints) {
   }
 }
 
+TEST_F(PipelineScheduleTest, RecomputeCheapValues) {
+  // The zero-delay concat `wide` is used in the first and the last stage.
+  // Recomputing it in the last stage only requires carrying the narrow `x`.
+  auto build_function = [&](Package* p) -> absl::StatusOr<Function*> {
+    FunctionBuilder fb(TestName(), p);
+    BValue x = fb.Param("x", p->GetBitsType(8));
+    BValue y = fb.Param("y", p->GetBitsType(32));
+    BValue wide = fb.Concat({fb.Literal(UBits(0, 24)), x});
+    BValue chain = fb.Negate(fb.Negate(fb.Add(wide, y)));
+    return fb.BuildWithReturnValue(fb.Add(chain, wide));
+  };
+  SchedulingOptions options;
+  options.clock_period_ps(1).pipeline_stages(4);
+
+  {
+    auto p = CreatePackage();
+    XLS_ASSERT_OK_AND_ASSIGN(Function * f, build_function(p.get()));
+    XLS_ASSERT_OK_AND_ASSIGN(
+        PipelineSchedule schedule,
+        PipelineSchedule::Run(f, TestDelayEstimator(), options));
+    EXPECT_EQ(schedule.CountFinalInteriorPipelineRegisters(), 192);
+    EXPECT_EQ(schedule.recompute_flop_savings(), 0);
+  }
+
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, build_function(p.get()));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      PipelineSchedule schedule,
+      PipelineSchedule::Run(f, TestDelayEstimator(),
+                            options.recompute_cheap_values(true)));
+  EXPECT_EQ(schedule.CountFinalInteriorPipelineRegisters(), 120);
+  EXPECT_EQ(schedule.recompute_flop_savings(), 72);
+
+  Node* recomputed = f->return_value()->operand(1);
+  EXPECT_THAT(recomputed, m::Concat(m::Literal(), m::Param("x")));
+  EXPECT_EQ(schedule.cycle(recomputed), 3);
+  EXPECT_EQ(schedule.cycle(recomputed->operand(0)), 3);
+  EXPECT_THAT(f->return_value()->operand(0),
+              m::Neg(m::Neg(m::Add(m::Concat(m::Literal(), m::Param("x")),
+                                   m::Param("y")))));
+}
+
 TEST_F(PipelineScheduleTest, RandomSchedule) {
   auto p = CreatePackage();
   FunctionBuilder fb(TestName(), p.get());
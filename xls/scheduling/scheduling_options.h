@@ -178,6 +178,18 @@ class SchedulingOptions {
     return constraints_;
   }
 
+  // Sets/gets whether the SDC scheduler may recompute zero-delay operations
+  // (e.g., bit slices and concats with literals) in the stages of their later
+  // users instead of carrying their values in pipeline registers. The
+  // recompute/register decision is made by the scheduler to minimize the
+  // pipeline register count. Recomputed operations are duplicated in the IR.
+  // Only used if the scheduler is `SDC`.
+  SchedulingOptions& recompute_cheap_values(bool value) {
+    recompute_cheap_values_ = value;
+    return *this;
+  }
+  bool recompute_cheap_values() const { return recompute_cheap_values_; }
+
   // The random seed, which is only used if the scheduler is `RANDOM`.
   SchedulingOptions& seed(int32_t value) {
     seed_ = value;
@@ -194,6 +206,7 @@ class SchedulingOptions {
   std::optional<int64_t> additional_input_delay_ps_;
   std::vector<SchedulingConstraint> constraints_;
   std::optional<int32_t> seed_;
+  bool recompute_cheap_values_ = false;
 };
 
 // A map from node to cycle as a bare-bones representation of a schedule.
@@ -22,6 +22,7 @@
 #include "absl/container/btree_map.h"
 #include "absl/container/btree_set.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
@@ -33,6 +34,8 @@
 #include "xls/data_structures/union_find.h"
 #include "xls/ir/node_iterator.h"
 #include "xls/ir/node_util.h"
+#include "xls/ir/op.h"
+#include "xls/ir/type.h"
 #include "xls/scheduling/schedule_bounds.h"
 #include "ortools/linear_solver/linear_solver.h"
 
@@ -176,12 +179,42 @@ ComputeCombinationalDelayConstraints(FunctionBase* f, int64_t clock_period_ps,
   return result;
 }
 
+// Returns the nodes which the scheduler may choose to recompute in the cycles
+// of their users rather than carry in pipeline registers. These are nodes
+// without side effects whose estimated delay is zero, so placing a copy of the
+// node in a later cycle cannot violate timing. To keep the formulation simple,
+// a node with an operand (other than a literal) which is itself a candidate is
+// not a candidate. Literal operands are always recomputed along with the node.
+absl::flat_hash_set<Node*> ComputeRecomputeCandidates(
+    FunctionBase* f, const DelayMap& delay_map) {
+  absl::flat_hash_set<Node*> candidates;
+  for (Node* node : TopoSort(f)) {
+    if (delay_map.at(node) != 0 || OpIsSideEffecting(node->op()) ||
+        TypeHasToken(node->GetType()) || node->users().empty() ||
+        f->HasImplicitUse(node)) {
+      continue;
+    }
+    if (std::all_of(node->operands().begin(), node->operands().end(),
+                    [&](Node* operand) {
+                      return operand->Is<Literal>() ||
+                             !candidates.contains(operand);
+                    })) {
+      candidates.insert(node);
+    }
+  }
+  return candidates;
+}
+
 class ConstraintBuilder {
  public:
+  // If `recompute_candidates` is non-empty, a binary variable is created for
+  // each candidate indicating whether the node is recomputed in the cycles of
+  // its users and all variables are made integral.
   ConstraintBuilder(FunctionBase* func, or_tools::MPSolver* solver,
                     int64_t pipeline_length, int64_t clock_period_ps,
                     const sched::ScheduleBounds& bounds,
-                    const DelayMap& delay_map);
+                    const DelayMap& delay_map,
+                    const absl::flat_hash_set<Node*>& recompute_candidates);
 
   absl::Status AddDefUseConstraints(Node* node, std::optional<Node*> user);
   absl::Status AddCausalConstraint(Node* node, std::optional<Node*> user);
@@ -201,6 +234,9 @@ class ConstraintBuilder {
 
   absl::StatusOr<ScheduleCycleMap> ExtractResult() const;
 
+  // Returns the candidate nodes which the solution chose to recompute.
+  absl::flat_hash_set<Node*> ExtractRecomputedNodes() const;
+
   absl::flat_hash_map<Node*, or_tools::MPVariable*> GetCycleVars() const {
     return cycle_var_;
   }
@@ -265,6 +301,14 @@ class ConstraintBuilder {
   // graph.
   or_tools::MPVariable* cycle_at_sinknode_;
 
+  // Whether each recompute candidate is recomputed in the cycles of its users
+  // (1) or carried in pipeline registers (0).
+  absl::flat_hash_map<Node*, or_tools::MPVariable*> recompute_var_;
+
+  // An upper bound on the difference between the cycles of any two nodes. Used
+  // to relax lifetime constraints depending on the recompute variables.
+  int64_t max_cycle_difference_;
+
   // A cache of the delay constraints.
   absl::flat_hash_map<Node*, std::vector<Node*>> delay_constraints_;
 };
@@ -274,21 +318,38 @@ ConstraintBuilder::ConstraintBuilder(FunctionBase* func,
                                      int64_t pipeline_length,
                                      int64_t clock_period_ps,
                                      const sched::ScheduleBounds& bounds,
-                                     const DelayMap& delay_map)
+                                     const DelayMap& delay_map,
+                                     const absl::flat_hash_set<Node*>&
+                                         recompute_candidates)
     : func_(func),
       solver_(solver),
       pipeline_length_(pipeline_length),
       clock_period_ps_(clock_period_ps),
       delay_map_(delay_map),
       infinity_(solver->infinity()) {
+  int64_t max_ub = 0;
   for (Node* node : func_->nodes()) {
-    cycle_var_[node] =
-        solver_->MakeNumVar(bounds.lb(node), bounds.ub(node), node->GetName());
-    lifetime_var_[node] = solver_->MakeNumVar(
-        0.0, infinity_, absl::StrFormat("lifetime_%s", node->GetName()));
+    max_ub = std::max(max_ub, bounds.ub(node));
+  }
+  max_cycle_difference_ = std::max(max_ub, pipeline_length - 1);
+
+  // Integer programming solvers require finite bounds on all variables.
+  bool integral = !recompute_candidates.empty();
+  for (Node* node : func_->nodes()) {
+    cycle_var_[node] = solver_->MakeVar(bounds.lb(node), bounds.ub(node),
+                                        integral, node->GetName());
+    lifetime_var_[node] = solver_->MakeVar(
+        0.0, integral ? max_cycle_difference_ : infinity_, integral,
+        absl::StrFormat("lifetime_%s", node->GetName()));
   }
   cycle_at_sinknode_ =
-      solver->MakeNumVar(-infinity_, infinity_, "cycle_at_sinknode");
+      integral ? solver->MakeIntVar(0.0, max_cycle_difference_,
+                                    "cycle_at_sinknode")
+               : solver->MakeNumVar(-infinity_, infinity_, "cycle_at_sinknode");
+  for (Node* node : recompute_candidates) {
+    recompute_var_[node] = solver_->MakeBoolVar(
+        absl::StrFormat("recompute_%s", node->GetName()));
+  }
 }
 
 absl::Status ConstraintBuilder::AddDefUseConstraints(
@@ -337,9 +398,41 @@ absl::Status ConstraintBuilder::AddLifetimeConstraint(
   lifetime->SetCoefficient(cycle_at_node, -1);
   lifetime->SetCoefficient(lifetime_at_node, -1);
 
+  auto recompute_it = recompute_var_.find(node);
+  if (recompute_it == recompute_var_.end()) {
+    XLS_VLOG(2) << "Setting lifetime constraint: "
+                << absl::StrFormat("lifetime[%s] + cycle[%s] - cycle[%s] ≥ 0",
+                                   node->GetName(), node->GetName(), user_str);
+    return absl::OkStatus();
+  }
+
+  // If the node is recomputed in the cycle of the user, the node need not be
+  // carried to the user but its (non-literal) operands must be:
+  //
+  //   cycle[node_user] - cycle[node] - lifetime[node] <= M * recompute[node]
+  //   cycle[node_user] - cycle[operand] - lifetime[operand]
+  //       <= M * (1 - recompute[node])
+  or_tools::MPVariable* recompute = recompute_it->second;
+  lifetime->SetCoefficient(recompute, -max_cycle_difference_);
   XLS_VLOG(2) << "Setting lifetime constraint: "
-              << absl::StrFormat("lifetime[%s] + cycle[%s] - cycle[%s] ≥ 0",
-                                 node->GetName(), node->GetName(), user_str);
+              << absl::StrFormat(
+                     "lifetime[%s] + cycle[%s] - cycle[%s] + %d * "
+                     "recompute[%s] ≥ 0",
+                     node->GetName(), node->GetName(), user_str,
+                     max_cycle_difference_, node->GetName());
+  for (Node* operand : node->operands()) {
+    if (operand->Is<Literal>()) {
+      continue;
+    }
+    or_tools::MPConstraint* operand_lifetime = solver_->MakeRowConstraint(
+        -infinity_, max_cycle_difference_,
+        absl::StrFormat("recompute_lifetime_%s_%s_%s", operand->GetName(),
+                        node->GetName(), user_str));
+    operand_lifetime->SetCoefficient(cycle_at_user, 1);
+    operand_lifetime->SetCoefficient(cycle_var_.at(operand), -1);
+    operand_lifetime->SetCoefficient(lifetime_var_.at(operand), -1);
+    operand_lifetime->SetCoefficient(recompute, max_cycle_difference_);
+  }
 
   return absl::OkStatus();
 }
@@ -544,6 +637,10 @@ absl::Status ConstraintBuilder::AddObjective() {
     objective->SetCoefficient(lifetime_var_.at(node),
                               1024 * node->GetType()->GetFlatBitCount());
   }
+  for (const auto& [node, recompute] : recompute_var_) {
+    // Recomputing a node duplicates logic so only do it if it saves registers.
+    objective->SetCoefficient(recompute, 1);
+  }
   objective->SetMinimization();
   return absl::OkStatus();
 }
@@ -561,13 +658,32 @@ absl::StatusOr<ScheduleCycleMap> ConstraintBuilder::ExtractResult() const {
   return cycle_map;
 }
 
+absl::flat_hash_set<Node*> ConstraintBuilder::ExtractRecomputedNodes() const {
+  absl::flat_hash_set<Node*> result;
+  for (const auto& [node, recompute] : recompute_var_) {
+    if (recompute->solution_value() < 0.5) {
+      continue;
+    }
+    // Only nodes with users in later cycles are actually recomputed.
+    double cycle = cycle_var_.at(node)->solution_value();
+    if (std::any_of(node->users().begin(), node->users().end(),
+                    [&](Node* user) {
+                      return cycle_var_.at(user)->solution_value() >
+                             cycle + 0.5;
+                    })) {
+      result.insert(node);
+    }
+  }
+  return result;
+}
+
 }  // namespace
 
 absl::StatusOr<ScheduleCycleMap> SDCScheduler(
     FunctionBase* f, int64_t pipeline_stages, int64_t clock_period_ps,
     const DelayEstimator& delay_estimator, sched::ScheduleBounds* bounds,
     absl::Span<const SchedulingConstraint> constraints,
-    bool check_feasibility) {
+    bool check_feasibility, absl::flat_hash_set<Node*>* recomputed_nodes) {
   XLS_VLOG(3) << "SDCScheduler()";
   XLS_VLOG(3) << "  pipeline stages = " << pipeline_stages;
   XLS_VLOG_LINES(4, f->DumpIr());
@@ -575,17 +691,29 @@ absl::StatusOr<ScheduleCycleMap> SDCScheduler(
   XLS_VLOG(4) << "Initial bounds:";
   XLS_VLOG_LINES(4, bounds->ToString());
 
+  XLS_ASSIGN_OR_RETURN(DelayMap delay_map,
+                       ComputeNodeDelays(f, delay_estimator));
+
+  // Recomputation only affects the objective so it is not considered when
+  // merely checking feasibility.
+  absl::flat_hash_set<Node*> recompute_candidates;
+  if (recomputed_nodes != nullptr && !check_feasibility) {
+    recompute_candidates = ComputeRecomputeCandidates(f, delay_map);
+  }
+
+  // Without recompute decisions the constraint matrix is totally unimodular
+  // and the problem can be solved as an LP. Otherwise an integer programming
+  // solver is required.
+  std::string solver_name = recompute_candidates.empty() ? "GLOP" : "SAT";
   std::unique_ptr<or_tools::MPSolver> solver(
-      or_tools::MPSolver::CreateSolver("GLOP"));
+      or_tools::MPSolver::CreateSolver(solver_name));
   if (!solver) {
-    return absl::UnavailableError("GLOP solver unavailable.");
+    return absl::UnavailableError(
+        absl::StrFormat("%s solver unavailable.", solver_name));
   }
 
-  XLS_ASSIGN_OR_RETURN(DelayMap delay_map,
-                       ComputeNodeDelays(f, delay_estimator));
-
   ConstraintBuilder builder(f, solver.get(), pipeline_stages, clock_period_ps,
-                            *bounds, delay_map);
+                            *bounds, delay_map, recompute_candidates);
 
   for (const SchedulingConstraint& constraint : constraints) {
     XLS_RETURN_IF_ERROR(builder.AddSchedulingConstraint(constraint));
@@ -614,6 +742,9 @@ absl::StatusOr<ScheduleCycleMap> SDCScheduler(
     return absl::InternalError("The problem does not have an optimal solution");
   }
 
+  if (recomputed_nodes != nullptr) {
+    *recomputed_nodes = builder.ExtractRecomputedNodes();
+  }
   return builder.ExtractResult();
 }
 
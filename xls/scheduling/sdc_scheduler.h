@@ -16,6 +16,7 @@
 #define XLS_SCHEDULING_SDC_SCHEDULER_H_
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "xls/delay_model/delay_estimator.h"
@@ -35,6 +36,15 @@ namespace xls {
 // the LP solver will merely attempt to show that the generated set of
 // constraints is feasible, rather than find an register-optimal schedule.
 //
+// If `recomputed_nodes` is non-null, the scheduler may additionally choose to
+// recompute zero-delay operations (e.g., bit slices and concats with literals)
+// in the cycles of their later users rather than carrying their values in
+// pipeline registers, in which case the operands of the operation are carried
+// instead. This decision is made inside the formulation by a binary variable
+// per candidate operation so the problem is solved as an integer program. The
+// chosen operations are added to `recomputed_nodes`; the caller is responsible
+// for rewriting the IR accordingly.
+//
 // References:
 //   - Cong, Jason, and Zhiru Zhang. "An efficient and versatile scheduling
 //   algorithm based on SDC formulation." 2006 43rd ACM/IEEE Design Automation
@@ -46,7 +56,8 @@ absl::StatusOr<ScheduleCycleMap> SDCScheduler(
     FunctionBase* f, int64_t pipeline_stages, int64_t clock_period_ps,
     const DelayEstimator& delay_estimator, sched::ScheduleBounds* bounds,
     absl::Span<const SchedulingConstraint> constraints,
-    bool check_feasibility = false);
+    bool check_feasibility = false,
+    absl::flat_hash_set<Node*>* recomputed_nodes = nullptr);
 
 }  // namespace xls
 
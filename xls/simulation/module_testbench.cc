@@ -29,6 +29,7 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "xls/codegen/vast.h"
+#include "xls/common/file/temp_file.h"
 #include "xls/common/logging/log_lines.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/source_location.h"
@@ -37,6 +38,7 @@
 #include "xls/common/visitor.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/bits_ops.h"
+#include "xls/ir/format_preference.h"
 #include "xls/ir/number_parser.h"
 #include "xls/simulation/verilog_simulator.h"
 #include "re2/re2.h"
@@ -56,6 +58,14 @@ static constexpr int64_t kSimulationCycleLimit = 10000;
 static_assert(kResetCycles < kSimulationCycleLimit,
               "Reset cycles must be less than the simulation cycle limit.");
 
+// Name of the memory holding the values driven onto the inputs of the design
+// under test, and of the plusarg naming the file from which it is loaded.
+static constexpr char kStimulusMemoryName[] = "__stimulus";
+static constexpr char kStimulusPlusarg[] = "stimulus";
+
+// Maximum length in characters of the path of the stimulus file.
+static constexpr int64_t kMaxStimulusPathLength = 1024;
+
 std::string GetTimeoutMessage() {
   return absl::StrFormat("ERROR: timeout, simulation ran too long (%d cycles).",
                          kSimulationCycleLimit);
@@ -328,9 +338,30 @@ absl::Status ModuleTestbenchThread::CheckOutput(
   return absl::OkStatus();
 }
 
+int64_t ModuleTestbenchThread::GetStimulusCount() const {
+  auto is_stimulus = [&](std::string_view signal_name) {
+    auto it = shared_data_->input_port_widths.find(signal_name);
+    return it != shared_data_->input_port_widths.end() && it->second > 0;
+  };
+  int64_t count = 0;
+  for (const auto& [signal_name, value] : owned_signals_to_drive_) {
+    if (value.has_value() && is_stimulus(signal_name)) {
+      ++count;
+    }
+  }
+  for (const Action& action : actions_) {
+    if (std::holds_alternative<SetSignal>(action) &&
+        is_stimulus(std::get<SetSignal>(action).signal_name)) {
+      ++count;
+    }
+  }
+  return count;
+}
+
 void ModuleTestbenchThread::EmitInto(
     StructuredProcedure* procedure,
-    const absl::flat_hash_map<std::string, LogicRef*>& signal_refs) {
+    const absl::flat_hash_map<std::string, LogicRef*>& signal_refs,
+    TestbenchStimulus* stimulus) {
   XLS_CHECK_NE(procedure, nullptr);
   VerilogFile& file = *procedure->file();
   LogicRef* clk = signal_refs.at(shared_data_->clk_name);
@@ -339,11 +370,20 @@ void ModuleTestbenchThread::EmitInto(
         WaitNCycles(clk, procedure->statements(), a.amount);
       },
       [&](const SetSignal& s) {
-        if (GetSignalWidth(s.signal_name) > 0) {
-          procedure->statements()->Add<NonblockingAssignment>(
-              SourceInfo(), signal_refs.at(s.signal_name),
-              file.Literal(s.value, SourceInfo()));
+        if (GetSignalWidth(s.signal_name) == 0) {
+          return;
+        }
+        Expression* value;
+        if (stimulus != nullptr &&
+            shared_data_->input_port_widths.contains(s.signal_name)) {
+          value = file.Index(stimulus->memory, stimulus->values.size(),
+                             SourceInfo());
+          stimulus->values.push_back(s.value);
+        } else {
+          value = file.Literal(s.value, SourceInfo());
         }
+        procedure->statements()->Add<NonblockingAssignment>(
+            SourceInfo(), signal_refs.at(s.signal_name), value);
       },
       [&](const SetSignalX& s) {
         if (GetSignalWidth(s.signal_name) > 0) {
@@ -634,6 +674,11 @@ absl::Status ModuleTestbench::CheckOutput(std::string_view stdout_str) const {
 }
 
 std::string ModuleTestbench::GenerateVerilog() {
+  return GenerateVerilog(/*stimulus_values=*/nullptr);
+}
+
+std::string ModuleTestbench::GenerateVerilog(
+    std::vector<Bits>* stimulus_values) {
   VerilogFile file(file_type_);
   Module* m = file.AddModule("testbench", SourceInfo());
 
@@ -689,6 +734,51 @@ std::string ModuleTestbench::GenerateVerilog() {
     signal_refs[threads_[index]->done_signal_name().value()] = ref;
   }
 
+  std::optional<TestbenchStimulus> stimulus;
+  int64_t stimulus_count = 0;
+  for (const std::unique_ptr<ModuleTestbenchThread>& thread : threads_) {
+    stimulus_count += thread->GetStimulusCount();
+  }
+  if (stimulus_values != nullptr && stimulus_count > 0) {
+    // Load the stimulus memory from the file named by the plusarg at time zero.
+    // The threads first read the memory after the first cycle.
+    int64_t stimulus_width = 0;
+    for (const auto& [port_name, width] : shared_data_.input_port_widths) {
+      stimulus_width = std::max(stimulus_width, width);
+    }
+    stimulus = TestbenchStimulus{
+        m->AddReg(kStimulusMemoryName,
+                  file.UnpackedArrayType(stimulus_width, {stimulus_count},
+                                         SourceInfo()),
+                  SourceInfo()),
+        {}};
+    LogicRef* path = m->AddReg(
+        "__stimulus_path",
+        file.BitVectorType(8 * kMaxStimulusPathLength, SourceInfo()),
+        SourceInfo());
+    Initial* initial = m->Add<Initial>(SourceInfo());
+    Conditional* missing_plusarg = initial->statements()->Add<Conditional>(
+        SourceInfo(),
+        file.LogicalNot(
+            file.Make<SystemFunctionCall>(
+                SourceInfo(), "value$plusargs",
+                std::vector<Expression*>{
+                    file.Make<QuotedString>(
+                        SourceInfo(),
+                        absl::StrCat(kStimulusPlusarg, "=%s")),
+                    path}),
+            SourceInfo()));
+    missing_plusarg->consequent()->Add<Display>(
+        SourceInfo(), std::vector<Expression*>{file.Make<QuotedString>(
+                          SourceInfo(),
+                          absl::StrFormat("ERROR: missing +%s plusarg.",
+                                          kStimulusPlusarg))});
+    missing_plusarg->consequent()->Add<Finish>(SourceInfo());
+    initial->statements()->Add<SystemTaskCall>(
+        SourceInfo(), "readmemh",
+        std::vector<Expression*>{path, stimulus->memory});
+  }
+
   {
     // Generate the clock. It has a frequency of two time units. Start clk at 0
     // at time zero to avoid any races with rising edge of clock and
@@ -759,7 +849,13 @@ std::string ModuleTestbench::GenerateVerilog() {
   for (int64_t index = 0; index < threads_.size(); ++index) {
     // TODO(vmirian) : Consider lowering the thread to an 'always' block.
     Initial* initial = m->Add<Initial>(SourceInfo());
-    threads_[index]->EmitInto(initial, signal_refs);
+    threads_[index]->EmitInto(initial, signal_refs,
+                              stimulus.has_value() ? &stimulus.value()
+                                                   : nullptr);
+  }
+  if (stimulus.has_value()) {
+    XLS_CHECK_EQ(stimulus->values.size(), stimulus_count);
+    *stimulus_values = std::move(stimulus->values);
   }
 
   {
@@ -801,12 +897,32 @@ std::string ModuleTestbench::GenerateVerilog() {
 }
 
 absl::Status ModuleTestbench::Run() {
-  std::string verilog_text = GenerateVerilog();
+  std::vector<Bits> stimulus_values;
+  std::string verilog_text = simulator_->SupportsPlusargs()
+                                 ? GenerateVerilog(&stimulus_values)
+                                 : GenerateVerilog();
   XLS_VLOG(2) << verilog_text;
 
   std::pair<std::string, std::string> stdout_stderr;
-  XLS_ASSIGN_OR_RETURN(stdout_stderr,
-                       simulator_->Run(verilog_text, file_type_, includes_));
+  if (stimulus_values.empty()) {
+    XLS_ASSIGN_OR_RETURN(stdout_stderr,
+                         simulator_->Run(verilog_text, file_type_, includes_));
+  } else {
+    std::string stimulus_text;
+    for (const Bits& value : stimulus_values) {
+      absl::StrAppend(&stimulus_text,
+                      value.ToString(FormatPreference::kPlainHex), "\n");
+    }
+    XLS_ASSIGN_OR_RETURN(TempFile stimulus_file,
+                         TempFile::CreateWithContent(stimulus_text, ".hex"));
+    std::string stimulus_path = stimulus_file.path().string();
+    XLS_RET_CHECK_LE(stimulus_path.size(), kMaxStimulusPathLength);
+    XLS_ASSIGN_OR_RETURN(
+        stdout_stderr,
+        simulator_->RunWithPlusargs(
+            verilog_text, file_type_, includes_,
+            {absl::StrCat(kStimulusPlusarg, "=", stimulus_path)}));
+  }
 
   XLS_VLOG(2) << "Verilog simulator stdout:\n" << stdout_stderr.first;
   XLS_VLOG(2) << "Verilog simulator stderr:\n" << stdout_stderr.second;
@@ -51,6 +51,17 @@ struct ModuleTestbenchData {
   std::optional<ResetProto> reset;
 };
 
+// Memory in the testbench from which the threads read the values driven onto
+// the inputs of the design under test. The memory is loaded at runtime from a
+// file so the testbench Verilog does not depend on the stimulus values and the
+// simulator can reuse a compiled testbench across runs with different values.
+struct TestbenchStimulus {
+  // The unpacked array holding the values.
+  LogicRef* memory;
+  // The values in the order of their index in the memory.
+  std::vector<Bits> values;
+};
+
 // Provides a fluent interface for driving inputs, capturing outputs, and
 // setting expectations.
 class ModuleTestbenchThread {
@@ -160,9 +171,17 @@ class ModuleTestbenchThread {
       const absl::flat_hash_map<InstanceSignalName, std::variant<Bits, IsX>>&
           parsed_values) const;
 
+  // Returns the number of values the thread drives onto inputs of the design
+  // under test, i.e., the number of entries EmitInto adds to the stimulus.
+  int64_t GetStimulusCount() const;
+
   // Emit the thread contents into the verilog file with the contents specified.
+  // If `stimulus` is not null, the values driven onto inputs of the design
+  // under test are appended to `stimulus` and read from its memory rather than
+  // emitted as literals.
   void EmitInto(StructuredProcedure* procedure,
-                const absl::flat_hash_map<std::string, LogicRef*>& signal_refs);
+                const absl::flat_hash_map<std::string, LogicRef*>& signal_refs,
+                TestbenchStimulus* stimulus = nullptr);
 
  private:
   // Returns the width of the given signal.
@@ -290,10 +309,20 @@ class ModuleTestbench {
   // Generates the Verilog representation of the testbench.
   std::string GenerateVerilog();
 
-  // Runs the simulation.
+  // Runs the simulation. If the simulator supports plusargs, the values driven
+  // onto the inputs are passed in a file named by the `stimulus` plusarg so
+  // that runs of testbenches which differ only in these values reuse the
+  // compiled simulation.
   absl::Status Run();
 
  private:
+  // Generates the Verilog representation of the testbench. If
+  // `stimulus_values` is not null, the values driven onto the inputs of the
+  // design under test are read from a memory loaded with $readmemh from the
+  // file named by the `stimulus` plusarg and are returned in
+  // `stimulus_values`.
+  std::string GenerateVerilog(std::vector<Bits>* stimulus_values);
+
   // Checks the stdout of a simulation run against expectations.
   absl::Status CheckOutput(std::string_view stdout_str) const;
 
@@ -218,6 +218,36 @@ TEST_P(ModuleTestbenchTest, TwoStagePipeline) {
   XLS_ASSERT_OK(tb.Run());
 }
 
+TEST_P(ModuleTestbenchTest, TwoStagePipelineRepeatedWithDifferentInputs) {
+  // Testbenches which differ only in the driven values may share a compiled
+  // simulation; the values of each run must nevertheless be observed.
+  for (uint64_t value : {0x1234, 0xbeef, 0x0042}) {
+    VerilogFile f = NewVerilogFile();
+    Module* m = MakeTwoStageIdentityPipeline(&f);
+
+    ModuleTestbench tb(m, GetSimulator(), "clk");
+    ModuleTestbenchThread& tbt = tb.CreateThread();
+    tbt.Set("in", value);
+    tbt.NextCycle().Set("in", value + 1);
+    tbt.NextCycle().ExpectEq("out", value);
+    tbt.NextCycle().ExpectEq("out", value + 1);
+
+    XLS_ASSERT_OK(tb.Run());
+  }
+
+  VerilogFile f = NewVerilogFile();
+  Module* m = MakeTwoStageIdentityPipeline(&f);
+  ModuleTestbench tb(m, GetSimulator(), "clk");
+  ModuleTestbenchThread& tbt = tb.CreateThread();
+  tbt.Set("in", 0x1234);
+  tbt.NextCycle().Set("in", 0x1235);
+  tbt.NextCycle().ExpectEq("out", 0x0042);
+  tbt.NextCycle().ExpectEq("out", 0x1235);
+  EXPECT_THAT(tb.Run(),
+              StatusIs(absl::StatusCode::kFailedPrecondition,
+                       HasSubstr("to have value: 66, actual: 4660")));
+}
+
 TEST_P(ModuleTestbenchTest, WaitForXAndNotX) {
   VerilogFile f = NewVerilogFile();
   Module* m = MakeTwoStageIdentityPipeline(&f);
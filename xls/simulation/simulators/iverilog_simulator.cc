@@ -12,16 +12,24 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <deque>
+#include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/strip.h"
+#include "absl/synchronization/mutex.h"
 #include "xls/common/file/filesystem.h"
 #include "xls/common/file/get_runfile_path.h"
 #include "xls/common/file/temp_directory.h"
 #include "xls/common/file/temp_file.h"
+#include "xls/common/logging/logging.h"
 #include "xls/common/module_initializer.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/common/subprocess.h"
@@ -68,40 +76,81 @@ absl::StatusOr<std::pair<std::string, std::string>> InvokeVvp(
   return InvokeSubprocess(args_vec);
 }
 
+// Maximum number of compiled simulation images retained by the simulator.
+// Images are evicted in first-in first-out order.
+constexpr int64_t kMaxCachedImages = 64;
+
+// The inputs to iverilog which determine the compiled simulation image.
+struct CompileKey {
+  FileType file_type;
+  std::string text;
+  std::vector<std::pair<std::string, std::string>> includes;
+
+  bool operator==(const CompileKey& other) const {
+    return file_type == other.file_type && text == other.text &&
+           includes == other.includes;
+  }
+
+  template <typename H>
+  friend H AbslHashValue(H h, const CompileKey& key) {
+    return H::combine(std::move(h), key.file_type, key.text, key.includes);
+  }
+};
+
 class IcarusVerilogSimulator : public VerilogSimulator {
  public:
   absl::StatusOr<std::pair<std::string, std::string>> Run(
       std::string_view text, FileType file_type,
       absl::Span<const VerilogInclude> includes) const override {
-    if (file_type == FileType::kSystemVerilog) {
-      return absl::UnimplementedError(
-          "iverilog does not support SystemVerilog");
-    }
-    XLS_ASSIGN_OR_RETURN(TempDirectory temp_top, TempDirectory::Create());
-    XLS_RETURN_IF_ERROR(RecursivelyCreateDir(temp_top.path()));
-    std::filesystem::path temp_dir = temp_top.path();
-
-    std::string top_v_path = temp_dir / GetTopFileName(file_type);
-    XLS_RETURN_IF_ERROR(SetFileContents(top_v_path, text));
-
-    XLS_ASSIGN_OR_RETURN(TempFile temp_out, TempFile::Create(".out"));
+    return RunWithPlusargs(text, file_type, includes, /*plusargs=*/{});
+  }
 
-    XLS_CHECK_OK(SetUpIncludes(temp_dir, includes));
-    XLS_RETURN_IF_ERROR(
-        InvokeIverilog({top_v_path, "-o", temp_out.path().string(), "-I",
-                        temp_dir.string()})
-            .status());
+  bool SupportsPlusargs() const override { return true; }
 
-    return InvokeVvp({temp_out.path().string()});
+  absl::StatusOr<std::pair<std::string, std::string>> RunWithPlusargs(
+      std::string_view text, FileType file_type,
+      absl::Span<const VerilogInclude> includes,
+      absl::Span<const std::string> plusargs) const override {
+    XLS_ASSIGN_OR_RETURN(std::shared_ptr<TempFile> image,
+                         GetOrCompileImage(text, file_type, includes));
+    std::vector<std::string> args = {image->path().string()};
+    for (const std::string& plusarg : plusargs) {
+      args.push_back(absl::StrCat("+", plusarg));
+    }
+    return InvokeVvp(args);
   }
 
   absl::Status RunSyntaxChecking(
       std::string_view text, FileType file_type,
       absl::Span<const VerilogInclude> includes) const override {
+    return GetOrCompileImage(text, file_type, includes).status();
+  }
+
+ private:
+  // Returns the compiled simulation image of the given Verilog. Images are
+  // cached so a testbench which is run repeatedly with different stimulus
+  // (passed as plusargs) is only compiled once.
+  absl::StatusOr<std::shared_ptr<TempFile>> GetOrCompileImage(
+      std::string_view text, FileType file_type,
+      absl::Span<const VerilogInclude> includes) const {
     if (file_type == FileType::kSystemVerilog) {
       return absl::UnimplementedError(
           "iverilog does not support SystemVerilog");
     }
+    CompileKey key{file_type, std::string(text), {}};
+    for (const VerilogInclude& include : includes) {
+      key.includes.push_back(
+          {include.relative_path.string(), include.verilog_text});
+    }
+    {
+      absl::MutexLock lock(&mutex_);
+      auto it = images_.find(key);
+      if (it != images_.end()) {
+        XLS_VLOG(2) << "Reusing compiled iverilog image " << it->second->path();
+        return it->second;
+      }
+    }
+
     XLS_ASSIGN_OR_RETURN(TempDirectory temp_top, TempDirectory::Create());
     XLS_RETURN_IF_ERROR(RecursivelyCreateDir(temp_top.path()));
     std::filesystem::path temp_dir = temp_top.path();
@@ -117,8 +166,27 @@ class IcarusVerilogSimulator : public VerilogSimulator {
                         temp_dir.string()})
             .status());
 
-    return absl::OkStatus();
+    // The image is shared so that evicting it from the cache does not remove
+    // the file while another thread is simulating it.
+    auto image = std::make_shared<TempFile>(std::move(temp_out));
+    absl::MutexLock lock(&mutex_);
+    auto [it, inserted] = images_.try_emplace(key, image);
+    if (!inserted) {
+      // Another thread compiled the same design concurrently.
+      return it->second;
+    }
+    insertion_order_.push_back(std::move(key));
+    if (insertion_order_.size() > kMaxCachedImages) {
+      images_.erase(insertion_order_.front());
+      insertion_order_.pop_front();
+    }
+    return image;
   }
+
+  mutable absl::Mutex mutex_;
+  mutable absl::flat_hash_map<CompileKey, std::shared_ptr<TempFile>> images_
+      ABSL_GUARDED_BY(mutex_);
+  mutable std::deque<CompileKey> insertion_order_ ABSL_GUARDED_BY(mutex_);
 };
 
 XLS_REGISTER_MODULE_INITIALIZER(iverilog_simulator, {
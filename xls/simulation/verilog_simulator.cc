@@ -95,6 +95,15 @@ absl::Status VerilogSimulator::RunSyntaxChecking(std::string_view text,
   return RunSyntaxChecking(text, file_type, /*includes=*/{});
 }
 
+absl::StatusOr<std::pair<std::string, std::string>>
+VerilogSimulator::RunWithPlusargs(
+    std::string_view text, FileType file_type,
+    absl::Span<const VerilogInclude> includes,
+    absl::Span<const std::string> plusargs) const {
+  return absl::UnimplementedError(
+      "Verilog simulator does not support plusargs");
+}
+
 absl::StatusOr<std::vector<Observation>>
 VerilogSimulator::SimulateCombinational(
     std::string_view text, FileType file_type,
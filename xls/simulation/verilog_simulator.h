@@ -57,6 +57,19 @@ class VerilogSimulator {
   absl::Status RunSyntaxChecking(std::string_view text,
                                  FileType file_type) const;
 
+  // Returns whether the simulator supports passing plusargs to the simulation
+  // at runtime via RunWithPlusargs.
+  virtual bool SupportsPlusargs() const { return false; }
+
+  // As Run but passes the given plusargs (without the leading '+') to the
+  // simulation where they can be read with $test$plusargs and
+  // $value$plusargs. Simulators which compile the design before simulation may
+  // reuse the compiled design across runs which differ only in plusargs.
+  virtual absl::StatusOr<std::pair<std::string, std::string>> RunWithPlusargs(
+      std::string_view text, FileType file_type,
+      absl::Span<const VerilogInclude> includes,
+      absl::Span<const std::string> plusargs) const;
+
   // Simulation runner harness: runs the given Verilog text using the verilog
   // simulator infrastructure and returns observations of data values that arose
   // during simulation.
@@ -14,6 +14,10 @@
 
 #include "xls/solvers/z3_ir_translator.h"
 
+#include <algorithm>
+#include <optional>
+#include <vector>
+
 #include "absl/debugging/leak_check.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -1464,6 +1468,118 @@ absl::StatusOr<bool> TryProve(Function* f, Node* subject, Predicate p,
   return false;
 }
 
+namespace {
+
+// Reads the value of "ast" (of XLS type "type") out of a satisfying model.
+absl::StatusOr<Value> ValueFromModel(Z3_context ctx, Z3_model model,
+                                     Type* type, Z3_ast ast) {
+  switch (type->kind()) {
+    case TypeKind::kBits: {
+      // Z3 numerals are only exposed as native integers, so read the value in
+      // 64-bit chunks.
+      int64_t bit_count = type->AsBitsOrDie()->bit_count();
+      BitsRope rope(bit_count);
+      for (int64_t low = 0; low < bit_count; low += 64) {
+        int64_t width = std::min<int64_t>(64, bit_count - low);
+        Z3_ast chunk = Z3_mk_extract(ctx, low + width - 1, low, ast);
+        Z3_ast chunk_value;
+        uint64_t chunk_bits;
+        if (!Z3_model_eval(ctx, model, chunk, /*model_completion=*/true,
+                           &chunk_value) ||
+            !Z3_get_numeral_uint64(ctx, chunk_value, &chunk_bits)) {
+          return absl::InternalError(
+              absl::StrFormat("Could not evaluate %s in the model",
+                              Z3_ast_to_string(ctx, ast)));
+        }
+        rope.push_back(UBits(chunk_bits, width));
+      }
+      return Value(rope.Build());
+    }
+    case TypeKind::kTuple: {
+      TupleType* tuple_type = type->AsTupleOrDie();
+      Z3_sort sort = Z3_get_sort(ctx, ast);
+      std::vector<Value> elements;
+      for (int64_t i = 0; i < tuple_type->size(); ++i) {
+        Z3_func_decl accessor = Z3_get_tuple_sort_field_decl(ctx, sort, i);
+        Z3_ast element = Z3_mk_app(ctx, accessor, 1, &ast);
+        XLS_ASSIGN_OR_RETURN(
+            Value value, ValueFromModel(ctx, model,
+                                        tuple_type->element_type(i), element));
+        elements.push_back(std::move(value));
+      }
+      return Value::TupleOwned(std::move(elements));
+    }
+    case TypeKind::kArray: {
+      ArrayType* array_type = type->AsArrayOrDie();
+      Z3_sort index_sort = Z3_get_array_sort_domain(ctx, Z3_get_sort(ctx, ast));
+      std::vector<Value> elements;
+      for (int64_t i = 0; i < array_type->size(); ++i) {
+        Z3_ast element =
+            Z3_mk_select(ctx, ast, Z3_mk_int64(ctx, i, index_sort));
+        XLS_ASSIGN_OR_RETURN(
+            Value value, ValueFromModel(ctx, model,
+                                        array_type->element_type(), element));
+        elements.push_back(std::move(value));
+      }
+      return Value::Array(elements);
+    }
+    case TypeKind::kToken:
+      return Value::Token();
+  }
+  return absl::InternalError(
+      absl::StrFormat("Unhandled type: %s", type->ToString()));
+}
+
+}  // namespace
+
+absl::StatusOr<std::optional<std::vector<Value>>> FindCounterexample(
+    Function* f, Node* subject, Predicate p, absl::Duration timeout) {
+  XLS_ASSIGN_OR_RETURN(auto translator, IrTranslator::CreateAndTranslate(f));
+  translator->SetTimeout(timeout);
+  Z3_ast value = translator->GetTranslation(subject);
+  if (translator->GetValueKind(value) != Z3_BV_SORT) {
+    return absl::InvalidArgumentError(
+        "Cannot prove properties of non-bits-typed node: " +
+        subject->ToString());
+  }
+  XLS_ASSIGN_OR_RETURN(Z3_ast objective,
+                       PredicateToObjective(p, value, translator.get()));
+  Z3_context ctx = translator->ctx();
+  Z3_solver solver = solvers::z3::CreateSolver(ctx, 1);
+  Z3_solver_assert(ctx, solver, objective);
+  Z3_lbool satisfiable = Z3_solver_check(ctx, solver);
+  XLS_VLOG(2) << solvers::z3::SolverResultToString(ctx, solver, satisfiable)
+              << std::endl;
+
+  // As in TryProve(), an unsatisfiable inverse means the predicate holds; a
+  // model of the inverse is a counterexample.
+  absl::Status status;
+  std::optional<std::vector<Value>> counterexample;
+  if (satisfiable == Z3_L_UNDEF) {
+    status = absl::DeadlineExceededError(
+        absl::StrFormat("Solver could not decide the predicate: %s",
+                        Z3_solver_get_reason_unknown(ctx, solver)));
+  } else if (satisfiable == Z3_L_TRUE) {
+    Z3_model model = Z3_solver_get_model(ctx, solver);
+    Z3_model_inc_ref(ctx, model);
+    counterexample.emplace();
+    for (Param* param : f->params()) {
+      absl::StatusOr<Value> param_value =
+          ValueFromModel(ctx, model, param->GetType(),
+                         translator->GetTranslation(param));
+      if (!param_value.ok()) {
+        status = param_value.status();
+        break;
+      }
+      counterexample->push_back(std::move(param_value).value());
+    }
+    Z3_model_dec_ref(ctx, model);
+  }
+  Z3_solver_dec_ref(ctx, solver);
+  XLS_RETURN_IF_ERROR(status);
+  return counterexample;
+}
+
 }  // namespace z3
 }  // namespace solvers
 }  // namespace xls
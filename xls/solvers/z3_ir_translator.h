@@ -18,12 +18,16 @@
 #ifndef XLS_TOOLS_Z3_IR_TRANSLATOR_H_
 #define XLS_TOOLS_Z3_IR_TRANSLATOR_H_
 
+#include <optional>
+#include <vector>
+
 #include "absl/status/statusor.h"
 #include "absl/time/time.h"
 #include "xls/common/logging/logging.h"
 #include "xls/data_structures/leaf_type_tree.h"
 #include "xls/ir/function.h"
 #include "xls/ir/nodes.h"
+#include "xls/ir/value.h"
 #include "xls/solvers/z3_utils.h"
 #include "../z3/src/api/z3.h"
 
@@ -316,6 +320,13 @@ class Predicate {
 absl::StatusOr<bool> TryProve(Function* f, Node* subject, Predicate p,
                               absl::Duration timeout);
 
+// As TryProve(), but when the predicate does not hold returns a counterexample:
+// a value for each parameter of "f" under which "subject" violates it. Returns
+// std::nullopt if the predicate was proven, and a DeadlineExceeded error if the
+// solver could not decide it within "timeout".
+absl::StatusOr<std::optional<std::vector<Value>>> FindCounterexample(
+    Function* f, Node* subject, Predicate p, absl::Duration timeout);
+
 }  // namespace z3
 }  // namespace solvers
 }  // namespace xls
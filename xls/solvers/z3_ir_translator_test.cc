@@ -16,6 +16,8 @@
 
 #include <cstdint>
 #include <limits>
+#include <optional>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -34,10 +36,13 @@
 namespace xls {
 namespace {
 
+using solvers::z3::FindCounterexample;
 using solvers::z3::IrTranslator;
 using solvers::z3::Predicate;
 using solvers::z3::TryProve;
 using status_testing::IsOkAndHolds;
+using testing::ElementsAre;
+using testing::Optional;
 
 class Z3IrTranslatorTest : public IrTestBase {};
 
@@ -68,6 +73,51 @@ TEST_F(Z3IrTranslatorTest, ZeroIsZero) {
   EXPECT_TRUE(proven);
 }
 
+TEST_F(Z3IrTranslatorTest, FindCounterexampleOfProvenPredicate) {
+  auto p = CreatePackage();
+  FunctionBuilder b("f", p.get());
+  auto x = b.Param("x", p->GetBitsType(8));
+  auto eq = b.Eq(x, x);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, b.Build());
+  EXPECT_THAT(FindCounterexample(f, eq.node(), Predicate::NotEqualToZero(),
+                                 absl::InfiniteDuration()),
+              IsOkAndHolds(std::nullopt));
+}
+
+TEST_F(Z3IrTranslatorTest, FindCounterexampleOfBitsParam) {
+  auto p = CreatePackage();
+  FunctionBuilder b("f", p.get());
+  auto x = b.Param("x", p->GetBitsType(8));
+  auto ne = b.Ne(x, b.Literal(UBits(42, 8)));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, b.Build());
+  EXPECT_THAT(FindCounterexample(f, ne.node(), Predicate::NotEqualToZero(),
+                                 absl::InfiniteDuration()),
+              IsOkAndHolds(Optional(ElementsAre(Value(UBits(42, 8))))));
+}
+
+TEST_F(Z3IrTranslatorTest, FindCounterexampleOfAggregateParam) {
+  auto p = CreatePackage();
+  FunctionBuilder b("f", p.get());
+  Type* tuple_type = p->GetTupleType(
+      {p->GetBitsType(100), p->GetArrayType(2, p->GetBitsType(4))});
+  auto t = b.Param("t", tuple_type);
+  auto ne = b.Ne(b.TupleIndex(t, 0),
+                 b.Literal(Bits::PowerOfTwo(/*set_bit_index=*/90, 100)));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, b.Build());
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::optional<std::vector<Value>> counterexample,
+      FindCounterexample(f, ne.node(), Predicate::NotEqualToZero(),
+                         absl::InfiniteDuration()));
+  ASSERT_TRUE(counterexample.has_value());
+  ASSERT_EQ(counterexample->size(), 1);
+  const Value& value = counterexample->front();
+  ASSERT_TRUE(value.IsTuple());
+  EXPECT_EQ(value.element(0),
+            Value(Bits::PowerOfTwo(/*set_bit_index=*/90, 100)));
+  EXPECT_TRUE(value.element(1).IsArray());
+  EXPECT_EQ(value.element(1).size(), 2);
+}
+
 TEST_F(Z3IrTranslatorTest, ZeroTwoBitsIsZero) {
   auto p = CreatePackage();
   FunctionBuilder b("f", p.get());
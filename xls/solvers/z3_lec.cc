@@ -264,9 +264,35 @@ bool Lec::Run() {
   return !satisfiable_;
 }
 
+absl::StatusOr<bool> Lec::RunPortfolio(const PortfolioOptions& options) {
+  XLS_LOG(INFO) << "Beginning portfolio execution";
+  Z3_ast_vector assertion_vector =
+      Z3_solver_get_assertions(ctx(), solver_.value());
+  Z3_ast_vector_inc_ref(ctx(), assertion_vector);
+  std::vector<Z3_ast> assertions;
+  for (unsigned i = 0; i < Z3_ast_vector_size(ctx(), assertion_vector); ++i) {
+    assertions.push_back(Z3_ast_vector_get(ctx(), assertion_vector, i));
+  }
+  absl::StatusOr<PortfolioResult> result =
+      SolvePortfolio(ctx(), assertions, options);
+  Z3_ast_vector_dec_ref(ctx(), assertion_vector);
+  XLS_RETURN_IF_ERROR(result.status());
+  if (result->satisfiable == Z3_L_UNDEF) {
+    return absl::DeadlineExceededError(
+        "No solver configuration reached a result.");
+  }
+  XLS_LOG(INFO) << "Solved by configuration " << result->config_name;
+  satisfiable_ = result->satisfiable == Z3_L_TRUE;
+  if (model_) {
+    Z3_model_dec_ref(ctx(), model_.value());
+  }
+  model_ = result->model;
+  return !satisfiable_;
+}
+
 std::string Lec::ResultToString() {
   std::vector<std::string> output;
-  output.push_back(SolverResultToString(ctx(), solver_.value(),
+  output.push_back(SolverResultToString(ctx(), model_,
                                         satisfiable_ ? Z3_L_TRUE : Z3_L_FALSE,
                                         /*hexify=*/true));
   if (satisfiable_) {
@@ -26,6 +26,7 @@
 #include "xls/scheduling/pipeline_schedule.h"
 #include "xls/solvers/z3_ir_translator.h"
 #include "xls/solvers/z3_netlist_translator.h"
+#include "xls/solvers/z3_portfolio.h"
 
 namespace xls {
 namespace solvers {
@@ -76,6 +77,11 @@ class Lec {
   // Returns true of the netlist and IR are proved to be equivalent.
   bool Run();
 
+  // As Run(), but races the configurations of a solver portfolio (see
+  // SolvePortfolio) on the problem. Returns a DeadlineExceeded error if no
+  // configuration reached an answer.
+  absl::StatusOr<bool> RunPortfolio(const PortfolioOptions& options);
+
   // Dumps all Z3 values corresponding to IR nodes in the input function.
   void DumpIrTree();
 
@@ -0,0 +1,241 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/solvers/z3_portfolio.h"
+
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/synchronization/mutex.h"
+#include "xls/common/logging/logging.h"
+#include "xls/solvers/z3_utils.h"
+#include "../z3/src/api/z3_api.h"
+
+namespace xls {
+namespace solvers {
+namespace z3 {
+namespace {
+
+// How often configurations still running after a definitive answer are
+// interrupted again. A configuration may be between checking for cancellation
+// and entering the solver when the first interrupt arrives.
+constexpr absl::Duration kInterruptPeriod = absl::Milliseconds(10);
+
+// State of one configuration of the portfolio. The context is created and the
+// assertions translated on the calling thread; everything else happens on the
+// configuration's thread.
+struct Worker {
+  const SolverConfig* config;
+  Z3_config z3_config;
+  Z3_context ctx;
+  std::vector<Z3_ast> assertions;
+  Z3_solver solver = nullptr;
+  Z3_lbool satisfiable = Z3_L_UNDEF;
+  absl::Status status;
+  bool finished = false;
+};
+
+struct SharedState {
+  absl::Mutex mutex;
+  // The worker which reached the first definitive answer, if any.
+  Worker* winner ABSL_GUARDED_BY(mutex) = nullptr;
+  int64_t finished_count ABSL_GUARDED_BY(mutex) = 0;
+};
+
+Z3_solver CreateSolverForConfig(Z3_context ctx, const SolverConfig& config) {
+  Z3_solver solver;
+  if (config.tactics.empty()) {
+    solver = Z3_mk_solver(ctx);
+  } else {
+    Z3_tactic tactic = Z3_mk_tactic(ctx, config.tactics.front().c_str());
+    Z3_tactic_inc_ref(ctx, tactic);
+    for (int64_t i = 1; i < config.tactics.size(); ++i) {
+      Z3_tactic next = Z3_mk_tactic(ctx, config.tactics[i].c_str());
+      Z3_tactic_inc_ref(ctx, next);
+      Z3_tactic combined = Z3_tactic_and_then(ctx, tactic, next);
+      Z3_tactic_inc_ref(ctx, combined);
+      Z3_tactic_dec_ref(ctx, tactic);
+      Z3_tactic_dec_ref(ctx, next);
+      tactic = combined;
+    }
+    solver = Z3_mk_solver_from_tactic(ctx, tactic);
+    Z3_tactic_dec_ref(ctx, tactic);
+  }
+  Z3_solver_inc_ref(ctx, solver);
+
+  Z3_params params = Z3_mk_params(ctx);
+  Z3_params_inc_ref(ctx, params);
+  Z3_params_set_uint(ctx, params, Z3_mk_string_symbol(ctx, "random_seed"),
+                     config.random_seed);
+  Z3_solver_set_params(ctx, solver, params);
+  Z3_params_dec_ref(ctx, params);
+  return solver;
+}
+
+void RunWorker(Worker* worker, SharedState* state) {
+  bool cancelled;
+  {
+    absl::MutexLock lock(&state->mutex);
+    cancelled = state->winner != nullptr;
+  }
+  Z3_lbool satisfiable = Z3_L_UNDEF;
+  absl::Status status;
+  if (!cancelled) {
+    ScopedErrorHandler error_handler(worker->ctx);
+    worker->solver = CreateSolverForConfig(worker->ctx, *worker->config);
+    for (Z3_ast assertion : worker->assertions) {
+      Z3_solver_assert(worker->ctx, worker->solver, assertion);
+    }
+    satisfiable = Z3_solver_check(worker->ctx, worker->solver);
+    status = error_handler.status();
+  }
+
+  absl::MutexLock lock(&state->mutex);
+  worker->status = status;
+  worker->satisfiable = status.ok() ? satisfiable : Z3_L_UNDEF;
+  worker->finished = true;
+  ++state->finished_count;
+  if (worker->satisfiable != Z3_L_UNDEF && state->winner == nullptr) {
+    state->winner = worker;
+  }
+}
+
+}  // namespace
+
+std::vector<SolverConfig> DefaultPortfolio() {
+  return {
+      SolverConfig{.name = "default", .tactics = {}, .random_seed = 0},
+      SolverConfig{.name = "default-seed1", .tactics = {}, .random_seed = 1},
+      SolverConfig{.name = "bit-blast",
+                   .tactics = {"simplify", "fpa2bv", "propagate-values",
+                               "solve-eqs", "simplify", "bit-blast", "sat"},
+                   .random_seed = 0},
+      SolverConfig{
+          .name = "smt", .tactics = {"simplify", "smt"}, .random_seed = 2},
+  };
+}
+
+absl::StatusOr<PortfolioResult> SolvePortfolio(
+    Z3_context ctx, absl::Span<const Z3_ast> assertions,
+    const PortfolioOptions& options) {
+  if (options.configs.empty()) {
+    return absl::InvalidArgumentError("Solver portfolio has no configurations");
+  }
+
+  // Z3 contexts are not thread-safe, so every configuration gets its own copy
+  // of the problem. Translation reads `ctx` and therefore happens here, before
+  // any thread starts.
+  std::vector<std::unique_ptr<Worker>> workers;
+  for (const SolverConfig& config : options.configs) {
+    auto worker = std::make_unique<Worker>();
+    worker->config = &config;
+    worker->z3_config = Z3_mk_config();
+    if (options.timeout != absl::InfiniteDuration()) {
+      std::string timeout_str =
+          absl::StrCat(absl::ToInt64Milliseconds(options.timeout));
+      Z3_set_param_value(worker->z3_config, "timeout", timeout_str.c_str());
+    }
+    worker->ctx = Z3_mk_context(worker->z3_config);
+    for (Z3_ast assertion : assertions) {
+      worker->assertions.push_back(Z3_translate(ctx, assertion, worker->ctx));
+    }
+    workers.push_back(std::move(worker));
+  }
+
+  SharedState state;
+  std::vector<std::thread> threads;
+  threads.reserve(workers.size());
+  for (std::unique_ptr<Worker>& worker : workers) {
+    threads.emplace_back(RunWorker, worker.get(), &state);
+  }
+
+  {
+    absl::MutexLock lock(&state.mutex);
+    auto decided = [&]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(state.mutex) {
+      return state.winner != nullptr ||
+             state.finished_count == workers.size();
+    };
+    state.mutex.Await(absl::Condition(&decided));
+    auto all_finished = [&]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(state.mutex) {
+      return state.finished_count == workers.size();
+    };
+    while (!all_finished()) {
+      for (std::unique_ptr<Worker>& worker : workers) {
+        if (!worker->finished) {
+          Z3_interrupt(worker->ctx);
+        }
+      }
+      state.mutex.AwaitWithTimeout(absl::Condition(&all_finished),
+                                   kInterruptPeriod);
+    }
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  PortfolioResult result;
+  absl::Status first_error;
+  bool any_ok = false;
+  Worker* winner;
+  {
+    absl::MutexLock lock(&state.mutex);
+    winner = state.winner;
+  }
+  for (std::unique_ptr<Worker>& worker : workers) {
+    XLS_VLOG(1) << absl::StreamFormat(
+        "Solver configuration %s: %s%s", worker->config->name,
+        worker->satisfiable == Z3_L_UNDEF
+            ? "undef"
+            : (worker->satisfiable == Z3_L_TRUE ? "sat" : "unsat"),
+        worker.get() == winner ? " (first)" : "");
+    if (worker->status.ok()) {
+      any_ok = true;
+    } else if (first_error.ok()) {
+      first_error = worker->status;
+    }
+  }
+
+  if (winner != nullptr) {
+    result.satisfiable = winner->satisfiable;
+    result.config_name = winner->config->name;
+    if (winner->satisfiable == Z3_L_TRUE) {
+      Z3_model model = Z3_solver_get_model(winner->ctx, winner->solver);
+      Z3_model_inc_ref(winner->ctx, model);
+      Z3_model translated = Z3_model_translate(winner->ctx, model, ctx);
+      Z3_model_inc_ref(ctx, translated);
+      Z3_model_dec_ref(winner->ctx, model);
+      result.model = translated;
+    }
+  }
+
+  for (std::unique_ptr<Worker>& worker : workers) {
+    if (worker->solver != nullptr) {
+      Z3_solver_dec_ref(worker->ctx, worker->solver);
+    }
+    Z3_del_context(worker->ctx);
+    Z3_del_config(worker->z3_config);
+  }
+
+  if (winner == nullptr && !any_ok) {
+    return first_error;
+  }
+  return result;
+}
+
+}  // namespace z3
+}  // namespace solvers
+}  // namespace xls
@@ -0,0 +1,84 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_SOLVERS_Z3_PORTFOLIO_H_
+#define XLS_SOLVERS_Z3_PORTFOLIO_H_
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "../z3/src/api/z3.h"
+
+namespace xls {
+namespace solvers {
+namespace z3 {
+
+// A Z3 configuration raced by SolvePortfolio.
+struct SolverConfig {
+  // Name of the configuration for logging and results.
+  std::string name;
+
+  // Names of the Z3 tactics applied in sequence to build the solver, e.g.,
+  // {"simplify", "bit-blast", "sat"}. If empty, Z3's default solver is used,
+  // which picks a strategy based on the logic of the problem.
+  std::vector<std::string> tactics;
+
+  // Random seed of the SAT and SMT cores.
+  int random_seed = 0;
+};
+
+// Returns the configurations raced by default: the default solver with two
+// random seeds, eager bit-blasting to the SAT core, and the SMT core without
+// bit-blasting preprocessing.
+std::vector<SolverConfig> DefaultPortfolio();
+
+struct PortfolioOptions {
+  std::vector<SolverConfig> configs = DefaultPortfolio();
+
+  // How long each configuration may run.
+  absl::Duration timeout = absl::InfiniteDuration();
+};
+
+struct PortfolioResult {
+  // Z3_L_TRUE or Z3_L_FALSE if a configuration reached a definitive answer,
+  // Z3_L_UNDEF if none did (e.g., all timed out).
+  Z3_lbool satisfiable = Z3_L_UNDEF;
+
+  // Name of the configuration which reached the answer.
+  std::string config_name;
+
+  // If satisfiable, a model in the context passed to SolvePortfolio. The
+  // caller owns a reference to the model and must release it with
+  // Z3_model_dec_ref.
+  std::optional<Z3_model> model;
+};
+
+// Checks the satisfiability of the conjunction of `assertions` (built in
+// `ctx`). Each configuration runs on its own thread in its own Z3 context, to
+// which the assertions are translated up front. Returns the first definitive
+// answer; the configurations still running at that point are interrupted.
+// Returns an error only if every configuration failed with an error.
+absl::StatusOr<PortfolioResult> SolvePortfolio(
+    Z3_context ctx, absl::Span<const Z3_ast> assertions,
+    const PortfolioOptions& options = PortfolioOptions());
+
+}  // namespace z3
+}  // namespace solvers
+}  // namespace xls
+
+#endif  // XLS_SOLVERS_Z3_PORTFOLIO_H_
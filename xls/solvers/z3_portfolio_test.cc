@@ -0,0 +1,104 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/solvers/z3_portfolio.h"
+
+#include <cstdint>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "xls/common/status/matchers.h"
+#include "../z3/src/api/z3.h"
+#include "../z3/src/api/z3_api.h"
+
+namespace xls {
+namespace solvers {
+namespace z3 {
+namespace {
+
+using status_testing::StatusIs;
+
+class Z3PortfolioTest : public ::testing::Test {
+ protected:
+  Z3PortfolioTest()
+      : config_(Z3_mk_config()),
+        ctx_(Z3_mk_context(config_)),
+        x_(Z3_mk_const(ctx_, Z3_mk_string_symbol(ctx_, "x"),
+                       Z3_mk_bv_sort(ctx_, 8))) {}
+
+  ~Z3PortfolioTest() override {
+    Z3_del_context(ctx_);
+    Z3_del_config(config_);
+  }
+
+  Z3_ast U8(uint32_t value) {
+    return Z3_mk_unsigned_int(ctx_, value, Z3_mk_bv_sort(ctx_, 8));
+  }
+
+  Z3_config config_;
+  Z3_context ctx_;
+  Z3_ast x_;
+};
+
+TEST_F(Z3PortfolioTest, SatisfiableReturnsModelInCallerContext) {
+  // 3 * 173 = 519 = 7 (mod 256).
+  Z3_ast assertion = Z3_mk_eq(ctx_, Z3_mk_bvmul(ctx_, x_, U8(3)), U8(7));
+  XLS_ASSERT_OK_AND_ASSIGN(PortfolioResult result,
+                           SolvePortfolio(ctx_, {assertion}));
+  EXPECT_EQ(result.satisfiable, Z3_L_TRUE);
+  EXPECT_FALSE(result.config_name.empty());
+  ASSERT_TRUE(result.model.has_value());
+
+  Z3_ast value;
+  ASSERT_TRUE(Z3_model_eval(ctx_, result.model.value(), x_,
+                            /*model_completion=*/true, &value));
+  uint64_t x_value;
+  ASSERT_TRUE(Z3_get_numeral_uint64(ctx_, value, &x_value));
+  EXPECT_EQ(x_value, 173);
+  Z3_model_dec_ref(ctx_, result.model.value());
+}
+
+TEST_F(Z3PortfolioTest, EachDefaultConfigurationProvesUnsat) {
+  // x + 1 == x has no solution.
+  Z3_ast assertion = Z3_mk_eq(ctx_, Z3_mk_bvadd(ctx_, x_, U8(1)), x_);
+  for (const SolverConfig& config : DefaultPortfolio()) {
+    PortfolioOptions options;
+    options.configs = {config};
+    XLS_ASSERT_OK_AND_ASSIGN(PortfolioResult result,
+                             SolvePortfolio(ctx_, {assertion}, options));
+    EXPECT_EQ(result.satisfiable, Z3_L_FALSE) << config.name;
+    EXPECT_EQ(result.config_name, config.name);
+    EXPECT_FALSE(result.model.has_value());
+  }
+}
+
+TEST_F(Z3PortfolioTest, MultipleAssertionsAreConjoined) {
+  Z3_ast assertions[] = {Z3_mk_bvugt(ctx_, x_, U8(10)),
+                         Z3_mk_bvult(ctx_, x_, U8(11))};
+  XLS_ASSERT_OK_AND_ASSIGN(PortfolioResult result,
+                           SolvePortfolio(ctx_, assertions));
+  EXPECT_EQ(result.satisfiable, Z3_L_FALSE);
+}
+
+TEST_F(Z3PortfolioTest, NoConfigurations) {
+  PortfolioOptions options;
+  options.configs.clear();
+  EXPECT_THAT(SolvePortfolio(ctx_, {Z3_mk_true(ctx_)}, options),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace z3
+}  // namespace solvers
+}  // namespace xls
@@ -16,6 +16,7 @@
 #ifndef XLS_SOLVERS_Z3_UTILS_H_
 #define XLS_SOLVERS_Z3_UTILS_H_
 
+#include <optional>
 #include <string>
 
 #include "absl/strings/string_view.h"
@@ -56,6 +57,11 @@ Z3_solver CreateSolver(Z3_context ctx, int num_threads);
 std::string SolverResultToString(Z3_context ctx, Z3_solver solver,
                                  Z3_lbool satisfiable, bool hexify = true);
 
+// As above, but prints the given model (if any) rather than the model of a
+// solver, e.g., for the result of a solver portfolio.
+std::string SolverResultToString(Z3_context ctx, std::optional<Z3_model> model,
+                                 Z3_lbool satisfiable, bool hexify = true);
+
 // Returns a string representation of the given node interpreted under the given
 // model.
 // If "hexify" is true, then all output values will be converted from boolean or
@@ -43,6 +43,11 @@ ABSL_FLAG(int64_t, bdd_path_limit, 0,
           "and declaring a new variable. If zero, then no limit.");
 ABSL_FLAG(std::vector<std::string>, benchmarks, {},
           "Comma-separated list of benchmarks gather BDD stats about.");
+ABSL_FLAG(bool, interleave_variables, false,
+          "Interleave the BDD variables of the bits of operands which are "
+          "combined by the same node.");
+ABSL_FLAG(bool, sift_variables, false,
+          "Dynamically reorder the BDD variables by sifting as the BDD grows.");
 
 namespace xls {
 namespace {
@@ -101,9 +106,13 @@ absl::Status RealMain(std::string_view input_path) {
           "Top entity not set for package: %s.", package->name()));
     }
     absl::Time start = absl::Now();
+    BddVariableOrderOptions order_options{
+        .interleave_operands = absl::GetFlag(FLAGS_interleave_variables),
+        .sift = absl::GetFlag(FLAGS_sift_variables)};
     XLS_ASSIGN_OR_RETURN(
         std::unique_ptr<BddFunction> bdd_function,
-        BddFunction::Run(top.value(), absl::GetFlag(FLAGS_bdd_path_limit)));
+        BddFunction::Run(top.value(), absl::GetFlag(FLAGS_bdd_path_limit),
+                         /*node_filter=*/std::nullopt, order_options));
     absl::Duration bdd_time = absl::Now() - start;
     total_time += bdd_time;
     std::cout << "BDD construction time: " << bdd_time << "\n";
@@ -118,7 +127,7 @@ absl::Status RealMain(std::string_view input_path) {
     std::cout << "Bits in graph: " << number_bits << "\n";
 
     int64_t max_paths = 0;
-    for (int64_t i = 0; i < bdd_function->bdd().size(); ++i) {
+    for (int64_t i = 0; i < bdd_function->bdd().index_limit(); ++i) {
       max_paths =
           std::max(max_paths, bdd_function->bdd().path_count(BddNodeIndex(i)));
     }
@@ -40,13 +40,21 @@ Usage:
 ABSL_FLAG(std::string, top, "",
           "Name of top block to use in lieu of the default.");
 ABSL_FLAG(bool, schedule, true, "Enable running the scheduler.");
+ABSL_FLAG(int64_t, input_latency, 0,
+          "Number of cycles of latency added by input flops of the block "
+          "(e.g., 1 if the block was generated with --flop_inputs). Used for "
+          "computing latency metrics.");
+ABSL_FLAG(int64_t, output_latency, 0,
+          "Number of cycles of latency added by output flops of the block "
+          "(e.g., 1 if the block was generated with --flop_outputs). Used for "
+          "computing latency metrics.");
 
 namespace xls {
 namespace {
 
-absl::Status ScheduleAndPrintStats(Package* package,
-                                   const DelayEstimator& delay_estimator,
-                                   const SchedulingOptions& options) {
+absl::StatusOr<PipelineSchedule> ScheduleAndPrintStats(
+    Package* package, const DelayEstimator& delay_estimator,
+    const SchedulingOptions& options) {
   std::optional<FunctionBase*> top = package->GetTop();
   if (!top.has_value()) {
     return absl::InternalError(absl::StrFormat(
@@ -60,7 +68,35 @@ absl::Status ScheduleAndPrintStats(Package* package,
   std::cout << absl::StreamFormat("Scheduling time: %dms\n",
                                   total_time / absl::Milliseconds(1));
 
-  return absl::OkStatus();
+  return schedule;
+}
+
+void PrintThroughputStats(const verilog::BlockMetricsProto& metrics) {
+  std::cout << absl::StreamFormat("Pipeline latency: %d\n",
+                                  metrics.pipeline_latency());
+  if (metrics.has_initiation_interval()) {
+    std::cout << absl::StreamFormat("Initiation interval: %d\n",
+                                    metrics.initiation_interval());
+  } else {
+    std::cout << "Initiation interval: unbounded (may deadlock)\n";
+  }
+  std::cout << absl::StreamFormat("Worst-case throughput: %g\n",
+                                  metrics.worst_case_throughput());
+  if (!metrics.throughput_limiter().empty()) {
+    std::cout << absl::StreamFormat("Throughput limiter: %s\n",
+                                    metrics.throughput_limiter());
+  }
+  if (metrics.recompute_flop_savings() != 0) {
+    std::cout << absl::StreamFormat("Flops saved by recomputation: %d\n",
+                                    metrics.recompute_flop_savings());
+  }
+  for (const verilog::ChannelLatencyProto& channel :
+       metrics.channel_latencies()) {
+    std::cout << absl::StreamFormat(
+        "Channel latency: %s (%s): stage %d, %d cycles\n",
+        channel.channel_name(), channel.receive() ? "receive" : "send",
+        channel.stage(), channel.latency());
+  }
 }
 
 absl::StatusOr<Block*> GetTopBlock(Package* package) {
@@ -99,19 +135,27 @@ absl::Status RealMain(std::string_view opt_ir_path,
                        GetFileContents(verilog_path));
 
   std::optional<DelayEstimator*> delay_estimator;
+  std::optional<PipelineSchedule> schedule;
 
   if (absl::GetFlag(FLAGS_schedule)) {
     XLS_ASSIGN_OR_RETURN(SchedulingOptions scheduling_options,
                          SetUpSchedulingOptions(block_package.get()));
     XLS_ASSIGN_OR_RETURN(delay_estimator, SetUpDelayEstimator());
 
-    XLS_RETURN_IF_ERROR(ScheduleAndPrintStats(
-        opt_package.get(), *delay_estimator.value(), scheduling_options));
+    XLS_ASSIGN_OR_RETURN(
+        schedule, ScheduleAndPrintStats(opt_package.get(),
+                                        *delay_estimator.value(),
+                                        scheduling_options));
   }
 
   XLS_ASSIGN_OR_RETURN(Block * top, GetTopBlock(block_package.get()));
   XLS_ASSIGN_OR_RETURN(verilog::BlockMetricsProto metrics,
                        verilog::GenerateBlockMetrics(top, delay_estimator));
+  if (schedule.has_value()) {
+    XLS_RETURN_IF_ERROR(verilog::GenerateThroughputMetrics(
+        schedule.value(), absl::GetFlag(FLAGS_input_latency),
+        absl::GetFlag(FLAGS_output_latency), &metrics));
+  }
   std::cout << absl::StreamFormat("Flop count: %d\n", metrics.flop_count());
   std::cout << absl::StreamFormat(
       "Has feedthrough path: %s\n",
@@ -132,6 +176,9 @@ absl::Status RealMain(std::string_view opt_ir_path,
     std::cout << absl::StreamFormat("Max feedthrough path delay: %dps\n",
                                     metrics.max_feedthrough_path_delay_ps());
   }
+  if (schedule.has_value()) {
+    PrintThroughputStats(metrics);
+  }
   std::cout << absl::StreamFormat(
       "Lines of Verilog: %d\n",
       std::vector<std::string>(absl::StrSplit(verilog_contents, '\n')).size());
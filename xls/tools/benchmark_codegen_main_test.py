@@ -86,6 +86,9 @@ class CodeGenMainTest(test_base.TestCase):
     self.assertIn('Max reg-to-output delay: 2ps', output)
     self.assertIn('Lines of Verilog: 7', output)
     self.assertIn('Scheduling time:', output)
+    self.assertIn('Pipeline latency: 0', output)
+    self.assertIn('Initiation interval: 1', output)
+    self.assertIn('Worst-case throughput: 1', output)
 
   def test_simple_block_no_delay_model(self):
     opt_ir_file = self.create_tempfile(content=OPT_IR)
@@ -101,6 +104,7 @@ class CodeGenMainTest(test_base.TestCase):
     self.assertNotIn('Max reg-to-reg delays', output)
     self.assertNotIn('Max input-to-reg delay', output)
     self.assertNotIn('Max reg-to-output delay', output)
+    self.assertNotIn('Initiation interval', output)
     self.assertIn('Lines of Verilog: 7', output)
 
 
@@ -34,6 +34,7 @@
 #include "xls/passes/passes.h"
 #include "xls/passes/unroll_pass.h"
 #include "xls/solvers/z3_ir_translator.h"
+#include "xls/solvers/z3_portfolio.h"
 #include "xls/solvers/z3_utils.h"
 #include "../z3/src/api/z3.h"
 #include "../z3/src/api/z3_api.h"
@@ -58,6 +59,10 @@ ABSL_FLAG(std::string, top, "",
           "Functions are supported.");
 ABSL_FLAG(absl::Duration, timeout, absl::InfiniteDuration(),
           "How long to wait for any proof to complete.");
+ABSL_FLAG(bool, solver_portfolio, false,
+          "Race several Z3 configurations (tactics and random seeds) in "
+          "parallel and report the first definitive answer. The timeout "
+          "applies to each configuration.");
 // LINT.ThenChange(//xls/build_rules/xls_ir_rules.bzl)
 
 namespace xls {
@@ -80,7 +85,8 @@ absl::StatusOr<Z3_ast> CreateComparisonFunction(
 }
 
 absl::Status RealMain(const std::vector<std::string_view>& ir_paths,
-                      const std::string& entry, absl::Duration timeout) {
+                      const std::string& entry, absl::Duration timeout,
+                      bool solver_portfolio) {
   std::vector<std::unique_ptr<Package>> packages;
   for (const auto ir_path : ir_paths) {
     XLS_ASSIGN_OR_RETURN(std::string ir_text, GetFileContents(ir_path));
@@ -140,15 +146,30 @@ absl::Status RealMain(const std::vector<std::string_view>& ir_paths,
   XLS_ASSIGN_OR_RETURN(
       Z3_ast results_equal,
       CreateComparisonFunction(absl::MakeSpan(translators), functions));
-  translators[0]->SetTimeout(timeout);
-
-  Z3_solver solver =
-      solvers::z3::CreateSolver(ctx, std::thread::hardware_concurrency());
 
   // Remember: we try to prove the condition by searching for a model that
   // produces the opposite result. Thus, we want to find a model where the
   // results are _not_ equal.
   Z3_ast objective = Z3_mk_eq(ctx, Z3_mk_false(ctx), results_equal);
+
+  if (solver_portfolio) {
+    solvers::z3::PortfolioOptions options;
+    options.timeout = timeout;
+    XLS_ASSIGN_OR_RETURN(
+        solvers::z3::PortfolioResult result,
+        solvers::z3::SolvePortfolio(ctx, {objective}, options));
+    std::cout << solvers::z3::SolverResultToString(ctx, result.model,
+                                                   result.satisfiable)
+              << std::endl;
+    if (result.model.has_value()) {
+      Z3_model_dec_ref(ctx, result.model.value());
+    }
+    return absl::OkStatus();
+  }
+
+  translators[0]->SetTimeout(timeout);
+  Z3_solver solver =
+      solvers::z3::CreateSolver(ctx, std::thread::hardware_concurrency());
   Z3_solver_assert(ctx, solver, objective);
 
   // Finally, print the output to the terminal in gorgeous two-color ASCII.
@@ -168,5 +189,6 @@ int main(int argc, char** argv) {
       xls::InitXls(kUsage, argc, argv);
   XLS_QCHECK_EQ(positional_args.size(), 2) << "Two IR files must be specified!";
   XLS_QCHECK_OK(xls::RealMain(positional_args, absl::GetFlag(FLAGS_top),
-                              absl::GetFlag(FLAGS_timeout)));
+                              absl::GetFlag(FLAGS_timeout),
+                              absl::GetFlag(FLAGS_solver_portfolio)));
 }
@@ -0,0 +1,252 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/tools/codegen.h"
+
+#include <filesystem>  // NOLINT
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_format.h"
+#include "xls/codegen/combinational_generator.h"
+#include "xls/codegen/module_signature.pb.h"
+#include "xls/codegen/op_override_impls.h"
+#include "xls/codegen/pipeline_generator.h"
+#include "xls/codegen/ram_configuration.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/verifier.h"
+#include "xls/scheduling/scheduling_pass_pipeline.h"
+
+namespace xls {
+namespace {
+
+verilog::CodegenOptions::IOKind ToIOKind(IOKindProto p) {
+  switch (p) {
+    case IO_KIND_INVALID:
+    case IO_KIND_FLOP:
+      return verilog::CodegenOptions::IOKind::kFlop;
+    case IO_KIND_SKID_BUFFER:
+      return verilog::CodegenOptions::IOKind::kSkidBuffer;
+    case IO_KIND_ZERO_LATENCY_BUFFER:
+      return verilog::CodegenOptions::IOKind::kZeroLatencyBuffer;
+    default:
+      XLS_LOG(FATAL) << "Invalid IOKindProto value: " << static_cast<int>(p);
+  }
+}
+
+}  // namespace
+
+absl::StatusOr<verilog::CodegenOptions> CodegenOptionsFromProto(
+    const CodegenFlagsProto& p) {
+  verilog::CodegenOptions options;
+
+  if (p.generator() == GENERATOR_KIND_PIPELINE) {
+    options = verilog::BuildPipelineOptions();
+
+    if (!p.input_valid_signal().empty()) {
+      std::optional<std::string> output_signal;
+      if (!p.output_valid_signal().empty()) {
+        output_signal = p.output_valid_signal();
+      }
+      options.valid_control(p.input_valid_signal(), output_signal);
+    } else if (!p.manual_load_enable_signal().empty()) {
+      options.manual_control(p.manual_load_enable_signal());
+    }
+    options.flop_inputs(p.flop_inputs());
+    options.flop_outputs(p.flop_outputs());
+    options.flop_inputs_kind(ToIOKind(p.flop_inputs_kind()));
+    options.flop_outputs_kind(ToIOKind(p.flop_outputs_kind()));
+
+    options.flop_single_value_channels(p.flop_single_value_channels());
+    options.add_idle_output(p.add_idle_output());
+
+    if (!p.reset().empty()) {
+      options.reset(p.reset(), p.reset_asynchronous(), p.reset_active_low(),
+                    p.reset_data_path());
+    }
+  }
+
+  if (!p.module_name().empty()) {
+    options.module_name(p.module_name());
+  }
+
+  options.use_system_verilog(p.use_system_verilog());
+  options.separate_lines(p.separate_lines());
+
+  if (!p.gate_format().empty()) {
+    options.SetOpOverride(
+        Op::kGate,
+        std::make_unique<verilog::OpOverrideGateAssignment>(p.gate_format()));
+  }
+
+  if (!p.assert_format().empty()) {
+    options.SetOpOverride(
+        Op::kAssert,
+        std::make_unique<verilog::OpOverrideAssertion>(p.assert_format()));
+  }
+
+  if (!p.smulp_format().empty()) {
+    options.SetOpOverride(
+        Op::kSMulp,
+        std::make_unique<verilog::OpOverrideInstantiation>(p.smulp_format()));
+  }
+
+  if (!p.umulp_format().empty()) {
+    options.SetOpOverride(
+        Op::kUMulp,
+        std::make_unique<verilog::OpOverrideInstantiation>(p.umulp_format()));
+  }
+
+  options.streaming_channel_data_suffix(p.streaming_channel_data_suffix());
+  options.streaming_channel_valid_suffix(p.streaming_channel_valid_suffix());
+  options.streaming_channel_ready_suffix(p.streaming_channel_ready_suffix());
+
+  std::vector<std::unique_ptr<verilog::RamConfiguration>> ram_configurations;
+  ram_configurations.reserve(p.ram_configurations_size());
+  for (const std::string& config_text : p.ram_configurations()) {
+    XLS_ASSIGN_OR_RETURN(std::unique_ptr<verilog::RamConfiguration> config,
+                         verilog::RamConfiguration::ParseString(config_text));
+    ram_configurations.push_back(std::move(config));
+  }
+  options.ram_configurations(ram_configurations);
+
+  options.gate_recvs(p.gate_recvs());
+  options.array_index_bounds_checking(p.array_index_bounds_checking());
+  options.infer_register_enables(p.infer_register_enables());
+
+  return options;
+}
+
+absl::StatusOr<PipelineSchedule> RunSchedulingPipeline(
+    FunctionBase* main, const SchedulingOptions& scheduling_options,
+    const DelayEstimator* delay_estimator) {
+  Package* p = main->package();
+  SchedulingPassOptions sched_options;
+  sched_options.scheduling_options = scheduling_options;
+  sched_options.delay_estimator = delay_estimator;
+  std::unique_ptr<SchedulingCompoundPass> scheduling_pipeline =
+      CreateSchedulingPassPipeline();
+  SchedulingPassResults results;
+  SchedulingUnit<> scheduling_unit = {p, /*schedule=*/absl::nullopt};
+  absl::Status scheduling_status =
+      scheduling_pipeline->Run(&scheduling_unit, sched_options, &results)
+          .status();
+  if (!scheduling_status.ok()) {
+    if (absl::IsResourceExhausted(scheduling_status) &&
+        scheduling_options.pipeline_stages().has_value() &&
+        scheduling_options.clock_period_ps().has_value()) {
+      // Resource exhausted error indicates that the schedule was
+      // infeasible. Emit a meaningful error in this case.
+      // TODO(meheff): Add link to documentation with more information and
+      // guidance.
+      return absl::ResourceExhaustedError(absl::StrFormat(
+          "Design cannot be scheduled in %d stages with a %dps clock.",
+          scheduling_options.pipeline_stages().value(),
+          scheduling_options.clock_period_ps().value()));
+    }
+    return scheduling_status;
+  }
+  XLS_RET_CHECK(scheduling_unit.schedule.has_value());
+
+  return scheduling_unit.schedule.value();
+}
+
+absl::StatusOr<CodegenResult> ScheduleAndCodegen(
+    Package* p, const CodegenFlagsProto& codegen_flags,
+    const SchedulingOptions& scheduling_options,
+    const DelayEstimator* delay_estimator) {
+  XLS_RET_CHECK(p->GetTop().has_value())
+      << "Package " << p->name() << " needs a top function/proc.";
+  FunctionBase* main = p->GetTop().value();
+
+  XLS_RETURN_IF_ERROR(VerifyPackage(p, /*codegen=*/true));
+
+  XLS_ASSIGN_OR_RETURN(verilog::CodegenOptions codegen_options,
+                       CodegenOptionsFromProto(codegen_flags));
+
+  CodegenResult result;
+  if (codegen_flags.generator() == GENERATOR_KIND_PIPELINE) {
+    XLS_RET_CHECK(delay_estimator != nullptr);
+    XLS_ASSIGN_OR_RETURN(
+        PipelineSchedule schedule,
+        RunSchedulingPipeline(main, scheduling_options, delay_estimator));
+    XLS_ASSIGN_OR_RETURN(
+        result.module_generator_result,
+        verilog::ToPipelineModuleText(schedule, main, codegen_options));
+    result.schedule = std::move(schedule);
+  } else if (codegen_flags.generator() == GENERATOR_KIND_COMBINATIONAL) {
+    XLS_ASSIGN_OR_RETURN(
+        result.module_generator_result,
+        verilog::GenerateCombinationalModule(main, codegen_options));
+  } else {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Invalid generator kind: %d",
+                        static_cast<int>(codegen_flags.generator())));
+  }
+  return result;
+}
+
+absl::Status WriteCodegenArtifacts(const CodegenFlagsProto& codegen_flags,
+                                   Package* p, CodegenResult& result) {
+  verilog::ModuleGeneratorResult& module = result.module_generator_result;
+  if (!codegen_flags.output_schedule_path().empty() &&
+      result.schedule.has_value()) {
+    XLS_RETURN_IF_ERROR(SetTextProtoFile(codegen_flags.output_schedule_path(),
+                                         result.schedule->ToProto()));
+  }
+
+  if (!codegen_flags.output_block_ir_path().empty()) {
+    XLS_RET_CHECK_EQ(p->blocks().size(), 1)
+        << "There should be exactly one block in the package after generating "
+           "module text.";
+    XLS_RETURN_IF_ERROR(
+        SetFileContents(codegen_flags.output_block_ir_path(), p->DumpIr()));
+  }
+
+  if (!codegen_flags.output_signature_path().empty()) {
+    XLS_RETURN_IF_ERROR(SetTextProtoFile(codegen_flags.output_signature_path(),
+                                         module.signature.proto()));
+  }
+
+  const std::string& verilog_path = codegen_flags.output_verilog_path();
+  if (!verilog_path.empty()) {
+    std::filesystem::path absolute = std::filesystem::absolute(verilog_path);
+    for (int64_t i = 0; i < module.verilog_line_map.mapping_size(); ++i) {
+      module.verilog_line_map.mutable_mapping(i)->set_verilog_file(absolute);
+    }
+  }
+
+  const std::string& verilog_line_map_path =
+      codegen_flags.output_verilog_line_map_path();
+  if (!verilog_line_map_path.empty()) {
+    XLS_RETURN_IF_ERROR(
+        SetTextProtoFile(verilog_line_map_path, module.verilog_line_map));
+  }
+
+  if (verilog_path.empty()) {
+    std::cout << module.verilog_text;
+  } else {
+    XLS_RETURN_IF_ERROR(SetFileContents(verilog_path, module.verilog_text));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace xls
@@ -0,0 +1,68 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Library that backs the `codegen_main` tool's primary functionality.
+
+#ifndef XLS_TOOLS_CODEGEN_H_
+#define XLS_TOOLS_CODEGEN_H_
+
+#include <optional>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "xls/codegen/codegen_options.h"
+#include "xls/codegen/module_signature.h"
+#include "xls/delay_model/delay_estimator.h"
+#include "xls/ir/function_base.h"
+#include "xls/ir/package.h"
+#include "xls/scheduling/pipeline_schedule.h"
+#include "xls/scheduling/scheduling_options.h"
+#include "xls/tools/codegen_flags.pb.h"
+
+namespace xls {
+
+// Converts the codegen flags proto into the options used by the generators.
+absl::StatusOr<verilog::CodegenOptions> CodegenOptionsFromProto(
+    const CodegenFlagsProto& p);
+
+// Runs the scheduling pass pipeline on the package containing `main` and
+// returns the schedule of `main`.
+absl::StatusOr<PipelineSchedule> RunSchedulingPipeline(
+    FunctionBase* main, const SchedulingOptions& scheduling_options,
+    const DelayEstimator* delay_estimator);
+
+// The products of scheduling and code generation.
+struct CodegenResult {
+  verilog::ModuleGeneratorResult module_generator_result;
+  // Only set for the pipeline generator.
+  std::optional<PipelineSchedule> schedule;
+};
+
+// Schedules (if the pipeline generator is selected) and generates Verilog for
+// the top entity of `p`. `delay_estimator` may be null for the combinational
+// generator.
+absl::StatusOr<CodegenResult> ScheduleAndCodegen(
+    Package* p, const CodegenFlagsProto& codegen_flags,
+    const SchedulingOptions& scheduling_options,
+    const DelayEstimator* delay_estimator);
+
+// Writes the artifacts in `result` to the output paths given in
+// `codegen_flags`. If no Verilog output path is given the Verilog text is
+// printed to stdout.
+absl::Status WriteCodegenArtifacts(const CodegenFlagsProto& codegen_flags,
+                                   Package* p, CodegenResult& result);
+
+}  // namespace xls
+
+#endif  // XLS_TOOLS_CODEGEN_H_
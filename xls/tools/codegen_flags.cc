@@ -126,6 +126,11 @@ ABSL_FLAG(bool, gate_recvs, true,
 ABSL_FLAG(bool, array_index_bounds_checking, true,
           "If true, emit bounds checking on array-index operations in Verilog. "
           "Otherwise, the bounds checking is not evaluated.");
+ABSL_FLAG(bool, infer_register_enables, false,
+          "If true, infer load enables for registers whose next value is "
+          "provably unchanged, or whose value is provably unobserved, under "
+          "some predicate. Inferred enables are reported in the block "
+          "metrics as candidates for clock gating.");
 // LINT.ThenChange(
 //   //xls/build_rules/xls_codegen_rules.bzl,
 //   //docs_src/codegen_options.md
@@ -215,6 +220,7 @@ absl::StatusOr<CodegenFlagsProto> CodegenFlagsFromAbslFlags() {
   // Optimizations
   POPULATE_FLAG(gate_recvs);
   POPULATE_FLAG(array_index_bounds_checking);
+  POPULATE_FLAG(infer_register_enables);
 #undef POPULATE_FLAG
 #undef POPULATE_REPEATED_FLAG
   return p;
@@ -12,20 +12,35 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <optional>
 #include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/flags/flag.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/str_split.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "absl/types/span.h"
 #include "xls/common/file/filesystem.h"
 #include "xls/common/init_xls.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/common/thread.h"
 #include "xls/dslx/create_import_data.h"
 #include "xls/dslx/default_dslx_stdlib_path.h"
 #include "xls/dslx/ir_converter.h"
@@ -37,6 +52,7 @@
 #include "xls/ir/ir_parser.h"
 #include "xls/ir/value_helpers.h"
 #include "xls/jit/function_jit.h"
+#include "xls/jit/tiered_function_jit.h"
 #include "xls/passes/passes.h"
 #include "xls/passes/standard_pipeline.h"
 
@@ -84,6 +100,11 @@ Evaluate IR after every optimization pass:
 Evaluate IR using the JIT and with the interpreter and compare the results:
 
    eval_ir_main --test_llvm_jit --random_inputs=100  IR_FILE
+
+Evaluate a large batch of inputs on 16 threads:
+
+   eval_ir_main --jobs=16 --input_file=INPUT_FILE \
+      --expected_file=EXPECTED_FILE IR_FILE
 )";
 
 // LINT.IfChange
@@ -121,6 +142,15 @@ ABSL_FLAG(bool, test_llvm_jit, false,
 ABSL_FLAG(int64_t, llvm_opt_level, 3,
           "The optimization level of the LLVM JIT. Valid values are from 0 (no "
           "optimizations) to 3 (maximum optimizations).");
+ABSL_FLAG(bool, tiered_jit, false,
+          "If true, start evaluating with an unoptimized JIT build while the "
+          "JIT is compiled at --llvm_opt_level in the background, and switch "
+          "to the optimized code once it is ready. Reduces latency when "
+          "evaluating a small number of inputs.");
+ABSL_FLAG(int64_t, jobs, 1,
+          "Number of threads used to parse --input_file/--expected_file and "
+          "to evaluate and check the samples. Results are printed in input "
+          "order. Cannot be combined with --tiered_jit.");
 ABSL_FLAG(std::string, input_validator_expr, "",
           "DSLX expression to validate randomly-generated inputs. "
           "The expression can reference entry function input arguments "
@@ -159,52 +189,225 @@ std::string ArgsToString(absl::Span<const Value> args) {
   return absl::StrJoin(args, "; ", ValueFormatterHex);
 }
 
+// Calls `fn(i)` for every i in [0, count) spread across `jobs` threads.
+// Returns the error with the lowest index, if any.
+absl::Status ParallelFor(int64_t count, int64_t jobs,
+                         const std::function<absl::Status(int64_t)>& fn) {
+  std::vector<absl::Status> statuses(count);
+  {
+    std::vector<std::unique_ptr<Thread>> threads;
+    for (int64_t t = 0; t < jobs; ++t) {
+      threads.push_back(std::make_unique<Thread>([&, t]() {
+        // Contiguous shards keep each thread's writes in its own cache lines.
+        for (int64_t i = count * t / jobs; i < count * (t + 1) / jobs; ++i) {
+          statuses[i] = fn(i);
+        }
+      }));
+    }
+  }
+  for (absl::Status& status : statuses) {
+    XLS_RETURN_IF_ERROR(status);
+  }
+  return absl::OkStatus();
+}
+
+// The outcome of evaluating a single ArgSet: the result of the evaluation and
+// whether the result matched the expectations (if any).
+struct SampleOutcome {
+  absl::StatusOr<Value> result;
+  absl::Status check;
+};
+
+// Buffer which collects outcomes produced out of order by worker threads and
+// hands them back in sample order. At most `capacity` outcomes are held at a
+// time; workers producing outcomes further ahead block until the consumer
+// catches up.
+class ReorderBuffer {
+ public:
+  explicit ReorderBuffer(int64_t capacity) : capacity_(capacity) {}
+
+  // Adds the outcome of sample `index`. Returns false if the buffer has been
+  // cancelled and the outcome was dropped.
+  bool Put(int64_t index, SampleOutcome outcome) {
+    absl::MutexLock lock(&mutex_);
+    auto can_put = [&]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+      return cancelled_ || index < next_index_ + capacity_;
+    };
+    mutex_.Await(absl::Condition(&can_put));
+    if (cancelled_) {
+      return false;
+    }
+    pending_.emplace(index, std::move(outcome));
+    return true;
+  }
+
+  // Blocks until the outcome of the next sample in order is available and
+  // returns it.
+  SampleOutcome Take() {
+    absl::MutexLock lock(&mutex_);
+    auto available = [&]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+      return pending_.contains(next_index_);
+    };
+    mutex_.Await(absl::Condition(&available));
+    auto it = pending_.find(next_index_);
+    SampleOutcome outcome = std::move(it->second);
+    pending_.erase(it);
+    ++next_index_;
+    return outcome;
+  }
+
+  // Drops all pending outcomes and unblocks producers.
+  void Cancel() {
+    absl::MutexLock lock(&mutex_);
+    cancelled_ = true;
+    pending_.clear();
+  }
+
+  bool cancelled() {
+    absl::MutexLock lock(&mutex_);
+    return cancelled_;
+  }
+
+ private:
+  const int64_t capacity_;
+  absl::Mutex mutex_;
+  int64_t next_index_ ABSL_GUARDED_BY(mutex_) = 0;
+  bool cancelled_ ABSL_GUARDED_BY(mutex_) = false;
+  absl::flat_hash_map<int64_t, SampleOutcome> pending_ ABSL_GUARDED_BY(mutex_);
+};
+
+// Evaluates `f` with a single ArgSet. Uses the JIT if `jit` or `tiered_jit` is
+// non-null and the interpreter otherwise. `buffers` are the JIT buffers of the
+// calling thread.
+absl::StatusOr<Value> EvalArgSet(Function* f, const ArgSet& arg_set,
+                                 FunctionJit* jit, FunctionJitBuffers* buffers,
+                                 TieredFunctionJit* tiered_jit) {
+  if (jit != nullptr || tiered_jit != nullptr) {
+    if (!absl::GetFlag(FLAGS_test_only_inject_jit_result).empty()) {
+      return Parser::ParseTypedValue(
+          absl::GetFlag(FLAGS_test_only_inject_jit_result));
+    }
+    return DropInterpreterEvents(tiered_jit != nullptr
+                                     ? tiered_jit->Run(arg_set.args)
+                                     : jit->Run(arg_set.args, buffers));
+  }
+  // TODO(https://github.com/google/xls/issues/506): 2021-10-12 Also compare
+  // resulting events once the JIT fully supports events. Note: This will
+  // require rethinking some of the control flow because event comparison
+  // only makes sense for certain modes (optimize_ir and test_llvm_jit).
+  return DropInterpreterEvents(InterpretFunction(f, arg_set.args));
+}
+
+// Returns an error if `result` does not match the expected value of `arg_set`
+// (if any). `index` is the index of the ArgSet.
+absl::Status CheckResult(int64_t index, const ArgSet& arg_set,
+                         const Value& result, std::string_view actual_src,
+                         std::string_view expected_src) {
+  if (arg_set.expected.has_value() && result != *arg_set.expected) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Miscompare for input[%i] \"%s\"\n  %s: %s\n  %s: %s", index,
+        ArgsToString(arg_set.args), actual_src,
+        result.ToString(FormatPreference::kHex), expected_src,
+        arg_set.expected->ToString(FormatPreference::kHex)));
+  }
+  return absl::OkStatus();
+}
+
 // Evaluates the function with the given ArgSets. Returns an error if the result
 // does not match expectations (if any). 'actual_src' and 'expected_src' are
 // string descriptions of the sources of the actual results and expected
-// results, respectively. These strings are included in error messages.
+// results, respectively. These strings are included in error messages. With
+// --jobs the ArgSets are evaluated and checked concurrently, each thread with
+// its own JIT buffers, and the results are printed in order.
 absl::StatusOr<std::vector<Value>> Eval(
     Function* f, absl::Span<const ArgSet> arg_sets, bool use_jit,
     std::string_view actual_src = "actual",
     std::string_view expected_src = "expected") {
   std::unique_ptr<FunctionJit> jit;
+  std::unique_ptr<TieredFunctionJit> tiered_jit;
   if (use_jit) {
     // No support for procs yet.
-    XLS_ASSIGN_OR_RETURN(
-        jit, FunctionJit::Create(f, absl::GetFlag(FLAGS_llvm_opt_level)));
+    if (absl::GetFlag(FLAGS_tiered_jit)) {
+      TieredJitOptions options;
+      options.opt_level = absl::GetFlag(FLAGS_llvm_opt_level);
+      XLS_ASSIGN_OR_RETURN(tiered_jit, TieredFunctionJit::Create(f, options));
+    } else {
+      XLS_ASSIGN_OR_RETURN(
+          jit, FunctionJit::Create(f, absl::GetFlag(FLAGS_llvm_opt_level)));
+    }
   }
 
+  absl::Time start = absl::Now();
+  int64_t jobs = std::min<int64_t>(absl::GetFlag(FLAGS_jobs), arg_sets.size());
   std::vector<Value> results;
-  for (const ArgSet& arg_set : arg_sets) {
-    Value result;
-    if (use_jit) {
-      if (absl::GetFlag(FLAGS_test_only_inject_jit_result).empty()) {
-        XLS_ASSIGN_OR_RETURN(result,
-                             DropInterpreterEvents(jit->Run(arg_set.args)));
-      } else {
-        XLS_ASSIGN_OR_RETURN(result, Parser::ParseTypedValue(absl::GetFlag(
-                                         FLAGS_test_only_inject_jit_result)));
-      }
-    } else {
-      // TODO(https://github.com/google/xls/issues/506): 2021-10-12 Also compare
-      // resulting events once the JIT fully supports events. Note: This will
-      // require rethinking some of the control flow because event comparison
-      // only makes sense for certain modes (optimize_ir and test_llvm_jit).
-      XLS_ASSIGN_OR_RETURN(
-          result, DropInterpreterEvents(InterpretFunction(f, arg_set.args)));
+  results.reserve(arg_sets.size());
+  if (jobs <= 1) {
+    std::unique_ptr<FunctionJitBuffers> buffers =
+        jit == nullptr ? nullptr : jit->CreateBuffers();
+    for (const ArgSet& arg_set : arg_sets) {
+      XLS_ASSIGN_OR_RETURN(Value result,
+                           EvalArgSet(f, arg_set, jit.get(), buffers.get(),
+                                      tiered_jit.get()));
+      std::cout << result.ToString(FormatPreference::kHex) << std::endl;
+      XLS_RETURN_IF_ERROR(CheckResult(results.size(), arg_set, result,
+                                      actual_src, expected_src));
+      results.push_back(result);
+    }
+  } else {
+    // Worker threads claim samples in order and push their outcomes into the
+    // reorder buffer from which this thread prints them in input order.
+    constexpr int64_t kSamplesPerThreadInFlight = 256;
+    ReorderBuffer reorder_buffer(jobs * kSamplesPerThreadInFlight);
+    std::atomic<int64_t> next_sample = 0;
+    std::vector<std::unique_ptr<Thread>> threads;
+    for (int64_t t = 0; t < jobs; ++t) {
+      threads.push_back(std::make_unique<Thread>([&]() {
+        std::unique_ptr<FunctionJitBuffers> buffers =
+            jit == nullptr ? nullptr : jit->CreateBuffers();
+        for (int64_t i = next_sample++; i < arg_sets.size();
+             i = next_sample++) {
+          SampleOutcome outcome{.result = EvalArgSet(f, arg_sets[i], jit.get(),
+                                                     buffers.get(),
+                                                     /*tiered_jit=*/nullptr)};
+          if (outcome.result.ok()) {
+            outcome.check = CheckResult(i, arg_sets[i], *outcome.result,
+                                        actual_src, expected_src);
+          }
+          if (!reorder_buffer.Put(i, std::move(outcome))) {
+            return;
+          }
+        }
+      }));
     }
-    std::cout << result.ToString(FormatPreference::kHex) << std::endl;
-
-    if (arg_set.expected.has_value()) {
-      if (result != *arg_set.expected) {
-        return absl::InvalidArgumentError(absl::StrFormat(
-            "Miscompare for input[%i] \"%s\"\n  %s: %s\n  %s: %s",
-            results.size(), ArgsToString(arg_set.args), actual_src,
-            result.ToString(FormatPreference::kHex), expected_src,
-            arg_set.expected->ToString(FormatPreference::kHex)));
+    absl::Status status = absl::OkStatus();
+    for (int64_t i = 0; i < arg_sets.size(); ++i) {
+      SampleOutcome outcome = reorder_buffer.Take();
+      if (!outcome.result.ok()) {
+        status = outcome.result.status();
+        break;
+      }
+      std::cout << outcome.result->ToString(FormatPreference::kHex) << "\n";
+      if (!outcome.check.ok()) {
+        status = outcome.check;
+        break;
       }
+      results.push_back(*std::move(outcome.result));
     }
-    results.push_back(result);
+    std::cout.flush();
+    reorder_buffer.Cancel();
+    // Join the workers before returning as they reference locals.
+    for (std::unique_ptr<Thread>& thread : threads) {
+      thread->Join();
+    }
+    XLS_RETURN_IF_ERROR(status);
+  }
+  absl::Duration elapsed = absl::Now() - start;
+  std::cerr << absl::StreamFormat(
+      "// Evaluated %d samples in %s with %d thread(s) (%.1f samples/sec)\n",
+      results.size(), absl::FormatDuration(elapsed), std::max<int64_t>(jobs, 1),
+      results.size() / std::max(absl::ToDoubleSeconds(elapsed), 1e-9));
+  if (tiered_jit != nullptr) {
+    XLS_VLOG(1) << "Tiered JIT: " << tiered_jit->GetStats().ToString();
   }
   return results;
 }
@@ -418,14 +621,23 @@ absl::Status RealMain(std::string_view input_path,
     absl::StatusOr<std::string> args_input_file =
         GetFileContents(absl::GetFlag(FLAGS_input_file));
     XLS_QCHECK_OK(args_input_file.status());
-    for (const auto& arg_line : absl::StrSplit(args_input_file.value(), '\n',
-                                               absl::SkipWhitespace())) {
-      absl::StatusOr<ArgSet> arg_set_status = ArgSetFromString(arg_line);
-      XLS_QCHECK_OK(arg_set_status.status())
-          << absl::StreamFormat("Invalid line in input file %s: %s",
-                                absl::GetFlag(FLAGS_input_file), arg_line);
-      arg_sets.push_back(arg_set_status.value());
-    }
+    std::vector<std::string_view> arg_lines = absl::StrSplit(
+        args_input_file.value(), '\n', absl::SkipWhitespace());
+    arg_sets.resize(arg_lines.size());
+    XLS_QCHECK_OK(ParallelFor(
+        arg_lines.size(), absl::GetFlag(FLAGS_jobs),
+        [&](int64_t i) -> absl::Status {
+          absl::StatusOr<ArgSet> arg_set_status =
+              ArgSetFromString(arg_lines[i]);
+          if (!arg_set_status.ok()) {
+            return absl::InvalidArgumentError(absl::StrFormat(
+                "Invalid line in input file %s: %s: %s",
+                absl::GetFlag(FLAGS_input_file), arg_lines[i],
+                arg_set_status.status().message()));
+          }
+          arg_sets[i] = *std::move(arg_set_status);
+          return absl::OkStatus();
+        }));
   } else {
     XLS_QCHECK_NE(absl::GetFlag(FLAGS_random_inputs), 0)
         << "Must specify --input, --input_file, or --random_inputs.";
@@ -469,22 +681,25 @@ absl::Status RealMain(std::string_view input_path,
     absl::StatusOr<std::string> expected_file =
         GetFileContents(absl::GetFlag(FLAGS_expected_file));
     XLS_QCHECK_OK(expected_file.status());
-    std::vector<Value> expecteds;
-    for (const auto& expected_line :
-         absl::StrSplit(expected_file.value(), '\n', absl::SkipWhitespace())) {
-      absl::StatusOr<Value> expected_status =
-          Parser::ParseTypedValue(expected_line);
-      XLS_QCHECK_OK(expected_status.status())
-          << absl::StreamFormat("Failed to parse line in expected file %s: %s",
-                                expected_line, expected_line);
-      expecteds.push_back(expected_status.value());
-    }
-    XLS_QCHECK_EQ(expecteds.size(), arg_sets.size())
+    std::vector<std::string_view> expected_lines = absl::StrSplit(
+        expected_file.value(), '\n', absl::SkipWhitespace());
+    XLS_QCHECK_EQ(expected_lines.size(), arg_sets.size())
         << "Number of values in expected file does not match the number of "
            "inputs.";
-    for (int64_t i = 0; i < arg_sets.size(); ++i) {
-      arg_sets[i].expected = expecteds[i];
-    }
+    XLS_QCHECK_OK(ParallelFor(
+        expected_lines.size(), absl::GetFlag(FLAGS_jobs),
+        [&](int64_t i) -> absl::Status {
+          absl::StatusOr<Value> expected_status =
+              Parser::ParseTypedValue(expected_lines[i]);
+          if (!expected_status.ok()) {
+            return absl::InvalidArgumentError(absl::StrFormat(
+                "Failed to parse line in expected file %s: %s: %s",
+                absl::GetFlag(FLAGS_expected_file), expected_lines[i],
+                expected_status.status().message()));
+          }
+          arg_sets[i].expected = *std::move(expected_status);
+          return absl::OkStatus();
+        }));
   }
 
   return Run(package.get(), arg_sets);
@@ -500,6 +715,9 @@ int main(int argc, char** argv) {
     XLS_LOG(QFATAL) << absl::StreamFormat("Expected invocation: %s <ir-path>",
                                           argv[0]);
   }
+  XLS_QCHECK_GE(absl::GetFlag(FLAGS_jobs), 1) << "--jobs must be positive";
+  XLS_QCHECK(absl::GetFlag(FLAGS_jobs) == 1 || !absl::GetFlag(FLAGS_tiered_jit))
+      << "Cannot specify both --jobs and --tiered_jit";
   XLS_QCHECK(absl::GetFlag(FLAGS_input_validator_expr).empty() ||
              absl::GetFlag(FLAGS_input_validator_path).empty())
       << "At most one one of 'input_validator' or 'input_validator_path' may "
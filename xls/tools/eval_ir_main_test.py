@@ -165,6 +165,54 @@ class EvalMainTest(absltest.TestCase):
     self.assertIn('Miscompare for input[1] "bits[32]:0x10; bits[32]:0x0"',
                   comp.stderr.decode('utf-8'))
 
+  def test_input_file_with_jobs(self):
+    ir_file = self.create_tempfile(content=ADD_IR)
+    input_file = self.create_tempfile(content='\n'.join(
+        'bits[32]:{}; bits[32]:{}'.format(i, 2 * i) for i in range(1000)))
+    expected_file = self.create_tempfile(
+        content='\n'.join('bits[32]:{}'.format(3 * i) for i in range(1000)))
+    for use_llvm_jit in ('true', 'false'):
+      results = subprocess.check_output([
+          EVAL_IR_MAIN_PATH, '--jobs=4', '--use_llvm_jit=' + use_llvm_jit,
+          '--input_file=' + input_file.full_path,
+          '--expected_file=' + expected_file.full_path, ir_file.full_path
+      ])
+      # Results are printed in input order.
+      self.assertSequenceEqual(
+          ['bits[32]:{:#x}'.format(3 * i) for i in range(1000)],
+          results.decode('utf-8').strip().split('\n'))
+
+  def test_input_file_with_jobs_failed_expected_file(self):
+    ir_file = self.create_tempfile(content=ADD_IR)
+    input_file = self.create_tempfile(content='\n'.join(
+        'bits[32]:{}; bits[32]:{}'.format(i, 2 * i) for i in range(1000)))
+    expected_file = self.create_tempfile(content='\n'.join(
+        'bits[32]:{}'.format(3 * i if i != 500 else 0) for i in range(1000)))
+    comp = subprocess.run([
+        EVAL_IR_MAIN_PATH, '--jobs=4', '--input_file=' + input_file.full_path,
+        '--expected_file=' + expected_file.full_path, ir_file.full_path
+    ],
+                          stdout=subprocess.PIPE,
+                          stderr=subprocess.PIPE,
+                          check=False)
+    self.assertNotEqual(comp.returncode, 0)
+    self.assertIn('Miscompare for input[500] "bits[32]:0x1f4; bits[32]:0x3e8"',
+                  comp.stderr.decode('utf-8'))
+    # Results up to and including the first miscompare are printed in order.
+    self.assertLen(comp.stdout.decode('utf-8').strip().split('\n'), 501)
+
+  def test_test_llvm_jit_with_jobs(self):
+    ir_file = self.create_tempfile(content=ADD_IR)
+    comp = subprocess.run([
+        EVAL_IR_MAIN_PATH, '--random_inputs=1000', '--jobs=4',
+        '--test_llvm_jit', ir_file.full_path
+    ],
+                          stdout=subprocess.PIPE,
+                          stderr=subprocess.PIPE,
+                          check=False)
+    self.assertEqual(comp.returncode, 0)
+    self.assertIn('samples/sec', comp.stderr.decode('utf-8'))
+
   def test_empty_input_file(self):
     ir_file = self.create_tempfile(content=ADD_IR)
     input_file = self.create_tempfile(content='')
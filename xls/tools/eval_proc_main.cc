@@ -120,6 +120,10 @@ ABSL_FLAG(int64_t, random_seed, 42, "Random seed");
 ABSL_FLAG(double, prob_input_valid_assert, 1.0,
           "Single-cycle probability of asserting valid with more input ready.");
 ABSL_FLAG(bool, show_trace, false, "Whether or not to print trace messages.");
+ABSL_FLAG(int64_t, jit_packed_array_threshold, 0,
+          "If non-zero, arrays with at least this many elements of at most 4 "
+          "bits each use a bit-packed layout in the JIT. Applies to the "
+          "serial_jit backend only.");
 
 namespace xls {
 
@@ -130,7 +134,10 @@ absl::Status EvaluateProcs(
         expected_outputs_for_channels) {
   std::unique_ptr<SerialProcRuntime> runtime;
   if (use_jit) {
-    XLS_ASSIGN_OR_RETURN(runtime, CreateJitSerialProcRuntime(package));
+    XLS_ASSIGN_OR_RETURN(
+        runtime,
+        CreateJitSerialProcRuntime(
+            package, absl::GetFlag(FLAGS_jit_packed_array_threshold)));
   } else {
     XLS_ASSIGN_OR_RETURN(runtime, CreateInterpreterSerialProcRuntime(package));
   }
@@ -540,8 +540,11 @@ absl::StatusOr<SimplificationResult> RunRandomPass(
   return SimplificationResult::kDidNotChange;
 }
 
-absl::StatusOr<SimplificationResult> SimplifyNode(
-    Node* n, std::mt19937* rng, std::string* which_transform) {
+// Simplifies the given node. Sets `package_changed` if the transformation
+// changed the package beyond the node's function base.
+absl::StatusOr<SimplificationResult> SimplifyNode(Node* n, std::mt19937* rng,
+                                                  std::string* which_transform,
+                                                  bool* package_changed) {
   FunctionBase* f = n->function_base();
   if (((n->Is<Receive>() && absl::GetFlag(FLAGS_can_remove_receives)) ||
        (n->Is<Send>() && absl::GetFlag(FLAGS_can_remove_sends))) &&
@@ -565,6 +568,7 @@ absl::StatusOr<SimplificationResult> SimplifyNode(
         *which_transform = "remove send: %s" + n->GetName();
         XLS_RETURN_IF_ERROR(f->RemoveNode(n));
         XLS_RETURN_IF_ERROR(f->package()->RemoveChannel(c));
+        *package_changed = true;
         return SimplificationResult::kDidChange;
       }
       if (n->Is<Receive>() && channel_to_nodes.at(c).size() == 1) {
@@ -588,6 +592,7 @@ absl::StatusOr<SimplificationResult> SimplifyNode(
         *which_transform = "remove receive: %s" + n->GetName();
         XLS_RETURN_IF_ERROR(f->RemoveNode(n));
         XLS_RETURN_IF_ERROR(f->package()->RemoveChannel(c));
+        *package_changed = true;
         return SimplificationResult::kDidChange;
       }
     }
@@ -674,13 +679,17 @@ absl::StatusOr<SimplificationResult> SimplifyNode(
   return SimplificationResult::kDidChange;
 }
 
+// Applies a random simplification to `f`. Sets `package_changed` if the
+// transformation changed the package beyond `f` (e.g., by running passes over
+// the whole package or removing channels).
 absl::StatusOr<SimplificationResult> Simplify(
     FunctionBase* f, std::optional<std::vector<Value>> inputs,
-    std::mt19937* rng, std::string* which_transform) {
+    std::mt19937* rng, std::string* which_transform, bool* package_changed) {
   if (absl::GetFlag(FLAGS_use_optimization_passes) && Random0To1(rng) < 0.2) {
     XLS_ASSIGN_OR_RETURN(SimplificationResult pass_result,
                          RunRandomPass(f, rng, which_transform));
     if (pass_result != SimplificationResult::kDidNotChange) {
+      *package_changed = true;
       return pass_result;
     }
   }
@@ -691,6 +700,7 @@ absl::StatusOr<SimplificationResult> Simplify(
     XLS_ASSIGN_OR_RETURN(bool changed, RunStandardPassPipeline(f->package()));
     if (changed) {
       *which_transform = "Optimization pipeline";
+      *package_changed = true;
       return SimplificationResult::kDidChange;
     }
   }
@@ -721,13 +731,14 @@ absl::StatusOr<SimplificationResult> Simplify(
   // Pick a random node and try to do something with it.
   int64_t i = absl::Uniform<int64_t>(*rng, 0, f->node_count());
   Node* n = *std::next(f->nodes().begin(), i);
-  return SimplifyNode(n, rng, which_transform);
+  return SimplifyNode(n, rng, which_transform, package_changed);
 }
 
 // Runs removal of dead nodes (transitively), and then any dead parameters.
+// Returns whether function bases other than `f` were removed.
 //
 // Note removing dead parameters will not cause any additional nodes to be dead.
-absl::Status CleanUp(FunctionBase* f, bool can_remove_params) {
+absl::StatusOr<bool> CleanUp(FunctionBase* f, bool can_remove_params) {
   DeadCodeEliminationPass dce;
   DeadFunctionEliminationPass dfe;
   PassResults results;
@@ -736,8 +747,7 @@ absl::Status CleanUp(FunctionBase* f, bool can_remove_params) {
   if (can_remove_params) {
     XLS_RETURN_IF_ERROR(RemoveDeadParameters(f).status());
   }
-  XLS_RETURN_IF_ERROR(dfe.Run(f->package(), PassOptions(), &results).status());
-  return absl::OkStatus();
+  return dfe.Run(f->package(), PassOptions(), &results);
 }
 
 absl::Status RealMain(std::string_view path,
@@ -774,7 +784,7 @@ absl::Status RealMain(std::string_view path,
     XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
                          ParsePackage(knownf_ir_text));
     FunctionBase* main = package->GetTop().value();
-    XLS_RETURN_IF_ERROR(CleanUp(main, can_remove_params));
+    XLS_RETURN_IF_ERROR(CleanUp(main, can_remove_params).status());
     XLS_RETURN_IF_ERROR(VerifyPackage(package.get()));
     knownf_ir_text = package->DumpIr();
     XLS_RETURN_IF_ERROR(VerifyStillFails(
@@ -790,6 +800,22 @@ absl::Status RealMain(std::string_view path,
   int64_t failed_simplification_attempts = 0;
   int64_t total_attempts = 0;
 
+  // The package holding the known failing IR. Each attempt edits it in place
+  // under a checkpoint of the top function base and rolls the edits back if
+  // the attempt is rejected. Only transformations which change the package
+  // beyond the top function base require re-parsing the known failing IR.
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
+                       ParsePackage(knownf_ir_text));
+  FunctionBase* candidate = package->GetTop().value();
+  auto revert = [&](bool package_changed) -> absl::Status {
+    if (!package_changed && candidate->Rollback().ok()) {
+      return absl::OkStatus();
+    }
+    XLS_ASSIGN_OR_RETURN(package, ParsePackage(knownf_ir_text));
+    candidate = package->GetTop().value();
+    return absl::OkStatus();
+  };
+
   while (true) {
     if (failed_simplification_attempts >= failed_attempt_limit) {
       XLS_LOG(INFO) << "Hit failed-simplification-attempt-limit: "
@@ -806,16 +832,16 @@ absl::Status RealMain(std::string_view path,
 
     XLS_VLOG(1) << "=== Simplification attempt " << total_attempts;
 
-    XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
-                         ParsePackage(knownf_ir_text));
-    FunctionBase* candidate = package->GetTop().value();
     XLS_VLOG_LINES(2,
                    "=== Candidate for simplification:\n" + candidate->DumpIr());
 
     // Simplify the function.
     std::string which_transform;
+    bool package_changed = false;
+    candidate->Checkpoint();
     XLS_ASSIGN_OR_RETURN(SimplificationResult simplification,
-                         Simplify(candidate, inputs, &rng, &which_transform));
+                         Simplify(candidate, inputs, &rng, &which_transform,
+                                  &package_changed));
 
     // If we cannot change it, we're done.
     if (simplification == SimplificationResult::kCannotChange) {
@@ -828,6 +854,7 @@ absl::Status RealMain(std::string_view path,
     // wedged in a state where we can't simplify anything.
     if (simplification == SimplificationResult::kDidNotChange) {
       XLS_VLOG(1) << "Did not change the sample.";
+      XLS_RETURN_IF_ERROR(revert(package_changed));
       failed_simplification_attempts++;
       continue;
     }
@@ -835,7 +862,9 @@ absl::Status RealMain(std::string_view path,
 
     // When we changed (simplified) it, clean it up then see if it still fails.
     XLS_CHECK(simplification == SimplificationResult::kDidChange);
-    XLS_RETURN_IF_ERROR(CleanUp(candidate, can_remove_params));
+    XLS_ASSIGN_OR_RETURN(bool removed_function_bases,
+                         CleanUp(candidate, can_remove_params));
+    package_changed |= removed_function_bases;
 
     XLS_VLOG_LINES(2, "=== After simplification [" + which_transform + "]\n" +
                           candidate->DumpIr());
@@ -844,6 +873,7 @@ absl::Status RealMain(std::string_view path,
     XLS_ASSIGN_OR_RETURN(bool still_fails,
                          StillFails(candidate_ir_text, inputs, &test_cache));
     if (!still_fails) {
+      XLS_RETURN_IF_ERROR(revert(package_changed));
       failed_simplification_attempts++;
       XLS_LOG(INFO) << "Sample no longer fails.";
       XLS_LOG(INFO) << "Failed simplification attempts now: "
@@ -857,7 +887,8 @@ absl::Status RealMain(std::string_view path,
     // We found something that definitely fails, update our "knownf" value and
     // reset our failed simplification attempt count since we see we've made
     // some forward progress.
-    XLS_RETURN_IF_ERROR(CleanUp(candidate, can_remove_params));
+    candidate->Commit();
+    XLS_RETURN_IF_ERROR(CleanUp(candidate, can_remove_params).status());
 
     XLS_RETURN_IF_ERROR(VerifyStillFails(
         knownf_ir_text, inputs, "Known failure does not fail after cleanup!",
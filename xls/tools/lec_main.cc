@@ -22,6 +22,7 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/str_split.h"
+#include "absl/time/time.h"
 #include "xls/common/file/filesystem.h"
 #include "xls/common/file/get_runfile_path.h"
 #include "xls/common/init_xls.h"
@@ -37,6 +38,7 @@
 #include "xls/netlist/netlist_parser.h"
 #include "xls/scheduling/pipeline_schedule.pb.h"
 #include "xls/solvers/z3_lec.h"
+#include "xls/solvers/z3_portfolio.h"
 #include "xls/solvers/z3_utils.h"
 #include "../z3/src/api/z3_api.h"
 
@@ -78,6 +80,10 @@ ABSL_FLAG(std::string, schedule_path, "",
           "impossible.");
 ABSL_FLAG(int32_t, timeout_sec, -1,
           "Amount of time to allow for a LEC operation.");
+ABSL_FLAG(bool, solver_portfolio, false,
+          "Race several Z3 configurations (tactics and random seeds) in "
+          "parallel and use the first definitive answer. --timeout_sec "
+          "applies to each configuration.");
 ABSL_FLAG(bool, auto_stage, false,
           "If true, then the tool will determine on its own whether to perform "
           "staged or full LEC. This requires that a schedule be specified.");
@@ -169,11 +175,21 @@ void CancelAlarm(struct sigaction old_action) {
   sigaction(SIGALRM, &old_action, &dummy);
 }
 
+// Returns the portfolio options for the given timeout (-1 for none).
+solvers::z3::PortfolioOptions GetPortfolioOptions(int timeout_sec) {
+  solvers::z3::PortfolioOptions options;
+  if (timeout_sec != -1) {
+    options.timeout = absl::Seconds(timeout_sec);
+  }
+  return options;
+}
+
 // This function applies heuristics to determine whether or not a full LEC can
 // be performed or if we should break into stages. For now, these are simple:
 // does the IR contain a greater-than-8-bit MUL?
 absl::Status AutoStage(const solvers::z3::LecParams& lec_params,
-                       const PipelineSchedule& schedule, int timeout_sec) {
+                       const PipelineSchedule& schedule, int timeout_sec,
+                       bool solver_portfolio) {
   bool do_staged = false;
 
   // Other staged/full heuristics should go here.
@@ -186,6 +202,24 @@ absl::Status AutoStage(const solvers::z3::LecParams& lec_params,
       XLS_ASSIGN_OR_RETURN(
           auto lec, solvers::z3::Lec::CreateForStage(lec_params, schedule, i));
 
+      if (solver_portfolio) {
+        absl::StatusOr<bool> equal =
+            lec->RunPortfolio(GetPortfolioOptions(timeout_sec));
+        if (absl::IsDeadlineExceeded(equal.status())) {
+          std::cout << "TIMED OUT!\n";
+          continue;
+        }
+        XLS_RETURN_IF_ERROR(equal.status());
+        if (equal.value()) {
+          std::cout << "PASSED!\n";
+        } else {
+          std::cout << "FAILED!\n";
+          std::cout << std::endl << "IR/netlist value dump:" << std::endl;
+          lec->DumpIrTree();
+        }
+        continue;
+      }
+
       z3_interrupted = false;
       struct sigaction old_action = SetAlarm(timeout_sec);
       bool equal = lec->Run();
@@ -208,7 +242,13 @@ absl::Status AutoStage(const solvers::z3::LecParams& lec_params,
     std::cout << "Performing full LEC.\n";
     XLS_ASSIGN_OR_RETURN(auto lec,
                          solvers::z3::Lec::Create(std::move(lec_params)));
-    bool equal = lec->Run();
+    bool equal;
+    if (solver_portfolio) {
+      XLS_ASSIGN_OR_RETURN(equal,
+                           lec->RunPortfolio(GetPortfolioOptions(timeout_sec)));
+    } else {
+      equal = lec->Run();
+    }
     std::cout << lec->ResultToString() << std::endl;
     if (!equal) {
       std::cout << std::endl << "IR/netlist value dump:" << std::endl;
@@ -226,7 +266,7 @@ absl::Status RealMain(
     std::string_view netlist_module_name, std::string_view cell_lib_path,
     std::string_view cell_proto_path, std::string_view netlist_path,
     std::string_view constraints_file, std::string_view schedule_path,
-    int stage, bool auto_stage, int timeout_sec) {
+    int stage, bool auto_stage, int timeout_sec, bool solver_portfolio) {
   solvers::z3::LecParams lec_params;
   XLS_ASSIGN_OR_RETURN(std::string ir_text, GetFileContents(ir_path));
   XLS_ASSIGN_OR_RETURN(auto package, Parser::ParsePackage(ir_text));
@@ -254,7 +294,7 @@ absl::Status RealMain(
         PipelineSchedule schedule,
         PipelineSchedule::FromProto(lec_params.ir_function, proto));
     if (auto_stage) {
-      return AutoStage(lec_params, schedule, timeout_sec);
+      return AutoStage(lec_params, schedule, timeout_sec, solver_portfolio);
     }
     XLS_ASSIGN_OR_RETURN(lec, solvers::z3::Lec::CreateForStage(
                                   std::move(lec_params), schedule, stage));
@@ -278,17 +318,23 @@ absl::Status RealMain(
     XLS_RETURN_IF_ERROR(lec->AddConstraints(function));
   }
 
-  struct sigaction old_action;
-  if (timeout_sec != -1) {
-    old_action = SetAlarm(timeout_sec);
-  }
-  bool equal = lec->Run();
-  if (timeout_sec != -1) {
-    CancelAlarm(old_action);
-  }
-  absl::MutexLock lock(&mutex);
-  if (z3_interrupted) {
-    return absl::DeadlineExceededError("LEC timed out.");
+  bool equal;
+  if (solver_portfolio) {
+    XLS_ASSIGN_OR_RETURN(equal,
+                         lec->RunPortfolio(GetPortfolioOptions(timeout_sec)));
+  } else {
+    struct sigaction old_action;
+    if (timeout_sec != -1) {
+      old_action = SetAlarm(timeout_sec);
+    }
+    equal = lec->Run();
+    if (timeout_sec != -1) {
+      CancelAlarm(old_action);
+    }
+    absl::MutexLock lock(&mutex);
+    if (z3_interrupted) {
+      return absl::DeadlineExceededError("LEC timed out.");
+    }
   }
 
   std::cout << lec->ResultToString() << std::endl;
@@ -333,6 +379,7 @@ int main(int argc, char* argv[]) {
       ir_path, absl::GetFlag(FLAGS_entry_function_name),
       absl::GetFlag(FLAGS_netlist_module_name), cell_lib_path, cell_proto_path,
       netlist_path, absl::GetFlag(FLAGS_constraints_file), schedule_path, stage,
-      auto_stage, absl::GetFlag(FLAGS_timeout_sec)));
+      auto_stage, absl::GetFlag(FLAGS_timeout_sec),
+      absl::GetFlag(FLAGS_solver_portfolio)));
   return 0;
 }
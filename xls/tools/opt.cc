@@ -25,6 +25,13 @@ namespace xls::tools {
 
 absl::StatusOr<std::string> OptimizeIrForTop(std::string_view ir,
                                              const OptOptions& options) {
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
+                       Parser::ParsePackage(ir, options.ir_path));
+  XLS_RETURN_IF_ERROR(OptimizeIrForTop(package.get(), options));
+  return package->DumpIr();
+}
+
+absl::Status OptimizeIrForTop(Package* package, const OptOptions& options) {
   if (!options.top.empty()) {
     XLS_VLOG(3) << "OptimizeIrForEntry; top: '" << options.top
                 << "'; opt_level: " << options.opt_level;
@@ -32,8 +39,6 @@ absl::StatusOr<std::string> OptimizeIrForTop(std::string_view ir,
     XLS_VLOG(3) << "OptimizeIrForEntry; opt_level: " << options.opt_level;
   }
 
-  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
-                       Parser::ParsePackage(ir, options.ir_path));
   if (!options.top.empty()) {
     XLS_RETURN_IF_ERROR(package->SetTopByName(options.top));
   }
@@ -51,14 +56,21 @@ absl::StatusOr<std::string> OptimizeIrForTop(std::string_view ir,
       .skip_passes = options.skip_passes,
       .inline_procs = options.inline_procs,
       .convert_array_index_to_select = options.convert_array_index_to_select,
+      .resource_sharing = options.resource_sharing,
+      .carry_save_compression = options.carry_save_compression,
+      .time_budget = options.time_budget,
+      .max_fixed_point_iterations = options.max_fixed_point_iterations,
   };
   PassResults results;
-  XLS_RETURN_IF_ERROR(
-      pipeline->Run(package.get(), pass_options, &results).status());
+  XLS_RETURN_IF_ERROR(pipeline->Run(package, pass_options, &results).status());
+  // Report what the budget cut short so partially optimized output does not
+  // go unnoticed.
+  for (const std::string& what : results.budget.report()) {
+    XLS_LOG(WARNING) << "Optimization budget: " << what;
+  }
   // If opt returns something that obviously can't be codegenned, that's a bug
   // in opt, not codegen.
-  XLS_RETURN_IF_ERROR(xls::VerifyPackage(package.get(), /*codegen=*/true));
-  return package->DumpIr();
+  return xls::VerifyPackage(package, /*codegen=*/true);
 }
 
 }  // namespace xls::tools
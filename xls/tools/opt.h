@@ -21,8 +21,11 @@
 #include <string>
 #include <vector>
 
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "xls/ir/package.h"
 
 // TODO(meheff): 2021-10-04 Remove this header.
 #include "xls/passes/passes.h"
@@ -40,6 +43,10 @@ struct OptOptions {
   std::vector<std::string> skip_passes;
   std::optional<int64_t> convert_array_index_to_select = std::nullopt;
   bool inline_procs;
+  bool resource_sharing = false;
+  bool carry_save_compression = false;
+  std::optional<absl::Duration> time_budget = std::nullopt;
+  std::optional<int64_t> max_fixed_point_iterations = std::nullopt;
 };
 
 // Helper used in the opt_main tool, optimizes the given IR for a particular
@@ -48,6 +55,10 @@ struct OptOptions {
 absl::StatusOr<std::string> OptimizeIrForTop(std::string_view ir,
                                              const OptOptions& options);
 
+// As above, but optimizes the given package in place. If `options.top` is
+// empty the package must already have a top entity.
+absl::Status OptimizeIrForTop(Package* package, const OptOptions& options);
+
 }  // namespace xls::tools
 
 #endif  // XLS_TOOLS_OPT_H_
@@ -17,6 +17,7 @@
 
 #include "absl/status/status.h"
 #include "absl/strings/str_format.h"
+#include "absl/time/time.h"
 #include "xls/common/file/filesystem.h"
 #include "xls/common/init_xls.h"
 #include "xls/common/logging/logging.h"
@@ -64,6 +65,22 @@ ABSL_FLAG(int64_t, opt_level, xls::kMaxOptLevel,
                           xls::kMaxOptLevel));
 ABSL_FLAG(bool, inline_procs, false,
           "Whether to inline all procs by calling the proc inlining pass. ");
+ABSL_FLAG(bool, resource_sharing, false,
+          "Whether to share multipliers, dividers and wide adders which are "
+          "used under mutually exclusive conditions, as long as this does "
+          "not lengthen the critical path.");
+ABSL_FLAG(bool, carry_save_compression, false,
+          "Whether to rewrite sums of three or more addends into trees of "
+          "carry-save compressors followed by a single adder.");
+ABSL_FLAG(absl::Duration, time_budget, absl::InfiniteDuration(),
+          "If specified, the time budget of the optimization pipeline (e.g., "
+          "\"30s\"). Once half of the budget is spent expensive analyses "
+          "are degraded, and once all of it is spent fixed-point loops stop "
+          "iterating and expensive passes are skipped. Skipped work is "
+          "reported on stderr.");
+ABSL_FLAG(int64_t, max_fixed_point_iterations, -1,
+          "If non-negative, the maximum number of iterations of each "
+          "fixed-point pass (e.g., the simplification pass) invocation.");
 // LINT.ThenChange(//xls/build_rules/xls_ir_rules.bzl)
 
 namespace xls::tools {
@@ -80,6 +97,9 @@ absl::Status RealMain(std::string_view input_path) {
       absl::GetFlag(FLAGS_run_only_passes);
   int64_t convert_array_index_to_select =
       absl::GetFlag(FLAGS_convert_array_index_to_select);
+  absl::Duration time_budget = absl::GetFlag(FLAGS_time_budget);
+  int64_t max_fixed_point_iterations =
+      absl::GetFlag(FLAGS_max_fixed_point_iterations);
   const OptOptions options = {
       .opt_level = absl::GetFlag(FLAGS_opt_level),
       .top = top,
@@ -93,6 +113,15 @@ absl::Status RealMain(std::string_view input_path) {
               ? std::nullopt
               : std::make_optional(convert_array_index_to_select),
       .inline_procs = absl::GetFlag(FLAGS_inline_procs),
+      .resource_sharing = absl::GetFlag(FLAGS_resource_sharing),
+      .carry_save_compression = absl::GetFlag(FLAGS_carry_save_compression),
+      .time_budget = time_budget == absl::InfiniteDuration()
+                         ? std::nullopt
+                         : std::make_optional(time_budget),
+      .max_fixed_point_iterations =
+          (max_fixed_point_iterations < 0)
+              ? std::nullopt
+              : std::make_optional(max_fixed_point_iterations),
   };
   XLS_ASSIGN_OR_RETURN(std::string opt_ir,
                        tools::OptimizeIrForTop(ir, options));
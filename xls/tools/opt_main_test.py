@@ -128,6 +128,28 @@ class OptMainTest(test_base.TestCase):
     self.assertIn('bits[32] = add', optimized_ir)
     self.assertNotIn('concat', optimized_ir)
 
+  def test_time_budget(self):
+    ir_file = self.create_tempfile(content=ADD_ZERO_IR)
+
+    # With no time the expensive passes are skipped, but the remaining passes
+    # still run and the skipped work is reported.
+    result = subprocess.run(
+        [OPT_MAIN_PATH, '--time_budget=0s', '--alsologtostderr',
+         ir_file.full_path],
+        stdout=subprocess.PIPE,
+        stderr=subprocess.PIPE,
+        check=True)
+    self.assertIn('ret x', result.stdout.decode('utf-8'))
+    self.assertIn('skipped bdd_simp', result.stderr.decode('utf-8'))
+
+  def test_max_fixed_point_iterations(self):
+    ir_file = self.create_tempfile(content=ADD_ZERO_IR)
+
+    optimized_ir = subprocess.check_output(
+        [OPT_MAIN_PATH, '--max_fixed_point_iterations=1',
+         ir_file.full_path]).decode('utf-8')
+    self.assertIn('ret x', optimized_ir)
+
 
 if __name__ == '__main__':
   test_base.main()
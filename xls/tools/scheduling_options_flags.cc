@@ -61,6 +61,10 @@ ABSL_FLAG(std::vector<std::string>, io_constraints, {},
 ABSL_FLAG(bool, receives_first_sends_last, false,
           "If true, this forces receives into the first cycle and sends into "
           "the last cycle.");
+ABSL_FLAG(bool, recompute_cheap_values, false,
+          "If true, the scheduler may recompute zero-delay operations in the "
+          "stages of their later users instead of carrying their values in "
+          "pipeline registers when this reduces the pipeline register count.");
 // LINT.ThenChange(
 //   //xls/build_rules/xls_codegen_rules.bzl,
 //   //docs_src/codegen_options.md
@@ -136,6 +140,9 @@ absl::StatusOr<SchedulingOptions> SetUpSchedulingOptions(Package* p) {
   if (absl::GetFlag(FLAGS_receives_first_sends_last)) {
     scheduling_options.add_constraint(RecvsFirstSendsLastConstraint());
   }
+  if (absl::GetFlag(FLAGS_recompute_cheap_values)) {
+    scheduling_options.recompute_cheap_values(true);
+  }
 
   if (p != nullptr) {
     for (const SchedulingConstraint& c : scheduling_options.constraints()) {
@@ -39,6 +39,7 @@
 #include <cstdint>
 #include <functional>
 #include <iostream>
+#include <memory>
 
 #include "absl/strings/str_format.h"
 #include "absl/types/optional.h"
@@ -66,6 +67,21 @@ class TestbenchBuilder {
         compute_actual_(compute_actual),
         create_shard_data_(create_shard_data) {}
 
+  // Constructor for testbenches whose shard data is set via SetSharedJit.
+  TestbenchBuilder(ComputeFnT compute_expected, ComputeFnT compute_actual)
+      : compute_expected_(compute_expected), compute_actual_(compute_actual) {}
+
+  // Uses the JIT wrapper `jit` (e.g., as generated by xls_ir_jit_wrapper) to
+  // create the shard data of every worker. Each worker gets a wrapper created
+  // by `jit->CreateInstanceSharingJit()` which has its own buffers but shares
+  // the compiled code, so the function is compiled only once rather than once
+  // per worker thread. Overrides any shard data creation function passed to
+  // the constructor.
+  TestbenchBuilder& SetSharedJit(std::shared_ptr<const ShardDataT> jit) {
+    create_shard_data_ = [jit]() { return jit->CreateInstanceSharingJit(); };
+    return *this;
+  }
+
   TestbenchBuilder& SetCompareResultsFn(const CompareResultsFnT& fn) {
     compare_results_ = fn;
     return *this;
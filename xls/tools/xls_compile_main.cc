@@ -0,0 +1,423 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Compiles DSLX (or IR) to Verilog in a single process. This is equivalent to
+// running ir_converter_main, opt_main and codegen_main in sequence but the
+// package is kept in memory between the stages.
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>  // NOLINT
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/init_xls.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/common/thread.h"
+#include "xls/delay_model/delay_estimator.h"
+#include "xls/dslx/command_line_utils.h"
+#include "xls/dslx/create_import_data.h"
+#include "xls/dslx/default_dslx_stdlib_path.h"
+#include "xls/dslx/error_printer.h"
+#include "xls/dslx/ir_converter.h"
+#include "xls/dslx/mangle.h"
+#include "xls/dslx/parse_and_typecheck.h"
+#include "xls/ir/ir_parser.h"
+#include "xls/ir/package.h"
+#include "xls/passes/passes.h"
+#include "xls/tools/codegen.h"
+#include "xls/tools/codegen_flags.h"
+#include "xls/tools/opt.h"
+#include "xls/tools/scheduling_options_flags.h"
+
+const char kUsage[] = R"(
+Compiles DSLX (or IR) to Verilog in a single process: IR conversion,
+optimization, scheduling and code generation. The package is kept in memory
+between the stages. Accepts the codegen and scheduling flags of codegen_main.
+
+Compile a single top entity, writing the same artifacts as ir_converter_main,
+opt_main and codegen_main:
+
+   xls_compile_main --top=main --pipeline_stages=3 \
+       --output_ir_path=foo.ir --output_opt_ir_path=foo.opt.ir \
+       --output_verilog_path=foo.v --output_signature_path=foo.sig.textproto \
+       foo.x
+
+Compile several top entities of the same module in parallel, writing the
+artifacts of each top entity `T` to `DIR/T.ir`, `DIR/T.opt.ir`, `DIR/T.v`, etc:
+
+   xls_compile_main --tops=add,mul --pipeline_stages=3 --output_dir=DIR foo.x
+
+An IR file (with the extension `.ir`) may be given instead of DSLX files in
+which case IR conversion is skipped.
+)";
+
+// LINT.IfChange
+ABSL_FLAG(std::vector<std::string>, tops, {},
+          "Comma-separated list of top entities to compile. Each top entity is "
+          "compiled independently on a thread pool. Requires --output_dir. "
+          "Mutually exclusive with --top.");
+ABSL_FLAG(std::string, output_dir, "",
+          "Directory to which the artifacts of each top entity are written "
+          "when --tops is given.");
+ABSL_FLAG(std::string, output_ir_path, "",
+          "Path to which the unoptimized IR is written.");
+ABSL_FLAG(std::string, output_opt_ir_path, "",
+          "Path to which the optimized IR is written.");
+ABSL_FLAG(int64_t, jobs, 0,
+          "Number of top entities to compile concurrently. If zero, the "
+          "number of hardware threads is used.");
+ABSL_FLAG(std::string, stdlib_path, xls::kDefaultDslxStdlibPath,
+          "Path to DSLX standard library files.");
+ABSL_FLAG(std::string, dslx_path, "",
+          "Additional paths to search for modules (colon delimited).");
+ABSL_FLAG(std::string, package_name, "",
+          "Package name to use for output (required when multiple input .x "
+          "files are given).");
+ABSL_FLAG(bool, emit_fail_as_assert, true,
+          "Feature flag for emitting fail!() in the DSL as an assert IR op.");
+ABSL_FLAG(bool, warnings_as_errors, true,
+          "Whether to fail early, as an error, if warnings are detected");
+ABSL_FLAG(int64_t, opt_level, xls::kMaxOptLevel,
+          absl::StrFormat("Optimization level. Ranges from 1 to %d.",
+                          xls::kMaxOptLevel));
+ABSL_FLAG(std::vector<std::string>, skip_passes, {},
+          "If specified, passes in this comma-separated list of (short) "
+          "pass names are skipped.");
+ABSL_FLAG(int64_t, convert_array_index_to_select, -1,
+          "If specified, convert array indexes with fewer than or "
+          "equal to the given number of possible indices (by range analysis) "
+          "into chains of selects. Otherwise, this optimization is skipped.");
+ABSL_FLAG(bool, inline_procs, false,
+          "Whether to inline all procs by calling the proc inlining pass.");
+// LINT.ThenChange(//docs_src/tools.md)
+
+namespace xls {
+namespace {
+
+// A top entity to compile along with the paths of its artifacts.
+struct CompilationJob {
+  std::unique_ptr<Package> package;
+  std::string ir_path;
+  std::string opt_ir_path;
+  CodegenFlagsProto codegen_flags;
+};
+
+std::vector<std::filesystem::path> GetDslxPaths() {
+  std::vector<std::filesystem::path> dslx_paths;
+  for (std::string_view path :
+       absl::StrSplit(absl::GetFlag(FLAGS_dslx_path), ':', absl::SkipEmpty())) {
+    dslx_paths.push_back(std::filesystem::path(path));
+  }
+  return dslx_paths;
+}
+
+dslx::ConvertOptions GetConvertOptions() {
+  dslx::ConvertOptions convert_options;
+  convert_options.emit_positions = true;
+  convert_options.emit_fail_as_assert = absl::GetFlag(FLAGS_emit_fail_as_assert);
+  convert_options.verify_ir = true;
+  convert_options.warnings_as_errors = absl::GetFlag(FLAGS_warnings_as_errors);
+  return convert_options;
+}
+
+// Sets the top of `package` to the DSLX entity `top` defined in one of the
+// modules `module_names`. The IR converter mangles function names, so a DSLX
+// function is found under its mangled name; a top proc is already marked by the
+// converter. Otherwise `top` is taken to be an IR name.
+absl::Status SetTopFromDslxName(Package* package, std::string_view top,
+                                absl::Span<const std::string> module_names) {
+  for (const std::string& module_name : module_names) {
+    XLS_ASSIGN_OR_RETURN(
+        std::string ir_name,
+        dslx::MangleDslxName(module_name, top,
+                             dslx::CallingConvention::kTypical));
+    if (package->GetFunction(ir_name).ok()) {
+      return package->SetTopByName(ir_name);
+    }
+  }
+  if (package->GetTop().has_value()) {
+    return absl::OkStatus();
+  }
+  return package->SetTopByName(top);
+}
+
+// Converts the DSLX module at `path` once for each top entity in `tops`. The
+// module is parsed and typechecked only once.
+absl::StatusOr<std::vector<std::unique_ptr<Package>>> ConvertDslxForTops(
+    std::string_view path, absl::Span<const std::string> tops,
+    bool* printed_error) {
+  dslx::ImportData import_data(dslx::CreateImportData(
+      absl::GetFlag(FLAGS_stdlib_path), GetDslxPaths()));
+  XLS_ASSIGN_OR_RETURN(std::string text, GetFileContents(path));
+  XLS_ASSIGN_OR_RETURN(std::string module_name, dslx::PathToName(path));
+  absl::StatusOr<dslx::TypecheckedModule> tm =
+      dslx::ParseAndTypecheck(text, path, module_name, &import_data);
+  if (!tm.ok()) {
+    *printed_error = dslx::TryPrintError(tm.status());
+    return tm.status();
+  }
+  dslx::ConvertOptions convert_options = GetConvertOptions();
+  if (convert_options.warnings_as_errors && !tm->warnings.warnings().empty()) {
+    *printed_error = true;
+    dslx::PrintWarnings(tm->warnings);
+    return absl::InvalidArgumentError(
+        "Warnings encountered and warnings-as-errors set.");
+  }
+
+  std::string package_name = absl::GetFlag(FLAGS_package_name);
+  if (package_name.empty()) {
+    package_name = module_name;
+  }
+  std::vector<std::unique_ptr<Package>> packages;
+  for (const std::string& top : tops) {
+    auto package = std::make_unique<Package>(package_name);
+    XLS_RETURN_IF_ERROR(dslx::ConvertOneFunctionIntoPackage(
+        tm->module, top, &import_data, /*parametric_env=*/nullptr,
+        convert_options, package.get()));
+    XLS_RETURN_IF_ERROR(
+        SetTopFromDslxName(package.get(), top, {module_name}));
+    packages.push_back(std::move(package));
+  }
+  return packages;
+}
+
+// Returns one package per top entity. The top of each package is set.
+absl::StatusOr<std::vector<std::unique_ptr<Package>>> GetPackages(
+    absl::Span<const std::string_view> paths,
+    absl::Span<const std::string> tops, bool* printed_error) {
+  std::vector<std::unique_ptr<Package>> packages;
+  if (paths.size() == 1 && absl::EndsWith(paths[0], ".ir")) {
+    XLS_ASSIGN_OR_RETURN(std::string ir, GetFileContents(paths[0]));
+    if (tops.empty()) {
+      XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
+                           Parser::ParsePackage(ir, paths[0]));
+      packages.push_back(std::move(package));
+      return packages;
+    }
+    // Each top entity is optimized separately so each needs its own copy of
+    // the package.
+    for (const std::string& top : tops) {
+      XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
+                           Parser::ParsePackage(ir, paths[0]));
+      XLS_RETURN_IF_ERROR(package->SetTopByName(top));
+      packages.push_back(std::move(package));
+    }
+    return packages;
+  }
+
+  if (tops.empty()) {
+    return absl::InvalidArgumentError(
+        "Must specify --top or --tops when compiling DSLX.");
+  }
+  if (paths.size() == 1) {
+    return ConvertDslxForTops(paths[0], tops, printed_error);
+  }
+
+  // Multiple DSLX files are converted into a single package as in
+  // ir_converter_main. The top is then resolved in any of the modules.
+  XLS_RET_CHECK_EQ(tops.size(), 1)
+      << "Only a single top may be given with multiple input paths.";
+  std::optional<std::string_view> package_name;
+  if (!absl::GetFlag(FLAGS_package_name).empty()) {
+    package_name = absl::GetFlag(FLAGS_package_name);
+  }
+  std::vector<std::filesystem::path> dslx_paths = GetDslxPaths();
+  XLS_ASSIGN_OR_RETURN(
+      std::unique_ptr<Package> package,
+      dslx::ConvertFilesToPackage(paths, absl::GetFlag(FLAGS_stdlib_path),
+                                  dslx_paths, GetConvertOptions(),
+                                  /*top=*/std::nullopt, package_name,
+                                  printed_error));
+  std::vector<std::string> module_names;
+  for (std::string_view path : paths) {
+    XLS_ASSIGN_OR_RETURN(std::string module_name, dslx::PathToName(path));
+    module_names.push_back(std::move(module_name));
+  }
+  XLS_RETURN_IF_ERROR(
+      SetTopFromDslxName(package.get(), tops.front(), module_names));
+  packages.push_back(std::move(package));
+  return packages;
+}
+
+absl::Status CompileTop(CompilationJob& job,
+                        const tools::OptOptions& opt_options,
+                        const DelayEstimator* delay_estimator) {
+  Package* package = job.package.get();
+  if (!job.ir_path.empty()) {
+    XLS_RETURN_IF_ERROR(SetFileContents(job.ir_path, package->DumpIr()));
+  }
+
+  XLS_RETURN_IF_ERROR(tools::OptimizeIrForTop(package, opt_options));
+  if (!job.opt_ir_path.empty()) {
+    XLS_RETURN_IF_ERROR(SetFileContents(job.opt_ir_path, package->DumpIr()));
+  }
+
+  SchedulingOptions scheduling_options;
+  if (job.codegen_flags.generator() == GENERATOR_KIND_PIPELINE) {
+    XLS_ASSIGN_OR_RETURN(scheduling_options, SetUpSchedulingOptions(package));
+  }
+  XLS_ASSIGN_OR_RETURN(CodegenResult result,
+                       ScheduleAndCodegen(package, job.codegen_flags,
+                                          scheduling_options, delay_estimator));
+  return WriteCodegenArtifacts(job.codegen_flags, package, result);
+}
+
+// Compiles the jobs on a pool of `thread_count` threads. Returns the error of
+// the first failing job (in job order).
+absl::Status CompileAll(std::vector<CompilationJob>& jobs,
+                        const tools::OptOptions& opt_options,
+                        const DelayEstimator* delay_estimator,
+                        int64_t thread_count) {
+  std::vector<absl::Status> statuses(jobs.size());
+  std::atomic<int64_t> next_job = 0;
+  auto worker = [&]() {
+    for (int64_t i = next_job++; i < jobs.size(); i = next_job++) {
+      statuses[i] = CompileTop(jobs[i], opt_options, delay_estimator);
+    }
+  };
+  if (thread_count <= 1 || jobs.size() <= 1) {
+    worker();
+  } else {
+    std::vector<std::unique_ptr<Thread>> threads;
+    for (int64_t i = 0; i < std::min<int64_t>(thread_count, jobs.size());
+         ++i) {
+      threads.push_back(std::make_unique<Thread>(worker));
+    }
+    for (std::unique_ptr<Thread>& thread : threads) {
+      thread->Join();
+    }
+  }
+  for (const absl::Status& status : statuses) {
+    XLS_RETURN_IF_ERROR(status);
+  }
+  return absl::OkStatus();
+}
+
+absl::Status RealMain(absl::Span<const std::string_view> paths,
+                      bool* printed_error) {
+  XLS_ASSIGN_OR_RETURN(CodegenFlagsProto codegen_flags_proto,
+                       CodegenFlagsFromAbslFlags());
+  std::vector<std::string> tops = absl::GetFlag(FLAGS_tops);
+  std::string output_dir = absl::GetFlag(FLAGS_output_dir);
+  if (!tops.empty()) {
+    XLS_QCHECK(codegen_flags_proto.top().empty())
+        << "--top and --tops may not both be given.";
+    XLS_QCHECK(!output_dir.empty()) << "--tops requires --output_dir.";
+  } else if (!codegen_flags_proto.top().empty()) {
+    tops.push_back(codegen_flags_proto.top());
+  }
+
+  const DelayEstimator* delay_estimator = nullptr;
+  if (codegen_flags_proto.generator() == GENERATOR_KIND_PIPELINE) {
+    XLS_QCHECK(absl::GetFlag(FLAGS_pipeline_stages) != 0 ||
+               absl::GetFlag(FLAGS_clock_period_ps) != 0)
+        << "Must specify --pipeline_stages or --clock_period_ps (or both).";
+    XLS_ASSIGN_OR_RETURN(delay_estimator, SetUpDelayEstimator());
+  }
+
+  XLS_ASSIGN_OR_RETURN(std::vector<std::unique_ptr<Package>> packages,
+                       GetPackages(paths, tops, printed_error));
+
+  std::vector<CompilationJob> jobs;
+  for (std::unique_ptr<Package>& package : packages) {
+    CompilationJob job;
+    job.codegen_flags = codegen_flags_proto;
+    if (output_dir.empty()) {
+      job.ir_path = absl::GetFlag(FLAGS_output_ir_path);
+      job.opt_ir_path = absl::GetFlag(FLAGS_output_opt_ir_path);
+    } else {
+      std::string top = tops[jobs.size()];
+      auto artifact_path = [&](std::string_view extension) {
+        return (std::filesystem::path(output_dir) /
+                absl::StrCat(top, extension))
+            .string();
+      };
+      job.ir_path = artifact_path(".ir");
+      job.opt_ir_path = artifact_path(".opt.ir");
+      job.codegen_flags.clear_top();
+      job.codegen_flags.set_output_verilog_path(artifact_path(
+          codegen_flags_proto.use_system_verilog() ? ".sv" : ".v"));
+      job.codegen_flags.set_output_signature_path(
+          artifact_path(".sig.textproto"));
+      job.codegen_flags.set_output_block_ir_path(artifact_path(".block.ir"));
+      job.codegen_flags.set_output_verilog_line_map_path(
+          artifact_path(".verilog_line_map.textproto"));
+      if (codegen_flags_proto.generator() == GENERATOR_KIND_PIPELINE) {
+        job.codegen_flags.set_output_schedule_path(
+            artifact_path(".schedule.textproto"));
+      }
+    }
+    job.package = std::move(package);
+    jobs.push_back(std::move(job));
+  }
+
+  int64_t convert_array_index_to_select =
+      absl::GetFlag(FLAGS_convert_array_index_to_select);
+  tools::OptOptions opt_options;
+  opt_options.opt_level = absl::GetFlag(FLAGS_opt_level);
+  opt_options.skip_passes = absl::GetFlag(FLAGS_skip_passes);
+  opt_options.convert_array_index_to_select =
+      convert_array_index_to_select < 0
+          ? std::nullopt
+          : std::make_optional(convert_array_index_to_select);
+  opt_options.inline_procs = absl::GetFlag(FLAGS_inline_procs);
+
+  int64_t thread_count = absl::GetFlag(FLAGS_jobs);
+  if (thread_count == 0) {
+    thread_count = std::max<int64_t>(1, std::thread::hardware_concurrency());
+  }
+  return CompileAll(jobs, opt_options, delay_estimator, thread_count);
+}
+
+}  // namespace
+}  // namespace xls
+
+int main(int argc, char** argv) {
+  std::vector<std::string_view> positional_arguments =
+      xls::InitXls(kUsage, argc, argv);
+  if (positional_arguments.empty()) {
+    XLS_LOG(QFATAL) << absl::StreamFormat(
+        "Expected invocation: %s DSLX_FILE... or %s IR_FILE", argv[0],
+        argv[0]);
+  }
+  for (auto& arg : positional_arguments) {
+    if (arg == "-") {
+      arg = "/dev/stdin";
+    }
+  }
+
+  bool printed_error = false;
+  absl::Status status = xls::RealMain(positional_arguments, &printed_error);
+  if (printed_error) {
+    return EXIT_FAILURE;
+  }
+  XLS_QCHECK_OK(status);
+  return EXIT_SUCCESS;
+}
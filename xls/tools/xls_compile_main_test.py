@@ -0,0 +1,123 @@
+#
+# Copyright 2023 The XLS Authors
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Tests for xls.tools.xls_compile_main."""
+
+import os
+import subprocess
+
+from google.protobuf import text_format
+from absl.testing import absltest
+from xls.codegen import module_signature_pb2
+from xls.common import runfiles
+
+XLS_COMPILE_MAIN_PATH = runfiles.get_path('xls/tools/xls_compile_main')
+
+ADD_MUL_DSLX = """fn add(x: u32, y: u32) -> u32 { x + y }
+
+fn mul(x: u32, y: u32) -> u32 { x * y }
+"""
+
+NOT_ADD_IR = """package not_add
+
+fn not_add(x: bits[32], y: bits[32]) -> bits[32] {
+  add.1: bits[32] = add(x, y)
+  ret not.2: bits[32] = not(add.1)
+}
+"""
+
+
+class XlsCompileMainTest(absltest.TestCase):
+
+  def test_single_top_from_dslx(self):
+    dslx_file = self.create_tempfile(
+        file_path='add_mul.x', content=ADD_MUL_DSLX)
+    output_dir = self.create_tempdir().full_path
+    ir_path = os.path.join(output_dir, 'add.ir')
+    opt_ir_path = os.path.join(output_dir, 'add.opt.ir')
+    verilog_path = os.path.join(output_dir, 'add.v')
+    signature_path = os.path.join(output_dir, 'add.sig.textproto')
+    subprocess.check_call([
+        XLS_COMPILE_MAIN_PATH, '--top=add', '--pipeline_stages=2',
+        '--delay_model=unit', '--module_name=add',
+        '--output_ir_path=' + ir_path, '--output_opt_ir_path=' + opt_ir_path,
+        '--output_verilog_path=' + verilog_path,
+        '--output_signature_path=' + signature_path, dslx_file.full_path
+    ])
+
+    with open(ir_path, 'r') as f:
+      ir = f.read()
+      self.assertIn('package add_mul', ir)
+      self.assertIn('top fn __add_mul__add(', ir)
+    with open(opt_ir_path, 'r') as f:
+      self.assertIn('add(', f.read())
+    with open(verilog_path, 'r') as f:
+      self.assertIn('module add(', f.read())
+    with open(signature_path, 'r') as f:
+      sig_proto = text_format.Parse(f.read(),
+                                    module_signature_pb2.ModuleSignatureProto())
+      self.assertEqual(sig_proto.module_name, 'add')
+      self.assertEqual(sig_proto.pipeline.latency, 2)
+
+  def test_multiple_tops_from_dslx(self):
+    dslx_file = self.create_tempfile(
+        file_path='add_mul.x', content=ADD_MUL_DSLX)
+    output_dir = self.create_tempdir().full_path
+    subprocess.check_call([
+        XLS_COMPILE_MAIN_PATH, '--tops=add,mul', '--pipeline_stages=1',
+        '--delay_model=unit', '--jobs=2', '--output_dir=' + output_dir,
+        dslx_file.full_path
+    ])
+
+    for top in ('add', 'mul'):
+      for extension in ('.ir', '.opt.ir', '.v', '.sig.textproto',
+                        '.schedule.textproto', '.block.ir'):
+        self.assertTrue(
+            os.path.exists(os.path.join(output_dir, top + extension)),
+            msg=top + extension)
+    with open(os.path.join(output_dir, 'mul.opt.ir'), 'r') as f:
+      self.assertIn('umul(', f.read())
+    for top in ('add', 'mul'):
+      with open(os.path.join(output_dir, top + '.ir'), 'r') as f:
+        self.assertIn('top fn __add_mul__{}('.format(top), f.read())
+
+  def test_top_from_multiple_dslx_files(self):
+    add_file = self.create_tempfile(
+        file_path='adder.x', content='fn add(x: u32, y: u32) -> u32 { x + y }')
+    mul_file = self.create_tempfile(
+        file_path='multiplier.x',
+        content='fn mul(x: u32, y: u32) -> u32 { x * y }')
+    output_dir = self.create_tempdir().full_path
+    ir_path = os.path.join(output_dir, 'mul.ir')
+    verilog = subprocess.check_output([
+        XLS_COMPILE_MAIN_PATH, '--generator=combinational', '--top=mul',
+        '--package_name=arith', '--output_ir_path=' + ir_path,
+        add_file.full_path, mul_file.full_path
+    ]).decode('utf-8')
+    self.assertIn('module ', verilog)
+    with open(ir_path, 'r') as f:
+      self.assertIn('top fn __multiplier__mul(', f.read())
+
+  def test_combinational_from_ir(self):
+    ir_file = self.create_tempfile(file_path='not_add.ir', content=NOT_ADD_IR)
+    verilog = subprocess.check_output([
+        XLS_COMPILE_MAIN_PATH, '--generator=combinational', '--top=not_add',
+        ir_file.full_path
+    ]).decode('utf-8')
+    self.assertIn('module not_add(', verilog)
+
+
+if __name__ == '__main__':
+  absltest.main()